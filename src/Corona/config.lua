@@ -19,6 +19,51 @@ application =
         clientSecret = "REPLACE_THIS",
         productId = "REPLACE_THIS",
         sandboxId = "REPLACE_THIS",
-        deploymentId = "REPLACE_THIS"
+        deploymentId = "REPLACE_THIS",
+        -- Downloads offer images after eos.loadProducts(), dispatching a "productImage" event per image.
+        -- prefetchProductImages = true,
+        -- imageCacheMaxBytes = 32 * 1024 * 1024,
+        -- Provides "loadProducts" event.products as a proxy that copies each offer from EOS when first read,
+        -- instead of an array of all offers. The proxy supports products[i] and #products only, so ipairs(),
+        -- pairs(), the table library and json.encode() cannot be used on it.
+        -- lazyProducts = true,
+        -- On Windows and macOS, the refresh token of the last login is kept in the Credential Manager or
+        -- Keychain and used to log in on the next launch. Set false to always require a new login.
+        -- persistentLogin = false,
+        -- Logs into the Connect interface after each login, dispatching a "connectLoginResponse" event.
+        -- The session is renewed before it expires and eos.getProductUserId() returns its user's ID.
+        -- connectLogin = true,
+        -- Initializes EOS on first use of an API needing it, or after "initializationDelay" seconds,
+        -- instead of while require("plugin.eos") is running. Calls made before then are queued.
+        -- deferInitialization = true,
+        -- initializationDelay = 2,
+        -- Queries the catalog and entitlements as soon as the user logs in, without waiting for Lua.
+        -- A "startup" event then reports how long each stage took.
+        -- startup = {
+        --     loadProducts = true,
+        --     restore = true,
+        -- },
+        -- EOS is not ticked while the app is suspended. Up to "eventLimit" events received meanwhile are held,
+        -- dropping the oldest or newest past that. Purchases are never dropped. Once resumed, the held events
+        -- and those EOS delivers on its first tick are dispatched "resumeEventsPerFrame" at a time.
+        -- background = {
+        --     eventLimit = 100,
+        --     overflow = "dropOldest",
+        --     resumeEventsPerFrame = 8,
+        -- },
+        -- Runs as a dedicated server: the platform is created with the client credentials alone and no user
+        -- logs in. Players are then tracked by product user ID via eos.addPlayer() and eos.removePlayer().
+        -- server = true,
+        -- Runtimes in the same process using the same product, sandbox and deployment share 1 EOS platform.
+        -- Give a runtime its own platform, ticked independently of the others, by setting a distinct name here.
+        -- Its purchase journal and offline queue are then also kept in files of their own.
+        -- platformInstance = "storefrontTest",
+        -- Spreads the garbage collection caused by large event bursts, such as "loadProducts", over "stepFrames"
+        -- frames. "pauseDuringDispatch" stops the collector while events are dispatched. Leave it off if the
+        -- app stops the collector itself, since it is restarted after each dispatch.
+        -- gcPacing = {
+        --     stepFrames = 10,
+        --     pauseDuringDispatch = true,
+        -- },
     },
 }
@@ -0,0 +1,31 @@
+// ----------------------------------------------------------------------------
+//
+// AtomicFile.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#include "AtomicFile.h"
+#if defined(_WIN32)
+#	include <windows.h>
+#else
+#	include <cstdio>
+#endif
+
+
+bool AtomicFile::Replace(const char* temporaryFilePath, const char* filePath)
+{
+	// Validate.
+	if (!temporaryFilePath || !filePath)
+	{
+		return false;
+	}
+
+#if defined(_WIN32)
+	return (MoveFileExA(temporaryFilePath, filePath, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != FALSE);
+#else
+	return (rename(temporaryFilePath, filePath) == 0);
+#endif
+}
@@ -0,0 +1,32 @@
+// ----------------------------------------------------------------------------
+//
+// AtomicFile.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+
+/**
+  Swaps in files that were written beside the file they replace, so that a crash leaves either the old
+  or the new file intact, never neither of them.
+
+  Uses rename() on POSIX platforms, which replaces an existing file atomically. On Windows, where rename()
+  fails if the destination exists, MoveFileExA() with MOVEFILE_REPLACE_EXISTING is used instead, with
+  MOVEFILE_WRITE_THROUGH so that it does not return until the move has been flushed to disk.
+ */
+class AtomicFile
+{
+	public:
+		/**
+		  Replaces the given file with the given temporary file, which is moved in its place.
+		  @param temporaryFilePath Path to the fully written and closed file to move.
+		  @param filePath Path to the file to replace. Does not need to exist.
+		  @return Returns true if replaced. Returns false if given a null path or if the move failed,
+		          in which case both files are left as they were.
+		 */
+		static bool Replace(const char* temporaryFilePath, const char* filePath);
+};
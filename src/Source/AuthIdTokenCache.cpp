@@ -0,0 +1,210 @@
+// ----------------------------------------------------------------------------
+//
+// AuthIdTokenCache.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#include "AuthIdTokenCache.h"
+#include "CoronaLua.h"
+#include "JsonWebToken.h"
+#include "RuntimeContext.h"
+#include "eos_auth.h"
+#include <cstring>
+#include <ctime>
+extern "C"
+{
+#	include "lua.h"
+#	include "lauxlib.h"
+}
+
+
+/** Lifetime assumed for tokens whose "exp" claim cannot be read. */
+static const int64_t kDefaultTokenLifetimeInSeconds = 300;
+
+/** How long to wait before copying again when EOS has not refreshed a token that is due for a refresh. */
+static const int64_t kRefreshRetryDelayInSeconds = 10;
+
+
+AuthIdTokenCache::AuthIdTokenCache(RuntimeContext* contextPointer, EOS_EpicAccountId localUserId)
+:	fContextPointer(contextPointer),
+	fLocalUserId(localUserId),
+	fAuthHandle(nullptr),
+	fLoginStatusChangedNotificationId(EOS_INVALID_NOTIFICATIONID),
+	fAccountId(nullptr),
+	fLuaTokenReference(LUA_NOREF),
+	fExpirationTime(0),
+	fRefreshTime(0)
+{
+}
+
+AuthIdTokenCache::~AuthIdTokenCache()
+{
+	// Note: The token's registry reference is released by SetAuthHandle(nullptr), which the runtime context's
+	//       destructor calls via LocalUserTable::Clear() while its Lua state is still open. The Lua state may
+	//       already be closed by the time this destructor runs, so the reference is not touched here.
+	if (fAuthHandle && (fLoginStatusChangedNotificationId != EOS_INVALID_NOTIFICATIONID))
+	{
+		EOS_Auth_RemoveNotifyLoginStatusChanged(fAuthHandle, fLoginStatusChangedNotificationId);
+	}
+}
+
+bool AuthIdTokenCache::PushTo(lua_State* luaStatePointer)
+{
+	// Validate.
+	if (!luaStatePointer || !fContextPointer || !fLocalUserId)
+	{
+		return false;
+	}
+	SetAuthHandle(fContextPointer->fAuthHandle);
+	EOS_EpicAccountId accountId = fLocalUserId;
+
+	// Copy the token from EOS if not cached, expired or belonging to another account.
+	if ((fLuaTokenReference == LUA_NOREF) || (accountId != fAccountId) || ((int64_t)time(nullptr) >= fExpirationTime))
+	{
+		if (!CopyFromEos(accountId))
+		{
+			return false;
+		}
+	}
+
+	lua_rawgeti(luaStatePointer, LUA_REGISTRYINDEX, fLuaTokenReference);
+	return true;
+}
+
+void AuthIdTokenCache::Update()
+{
+	if (!fContextPointer)
+	{
+		return;
+	}
+	SetAuthHandle(fContextPointer->fAuthHandle);
+	EOS_EpicAccountId accountId = fLocalUserId;
+	if (fLuaTokenReference == LUA_NOREF)
+	{
+		return;
+	}
+	if (accountId != fAccountId)
+	{
+		Invalidate();
+		return;
+	}
+
+	// Re-copy the token once it is due for a refresh.
+	// Note: If EOS has not refreshed the token yet, then the same token is copied and checked again later.
+	int64_t currentTime = (int64_t)time(nullptr);
+	if (currentTime >= fRefreshTime)
+	{
+		if (!CopyFromEos(accountId))
+		{
+			return;
+		}
+		if (fRefreshTime <= currentTime)
+		{
+			fRefreshTime = (currentTime + kRefreshRetryDelayInSeconds < fExpirationTime) ?
+					(currentTime + kRefreshRetryDelayInSeconds) : fExpirationTime;
+		}
+	}
+}
+
+void AuthIdTokenCache::SetAuthHandle(EOS_HAuth authHandle)
+{
+	if (authHandle == fAuthHandle)
+	{
+		return;
+	}
+
+	// Unsubscribe from the last auth interface.
+	if (fAuthHandle && (fLoginStatusChangedNotificationId != EOS_INVALID_NOTIFICATIONID))
+	{
+		EOS_Auth_RemoveNotifyLoginStatusChanged(fAuthHandle, fLoginStatusChangedNotificationId);
+	}
+	fLoginStatusChangedNotificationId = EOS_INVALID_NOTIFICATIONID;
+	Invalidate();
+
+	// Subscribe to the new auth interface.
+	fAuthHandle = authHandle;
+	if (fAuthHandle)
+	{
+		EOS_Auth_AddNotifyLoginStatusChangedOptions NotifyOptions{ 0 };
+		NotifyOptions.ApiVersion = EOS_AUTH_ADDNOTIFYLOGINSTATUSCHANGED_API_LATEST;
+		fLoginStatusChangedNotificationId = EOS_Auth_AddNotifyLoginStatusChanged(
+				fAuthHandle, &NotifyOptions, this, &AuthIdTokenCache::OnLoginStatusChanged);
+	}
+}
+
+void AuthIdTokenCache::Invalidate()
+{
+	lua_State* luaStatePointer = fContextPointer ? fContextPointer->GetMainLuaState() : nullptr;
+	if (luaStatePointer && (fLuaTokenReference != LUA_NOREF))
+	{
+		luaL_unref(luaStatePointer, LUA_REGISTRYINDEX, fLuaTokenReference);
+	}
+	fLuaTokenReference = LUA_NOREF;
+	fAccountId = nullptr;
+	fExpirationTime = 0;
+	fRefreshTime = 0;
+}
+
+bool AuthIdTokenCache::CopyFromEos(EOS_EpicAccountId accountId)
+{
+	lua_State* luaStatePointer = fContextPointer->GetMainLuaState();
+	if (!fAuthHandle || !luaStatePointer)
+	{
+		return false;
+	}
+
+	EOS_Auth_CopyIdTokenOptions CopyTokenOptions{ 0 };
+	CopyTokenOptions.ApiVersion = EOS_AUTH_COPYIDTOKEN_API_LATEST;
+	CopyTokenOptions.AccountId = accountId;
+	EOS_Auth_IdToken* IdToken = nullptr;
+	if ((EOS_Auth_CopyIdToken(fAuthHandle, &CopyTokenOptions, &IdToken) != EOS_EResult::EOS_Success) || !IdToken)
+	{
+		Invalidate();
+		return false;
+	}
+
+	// Parse the token's expiration time and schedule its refresh after 3/4 of its lifetime.
+	int64_t currentTime = (int64_t)time(nullptr);
+	int64_t expirationTime = 0;
+	if (!JsonWebToken::GetExpirationTime(IdToken->JsonWebToken, expirationTime))
+	{
+		expirationTime = currentTime + kDefaultTokenLifetimeInSeconds;
+	}
+
+	// Store the token string in the Lua registry, unless it is the token already cached.
+	bool isSameToken = false;
+	if (fLuaTokenReference != LUA_NOREF)
+	{
+		lua_rawgeti(luaStatePointer, LUA_REGISTRYINDEX, fLuaTokenReference);
+		auto cachedToken = lua_tostring(luaStatePointer, -1);
+		isSameToken = cachedToken && IdToken->JsonWebToken && !strcmp(cachedToken, IdToken->JsonWebToken);
+		lua_pop(luaStatePointer, 1);
+	}
+	if (!isSameToken)
+	{
+		Invalidate();
+		lua_pushstring(luaStatePointer, IdToken->JsonWebToken ? IdToken->JsonWebToken : "");
+		fLuaTokenReference = luaL_ref(luaStatePointer, LUA_REGISTRYINDEX);
+		fExpirationTime = expirationTime;
+		fRefreshTime = currentTime + (((expirationTime > currentTime) ? (expirationTime - currentTime) : 0) * 3) / 4;
+	}
+	fAccountId = accountId;
+	EOS_Auth_IdToken_Release(IdToken);
+	return true;
+}
+
+void EOS_CALL AuthIdTokenCache::OnLoginStatusChanged(const EOS_Auth_LoginStatusChangedCallbackInfo* Data)
+{
+	if (!Data)
+	{
+		return;
+	}
+	auto cachePointer = (AuthIdTokenCache*)Data->ClientData;
+	if (cachePointer && (Data->LocalUserId == cachePointer->fAccountId))
+	{
+		cachePointer->Invalidate();
+	}
+}
@@ -0,0 +1,112 @@
+// ----------------------------------------------------------------------------
+//
+// AuthIdTokenCache.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstdint>
+#include "eos_sdk.h"
+#include "eos_auth_types.h"
+
+// Forward declarations.
+class RuntimeContext;
+extern "C"
+{
+	struct lua_State;
+}
+
+
+/**
+  Caches a logged in user's ID token returned by EOS_Auth_CopyIdToken() as a Lua string.
+  Each local user has its own cache, owned by the runtime context's LocalUserTable.
+
+  The token is copied from EOS once and stored in the Lua registry, so every eos.getAuthIdToken() call
+  pushes the same interned Lua string instead of copying and hashing the JWT again. The token's "exp"
+  claim is parsed once, and the token is copied again once 3/4 of its lifetime has elapsed to pick up
+  the token the EOS SDK refreshes on its own.
+
+  The cached token is dropped when EOS reports a login status change for the user.
+ */
+class AuthIdTokenCache
+{
+	public:
+		/**
+		  Creates a new ID token cache.
+		  @param contextPointer The runtime context providing the auth interface and the main Lua state whose
+		                        registry stores the token. Cannot be null.
+		  @param localUserId The logged in account whose token is cached.
+		 */
+		AuthIdTokenCache(RuntimeContext* contextPointer, EOS_EpicAccountId localUserId);
+
+		/**
+		  Unsubscribes from EOS. Does not release the token's Lua registry reference.
+		  SetAuthHandle(nullptr) must be called before the EOS platform is released and the Lua state is closed,
+		  which releases the reference. LocalUserTable::Clear() does this when the runtime context is destroyed.
+		 */
+		virtual ~AuthIdTokenCache();
+
+		/**
+		  Pushes the user's ID token to the top of the Lua stack, copying it from EOS if not cached.
+		  @param luaStatePointer Lua state to push the token to. Can be a coroutine of the main Lua state.
+		  @return Returns true if the token was pushed. Returns false if no token is available,
+		          in which case nothing is pushed.
+		 */
+		bool PushTo(lua_State* luaStatePointer);
+
+		/**
+		  To be called every frame. Tracks the context's auth interface and re-copies the token once it is
+		  close to expiring.
+		 */
+		void Update();
+
+		/**
+		  Sets the auth interface to copy tokens from, subscribing to its login status notifications.
+		  @param authHandle The auth interface. Set to null to unsubscribe and drop the cached token.
+		 */
+		void SetAuthHandle(EOS_HAuth authHandle);
+
+		/** Drops the cached token, so that the next PushTo() call copies it from EOS again. */
+		void Invalidate();
+
+	private:
+		/** Copy constructor deleted to prevent it from being called. */
+		AuthIdTokenCache(const AuthIdTokenCache&) = delete;
+
+		/** Method deleted to prevent the copy operator from being used. */
+		void operator=(const AuthIdTokenCache&) = delete;
+
+		/**
+		  Copies the given account's ID token from EOS and replaces the cached token with it.
+		  @param accountId The logged in Epic account.
+		  @return Returns true if a token was copied. Returns false if EOS has no token for the account.
+		 */
+		bool CopyFromEos(EOS_EpicAccountId accountId);
+
+		/** Called by EOS when a local user's login status changes. */
+		static void EOS_CALL OnLoginStatusChanged(const EOS_Auth_LoginStatusChangedCallbackInfo* Data);
+
+		RuntimeContext* fContextPointer;
+
+		/** The account whose token is cached. */
+		EOS_EpicAccountId fLocalUserId;
+
+		EOS_HAuth fAuthHandle;
+		EOS_NotificationId fLoginStatusChangedNotificationId;
+
+		/** The account the cached token belongs to. */
+		EOS_EpicAccountId fAccountId;
+
+		/** Lua registry reference to the cached token string. LUA_NOREF if not cached. */
+		int fLuaTokenReference;
+
+		/** The token's "exp" claim in seconds since the Unix epoch. */
+		int64_t fExpirationTime;
+
+		/** Time at which the token will be re-copied from EOS, in seconds since the Unix epoch. */
+		int64_t fRefreshTime;
+};
@@ -0,0 +1,586 @@
+// ----------------------------------------------------------------------------
+//
+// ConnectSession.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#include "ConnectSession.h"
+#include "DispatchEventTask.h"
+#include "RuntimeContext.h"
+#include "eos_auth.h"
+#include "eos_connect.h"
+#include <cstdio>
+#include <memory>
+#include <unordered_set>
+#if defined(__APPLE__)
+#	include <TargetConditionals.h>
+#endif
+
+
+/** Stores a collection of all ConnectSession instances that currently exist in the application. */
+static std::unordered_set<ConnectSession*> sConnectSessionCollection;
+
+/** How long to wait before logging in again after a login failed due to a transient error. */
+static const std::chrono::seconds kLoginRetryDelay(15);
+
+/** Display name used by device ID logins that were not given one. */
+static const char kDefaultGuestDisplayName[] = "Guest";
+
+/** Describes this device to account linking management, as required by EOS_Connect_CreateDeviceId(). */
+#if defined(__ANDROID__)
+static const char kDeviceModel[] = "Android";
+#elif defined(__APPLE__) && TARGET_OS_IPHONE
+static const char kDeviceModel[] = "iOS";
+#elif defined(__APPLE__)
+static const char kDeviceModel[] = "Mac";
+#elif defined(_WIN32)
+static const char kDeviceModel[] = "PC Windows";
+#else
+static const char kDeviceModel[] = "Unknown";
+#endif
+
+
+ConnectSession::ConnectSession(RuntimeContext* contextPointer)
+:	fContextPointer(contextPointer),
+	fIsEnabled(false),
+	fConnectHandle(nullptr),
+	fAuthExpirationNotificationId(EOS_INVALID_NOTIFICATIONID),
+	fLoginStatusChangedNotificationId(EOS_INVALID_NOTIFICATIONID),
+	fEpicAccountId(nullptr),
+	fIsDeviceIdLogin(false),
+	fHasRecreatedDeviceId(false),
+	fProductUserId(nullptr),
+	fIsLoginInFlight(false),
+	fIsRetryPending(false),
+	fGeneration(0)
+{
+	fProductUserIdString[0] = '\0';
+
+	// Add this class instance to the global collection.
+	sConnectSessionCollection.insert(this);
+}
+
+ConnectSession::~ConnectSession()
+{
+	// Remove this class instance from the global collection.
+	// Note: In-flight login callbacks check this collection and will do nothing once it is removed.
+	sConnectSessionCollection.erase(this);
+}
+
+void ConnectSession::SetEnabled(bool value)
+{
+	fIsEnabled = value;
+}
+
+bool ConnectSession::IsEnabled() const
+{
+	return fIsEnabled;
+}
+
+void ConnectSession::Login(EOS_EpicAccountId epicAccountId)
+{
+	// Validate.
+	if (!fIsEnabled || !epicAccountId || !fContextPointer || !fContextPointer->fPlatformHandle)
+	{
+		return;
+	}
+
+	// Do nothing if this account is already logged in or logging in.
+	if (epicAccountId == fEpicAccountId)
+	{
+		if (fProductUserId || fIsLoginInFlight)
+		{
+			return;
+		}
+	}
+	else
+	{
+		// Drop the last account's product user and ignore its in-flight login.
+		fGeneration++;
+		fEpicAccountId = epicAccountId;
+		fIsDeviceIdLogin = false;
+		fProductUserId = nullptr;
+		fProductUserIdString[0] = '\0';
+		fIsLoginInFlight = false;
+	}
+	fIsRetryPending = false;
+
+	fContextPointer->GetStartupPipeline().OnStageStarted(StartupPipeline::Stage::kConnectLogin);
+	StartLogin(false);
+}
+
+bool ConnectSession::LoginWithDeviceId(const char* displayName)
+{
+	// Validate.
+	if (!fContextPointer || !fContextPointer->fPlatformHandle)
+	{
+		return false;
+	}
+
+	// Do nothing if already logged in or logging in as a guest.
+	if (fIsDeviceIdLogin && (fProductUserId || fIsLoginInFlight))
+	{
+		return true;
+	}
+
+	// Drop the last product user and ignore its in-flight login.
+	fGeneration++;
+	fEpicAccountId = nullptr;
+	fIsDeviceIdLogin = true;
+	fDisplayName = (displayName && displayName[0]) ? displayName : kDefaultGuestDisplayName;
+	fHasRecreatedDeviceId = false;
+	fProductUserId = nullptr;
+	fProductUserIdString[0] = '\0';
+	fIsLoginInFlight = false;
+	fIsRetryPending = false;
+	if (!fConnectHandle)
+	{
+		fConnectHandle = EOS_Platform_GetConnectInterface(fContextPointer->fPlatformHandle);
+	}
+
+	// Log in right away if this device's ID was created on an earlier launch.
+	fContextPointer->GetStartupPipeline().OnStageStarted(StartupPipeline::Stage::kConnectLogin);
+	bool wasDeviceIdCreated = false;
+	if (!fDeviceIdStatePath.empty())
+	{
+		FILE* filePointer = fopen(fDeviceIdStatePath.c_str(), "r");
+		if (filePointer)
+		{
+			wasDeviceIdCreated = true;
+			fclose(filePointer);
+		}
+	}
+	if (wasDeviceIdCreated)
+	{
+		StartLogin(false);
+	}
+	else
+	{
+		CreateDeviceId();
+	}
+	return true;
+}
+
+void ConnectSession::SetDeviceIdStatePath(const char* path)
+{
+	fDeviceIdStatePath = path ? path : "";
+}
+
+void ConnectSession::Update()
+{
+	if (!fIsRetryPending || fIsLoginInFlight || (std::chrono::steady_clock::now() < fRetryTime))
+	{
+		return;
+	}
+	fIsRetryPending = false;
+
+	// Only retry guests, or accounts that are still logged in via the Auth interface.
+	if (fContextPointer && (fIsDeviceIdLogin || (fContextPointer->fAccountId && fEpicAccountId)))
+	{
+		StartLogin(fProductUserId != nullptr);
+	}
+}
+
+void ConnectSession::Shutdown()
+{
+	if (fConnectHandle)
+	{
+		if (fAuthExpirationNotificationId != EOS_INVALID_NOTIFICATIONID)
+		{
+			EOS_Connect_RemoveNotifyAuthExpiration(fConnectHandle, fAuthExpirationNotificationId);
+		}
+		if (fLoginStatusChangedNotificationId != EOS_INVALID_NOTIFICATIONID)
+		{
+			EOS_Connect_RemoveNotifyLoginStatusChanged(fConnectHandle, fLoginStatusChangedNotificationId);
+		}
+	}
+	fAuthExpirationNotificationId = EOS_INVALID_NOTIFICATIONID;
+	fLoginStatusChangedNotificationId = EOS_INVALID_NOTIFICATIONID;
+	fConnectHandle = nullptr;
+
+	// Ignore the in-flight login, if any.
+	fGeneration++;
+	fEpicAccountId = nullptr;
+	fIsDeviceIdLogin = false;
+	fProductUserId = nullptr;
+	fProductUserIdString[0] = '\0';
+	fIsLoginInFlight = false;
+	fIsRetryPending = false;
+}
+
+EOS_ProductUserId ConnectSession::GetProductUserId() const
+{
+	return fProductUserId;
+}
+
+const char* ConnectSession::GetProductUserIdString() const
+{
+	return fProductUserIdString;
+}
+
+void ConnectSession::StartLogin(bool isRefresh)
+{
+	if (!fContextPointer || !fContextPointer->fPlatformHandle)
+	{
+		return;
+	}
+	if (!fConnectHandle)
+	{
+		fConnectHandle = EOS_Platform_GetConnectInterface(fContextPointer->fPlatformHandle);
+	}
+	Subscribe();
+
+	// Guests log in with the device ID kept by EOS, which needs no token.
+	// Note: Logins are sent via the request scheduler, which may hold them for a later frame if rate limited.
+	fIsLoginInFlight = true;
+	auto requestPointer = new LoginRequest{ this, fGeneration, isRefresh };
+	if (fIsDeviceIdLogin)
+	{
+		fContextPointer->GetRequestScheduler().Submit(
+				RequestScheduler::Interface::kConnect, [this, requestPointer]()
+		{
+			EOS_Connect_Credentials Credentials{ 0 };
+			Credentials.ApiVersion = EOS_CONNECT_CREDENTIALS_API_LATEST;
+			Credentials.Type = EOS_EExternalCredentialType::EOS_ECT_DEVICEID_ACCESS_TOKEN;
+			Credentials.Token = nullptr;
+
+			EOS_Connect_UserLoginInfo UserLoginInfo{ 0 };
+			UserLoginInfo.ApiVersion = EOS_CONNECT_USERLOGININFO_API_LATEST;
+			UserLoginInfo.DisplayName = fDisplayName.c_str();
+
+			EOS_Connect_LoginOptions LoginOptions{ 0 };
+			LoginOptions.ApiVersion = EOS_CONNECT_LOGIN_API_LATEST;
+			LoginOptions.Credentials = &Credentials;
+			LoginOptions.UserLoginInfo = &UserLoginInfo;
+			SendLogin(requestPointer, LoginOptions);
+		});
+		return;
+	}
+	if (!fContextPointer->fAuthHandle || !fEpicAccountId)
+	{
+		fIsLoginInFlight = false;
+		delete requestPointer;
+		return;
+	}
+
+	// Log in with the account's current ID token, which the Auth interface keeps refreshed.
+	EOS_Auth_CopyIdTokenOptions CopyTokenOptions{ 0 };
+	CopyTokenOptions.ApiVersion = EOS_AUTH_COPYIDTOKEN_API_LATEST;
+	CopyTokenOptions.AccountId = fEpicAccountId;
+	EOS_Auth_IdToken* IdToken = nullptr;
+	EOS_EResult resultCode = EOS_Auth_CopyIdToken(fContextPointer->fAuthHandle, &CopyTokenOptions, &IdToken);
+	if ((resultCode != EOS_EResult::EOS_Success) || !IdToken)
+	{
+		std::unique_ptr<LoginRequest> failedRequestPointer(requestPointer);
+		OnLoginEnded(*failedRequestPointer, (resultCode != EOS_EResult::EOS_Success) ? resultCode : EOS_EResult::EOS_UnexpectedError, nullptr);
+		return;
+	}
+	std::string idToken(IdToken->JsonWebToken ? IdToken->JsonWebToken : "");
+	EOS_Auth_IdToken_Release(IdToken);
+
+	fContextPointer->GetRequestScheduler().Submit(
+			RequestScheduler::Interface::kConnect, [this, requestPointer, idToken]()
+	{
+		EOS_Connect_Credentials Credentials{ 0 };
+		Credentials.ApiVersion = EOS_CONNECT_CREDENTIALS_API_LATEST;
+		Credentials.Type = EOS_EExternalCredentialType::EOS_ECT_EPIC_ID_TOKEN;
+		Credentials.Token = idToken.c_str();
+
+		EOS_Connect_LoginOptions LoginOptions{ 0 };
+		LoginOptions.ApiVersion = EOS_CONNECT_LOGIN_API_LATEST;
+		LoginOptions.Credentials = &Credentials;
+		LoginOptions.UserLoginInfo = nullptr;
+		SendLogin(requestPointer, LoginOptions);
+	});
+}
+
+void ConnectSession::SendLogin(LoginRequest* requestPointer, const EOS_Connect_LoginOptions& options)
+{
+	// Drop the login if this session was shut down or started another login while it was waiting to be sent.
+	if (!fConnectHandle || (requestPointer->Generation != fGeneration))
+	{
+		delete requestPointer;
+		return;
+	}
+
+	// Note: EOS copies the options before returning, so they only need to outlive this call.
+	EOS_Connect_Login(fConnectHandle, &options, requestPointer, &ConnectSession::OnLoginResponse);
+}
+
+void ConnectSession::OnLoginEnded(const LoginRequest& request, EOS_EResult resultCode, EOS_ProductUserId productUserId)
+{
+	fIsLoginInFlight = false;
+
+	// Cache the product user and its string form, so that Lua fetches it without a conversion.
+	if ((resultCode == EOS_EResult::EOS_Success) && productUserId)
+	{
+		int32_t stringLength = (int32_t)sizeof(fProductUserIdString);
+		if (EOS_ProductUserId_ToString(productUserId, fProductUserIdString, &stringLength) != EOS_EResult::EOS_Success)
+		{
+			fProductUserIdString[0] = '\0';
+		}
+		fProductUserId = productUserId;
+	}
+	else
+	{
+		// Retry transient failures later. A failed refresh keeps the session until it expires.
+		bool isTransientFailure =
+				(resultCode == EOS_EResult::EOS_TooManyRequests) ||
+				(resultCode == EOS_EResult::EOS_TimedOut) ||
+				(resultCode == EOS_EResult::EOS_ServiceFailure) ||
+				(resultCode == EOS_EResult::EOS_NoConnection);
+		if (isTransientFailure)
+		{
+			fIsRetryPending = true;
+			fRetryTime = std::chrono::steady_clock::now() + kLoginRetryDelay;
+		}
+		else if (!request.IsRefresh)
+		{
+			fProductUserId = nullptr;
+			fProductUserIdString[0] = '\0';
+		}
+	}
+
+	// Record the product user on the Epic account's local user, for eos.getLocalUsers().
+	fContextPointer->GetLocalUsers().SetProductUserId(fEpicAccountId, fProductUserId);
+
+	// Dispatch the result to Lua.
+	auto taskPointer = new DispatchConnectLoginEventTask();
+	taskPointer->SetLuaEventDispatcher(fContextPointer->GetLuaEventDispatcher());
+	taskPointer->AcquireEventDataFrom(resultCode, fProductUserId ? fProductUserIdString : nullptr, request.IsRefresh);
+	fContextPointer->QueueDispatchEventTask(std::shared_ptr<BaseDispatchEventTask>(taskPointer));
+
+	if (!request.IsRefresh)
+	{
+		fContextPointer->GetStartupPipeline().OnStageEnded(StartupPipeline::Stage::kConnectLogin, resultCode);
+	}
+}
+
+void ConnectSession::CreateDeviceId()
+{
+	if (!fConnectHandle)
+	{
+		return;
+	}
+
+	EOS_Connect_CreateDeviceIdOptions CreateOptions{ 0 };
+	CreateOptions.ApiVersion = EOS_CONNECT_CREATEDEVICEID_API_LATEST;
+	CreateOptions.DeviceModel = kDeviceModel;
+
+	fIsLoginInFlight = true;
+	auto requestPointer = new LoginRequest{ this, fGeneration, false };
+	EOS_Connect_CreateDeviceId(fConnectHandle, &CreateOptions, requestPointer, &ConnectSession::OnCreateDeviceIdResponse);
+}
+
+void ConnectSession::Subscribe()
+{
+	if (!fConnectHandle)
+	{
+		return;
+	}
+	if (fAuthExpirationNotificationId == EOS_INVALID_NOTIFICATIONID)
+	{
+		EOS_Connect_AddNotifyAuthExpirationOptions NotifyOptions{ 0 };
+		NotifyOptions.ApiVersion = EOS_CONNECT_ADDNOTIFYAUTHEXPIRATION_API_LATEST;
+		fAuthExpirationNotificationId = EOS_Connect_AddNotifyAuthExpiration(
+				fConnectHandle, &NotifyOptions, this, &ConnectSession::OnAuthExpiration);
+	}
+	if (fLoginStatusChangedNotificationId == EOS_INVALID_NOTIFICATIONID)
+	{
+		EOS_Connect_AddNotifyLoginStatusChangedOptions NotifyOptions{ 0 };
+		NotifyOptions.ApiVersion = EOS_CONNECT_ADDNOTIFYLOGINSTATUSCHANGED_API_LATEST;
+		fLoginStatusChangedNotificationId = EOS_Connect_AddNotifyLoginStatusChanged(
+				fConnectHandle, &NotifyOptions, this, &ConnectSession::OnLoginStatusChanged);
+	}
+}
+
+void EOS_CALL ConnectSession::OnLoginResponse(const EOS_Connect_LoginCallbackInfo* Data)
+{
+	if (!Data || !EOS_EResult_IsOperationComplete(Data->ResultCode))
+	{
+		return;
+	}
+
+	// Ignore the response if the session was deleted or its account changed since the login started.
+	std::unique_ptr<LoginRequest> requestPointer((LoginRequest*)Data->ClientData);
+	if (!requestPointer)
+	{
+		return;
+	}
+	auto sessionPointer = requestPointer->SessionPointer;
+	if (sConnectSessionCollection.find(sessionPointer) == sConnectSessionCollection.end())
+	{
+		return;
+	}
+	if (requestPointer->Generation != sessionPointer->fGeneration)
+	{
+		return;
+	}
+	sessionPointer->fContextPointer->GetRequestScheduler().OnResultReceived(
+			RequestScheduler::Interface::kConnect, Data->ResultCode);
+
+	// If EOS no longer has the device ID recorded in the state file, such as after the app's data was
+	// restored onto another device, then create it again once and retry.
+	if ((Data->ResultCode == EOS_EResult::EOS_NotFound) && sessionPointer->fIsDeviceIdLogin &&
+	    !sessionPointer->fHasRecreatedDeviceId)
+	{
+		sessionPointer->fHasRecreatedDeviceId = true;
+		if (!sessionPointer->fDeviceIdStatePath.empty())
+		{
+			remove(sessionPointer->fDeviceIdStatePath.c_str());
+		}
+		sessionPointer->CreateDeviceId();
+		return;
+	}
+
+	// Create the product user if this is the account's or device's first login to this product.
+	if ((Data->ResultCode == EOS_EResult::EOS_InvalidUser) && Data->ContinuanceToken && sessionPointer->fConnectHandle)
+	{
+		EOS_Connect_CreateUserOptions CreateOptions{ 0 };
+		CreateOptions.ApiVersion = EOS_CONNECT_CREATEUSER_API_LATEST;
+		CreateOptions.ContinuanceToken = Data->ContinuanceToken;
+		EOS_Connect_CreateUser(
+				sessionPointer->fConnectHandle, &CreateOptions, requestPointer.release(), &ConnectSession::OnCreateUserResponse);
+		return;
+	}
+
+	sessionPointer->OnLoginEnded(*requestPointer, Data->ResultCode, Data->LocalUserId);
+}
+
+void EOS_CALL ConnectSession::OnCreateUserResponse(const EOS_Connect_CreateUserCallbackInfo* Data)
+{
+	if (!Data || !EOS_EResult_IsOperationComplete(Data->ResultCode))
+	{
+		return;
+	}
+
+	std::unique_ptr<LoginRequest> requestPointer((LoginRequest*)Data->ClientData);
+	if (!requestPointer)
+	{
+		return;
+	}
+	auto sessionPointer = requestPointer->SessionPointer;
+	if (sConnectSessionCollection.find(sessionPointer) == sConnectSessionCollection.end())
+	{
+		return;
+	}
+	if (requestPointer->Generation != sessionPointer->fGeneration)
+	{
+		return;
+	}
+	sessionPointer->OnLoginEnded(*requestPointer, Data->ResultCode, Data->LocalUserId);
+}
+
+void EOS_CALL ConnectSession::OnCreateDeviceIdResponse(const EOS_Connect_CreateDeviceIdCallbackInfo* Data)
+{
+	if (!Data || !EOS_EResult_IsOperationComplete(Data->ResultCode))
+	{
+		return;
+	}
+
+	std::unique_ptr<LoginRequest> requestPointer((LoginRequest*)Data->ClientData);
+	if (!requestPointer)
+	{
+		return;
+	}
+	auto sessionPointer = requestPointer->SessionPointer;
+	if (sConnectSessionCollection.find(sessionPointer) == sConnectSessionCollection.end())
+	{
+		return;
+	}
+	if (requestPointer->Generation != sessionPointer->fGeneration)
+	{
+		return;
+	}
+
+	// A device ID that already exists can be logged in with as well.
+	bool hasDeviceId =
+			(Data->ResultCode == EOS_EResult::EOS_Success) ||
+			(Data->ResultCode == EOS_EResult::EOS_DuplicateNotAllowed);
+	if (!hasDeviceId)
+	{
+		sessionPointer->OnLoginEnded(*requestPointer, Data->ResultCode, nullptr);
+		return;
+	}
+
+	// Record that the device ID exists, so that the next launch logs in without creating it first.
+	if (!sessionPointer->fDeviceIdStatePath.empty())
+	{
+		FILE* filePointer = fopen(sessionPointer->fDeviceIdStatePath.c_str(), "w");
+		if (filePointer)
+		{
+			fputs(kDeviceModel, filePointer);
+			fclose(filePointer);
+		}
+	}
+	sessionPointer->StartLogin(requestPointer->IsRefresh);
+}
+
+void EOS_CALL ConnectSession::OnAuthExpiration(const EOS_Connect_AuthExpirationCallbackInfo* Data)
+{
+	if (!Data)
+	{
+		return;
+	}
+	auto sessionPointer = (ConnectSession*)Data->ClientData;
+	if (sConnectSessionCollection.find(sessionPointer) == sConnectSessionCollection.end())
+	{
+		return;
+	}
+	if (!sessionPointer->fProductUserId || (Data->LocalUserId != sessionPointer->fProductUserId))
+	{
+		return;
+	}
+	if (sessionPointer->fIsLoginInFlight)
+	{
+		return;
+	}
+
+	// Log in again before the session expires, with an ID token fetched from EOS instead of the cache,
+	// and drop the cached token so that Lua is handed the same token the new session is based on.
+	// Note: Guests simply log in with their device ID again.
+	if (!sessionPointer->fIsDeviceIdLogin)
+	{
+		auto& localUsers = sessionPointer->fContextPointer->GetLocalUsers();
+		auto userPointer = localUsers.GetBy(localUsers.FindBy(sessionPointer->fEpicAccountId));
+		if (userPointer)
+		{
+			userPointer->AuthIdTokenCachePointer->Invalidate();
+		}
+	}
+	sessionPointer->fIsRetryPending = false;
+	sessionPointer->StartLogin(true);
+}
+
+void EOS_CALL ConnectSession::OnLoginStatusChanged(const EOS_Connect_LoginStatusChangedCallbackInfo* Data)
+{
+	if (!Data)
+	{
+		return;
+	}
+	auto sessionPointer = (ConnectSession*)Data->ClientData;
+	if (sConnectSessionCollection.find(sessionPointer) == sConnectSessionCollection.end())
+	{
+		return;
+	}
+	if (!sessionPointer->fProductUserId || (Data->LocalUserId != sessionPointer->fProductUserId))
+	{
+		return;
+	}
+
+	// If the session expired anyway, such as while offline, then log in again from scratch.
+	if (Data->CurrentStatus == EOS_ELoginStatus::EOS_LS_NotLoggedIn)
+	{
+		sessionPointer->fProductUserId = nullptr;
+		sessionPointer->fProductUserIdString[0] = '\0';
+		sessionPointer->fContextPointer->GetLocalUsers().SetProductUserId(sessionPointer->fEpicAccountId, nullptr);
+		if (!sessionPointer->fIsLoginInFlight)
+		{
+			sessionPointer->fIsRetryPending = true;
+			sessionPointer->fRetryTime = std::chrono::steady_clock::now();
+		}
+	}
+}
@@ -0,0 +1,193 @@
+// ----------------------------------------------------------------------------
+//
+// ConnectSession.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include "eos_sdk.h"
+#include "eos_connect_types.h"
+
+// Forward declarations.
+class RuntimeContext;
+
+
+/**
+  Logs the Epic account logged in via the Auth interface into the Connect interface, which provides the
+  EOS_ProductUserId that game services such as stats, achievements, lobbies, P2P and storage require.
+
+  The login is started as soon as the Auth login succeeds, using the account's Auth ID token, and creates
+  the account's product user on its first login. The resulting EOS_ProductUserId and its string form are
+  cached until the account logs out or changes.
+
+  Connect sessions expire on their own, so this class subscribes to EOS_Connect_AddNotifyAuthExpiration(),
+  which EOS posts shortly before expiry, and logs in again with a fresh ID token right away. This keeps
+  the session valid without game service calls ever stalling on an expired session.
+
+  Guests without an Epic account can log in anonymously via LoginWithDeviceId() instead. The device ID
+  only needs to be created once per device, which is recorded in a state file so that later launches
+  go straight to EOS_Connect_Login().
+ */
+class ConnectSession
+{
+	public:
+		/**
+		  Creates a new disabled Connect session.
+		  @param contextPointer The runtime context providing the platform and auth interface,
+		                        and used to dispatch events. Cannot be null.
+		 */
+		ConnectSession(RuntimeContext* contextPointer);
+
+		/** Stops handling in-flight logins. Shutdown() must be called before the EOS platform is released. */
+		virtual ~ConnectSession();
+
+		/**
+		  Enables or disables logging into the Connect interface after each Auth login.
+		  @param value Set true to log in automatically.
+		 */
+		void SetEnabled(bool value);
+
+		/**
+		  Determines if logging into the Connect interface after each Auth login is enabled.
+		  @return Returns true if enabled.
+		 */
+		bool IsEnabled() const;
+
+		/**
+		  Logs the given Epic account into the Connect interface using its Auth ID token.
+		  Does nothing if disabled or if the account is already logged in or logging in.
+		  A "connectLoginResponse" event is dispatched to Lua once the login completes.
+		  @param epicAccountId The Epic account logged in via the Auth interface.
+		 */
+		void Login(EOS_EpicAccountId epicAccountId);
+
+		/**
+		  Logs into the Connect interface anonymously with this device's ID, creating the device ID first
+		  unless the state file says it was already created. Replaces the current login, if any.
+		  A "connectLoginResponse" event is dispatched to Lua once the login completes.
+		  @param displayName Name shown for the guest by game services such as leaderboards.
+		                     Set to null or empty to use a default name.
+		  @return Returns true if the login was started or is already in progress.
+		          Returns false if the EOS platform has not been created.
+		 */
+		bool LoginWithDeviceId(const char* displayName);
+
+		/**
+		  Sets the path to the file recording that this device's ID has been created.
+		  @param path Path to the state file. Set to null or empty to always create the device ID first.
+		 */
+		void SetDeviceIdStatePath(const char* path);
+
+		/** To be called every frame. Retries logins that failed due to a transient error. */
+		void Update();
+
+		/** Unsubscribes from EOS notifications and drops the cached product user ID. */
+		void Shutdown();
+
+		/**
+		  Fetches the product user ID of the logged in user.
+		  @return Returns the product user ID. Returns null if not logged into the Connect interface.
+		 */
+		EOS_ProductUserId GetProductUserId() const;
+
+		/**
+		  Fetches the string form of the logged in user's product user ID.
+		  @return Returns the product user ID string. Returns an empty string if not logged in.
+		 */
+		const char* GetProductUserIdString() const;
+
+	private:
+		/** Copy constructor deleted to prevent it from being called. */
+		ConnectSession(const ConnectSession&) = delete;
+
+		/** Method deleted to prevent the copy operator from being used. */
+		void operator=(const ConnectSession&) = delete;
+
+		/** Passed as client data to EOS_Connect_Login() and EOS_Connect_CreateUser(). */
+		struct LoginRequest
+		{
+			ConnectSession* SessionPointer;
+			uint32_t Generation;
+
+			/** Set true if logging in again ahead of the last session's expiry. */
+			bool IsRefresh;
+		};
+
+		/**
+		  Starts an EOS_Connect_Login() with the Auth ID token of the Epic account being logged in,
+		  or with the device ID if logging in as a guest.
+		  @param isRefresh Set true if logging in again to extend an existing session.
+		 */
+		void StartLogin(bool isRefresh);
+
+		/**
+		  Sends the given login to EOS, unless the session was shut down or restarted since it was queued.
+		  @param requestPointer The login's request, passed to EOS as client data. Deleted if not sent.
+		  @param options The login's options.
+		 */
+		void SendLogin(LoginRequest* requestPointer, const EOS_Connect_LoginOptions& options);
+
+		/**
+		  Caches the result of a login and dispatches it to Lua.
+		  @param request The login's request.
+		  @param resultCode The login's result.
+		  @param productUserId The logged in product user. Null if the login failed.
+		 */
+		void OnLoginEnded(const LoginRequest& request, EOS_EResult resultCode, EOS_ProductUserId productUserId);
+
+		/** Starts an EOS_Connect_CreateDeviceId() to be followed by a device ID login. */
+		void CreateDeviceId();
+
+		/** Subscribes to the Connect interface's auth expiration and login status notifications, if not done yet. */
+		void Subscribe();
+
+		static void EOS_CALL OnLoginResponse(const EOS_Connect_LoginCallbackInfo* Data);
+		static void EOS_CALL OnCreateUserResponse(const EOS_Connect_CreateUserCallbackInfo* Data);
+		static void EOS_CALL OnCreateDeviceIdResponse(const EOS_Connect_CreateDeviceIdCallbackInfo* Data);
+		static void EOS_CALL OnAuthExpiration(const EOS_Connect_AuthExpirationCallbackInfo* Data);
+		static void EOS_CALL OnLoginStatusChanged(const EOS_Connect_LoginStatusChangedCallbackInfo* Data);
+
+		RuntimeContext* fContextPointer;
+		bool fIsEnabled;
+		EOS_HConnect fConnectHandle;
+		EOS_NotificationId fAuthExpirationNotificationId;
+		EOS_NotificationId fLoginStatusChangedNotificationId;
+
+		/** The Epic account being logged into the Connect interface. Null if logging in as a guest. */
+		EOS_EpicAccountId fEpicAccountId;
+
+		/** Set true if logging in anonymously with this device's ID instead of an Epic account. */
+		bool fIsDeviceIdLogin;
+
+		/** Display name given to LoginWithDeviceId(). */
+		std::string fDisplayName;
+
+		/** Path to the file recording that this device's ID has been created. Empty if not set. */
+		std::string fDeviceIdStatePath;
+
+		/** Set true once the device ID was created again because EOS no longer knew the recorded one. */
+		bool fHasRecreatedDeviceId;
+
+		/** The logged in product user. Null if not logged in. */
+		EOS_ProductUserId fProductUserId;
+
+		/** String form of "fProductUserId". Empty if not logged in. */
+		char fProductUserIdString[EOS_PRODUCTUSERID_MAX_LENGTH + 1];
+
+		/** Set true while an EOS_Connect_Login() or EOS_Connect_CreateUser() is in flight. */
+		bool fIsLoginInFlight;
+
+		/** Set true if a login failed with a transient error and must be retried at "fRetryTime". */
+		bool fIsRetryPending;
+		std::chrono::steady_clock::time_point fRetryTime;
+
+		/** Incremented when the Epic account changes so that logins started before then are ignored. */
+		uint32_t fGeneration;
+};
@@ -0,0 +1,787 @@
+// ----------------------------------------------------------------------------
+//
+// DedicatedServer.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#include "DedicatedServer.h"
+#include "DispatchEventTask.h"
+#include "RuntimeContext.h"
+#include "eos_anticheatserver.h"
+#include "eos_sanctions.h"
+#include "eos_sessions.h"
+#include "eos_stats.h"
+#include <algorithm>
+#include <memory>
+#include <unordered_set>
+
+
+/** Stores a collection of all DedicatedServer instances that currently exist in the application. */
+static std::unordered_set<DedicatedServer*> sDedicatedServerCollection;
+
+/** How often the queued session registrations and unregistrations are sent. */
+static const std::chrono::milliseconds kSessionFlushInterval(250);
+
+/** How often the summed stat ingests are sent. */
+static const std::chrono::seconds kStatsFlushInterval(5);
+
+
+DedicatedServer::DedicatedServer(RuntimeContext* contextPointer)
+:	fContextPointer(contextPointer),
+	fIsEnabled(false),
+	fPendingRegistrationCount(0),
+	fSessionFlushTime(std::chrono::steady_clock::now()),
+	fStatsFlushTime(std::chrono::steady_clock::now()),
+	fAntiCheatHandle(nullptr),
+	fMessageToClientNotificationId(EOS_INVALID_NOTIFICATIONID),
+	fClientActionRequiredNotificationId(EOS_INVALID_NOTIFICATIONID),
+	fIsAntiCheatSessionActive(false)
+{
+	// Add this class instance to the global collection.
+	sDedicatedServerCollection.insert(this);
+}
+
+DedicatedServer::~DedicatedServer()
+{
+	// Remove this class instance from the global collection.
+	// Note: In-flight request callbacks check this collection and will do nothing once it is removed.
+	sDedicatedServerCollection.erase(this);
+}
+
+void DedicatedServer::SetEnabled(bool value)
+{
+	fIsEnabled = value;
+}
+
+bool DedicatedServer::IsEnabled() const
+{
+	return fIsEnabled;
+}
+
+bool DedicatedServer::AddPlayer(const char* productUserId, const char* sessionName, const char* ipAddress)
+{
+	// Validate.
+	if (!fIsEnabled || !fContextPointer->fPlatformHandle)
+	{
+		return false;
+	}
+
+	// Fetch the player, doing nothing more if already tracked.
+	size_t lastPlayerCount = fPlayers.GetCount();
+	auto playerPointer = fPlayers.Add(productUserId);
+	if (!playerPointer)
+	{
+		return false;
+	}
+	if (fPlayers.GetCount() == lastPlayerCount)
+	{
+		return true;
+	}
+	playerPointer->SessionName = sessionName ? sessionName : "";
+	playerPointer->IpAddress = ipAddress ? ipAddress : "";
+
+	// Queue the player to be registered with their session along with the other players who joined meanwhile.
+	if (!playerPointer->SessionName.empty())
+	{
+		playerPointer->Flags |= ServerPlayerTable::kIsSessionRegistrationPending;
+		fPendingRegistrationCount++;
+	}
+
+	// Check for active sanctions, such as bans, and start protecting the player if an anti-cheat session is running.
+	SubmitSanctionsRequest(SanctionsRequest{ this, playerPointer->ProductUserId, 1 });
+	RegisterWithAntiCheat(*playerPointer);
+	return true;
+}
+
+bool DedicatedServer::RemovePlayer(const char* productUserId)
+{
+	auto playerPointer = fPlayers.FindBy(productUserId);
+	if (!playerPointer)
+	{
+		return false;
+	}
+
+	// Send the player's stats before their state is dropped.
+	FlushStatsOf(*playerPointer);
+
+	// Stop protecting the player.
+	if (fAntiCheatHandle && (playerPointer->Flags & ServerPlayerTable::kIsRegisteredWithAntiCheat))
+	{
+		EOS_AntiCheatServer_UnregisterClientOptions options{ 0 };
+		options.ApiVersion = EOS_ANTICHEATSERVER_UNREGISTERCLIENT_API_LATEST;
+		options.ClientHandle = (EOS_AntiCheatCommon_ClientHandle)playerPointer->ProductUserId;
+		EOS_AntiCheatServer_UnregisterClient(fAntiCheatHandle, &options);
+	}
+
+	// Unregister the player from their session with the next batch, or drop their pending registration.
+	if (playerPointer->Flags & ServerPlayerTable::kIsRegisteredWithSession)
+	{
+		fPendingUnregistrations[playerPointer->SessionName].push_back(playerPointer->ProductUserId);
+	}
+	if (playerPointer->Flags & ServerPlayerTable::kIsSessionRegistrationPending)
+	{
+		fPendingRegistrationCount--;
+	}
+
+	fPlayers.Remove(productUserId);
+	return true;
+}
+
+bool DedicatedServer::IngestStat(const char* productUserId, const char* statName, int32_t amount)
+{
+	// Validate.
+	if (!statName || ('\0' == statName[0]))
+	{
+		return false;
+	}
+	auto playerPointer = fPlayers.FindBy(productUserId);
+	if (!playerPointer)
+	{
+		return false;
+	}
+
+	// Add the amount to the stat's pending ingest, if any, so that frequent updates cost a single request.
+	for (auto&& pendingStat : playerPointer->PendingStats)
+	{
+		if (pendingStat.StatName == statName)
+		{
+			pendingStat.Amount += amount;
+			return true;
+		}
+	}
+	playerPointer->PendingStats.push_back(ServerPlayerTable::PendingStat{ std::string(statName), amount });
+	return true;
+}
+
+bool DedicatedServer::BeginAntiCheatSession(const char* serverName, uint32_t registerTimeout)
+{
+	// Validate.
+	if (!fIsEnabled || !fContextPointer->fPlatformHandle)
+	{
+		return false;
+	}
+	if (fIsAntiCheatSessionActive)
+	{
+		return true;
+	}
+
+	// Begin the session, subscribing first so that no message to a client is missed.
+	fAntiCheatHandle = EOS_Platform_GetAntiCheatServerInterface(fContextPointer->fPlatformHandle);
+	if (!fAntiCheatHandle)
+	{
+		return false;
+	}
+	SubscribeToAntiCheat();
+	EOS_AntiCheatServer_BeginSessionOptions options{ 0 };
+	options.ApiVersion = EOS_ANTICHEATSERVER_BEGINSESSION_API_LATEST;
+	options.RegisterTimeoutSeconds = std::min(
+			std::max(registerTimeout, (uint32_t)EOS_ANTICHEATSERVER_BEGINSESSION_MIN_REGISTERTIMEOUT),
+			(uint32_t)EOS_ANTICHEATSERVER_BEGINSESSION_MAX_REGISTERTIMEOUT);
+	options.ServerName = (serverName && serverName[0]) ? serverName : nullptr;
+	options.bEnableGameplayData = EOS_FALSE;
+	options.LocalUserId = nullptr;
+	if (EOS_AntiCheatServer_BeginSession(fAntiCheatHandle, &options) != EOS_EResult::EOS_Success)
+	{
+		UnsubscribeFromAntiCheat();
+		return false;
+	}
+	fIsAntiCheatSessionActive = true;
+
+	// Protect the players who joined before the session began.
+	for (size_t index = 0; index < fPlayers.GetCount(); index++)
+	{
+		RegisterWithAntiCheat(fPlayers.GetAt(index));
+	}
+	return true;
+}
+
+void DedicatedServer::EndAntiCheatSession()
+{
+	if (!fIsAntiCheatSessionActive)
+	{
+		return;
+	}
+	fIsAntiCheatSessionActive = false;
+
+	// Unregister every player, then end the session.
+	for (size_t index = 0; index < fPlayers.GetCount(); index++)
+	{
+		auto& player = fPlayers.GetAt(index);
+		if (player.Flags & ServerPlayerTable::kIsRegisteredWithAntiCheat)
+		{
+			EOS_AntiCheatServer_UnregisterClientOptions options{ 0 };
+			options.ApiVersion = EOS_ANTICHEATSERVER_UNREGISTERCLIENT_API_LATEST;
+			options.ClientHandle = (EOS_AntiCheatCommon_ClientHandle)player.ProductUserId;
+			EOS_AntiCheatServer_UnregisterClient(fAntiCheatHandle, &options);
+			player.Flags &= ~ServerPlayerTable::kIsRegisteredWithAntiCheat;
+		}
+	}
+	EOS_AntiCheatServer_EndSessionOptions options{ 0 };
+	options.ApiVersion = EOS_ANTICHEATSERVER_ENDSESSION_API_LATEST;
+	EOS_AntiCheatServer_EndSession(fAntiCheatHandle, &options);
+	UnsubscribeFromAntiCheat();
+}
+
+bool DedicatedServer::ReceiveAntiCheatMessage(const char* productUserId, const void* data, uint32_t byteCount)
+{
+	// Validate.
+	if (!fIsAntiCheatSessionActive || !data || (byteCount < 1))
+	{
+		return false;
+	}
+	auto playerPointer = fPlayers.FindBy(productUserId);
+	if (!playerPointer || !(playerPointer->Flags & ServerPlayerTable::kIsRegisteredWithAntiCheat))
+	{
+		return false;
+	}
+
+	// Pass the message to EOS.
+	EOS_AntiCheatServer_ReceiveMessageFromClientOptions options{ 0 };
+	options.ApiVersion = EOS_ANTICHEATSERVER_RECEIVEMESSAGEFROMCLIENT_API_LATEST;
+	options.ClientHandle = (EOS_AntiCheatCommon_ClientHandle)playerPointer->ProductUserId;
+	options.DataLengthBytes = byteCount;
+	options.Data = data;
+	return (EOS_AntiCheatServer_ReceiveMessageFromClient(fAntiCheatHandle, &options) == EOS_EResult::EOS_Success);
+}
+
+ServerPlayerTable& DedicatedServer::GetPlayers()
+{
+	return fPlayers;
+}
+
+void DedicatedServer::Update()
+{
+	if (!fIsEnabled)
+	{
+		return;
+	}
+
+	// Send the batches that are due.
+	auto currentTime = std::chrono::steady_clock::now();
+	if (currentTime >= fSessionFlushTime)
+	{
+		fSessionFlushTime = currentTime + kSessionFlushInterval;
+		FlushSessionBatches();
+	}
+	if (currentTime >= fStatsFlushTime)
+	{
+		fStatsFlushTime = currentTime + kStatsFlushInterval;
+		for (size_t index = 0; index < fPlayers.GetCount(); index++)
+		{
+			FlushStatsOf(fPlayers.GetAt(index));
+		}
+	}
+}
+
+void DedicatedServer::Shutdown()
+{
+	EndAntiCheatSession();
+	UnsubscribeFromAntiCheat();
+	fAntiCheatHandle = nullptr;
+	fPlayers.Clear();
+	fPendingUnregistrations.clear();
+	fPendingRegistrationCount = 0;
+}
+
+void DedicatedServer::FlushSessionBatches()
+{
+	// Group the players waiting to be registered by session.
+	if (fPendingRegistrationCount > 0)
+	{
+		std::unordered_map<std::string, std::vector<EOS_ProductUserId>> registrations;
+		for (size_t index = 0; index < fPlayers.GetCount(); index++)
+		{
+			auto& player = fPlayers.GetAt(index);
+			if (player.Flags & ServerPlayerTable::kIsSessionRegistrationPending)
+			{
+				player.Flags &= ~ServerPlayerTable::kIsSessionRegistrationPending;
+				registrations[player.SessionName].push_back(player.ProductUserId);
+			}
+		}
+		fPendingRegistrationCount = 0;
+		for (auto&& registration : registrations)
+		{
+			SubmitSessionRequest(SessionRequest{ this, false, registration.first, registration.second, 1 });
+		}
+	}
+
+	// Send the unregistrations of the players who left.
+	for (auto&& unregistration : fPendingUnregistrations)
+	{
+		SubmitSessionRequest(SessionRequest{ this, true, unregistration.first, unregistration.second, 1 });
+	}
+	fPendingUnregistrations.clear();
+}
+
+void DedicatedServer::FlushStatsOf(ServerPlayerTable::Player& player)
+{
+	auto& pendingStats = player.PendingStats;
+	for (size_t startIndex = 0; startIndex < pendingStats.size(); startIndex += EOS_STATS_MAX_INGEST_STATS)
+	{
+		size_t endIndex = std::min(pendingStats.size(), startIndex + (size_t)EOS_STATS_MAX_INGEST_STATS);
+		IngestRequest request{ this, player.ProductUserId, {}, 1 };
+		request.Stats.assign(pendingStats.begin() + startIndex, pendingStats.begin() + endIndex);
+		SubmitIngestRequest(request);
+	}
+	pendingStats.clear();
+}
+
+void DedicatedServer::RegisterWithAntiCheat(ServerPlayerTable::Player& player)
+{
+	if (!fIsAntiCheatSessionActive || (player.Flags & ServerPlayerTable::kIsRegisteredWithAntiCheat))
+	{
+		return;
+	}
+
+	// The product user ID doubles as the client handle, since it is unique per player and never changes.
+	EOS_AntiCheatServer_RegisterClientOptions options{ 0 };
+	options.ApiVersion = EOS_ANTICHEATSERVER_REGISTERCLIENT_API_LATEST;
+	options.ClientHandle = (EOS_AntiCheatCommon_ClientHandle)player.ProductUserId;
+	options.ClientType = EOS_EAntiCheatCommonClientType::EOS_ACCCT_ProtectedClient;
+	options.ClientPlatform = EOS_EAntiCheatCommonClientPlatform::EOS_ACCCP_Unknown;
+	options.AccountId_DEPRECATED = nullptr;
+	options.IpAddress = player.IpAddress.empty() ? nullptr : player.IpAddress.c_str();
+	options.UserId = player.ProductUserId;
+	if (EOS_AntiCheatServer_RegisterClient(fAntiCheatHandle, &options) == EOS_EResult::EOS_Success)
+	{
+		player.Flags |= ServerPlayerTable::kIsRegisteredWithAntiCheat;
+	}
+}
+
+void DedicatedServer::SubmitSessionRequest(const SessionRequest& request)
+{
+	fContextPointer->GetRequestScheduler().Submit(RequestScheduler::Interface::kSessions, [this, request]() {
+		SendSessionRequest(request);
+	});
+}
+
+void DedicatedServer::SendSessionRequest(const SessionRequest& request)
+{
+	if (!fContextPointer->fPlatformHandle || request.Players.empty())
+	{
+		return;
+	}
+
+	EOS_HSessions sessionsHandle = EOS_Platform_GetSessionsInterface(fContextPointer->fPlatformHandle);
+	auto requestPointer = new SessionRequest(request);
+	if (request.IsUnregistering)
+	{
+		EOS_Sessions_UnregisterPlayersOptions options{ 0 };
+		options.ApiVersion = EOS_SESSIONS_UNREGISTERPLAYERS_API_LATEST;
+		options.SessionName = requestPointer->SessionName.c_str();
+		options.PlayersToUnregister = requestPointer->Players.data();
+		options.PlayersToUnregisterCount = (uint32_t)requestPointer->Players.size();
+		EOS_Sessions_UnregisterPlayers(sessionsHandle, &options, requestPointer, &DedicatedServer::OnUnregisterPlayersResponse);
+	}
+	else
+	{
+		EOS_Sessions_RegisterPlayersOptions options{ 0 };
+		options.ApiVersion = EOS_SESSIONS_REGISTERPLAYERS_API_LATEST;
+		options.SessionName = requestPointer->SessionName.c_str();
+		options.PlayersToRegister = requestPointer->Players.data();
+		options.PlayersToRegisterCount = (uint32_t)requestPointer->Players.size();
+		EOS_Sessions_RegisterPlayers(sessionsHandle, &options, requestPointer, &DedicatedServer::OnRegisterPlayersResponse);
+	}
+}
+
+void DedicatedServer::SubmitIngestRequest(const IngestRequest& request)
+{
+	fContextPointer->GetRequestScheduler().Submit(RequestScheduler::Interface::kStats, [this, request]() {
+		SendIngestRequest(request);
+	});
+}
+
+void DedicatedServer::SendIngestRequest(const IngestRequest& request)
+{
+	if (!fContextPointer->fPlatformHandle || request.Stats.empty())
+	{
+		return;
+	}
+
+	std::vector<EOS_Stats_IngestData> ingestData;
+	ingestData.reserve(request.Stats.size());
+	auto requestPointer = new IngestRequest(request);
+	for (auto&& stat : requestPointer->Stats)
+	{
+		EOS_Stats_IngestData data{ 0 };
+		data.ApiVersion = EOS_STATS_INGESTDATA_API_LATEST;
+		data.StatName = stat.StatName.c_str();
+		data.IngestAmount = stat.Amount;
+		ingestData.push_back(data);
+	}
+
+	EOS_Stats_IngestStatOptions options{ 0 };
+	options.ApiVersion = EOS_STATS_INGESTSTAT_API_LATEST;
+	options.LocalUserId = nullptr;
+	options.Stats = ingestData.data();
+	options.StatsCount = (uint32_t)ingestData.size();
+	options.TargetUserId = requestPointer->Player;
+	EOS_Stats_IngestStat(
+			EOS_Platform_GetStatsInterface(fContextPointer->fPlatformHandle), &options, requestPointer,
+			&DedicatedServer::OnIngestStatResponse);
+}
+
+void DedicatedServer::SubmitSanctionsRequest(const SanctionsRequest& request)
+{
+	fContextPointer->GetRequestScheduler().Submit(RequestScheduler::Interface::kSanctions, [this, request]() {
+		SendSanctionsRequest(request);
+	});
+}
+
+void DedicatedServer::SendSanctionsRequest(const SanctionsRequest& request)
+{
+	if (!fContextPointer->fPlatformHandle)
+	{
+		return;
+	}
+
+	EOS_Sanctions_QueryActivePlayerSanctionsOptions options{ 0 };
+	options.ApiVersion = EOS_SANCTIONS_QUERYACTIVEPLAYERSANCTIONS_API_LATEST;
+	options.TargetUserId = request.Player;
+	options.LocalUserId = nullptr;
+	EOS_Sanctions_QueryActivePlayerSanctions(
+			EOS_Platform_GetSanctionsInterface(fContextPointer->fPlatformHandle), &options,
+			new SanctionsRequest(request), &DedicatedServer::OnQuerySanctionsResponse);
+}
+
+void DedicatedServer::SubscribeToAntiCheat()
+{
+	if (!fAntiCheatHandle)
+	{
+		return;
+	}
+	if (EOS_INVALID_NOTIFICATIONID == fMessageToClientNotificationId)
+	{
+		EOS_AntiCheatServer_AddNotifyMessageToClientOptions options{ 0 };
+		options.ApiVersion = EOS_ANTICHEATSERVER_ADDNOTIFYMESSAGETOCLIENT_API_LATEST;
+		fMessageToClientNotificationId = EOS_AntiCheatServer_AddNotifyMessageToClient(
+				fAntiCheatHandle, &options, this, &DedicatedServer::OnAntiCheatMessageToClient);
+	}
+	if (EOS_INVALID_NOTIFICATIONID == fClientActionRequiredNotificationId)
+	{
+		EOS_AntiCheatServer_AddNotifyClientActionRequiredOptions options{ 0 };
+		options.ApiVersion = EOS_ANTICHEATSERVER_ADDNOTIFYCLIENTACTIONREQUIRED_API_LATEST;
+		fClientActionRequiredNotificationId = EOS_AntiCheatServer_AddNotifyClientActionRequired(
+				fAntiCheatHandle, &options, this, &DedicatedServer::OnAntiCheatClientActionRequired);
+	}
+}
+
+void DedicatedServer::UnsubscribeFromAntiCheat()
+{
+	if (fAntiCheatHandle)
+	{
+		if (fMessageToClientNotificationId != EOS_INVALID_NOTIFICATIONID)
+		{
+			EOS_AntiCheatServer_RemoveNotifyMessageToClient(fAntiCheatHandle, fMessageToClientNotificationId);
+		}
+		if (fClientActionRequiredNotificationId != EOS_INVALID_NOTIFICATIONID)
+		{
+			EOS_AntiCheatServer_RemoveNotifyClientActionRequired(fAntiCheatHandle, fClientActionRequiredNotificationId);
+		}
+	}
+	fMessageToClientNotificationId = EOS_INVALID_NOTIFICATIONID;
+	fClientActionRequiredNotificationId = EOS_INVALID_NOTIFICATIONID;
+}
+
+std::string DedicatedServer::ToString(EOS_ProductUserId productUserId)
+{
+	char stringBuffer[EOS_PRODUCTUSERID_MAX_LENGTH + 1];
+	int32_t stringLength = (int32_t)sizeof(stringBuffer);
+	if (!productUserId || (EOS_ProductUserId_ToString(productUserId, stringBuffer, &stringLength) != EOS_EResult::EOS_Success))
+	{
+		return std::string();
+	}
+	return std::string(stringBuffer);
+}
+
+void EOS_CALL DedicatedServer::OnRegisterPlayersResponse(const EOS_Sessions_RegisterPlayersCallbackInfo* Data)
+{
+	if (!Data || !EOS_EResult_IsOperationComplete(Data->ResultCode))
+	{
+		return;
+	}
+	std::unique_ptr<SessionRequest> requestPointer((SessionRequest*)Data->ClientData);
+	if (!requestPointer || (sDedicatedServerCollection.find(requestPointer->ServerPointer) == sDedicatedServerCollection.end()))
+	{
+		return;
+	}
+	auto serverPointer = requestPointer->ServerPointer;
+
+	// Register the batch again later if EOS was busy or unreachable.
+	SessionRequest retryRequest = *requestPointer;
+	retryRequest.AttemptCount++;
+	bool wasRetried = serverPointer->fContextPointer->GetRequestScheduler().ScheduleRetry(
+			RequestScheduler::Interface::kSessions, Data->ResultCode, requestPointer->AttemptCount,
+			[serverPointer, retryRequest]() {
+				serverPointer->SendSessionRequest(retryRequest);
+			});
+	if (wasRetried)
+	{
+		return;
+	}
+
+	// Flag the registered and sanctioned players.
+	// Players who left while the request was in flight are queued to be unregistered again.
+	std::vector<std::string> registeredPlayers;
+	std::vector<std::string> sanctionedPlayers;
+	if (Data->ResultCode == EOS_EResult::EOS_Success)
+	{
+		for (uint32_t index = 0; index < Data->RegisteredPlayersCount; index++)
+		{
+			EOS_ProductUserId productUserId = Data->RegisteredPlayers[index];
+			auto playerPointer = serverPointer->fPlayers.FindBy(productUserId);
+			if (playerPointer)
+			{
+				playerPointer->Flags |= ServerPlayerTable::kIsRegisteredWithSession;
+			}
+			else
+			{
+				serverPointer->fPendingUnregistrations[requestPointer->SessionName].push_back(productUserId);
+			}
+			registeredPlayers.push_back(ToString(productUserId));
+		}
+		for (uint32_t index = 0; index < Data->SanctionedPlayersCount; index++)
+		{
+			auto playerPointer = serverPointer->fPlayers.FindBy(Data->SanctionedPlayers[index]);
+			if (playerPointer)
+			{
+				playerPointer->Flags |= ServerPlayerTable::kIsSanctioned;
+			}
+			sanctionedPlayers.push_back(ToString(Data->SanctionedPlayers[index]));
+		}
+	}
+	else
+	{
+		for (auto&& productUserId : requestPointer->Players)
+		{
+			registeredPlayers.push_back(ToString(productUserId));
+		}
+	}
+
+	// Dispatch the result to Lua.
+	auto taskPointer = new DispatchSessionPlayersEventTask();
+	taskPointer->SetLuaEventDispatcher(serverPointer->fContextPointer->GetLuaEventDispatcher());
+	taskPointer->AcquireEventDataFrom(
+			false, requestPointer->SessionName, Data->ResultCode, registeredPlayers, sanctionedPlayers);
+	serverPointer->fContextPointer->QueueDispatchEventTask(std::shared_ptr<BaseDispatchEventTask>(taskPointer));
+}
+
+void EOS_CALL DedicatedServer::OnUnregisterPlayersResponse(const EOS_Sessions_UnregisterPlayersCallbackInfo* Data)
+{
+	if (!Data || !EOS_EResult_IsOperationComplete(Data->ResultCode))
+	{
+		return;
+	}
+	std::unique_ptr<SessionRequest> requestPointer((SessionRequest*)Data->ClientData);
+	if (!requestPointer || (sDedicatedServerCollection.find(requestPointer->ServerPointer) == sDedicatedServerCollection.end()))
+	{
+		return;
+	}
+	auto serverPointer = requestPointer->ServerPointer;
+
+	// Unregister the batch again later if EOS was busy or unreachable.
+	SessionRequest retryRequest = *requestPointer;
+	retryRequest.AttemptCount++;
+	bool wasRetried = serverPointer->fContextPointer->GetRequestScheduler().ScheduleRetry(
+			RequestScheduler::Interface::kSessions, Data->ResultCode, requestPointer->AttemptCount,
+			[serverPointer, retryRequest]() {
+				serverPointer->SendSessionRequest(retryRequest);
+			});
+	if (wasRetried)
+	{
+		return;
+	}
+
+	// Dispatch the result to Lua.
+	std::vector<std::string> unregisteredPlayers;
+	if (Data->ResultCode == EOS_EResult::EOS_Success)
+	{
+		for (uint32_t index = 0; index < Data->UnregisteredPlayersCount; index++)
+		{
+			unregisteredPlayers.push_back(ToString(Data->UnregisteredPlayers[index]));
+		}
+	}
+	else
+	{
+		for (auto&& productUserId : requestPointer->Players)
+		{
+			unregisteredPlayers.push_back(ToString(productUserId));
+		}
+	}
+	auto taskPointer = new DispatchSessionPlayersEventTask();
+	taskPointer->SetLuaEventDispatcher(serverPointer->fContextPointer->GetLuaEventDispatcher());
+	taskPointer->AcquireEventDataFrom(
+			true, requestPointer->SessionName, Data->ResultCode, unregisteredPlayers, std::vector<std::string>());
+	serverPointer->fContextPointer->QueueDispatchEventTask(std::shared_ptr<BaseDispatchEventTask>(taskPointer));
+}
+
+void EOS_CALL DedicatedServer::OnIngestStatResponse(const EOS_Stats_IngestStatCompleteCallbackInfo* Data)
+{
+	if (!Data || !EOS_EResult_IsOperationComplete(Data->ResultCode))
+	{
+		return;
+	}
+	std::unique_ptr<IngestRequest> requestPointer((IngestRequest*)Data->ClientData);
+	if (!requestPointer || (sDedicatedServerCollection.find(requestPointer->ServerPointer) == sDedicatedServerCollection.end()))
+	{
+		return;
+	}
+	auto serverPointer = requestPointer->ServerPointer;
+
+	// Ingest the stats again later only if EOS throttled the request, since ingesting adds to the stats.
+	// Note: A timed out or failed ingest may have been applied, so retrying it could count the stats twice.
+	bool wasRetried = false;
+	if (Data->ResultCode == EOS_EResult::EOS_TooManyRequests)
+	{
+		IngestRequest retryRequest = *requestPointer;
+		retryRequest.AttemptCount++;
+		wasRetried = serverPointer->fContextPointer->GetRequestScheduler().ScheduleRetry(
+				RequestScheduler::Interface::kStats, Data->ResultCode, requestPointer->AttemptCount,
+				[serverPointer, retryRequest]() {
+					serverPointer->SendIngestRequest(retryRequest);
+				});
+	}
+	if (wasRetried || (Data->ResultCode == EOS_EResult::EOS_Success))
+	{
+		return;
+	}
+
+	// Only failures are dispatched to Lua, since a server ingests stats for every player every few seconds.
+	std::vector<std::string> statNames;
+	for (auto&& stat : requestPointer->Stats)
+	{
+		statNames.push_back(stat.StatName);
+	}
+	auto taskPointer = new DispatchIngestStatEventTask();
+	taskPointer->SetLuaEventDispatcher(serverPointer->fContextPointer->GetLuaEventDispatcher());
+	taskPointer->AcquireEventDataFrom(ToString(requestPointer->Player).c_str(), Data->ResultCode, statNames);
+	serverPointer->fContextPointer->QueueDispatchEventTask(std::shared_ptr<BaseDispatchEventTask>(taskPointer));
+}
+
+void EOS_CALL DedicatedServer::OnQuerySanctionsResponse(const EOS_Sanctions_QueryActivePlayerSanctionsCallbackInfo* Data)
+{
+	if (!Data || !EOS_EResult_IsOperationComplete(Data->ResultCode))
+	{
+		return;
+	}
+	std::unique_ptr<SanctionsRequest> requestPointer((SanctionsRequest*)Data->ClientData);
+	if (!requestPointer || (sDedicatedServerCollection.find(requestPointer->ServerPointer) == sDedicatedServerCollection.end()))
+	{
+		return;
+	}
+	auto serverPointer = requestPointer->ServerPointer;
+
+	// Query the sanctions again later if EOS was busy or unreachable.
+	SanctionsRequest retryRequest = *requestPointer;
+	retryRequest.AttemptCount++;
+	bool wasRetried = serverPointer->fContextPointer->GetRequestScheduler().ScheduleRetry(
+			RequestScheduler::Interface::kSanctions, Data->ResultCode, requestPointer->AttemptCount,
+			[serverPointer, retryRequest]() {
+				serverPointer->SendSanctionsRequest(retryRequest);
+			});
+	if (wasRetried)
+	{
+		return;
+	}
+
+	// Ignore the result if the player has left since.
+	auto playerPointer = serverPointer->fPlayers.FindBy(requestPointer->Player);
+	if (!playerPointer)
+	{
+		return;
+	}
+
+	// Copy the player's active sanctions out of the EOS cache.
+	std::vector<DispatchPlayerSanctionsEventTask::Sanction> sanctions;
+	if (Data->ResultCode == EOS_EResult::EOS_Success)
+	{
+		EOS_HSanctions sanctionsHandle = EOS_Platform_GetSanctionsInterface(serverPointer->fContextPointer->fPlatformHandle);
+		EOS_Sanctions_GetPlayerSanctionCountOptions countOptions{ 0 };
+		countOptions.ApiVersion = EOS_SANCTIONS_GETPLAYERSANCTIONCOUNT_API_LATEST;
+		countOptions.TargetUserId = requestPointer->Player;
+		uint32_t sanctionCount = EOS_Sanctions_GetPlayerSanctionCount(sanctionsHandle, &countOptions);
+		for (uint32_t index = 0; index < sanctionCount; index++)
+		{
+			EOS_Sanctions_CopyPlayerSanctionByIndexOptions copyOptions{ 0 };
+			copyOptions.ApiVersion = EOS_SANCTIONS_COPYPLAYERSANCTIONBYINDEX_API_LATEST;
+			copyOptions.TargetUserId = requestPointer->Player;
+			copyOptions.SanctionIndex = index;
+			EOS_Sanctions_PlayerSanction* sanctionPointer = nullptr;
+			if (EOS_Sanctions_CopyPlayerSanctionByIndex(sanctionsHandle, &copyOptions, &sanctionPointer) != EOS_EResult::EOS_Success)
+			{
+				continue;
+			}
+			DispatchPlayerSanctionsEventTask::Sanction sanction;
+			sanction.Action = sanctionPointer->Action ? sanctionPointer->Action : "";
+			sanction.ReferenceId = sanctionPointer->ReferenceId ? sanctionPointer->ReferenceId : "";
+			sanction.TimePlaced = sanctionPointer->TimePlaced;
+			sanction.TimeExpires = sanctionPointer->TimeExpires;
+			sanctions.push_back(sanction);
+			EOS_Sanctions_PlayerSanction_Release(sanctionPointer);
+		}
+		playerPointer->Flags |= ServerPlayerTable::kHasQueriedSanctions;
+		if (sanctions.empty())
+		{
+			playerPointer->Flags &= ~ServerPlayerTable::kIsSanctioned;
+		}
+		else
+		{
+			playerPointer->Flags |= ServerPlayerTable::kIsSanctioned;
+		}
+	}
+
+	// Dispatch the result to Lua, which decides whether to remove the player.
+	auto taskPointer = new DispatchPlayerSanctionsEventTask();
+	taskPointer->SetLuaEventDispatcher(serverPointer->fContextPointer->GetLuaEventDispatcher());
+	taskPointer->AcquireEventDataFrom(playerPointer->ProductUserIdString, Data->ResultCode, sanctions);
+	serverPointer->fContextPointer->QueueDispatchEventTask(std::shared_ptr<BaseDispatchEventTask>(taskPointer));
+}
+
+void EOS_CALL DedicatedServer::OnAntiCheatMessageToClient(const EOS_AntiCheatCommon_OnMessageToClientCallbackInfo* Data)
+{
+	if (!Data)
+	{
+		return;
+	}
+	auto serverPointer = (DedicatedServer*)Data->ClientData;
+	if (sDedicatedServerCollection.find(serverPointer) == sDedicatedServerCollection.end())
+	{
+		return;
+	}
+	auto playerPointer = serverPointer->fPlayers.FindBy((EOS_ProductUserId)Data->ClientHandle);
+	if (!playerPointer)
+	{
+		return;
+	}
+
+	auto taskPointer = new DispatchAntiCheatMessageEventTask();
+	taskPointer->SetLuaEventDispatcher(serverPointer->fContextPointer->GetLuaEventDispatcher());
+	taskPointer->AcquireEventDataFrom(playerPointer->ProductUserIdString, Data->MessageData, Data->MessageDataSizeBytes);
+	serverPointer->fContextPointer->QueueDispatchEventTask(std::shared_ptr<BaseDispatchEventTask>(taskPointer));
+}
+
+void EOS_CALL DedicatedServer::OnAntiCheatClientActionRequired(const EOS_AntiCheatCommon_OnClientActionRequiredCallbackInfo* Data)
+{
+	if (!Data)
+	{
+		return;
+	}
+	auto serverPointer = (DedicatedServer*)Data->ClientData;
+	if (sDedicatedServerCollection.find(serverPointer) == sDedicatedServerCollection.end())
+	{
+		return;
+	}
+	auto playerPointer = serverPointer->fPlayers.FindBy((EOS_ProductUserId)Data->ClientHandle);
+	if (!playerPointer)
+	{
+		return;
+	}
+
+	auto taskPointer = new DispatchAntiCheatActionEventTask();
+	taskPointer->SetLuaEventDispatcher(serverPointer->fContextPointer->GetLuaEventDispatcher());
+	taskPointer->AcquireEventDataFrom(playerPointer->ProductUserIdString, Data);
+	serverPointer->fContextPointer->QueueDispatchEventTask(std::shared_ptr<BaseDispatchEventTask>(taskPointer));
+}
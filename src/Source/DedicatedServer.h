@@ -0,0 +1,253 @@
+// ----------------------------------------------------------------------------
+//
+// DedicatedServer.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include "ServerPlayerTable.h"
+#include "eos_sdk.h"
+#include "eos_anticheatserver_types.h"
+#include "eos_sanctions_types.h"
+#include "eos_sessions_types.h"
+#include "eos_stats_types.h"
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Forward declarations.
+class RuntimeContext;
+
+
+/**
+  Performs the per-player EOS operations of a dedicated server, which runs on a platform created with
+  "bIsServer" set and its client credentials alone, without any user logged in.
+
+  Connected players are tracked by product user ID in a ServerPlayerTable. Adding a player queries their
+  active sanctions, registers them with the anti-cheat session if one is running, and queues them to be
+  registered with their game session. Session registrations and unregistrations are sent in batches per
+  session a few times per second, and stat ingests are summed per player and stat name and sent once per
+  flush interval, so that a server hosting hundreds of players makes a handful of requests per frame at
+  most. All requests are paced and retried via the runtime context's RequestScheduler.
+
+  Update() is expected to be called once per frame.
+ */
+class DedicatedServer
+{
+	public:
+		/**
+		  Creates a new disabled dedicated server.
+		  @param contextPointer The runtime context providing the platform and used to dispatch events. Cannot be null.
+		 */
+		DedicatedServer(RuntimeContext* contextPointer);
+
+		/** Stops handling in-flight requests. Shutdown() must be called before the EOS platform is released. */
+		virtual ~DedicatedServer();
+
+		/**
+		  Enables or disables the dedicated server APIs, as set by the "server" field in the "config.lua" file.
+		  @param value Set true if the platform was created as a server.
+		 */
+		void SetEnabled(bool value);
+
+		/**
+		  Determines if the dedicated server APIs are enabled.
+		  @return Returns true if enabled.
+		 */
+		bool IsEnabled() const;
+
+		/**
+		  Starts tracking the given player, querying their sanctions and registering them with the anti-cheat
+		  session, if running. Does nothing if the player is already tracked.
+		  @param productUserId String form of the player's product user ID.
+		  @param sessionName Name of the session to register the player with. Set to null or empty for none.
+		  @param ipAddress The player's IP address, passed to the anti-cheat interface. Set to null if not known.
+		  @return Returns true if the player is tracked. Returns false if disabled or given an invalid ID.
+		 */
+		bool AddPlayer(const char* productUserId, const char* sessionName, const char* ipAddress);
+
+		/**
+		  Stops tracking the given player, sending their pending stats, unregistering them from the anti-cheat
+		  session and queuing them to be unregistered from their session.
+		  @param productUserId String form of the player's product user ID.
+		  @return Returns true if the player was removed. Returns false if not tracked.
+		 */
+		bool RemovePlayer(const char* productUserId);
+
+		/**
+		  Adds the given amount to a stat of the given player, to be ingested with the next batch.
+		  @param productUserId String form of the player's product user ID.
+		  @param statName Name of the stat, as set up in the developer portal.
+		  @param amount The amount to ingest.
+		  @return Returns true if queued. Returns false if the player is not tracked or the stat name is empty.
+		 */
+		bool IngestStat(const char* productUserId, const char* statName, int32_t amount);
+
+		/**
+		  Begins an anti-cheat session and registers every tracked player with it.
+		  "antiCheatMessage" and "antiCheatAction" events are dispatched to Lua until the session ends.
+		  @param serverName Optional name of this server. Set to null for none.
+		  @param registerTimeout Seconds that newly registered clients have to authenticate.
+		  @return Returns true if the session began or was already running.
+		 */
+		bool BeginAntiCheatSession(const char* serverName, uint32_t registerTimeout);
+
+		/** Ends the anti-cheat session, if running. */
+		void EndAntiCheatSession();
+
+		/**
+		  Passes a message received from a player's anti-cheat client over the game's network to EOS.
+		  @param productUserId String form of the player's product user ID.
+		  @param data The message's bytes.
+		  @param byteCount Number of bytes in "data".
+		  @return Returns true if EOS accepted the message.
+		 */
+		bool ReceiveAntiCheatMessage(const char* productUserId, const void* data, uint32_t byteCount);
+
+		/**
+		  Fetches the tracked players.
+		  @return Returns a reference to the player table.
+		 */
+		ServerPlayerTable& GetPlayers();
+
+		/** To be called every frame. Sends the session registration and stat ingest batches that are due. */
+		void Update();
+
+		/** Ends the anti-cheat session, unsubscribes from EOS notifications and forgets every player. */
+		void Shutdown();
+
+	private:
+		/** Copy constructor deleted to prevent it from being called. */
+		DedicatedServer(const DedicatedServer&) = delete;
+
+		/** Method deleted to prevent the copy operator from being used. */
+		void operator=(const DedicatedServer&) = delete;
+
+		/** Passed as client data to EOS_Sessions_RegisterPlayers() and EOS_Sessions_UnregisterPlayers(). */
+		struct SessionRequest
+		{
+			DedicatedServer* ServerPointer;
+			bool IsUnregistering;
+			std::string SessionName;
+			std::vector<EOS_ProductUserId> Players;
+			int AttemptCount;
+		};
+
+		/** Passed as client data to EOS_Stats_IngestStat(). */
+		struct IngestRequest
+		{
+			DedicatedServer* ServerPointer;
+			EOS_ProductUserId Player;
+			std::vector<ServerPlayerTable::PendingStat> Stats;
+			int AttemptCount;
+		};
+
+		/** Passed as client data to EOS_Sanctions_QueryActivePlayerSanctions(). */
+		struct SanctionsRequest
+		{
+			DedicatedServer* ServerPointer;
+			EOS_ProductUserId Player;
+			int AttemptCount;
+		};
+
+		/** Sends the queued session registrations and unregistrations, 1 request per session and direction. */
+		void FlushSessionBatches();
+
+		/**
+		  Sends the given player's pending stats, in requests of up to EOS_STATS_MAX_INGEST_STATS stats.
+		  @param player The player whose stats to send. Their pending stats are cleared.
+		 */
+		void FlushStatsOf(ServerPlayerTable::Player& player);
+
+		/**
+		  Registers the given player with the anti-cheat session.
+		  @param player The player to register. Does nothing if already registered.
+		 */
+		void RegisterWithAntiCheat(ServerPlayerTable::Player& player);
+
+		/**
+		  Queues the given session request to be sent once the sessions interface's rate limit allows.
+		  @param request The request to send.
+		 */
+		void SubmitSessionRequest(const SessionRequest& request);
+
+		/**
+		  Sends the given session request to EOS, passing a copy of it as client data.
+		  @param request The request to send.
+		 */
+		void SendSessionRequest(const SessionRequest& request);
+
+		/**
+		  Queues the given ingest to be sent once the stats interface's rate limit allows.
+		  @param request The ingest to send.
+		 */
+		void SubmitIngestRequest(const IngestRequest& request);
+
+		/**
+		  Sends the given ingest to EOS, passing a copy of it as client data.
+		  @param request The ingest to send.
+		 */
+		void SendIngestRequest(const IngestRequest& request);
+
+		/**
+		  Queues the given sanctions query to be sent once the sanctions interface's rate limit allows.
+		  @param request The query to send.
+		 */
+		void SubmitSanctionsRequest(const SanctionsRequest& request);
+
+		/**
+		  Sends the given sanctions query to EOS, passing a copy of it as client data.
+		  @param request The query to send.
+		 */
+		void SendSanctionsRequest(const SanctionsRequest& request);
+
+		/** Subscribes to the anti-cheat interface's notifications, if not done yet. */
+		void SubscribeToAntiCheat();
+
+		/** Unsubscribes from the anti-cheat interface's notifications. */
+		void UnsubscribeFromAntiCheat();
+
+		/**
+		  Converts the given product user ID to a string.
+		  @param productUserId The ID to convert.
+		  @return Returns the ID's string form. Returns an empty string if invalid.
+		 */
+		static std::string ToString(EOS_ProductUserId productUserId);
+
+		static void EOS_CALL OnRegisterPlayersResponse(const EOS_Sessions_RegisterPlayersCallbackInfo* Data);
+		static void EOS_CALL OnUnregisterPlayersResponse(const EOS_Sessions_UnregisterPlayersCallbackInfo* Data);
+		static void EOS_CALL OnIngestStatResponse(const EOS_Stats_IngestStatCompleteCallbackInfo* Data);
+		static void EOS_CALL OnQuerySanctionsResponse(const EOS_Sanctions_QueryActivePlayerSanctionsCallbackInfo* Data);
+		static void EOS_CALL OnAntiCheatMessageToClient(const EOS_AntiCheatCommon_OnMessageToClientCallbackInfo* Data);
+		static void EOS_CALL OnAntiCheatClientActionRequired(const EOS_AntiCheatCommon_OnClientActionRequiredCallbackInfo* Data);
+
+		RuntimeContext* fContextPointer;
+		bool fIsEnabled;
+
+		/** The connected players and their per-player state. */
+		ServerPlayerTable fPlayers;
+
+		/**
+		  Players removed while registered with a session, keyed by session name, waiting to be unregistered.
+		  Product user IDs stay valid after a player is removed, since EOS keeps them until it shuts down.
+		 */
+		std::unordered_map<std::string, std::vector<EOS_ProductUserId>> fPendingUnregistrations;
+
+		/** Number of players flagged with kIsSessionRegistrationPending. */
+		size_t fPendingRegistrationCount;
+
+		/** Time at which the next session and stat batches are due. */
+		std::chrono::steady_clock::time_point fSessionFlushTime;
+		std::chrono::steady_clock::time_point fStatsFlushTime;
+
+		EOS_HAntiCheatServer fAntiCheatHandle;
+		EOS_NotificationId fMessageToClientNotificationId;
+		EOS_NotificationId fClientActionRequiredNotificationId;
+		bool fIsAntiCheatSessionActive;
+};
@@ -10,11 +10,10 @@
 #include "DispatchEventTask.h"
 #include "CoronaLua.h"
 #include "EosLuaInterface.h"
+#include "LuaOfferCatalog.h"
 #include "RuntimeContext.h"
-#include <sstream>
 #include <string>
 #include "eos_ecom.h"
-#include <iomanip>
 
 //---------------------------------------------------------------------------------
 // BaseDispatchEventTask Class Members
@@ -35,6 +34,11 @@ void BaseDispatchEventTask::SetLuaEventDispatcher(
     fLuaEventDispatcherPointer = dispatcherPointer;
 }
 
+bool BaseDispatchEventTask::CanBeDropped() const {
+    // Most events can be queried for again, so they may be dropped when too many are held while suspended.
+    return true;
+}
+
 bool BaseDispatchEventTask::Execute() {
     // Do not continue if not assigned a Lua event dispatcher.
     if (!fLuaEventDispatcherPointer) {
@@ -93,15 +97,17 @@ const char DispatchLoginResponseEventTask::kLuaEventName[] = "loginResponse";
 
 DispatchLoginResponseEventTask::DispatchLoginResponseEventTask()
         : fResult(EOS_EResult::EOS_UnexpectedError),
-          fSelectedAccountID("") {
+          fSelectedAccountID(""),
+          fUserHandle(0) {
 }
 
 DispatchLoginResponseEventTask::~DispatchLoginResponseEventTask() {
 }
 
 void DispatchLoginResponseEventTask::AcquireEventDataFrom(
-        const EOS_Auth_LoginCallbackInfo *eosEventData) {
+        const EOS_Auth_LoginCallbackInfo *eosEventData, uint32_t userHandle) {
     fResult = eosEventData->ResultCode;
+    fUserHandle = userHandle;
     int sz = 0;
     if (fResult == EOS_EResult::EOS_Success && eosEventData->SelectedAccountId) {
         sz = EOS_EPICACCOUNTID_MAX_LENGTH + 1;
@@ -114,6 +120,11 @@ const char *DispatchLoginResponseEventTask::GetLuaEventName() const {
     return kLuaEventName;
 }
 
+bool DispatchLoginResponseEventTask::CanBeDropped() const {
+    // Lua has no other way to learn that a login it started has completed.
+    return false;
+}
+
 bool DispatchLoginResponseEventTask::PushLuaEventTableTo(lua_State *luaStatePointer) const {
     // Validate.
     if (!luaStatePointer) {
@@ -127,6 +138,10 @@ bool DispatchLoginResponseEventTask::PushLuaEventTableTo(lua_State *luaStatePoin
         lua_pushstring(luaStatePointer, fSelectedAccountID);
         lua_setfield(luaStatePointer, -2, "selectedAccountId");
     }
+    if (fUserHandle) {
+        lua_pushnumber(luaStatePointer, (lua_Number) fUserHandle);
+        lua_setfield(luaStatePointer, -2, "userHandle");
+    }
 
     lua_pushboolean(luaStatePointer, fResult != EOS_EResult::EOS_Success ? 1 : 0);
     lua_setfield(luaStatePointer, -2, "isError");
@@ -142,7 +157,10 @@ bool DispatchLoginResponseEventTask::PushLuaEventTableTo(lua_State *luaStatePoin
 const char DispatchLoadProductsEventTask::kLuaEventName[] = "loadProducts";
 
 DispatchLoadProductsEventTask::DispatchLoadProductsEventTask()
-        : fResult(EOS_EResult::EOS_UnexpectedError) {
+        : fResult(EOS_EResult::EOS_UnexpectedError),
+          fLocalUserId(nullptr),
+          fOfferCount(0),
+          fIsLazy(false) {
 }
 
 DispatchLoadProductsEventTask::~DispatchLoadProductsEventTask() {
@@ -174,59 +192,17 @@ void DispatchLoadProductsEventTask::AcquireEventDataFrom(
         return;
     }
 
+    // Only count the offers here. They are copied out of the SDK's cache when dispatched, or when read if lazy.
     EOS_HEcom EcomHandle = EOS_Platform_GetEcomInterface(eosPlatformHandle);
 
     EOS_Ecom_GetOfferCountOptions CountOptions{0};
     CountOptions.ApiVersion = EOS_ECOM_GETOFFERCOUNT_API_LATEST;
     CountOptions.LocalUserId = eosEventData->LocalUserId;
-    uint32_t OfferCount = EOS_Ecom_GetOfferCount(EcomHandle, &CountOptions);
-
-    CoronaLog("[EOS SDK] NumOffers: %d", OfferCount);
-
-    fOffers.reserve(OfferCount);
-
-    EOS_Ecom_CopyOfferByIndexOptions IndexOptions{0};
-    IndexOptions.ApiVersion = EOS_ECOM_COPYOFFERBYINDEX_API_LATEST;
-    IndexOptions.LocalUserId = eosEventData->LocalUserId;
-    for (IndexOptions.OfferIndex = 0;
-         IndexOptions.OfferIndex < OfferCount; ++IndexOptions.OfferIndex) {
-        EOS_Ecom_CatalogOffer *Offer;
-        EOS_EResult CopyResult = EOS_Ecom_CopyOfferByIndex(EcomHandle, &IndexOptions, &Offer);
-        switch (CopyResult) {
-            case EOS_EResult::EOS_Success:
-            case EOS_EResult::EOS_Ecom_CatalogOfferPriceInvalid:
-            case EOS_EResult::EOS_Ecom_CatalogOfferStale: {
-                CoronaLog(
-                        "[EOS SDK] Offer[%d] id(%ls) title(%ls) Price[Result(%d) Curr(%ull) Original(%ull) DecimalPoint(%ud)] Available?(%ls) Limit[%d]",
-                        IndexOptions.OfferIndex,
-                        Offer->Id,
-                        Offer->TitleText,
-                        Offer->PriceResult, Offer->CurrentPrice64, Offer->OriginalPrice64,
-                        Offer->DecimalPoint,
-                        Offer->bAvailableForPurchase ? L"true" : L"false",
-                        Offer->PurchaseLimit);
-
-                std::ostringstream localizedPriceStream;
-                localizedPriceStream << Offer->CurrencyCode << std::fixed
-                                     << std::setprecision(static_cast<int>(Offer->DecimalPoint))
-                                     << static_cast<double>(Offer->CurrentPrice64) /
-                                        std::pow(10.0, Offer->DecimalPoint);
-                fOffers.push_back(EOSOfferData{
-                        std::string(Offer->Id),
-                        std::string(Offer->TitleText),
-                        std::string(Offer->DescriptionText),
-                        localizedPriceStream.str(),
-                        Offer->PriceResult == EOS_EResult::EOS_Success,
-                });
+    fOfferCount = EOS_Ecom_GetOfferCount(EcomHandle, &CountOptions);
+    fLocalUserId = eosEventData->LocalUserId;
+    fIsLazy = contextPointer->IsLazyProductCatalogEnabled();
 
-                EOS_Ecom_CatalogOffer_Release(Offer);
-                break;
-            }
-            default:
-                CoronaLog("[EOS SDK] Offer[%d] invalid : %d", IndexOptions.OfferIndex, CopyResult);
-                break;
-        }
-    }
+    CoronaLog("[EOS SDK] NumOffers: %d", fOfferCount);
 }
 
 const char *DispatchLoadProductsEventTask::GetLuaEventName() const {
@@ -251,28 +227,7 @@ bool DispatchLoadProductsEventTask::PushLuaEventTableTo(lua_State *luaStatePoint
         lua_pushinteger(luaStatePointer, (int) fResult);
         lua_setfield(luaStatePointer, -2, "resultCode");
 
-        lua_createtable(luaStatePointer, (int) fOffers.size(), 0);
-        for (int index = 0; index < (int) fOffers.size(); index++) {
-            const EOSOfferData &offer = fOffers.at(index);
-            lua_newtable(luaStatePointer);
-
-            lua_pushstring(luaStatePointer, (const char *) offer.Title.c_str());
-            lua_setfield(luaStatePointer, -2, "title");
-
-            lua_pushstring(luaStatePointer, "");
-            lua_setfield(luaStatePointer, -2, "description");
-
-            lua_pushstring(luaStatePointer, (const char *) offer.Id.c_str());
-            lua_setfield(luaStatePointer, -2, "productIdentifier");
-
-            lua_pushstring(luaStatePointer, (const char *) offer.localizedPrice.c_str());
-            lua_setfield(luaStatePointer, -2, "localizedPrice");
-
-            lua_pushboolean(luaStatePointer, offer.bPriceValid);
-            lua_setfield(luaStatePointer, -2, "priceIsValid");
-
-            lua_rawseti(luaStatePointer, -2, index + 1);
-        }
+        LuaOfferCatalog::PushTo(luaStatePointer, fLocalUserId, fOfferCount, fIsLazy);
         lua_setfield(luaStatePointer, -2, "products");
     }
 
@@ -336,8 +291,7 @@ void DispatchStoreTransactionCheckoutEventTask::AcquireEventDataFrom(
 
             CoronaLog("[EOS SDK] New Entitlements: %d", EntitlementCount);
 
-            std::vector<EOSEntitlementData> NewEntitlements;
-            NewEntitlements.reserve(EntitlementCount);
+            fEntitlements.reserve(EntitlementCount);
 
             EOS_Ecom_Transaction_CopyEntitlementByIndexOptions IndexOptions{ 0 };
             IndexOptions.ApiVersion = EOS_ECOM_TRANSACTION_COPYENTITLEMENTBYINDEX_API_LATEST;
@@ -355,7 +309,7 @@ void DispatchStoreTransactionCheckoutEventTask::AcquireEventDataFrom(
                                   Entitlement->EntitlementName,
                                   Entitlement->bRedeemed ? L"TRUE" : L"FALSE");
 
-                        NewEntitlements.push_back(EOSEntitlementData{
+                        fEntitlements.push_back(EOSEntitlementData{
                                 eosEventData->LocalUserId,
                                 std::string(Entitlement->EntitlementName),
                                 std::string(Entitlement->EntitlementId),
@@ -380,6 +334,11 @@ const char *DispatchStoreTransactionCheckoutEventTask::GetLuaEventName() const {
     return kLuaEventName;
 }
 
+bool DispatchStoreTransactionCheckoutEventTask::CanBeDropped() const {
+    // A purchase must always reach Lua, even if it is also recorded by the purchase journal.
+    return false;
+}
+
 bool DispatchStoreTransactionCheckoutEventTask::PushLuaEventTableTo(lua_State *luaStatePointer) const {
     // Validate.
     if (!luaStatePointer) {
@@ -421,6 +380,14 @@ bool DispatchStoreTransactionCheckoutEventTask::PushLuaEventTableTo(lua_State *l
     return true;
 }
 
+const char *DispatchStoreTransactionCheckoutEventTask::GetSelectedAccountId() const {
+    return fSelectedAccountID;
+}
+
+const std::vector<EOSEntitlementData> &DispatchStoreTransactionCheckoutEventTask::GetEntitlements() const {
+    return fEntitlements;
+}
+
 //---------------------------------------------------------------------------------
 // DispatchStoreTransactionQueryEntitlementsEventTask Class Members
 //---------------------------------------------------------------------------------
@@ -469,8 +436,7 @@ void DispatchStoreTransactionQueryEntitlementsEventTask::AcquireEventDataFrom(
 
     CoronaLog("[EOS SDK] NumEntitlements: %d", EntitlementCount);
 
-    std::vector<EOSEntitlementData> NewEntitlements;
-    NewEntitlements.reserve(EntitlementCount);
+    fEntitlements.reserve(EntitlementCount);
 
     EOS_Ecom_CopyEntitlementByIndexOptions IndexOptions{ 0 };
     IndexOptions.ApiVersion = EOS_ECOM_COPYENTITLEMENTBYINDEX_API_LATEST;
@@ -489,7 +455,7 @@ void DispatchStoreTransactionQueryEntitlementsEventTask::AcquireEventDataFrom(
                                Entitlement->EntitlementId,
                                Entitlement->bRedeemed ? L"TRUE" : L"FALSE");
 
-                NewEntitlements.push_back(EOSEntitlementData{
+                fEntitlements.push_back(EOSEntitlementData{
                         eosEventData->LocalUserId,
                         std::string(Entitlement->EntitlementName),
                         std::string(Entitlement->EntitlementId),
@@ -550,3 +516,687 @@ bool DispatchStoreTransactionQueryEntitlementsEventTask::PushLuaEventTableTo(lua
 
     return true;
 }
+
+//---------------------------------------------------------------------------------
+// DispatchFinishTransactionEventTask Class Members
+//---------------------------------------------------------------------------------
+
+const char DispatchFinishTransactionEventTask::kLuaEventName[] = "finishTransaction";
+
+DispatchFinishTransactionEventTask::DispatchFinishTransactionEventTask()
+        : fResult(EOS_EResult::EOS_UnexpectedError) {
+}
+
+DispatchFinishTransactionEventTask::~DispatchFinishTransactionEventTask() {
+}
+
+void DispatchFinishTransactionEventTask::AcquireEventDataFrom(
+        const EOS_Ecom_RedeemEntitlementsCallbackInfo *eosEventData, const std::string &entitlementId) {
+    fResult = eosEventData->ResultCode;
+    fEntitlementId = entitlementId;
+}
+
+const char *DispatchFinishTransactionEventTask::GetLuaEventName() const {
+    return kLuaEventName;
+}
+
+bool DispatchFinishTransactionEventTask::CanBeDropped() const {
+    // Lua relies on this event to stop retrying the redemption.
+    return false;
+}
+
+bool DispatchFinishTransactionEventTask::PushLuaEventTableTo(lua_State *luaStatePointer) const {
+    // Validate.
+    if (!luaStatePointer) {
+        return false;
+    }
+
+    // Push the event data to Lua.
+    CoronaLuaNewEvent(luaStatePointer, kLuaEventName);
+
+    lua_pushstring(luaStatePointer, fEntitlementId.c_str());
+    lua_setfield(luaStatePointer, -2, "identifier");
+
+    lua_pushboolean(luaStatePointer, fResult != EOS_EResult::EOS_Success ? 1 : 0);
+    lua_setfield(luaStatePointer, -2, "isError");
+    lua_pushinteger(luaStatePointer, (int) fResult);
+    lua_setfield(luaStatePointer, -2, "resultCode");
+
+    return true;
+}
+
+
+//---------------------------------------------------------------------------------
+// DispatchJournaledTransactionsEventTask Class Members
+//---------------------------------------------------------------------------------
+
+const char DispatchJournaledTransactionsEventTask::kLuaEventName[] = "storeTransaction";
+
+DispatchJournaledTransactionsEventTask::DispatchJournaledTransactionsEventTask() {
+}
+
+DispatchJournaledTransactionsEventTask::~DispatchJournaledTransactionsEventTask() {
+}
+
+void DispatchJournaledTransactionsEventTask::AcquireEventDataFrom(
+        const std::vector<PurchaseJournal::Transaction> &transactions) {
+    fTransactions = transactions;
+}
+
+const char *DispatchJournaledTransactionsEventTask::GetLuaEventName() const {
+    return kLuaEventName;
+}
+
+bool DispatchJournaledTransactionsEventTask::CanBeDropped() const {
+    // A purchase must always reach Lua.
+    return false;
+}
+
+bool DispatchJournaledTransactionsEventTask::PushLuaEventTableTo(lua_State *luaStatePointer) const {
+    // Validate.
+    if (!luaStatePointer) {
+        return false;
+    }
+
+    // Push the event data to Lua.
+    CoronaLuaNewEvent(luaStatePointer, kLuaEventName);
+
+    if (!fTransactions.empty()) {
+        lua_pushstring(luaStatePointer, fTransactions.front().AccountId.c_str());
+        lua_setfield(luaStatePointer, -2, "selectedAccountId");
+    }
+
+    lua_pushboolean(luaStatePointer, 0);
+    lua_setfield(luaStatePointer, -2, "isError");
+    lua_pushinteger(luaStatePointer, (int) EOS_EResult::EOS_Success);
+    lua_setfield(luaStatePointer, -2, "resultCode");
+
+    // Flag that these transactions were restored from the journal rather than received from a checkout.
+    lua_pushboolean(luaStatePointer, 1);
+    lua_setfield(luaStatePointer, -2, "isRestored");
+
+    lua_createtable(luaStatePointer, (int) fTransactions.size(), 0);
+    for (int index = 0; index < (int) fTransactions.size(); index++) {
+        const PurchaseJournal::Transaction &transaction = fTransactions.at(index);
+        lua_newtable(luaStatePointer);
+
+        lua_pushstring(luaStatePointer, transaction.CatalogItemId.c_str());
+        lua_setfield(luaStatePointer, -2, "receipt");
+
+        lua_pushstring(luaStatePointer, transaction.EntitlementId.c_str());
+        lua_setfield(luaStatePointer, -2, "identifier");
+
+        lua_pushstring(luaStatePointer, transaction.CatalogItemId.c_str());
+        lua_setfield(luaStatePointer, -2, "productIdentifier");
+
+        lua_rawseti(luaStatePointer, -2, index + 1);
+    }
+    lua_setfield(luaStatePointer, -2, "transactions");
+
+    return true;
+}
+
+//---------------------------------------------------------------------------------
+// DispatchEcomTokenEventTask Class Members
+//---------------------------------------------------------------------------------
+
+const char DispatchEcomTokenEventTask::kOwnershipTokenLuaEventName[] = "ownershipToken";
+const char DispatchEcomTokenEventTask::kEntitlementTokenLuaEventName[] = "entitlementToken";
+
+DispatchEcomTokenEventTask::DispatchEcomTokenEventTask()
+        : fType(EcomTokenCache::TokenType::kOwnership),
+          fResult(EOS_EResult::EOS_UnexpectedError),
+          fExpirationTime(0),
+          fUserHandle(0) {
+}
+
+DispatchEcomTokenEventTask::~DispatchEcomTokenEventTask() {
+}
+
+void DispatchEcomTokenEventTask::AcquireEventDataFrom(
+        EcomTokenCache::TokenType type, EOS_EResult resultCode, const std::vector<std::string> &ids,
+        const std::string &token, int64_t expirationTime, uint32_t userHandle) {
+    fType = type;
+    fResult = resultCode;
+    fIds = ids;
+    fToken = token;
+    fExpirationTime = expirationTime;
+    fUserHandle = userHandle;
+}
+
+const char *DispatchEcomTokenEventTask::GetLuaEventName() const {
+    return (fType == EcomTokenCache::TokenType::kOwnership) ? kOwnershipTokenLuaEventName : kEntitlementTokenLuaEventName;
+}
+
+bool DispatchEcomTokenEventTask::PushLuaEventTableTo(lua_State *luaStatePointer) const {
+    // Validate.
+    if (!luaStatePointer) {
+        return false;
+    }
+
+    // Push the event data to Lua.
+    CoronaLuaNewEvent(luaStatePointer, GetLuaEventName());
+
+    if (!fToken.empty()) {
+        lua_pushstring(luaStatePointer, fToken.c_str());
+        lua_setfield(luaStatePointer, -2, "token");
+        lua_pushnumber(luaStatePointer, (lua_Number) fExpirationTime);
+        lua_setfield(luaStatePointer, -2, "expiration");
+    }
+
+    lua_pushboolean(luaStatePointer, fToken.empty() ? 1 : 0);
+    lua_setfield(luaStatePointer, -2, "isError");
+    lua_pushinteger(luaStatePointer, (int) fResult);
+    lua_setfield(luaStatePointer, -2, "resultCode");
+
+    lua_createtable(luaStatePointer, (int) fIds.size(), 0);
+    for (int index = 0; index < (int) fIds.size(); index++) {
+        lua_pushstring(luaStatePointer, fIds.at(index).c_str());
+        lua_rawseti(luaStatePointer, -2, index + 1);
+    }
+    lua_setfield(luaStatePointer, -2,
+                 (fType == EcomTokenCache::TokenType::kOwnership) ? "catalogItemIds" : "entitlementNames");
+    if (fUserHandle) {
+        lua_pushnumber(luaStatePointer, (lua_Number) fUserHandle);
+        lua_setfield(luaStatePointer, -2, "userHandle");
+    }
+
+    return true;
+}
+
+//---------------------------------------------------------------------------------
+// DispatchProductImageEventTask Class Members
+//---------------------------------------------------------------------------------
+
+const char DispatchProductImageEventTask::kLuaEventName[] = "productImage";
+
+DispatchProductImageEventTask::DispatchProductImageEventTask() {
+}
+
+DispatchProductImageEventTask::~DispatchProductImageEventTask() {
+}
+
+void DispatchProductImageEventTask::AcquireEventDataFrom(
+        const std::string &productId, const std::string &imageType, const std::string &url, const std::string &path) {
+    fProductId = productId;
+    fImageType = imageType;
+    fUrl = url;
+    fPath = path;
+}
+
+const char *DispatchProductImageEventTask::GetLuaEventName() const {
+    return kLuaEventName;
+}
+
+bool DispatchProductImageEventTask::PushLuaEventTableTo(lua_State *luaStatePointer) const {
+    // Validate.
+    if (!luaStatePointer) {
+        return false;
+    }
+
+    // Push the event data to Lua.
+    CoronaLuaNewEvent(luaStatePointer, kLuaEventName);
+
+    lua_pushstring(luaStatePointer, fProductId.c_str());
+    lua_setfield(luaStatePointer, -2, "productIdentifier");
+    lua_pushstring(luaStatePointer, fImageType.c_str());
+    lua_setfield(luaStatePointer, -2, "type");
+    lua_pushstring(luaStatePointer, fUrl.c_str());
+    lua_setfield(luaStatePointer, -2, "url");
+    if (!fPath.empty()) {
+        lua_pushstring(luaStatePointer, fPath.c_str());
+        lua_setfield(luaStatePointer, -2, "path");
+    }
+
+    lua_pushboolean(luaStatePointer, fPath.empty() ? 1 : 0);
+    lua_setfield(luaStatePointer, -2, "isError");
+
+    return true;
+}
+
+//---------------------------------------------------------------------------------
+// DispatchStartupEventTask Class Members
+//---------------------------------------------------------------------------------
+
+const char DispatchStartupEventTask::kLuaEventName[] = "startup";
+
+DispatchStartupEventTask::DispatchStartupEventTask() {
+}
+
+DispatchStartupEventTask::~DispatchStartupEventTask() {
+}
+
+void DispatchStartupEventTask::AcquireEventDataFrom(const std::vector<StartupPipeline::StageTiming> &stages) {
+    fStages = stages;
+}
+
+const char *DispatchStartupEventTask::GetLuaEventName() const {
+    return kLuaEventName;
+}
+
+bool DispatchStartupEventTask::PushLuaEventTableTo(lua_State *luaStatePointer) const {
+    // Validate.
+    if (!luaStatePointer) {
+        return false;
+    }
+
+    // Push the event data to Lua.
+    CoronaLuaNewEvent(luaStatePointer, kLuaEventName);
+
+    // Provide each stage that was started, in milliseconds since the plugin was loaded.
+    // Note: The store is usable once the "loadProducts" stage has ended, which is provided as "timeToStore".
+    bool hasFailed = false;
+    long long totalTime = 0;
+    int stageCount = 0;
+    lua_newtable(luaStatePointer);
+    for (size_t stageIndex = 0; stageIndex < fStages.size(); stageIndex++) {
+        const StartupPipeline::StageTiming &timing = fStages.at(stageIndex);
+        if (!timing.HasStarted) {
+            continue;
+        }
+        bool isError = !timing.HasEnded || (timing.ResultCode != EOS_EResult::EOS_Success);
+        hasFailed |= isError;
+
+        lua_createtable(luaStatePointer, 0, 6);
+        lua_pushstring(luaStatePointer, timing.Name);
+        lua_setfield(luaStatePointer, -2, "name");
+        lua_pushnumber(luaStatePointer, (lua_Number) timing.StartTime.count());
+        lua_setfield(luaStatePointer, -2, "startTime");
+        if (timing.HasEnded) {
+            lua_pushnumber(luaStatePointer, (lua_Number) timing.EndTime.count());
+            lua_setfield(luaStatePointer, -2, "endTime");
+            lua_pushnumber(luaStatePointer, (lua_Number) (timing.EndTime - timing.StartTime).count());
+            lua_setfield(luaStatePointer, -2, "duration");
+            lua_pushinteger(luaStatePointer, (int) timing.ResultCode);
+            lua_setfield(luaStatePointer, -2, "resultCode");
+            if ((long long) timing.EndTime.count() > totalTime) {
+                totalTime = (long long) timing.EndTime.count();
+            }
+        }
+        lua_pushboolean(luaStatePointer, isError ? 1 : 0);
+        lua_setfield(luaStatePointer, -2, "isError");
+
+        // Also index the stage by name, such as "event.stages.login".
+        lua_pushvalue(luaStatePointer, -1);
+        lua_setfield(luaStatePointer, -3, timing.Name);
+        lua_rawseti(luaStatePointer, -2, ++stageCount);
+
+        if ((stageIndex == (size_t) StartupPipeline::Stage::kLoadProducts) && !isError) {
+            lua_pushnumber(luaStatePointer, (lua_Number) timing.EndTime.count());
+            lua_setfield(luaStatePointer, -3, "timeToStore");
+        }
+    }
+    lua_setfield(luaStatePointer, -2, "stages");
+
+    lua_pushnumber(luaStatePointer, (lua_Number) totalTime);
+    lua_setfield(luaStatePointer, -2, "totalTime");
+    lua_pushboolean(luaStatePointer, hasFailed ? 1 : 0);
+    lua_setfield(luaStatePointer, -2, "isError");
+
+    return true;
+}
+
+//---------------------------------------------------------------------------------
+// DispatchConnectLoginEventTask Class Members
+//---------------------------------------------------------------------------------
+
+const char DispatchConnectLoginEventTask::kLuaEventName[] = "connectLoginResponse";
+
+DispatchConnectLoginEventTask::DispatchConnectLoginEventTask()
+        : fResult(EOS_EResult::EOS_UnexpectedError),
+          fIsRefresh(false) {
+}
+
+DispatchConnectLoginEventTask::~DispatchConnectLoginEventTask() {
+}
+
+void DispatchConnectLoginEventTask::AcquireEventDataFrom(
+        EOS_EResult resultCode, const char *productUserId, bool isRefresh) {
+    fResult = resultCode;
+    fProductUserId = productUserId ? productUserId : "";
+    fIsRefresh = isRefresh;
+}
+
+const char *DispatchConnectLoginEventTask::GetLuaEventName() const {
+    return kLuaEventName;
+}
+
+bool DispatchConnectLoginEventTask::PushLuaEventTableTo(lua_State *luaStatePointer) const {
+    // Validate.
+    if (!luaStatePointer) {
+        return false;
+    }
+
+    // Push the event data to Lua.
+    CoronaLuaNewEvent(luaStatePointer, kLuaEventName);
+
+    if (!fProductUserId.empty()) {
+        lua_pushstring(luaStatePointer, fProductUserId.c_str());
+        lua_setfield(luaStatePointer, -2, "productUserId");
+    }
+
+    lua_pushboolean(luaStatePointer, (fResult != EOS_EResult::EOS_Success) ? 1 : 0);
+    lua_setfield(luaStatePointer, -2, "isError");
+    lua_pushinteger(luaStatePointer, (int) fResult);
+    lua_setfield(luaStatePointer, -2, "resultCode");
+    lua_pushboolean(luaStatePointer, fIsRefresh ? 1 : 0);
+    lua_setfield(luaStatePointer, -2, "isRefresh");
+
+    return true;
+}
+
+//---------------------------------------------------------------------------------
+// DispatchOperationTimeoutEventTask Class Members
+//---------------------------------------------------------------------------------
+
+const char DispatchOperationTimeoutEventTask::kLuaEventName[] = "operationTimeout";
+
+DispatchOperationTimeoutEventTask::DispatchOperationTimeoutEventTask()
+        : fOperationId(0),
+          fElapsedTime(0) {
+}
+
+DispatchOperationTimeoutEventTask::~DispatchOperationTimeoutEventTask() {
+}
+
+void DispatchOperationTimeoutEventTask::AcquireEventDataFrom(const InflightOperationRegistry::Operation &operation) {
+    fOperationId = operation.Id;
+    fOperationName = operation.Name;
+    fElapsedTime = std::chrono::duration<double>(operation.Deadline - operation.StartTime).count();
+}
+
+const char *DispatchOperationTimeoutEventTask::GetLuaEventName() const {
+    return kLuaEventName;
+}
+
+bool DispatchOperationTimeoutEventTask::PushLuaEventTableTo(lua_State *luaStatePointer) const {
+    // Validate.
+    if (!luaStatePointer) {
+        return false;
+    }
+
+    // Push the event data to Lua.
+    // Note: The operation is still in flight. Lua can wait longer or call eos.cancel() with its ID.
+    CoronaLuaNewEvent(luaStatePointer, kLuaEventName);
+    lua_pushnumber(luaStatePointer, (lua_Number) fOperationId);
+    lua_setfield(luaStatePointer, -2, "operationId");
+    lua_pushstring(luaStatePointer, fOperationName.c_str());
+    lua_setfield(luaStatePointer, -2, "operation");
+    lua_pushnumber(luaStatePointer, fElapsedTime);
+    lua_setfield(luaStatePointer, -2, "elapsedTime");
+    lua_pushboolean(luaStatePointer, 1);
+    lua_setfield(luaStatePointer, -2, "isError");
+    lua_pushinteger(luaStatePointer, (int) EOS_EResult::EOS_TimedOut);
+    lua_setfield(luaStatePointer, -2, "resultCode");
+
+    return true;
+}
+
+/**
+  Pushes the given strings to Lua as an array.
+  @param luaStatePointer Lua state to push the array to.
+  @param strings The strings to push.
+ */
+static void PushStringArrayTo(lua_State *luaStatePointer, const std::vector<std::string> &strings) {
+    lua_createtable(luaStatePointer, (int) strings.size(), 0);
+    for (int index = 0; index < (int) strings.size(); index++) {
+        lua_pushstring(luaStatePointer, strings.at(index).c_str());
+        lua_rawseti(luaStatePointer, -2, index + 1);
+    }
+}
+
+//---------------------------------------------------------------------------------
+// DispatchSessionPlayersEventTask Class Members
+//---------------------------------------------------------------------------------
+
+const char DispatchSessionPlayersEventTask::kLuaEventName[] = "sessionPlayers";
+
+DispatchSessionPlayersEventTask::DispatchSessionPlayersEventTask()
+        : fIsUnregistering(false),
+          fResult(EOS_EResult::EOS_UnexpectedError) {
+}
+
+DispatchSessionPlayersEventTask::~DispatchSessionPlayersEventTask() {
+}
+
+void DispatchSessionPlayersEventTask::AcquireEventDataFrom(
+        bool isUnregistering, const std::string &sessionName, EOS_EResult resultCode,
+        const std::vector<std::string> &productUserIds, const std::vector<std::string> &sanctionedProductUserIds) {
+    fIsUnregistering = isUnregistering;
+    fSessionName = sessionName;
+    fResult = resultCode;
+    fProductUserIds = productUserIds;
+    fSanctionedProductUserIds = sanctionedProductUserIds;
+}
+
+const char *DispatchSessionPlayersEventTask::GetLuaEventName() const {
+    return kLuaEventName;
+}
+
+bool DispatchSessionPlayersEventTask::PushLuaEventTableTo(lua_State *luaStatePointer) const {
+    // Validate.
+    if (!luaStatePointer) {
+        return false;
+    }
+
+    // Push the event data to Lua.
+    CoronaLuaNewEvent(luaStatePointer, kLuaEventName);
+    lua_pushstring(luaStatePointer, fIsUnregistering ? "unregister" : "register");
+    lua_setfield(luaStatePointer, -2, "type");
+    lua_pushstring(luaStatePointer, fSessionName.c_str());
+    lua_setfield(luaStatePointer, -2, "sessionName");
+    PushStringArrayTo(luaStatePointer, fProductUserIds);
+    lua_setfield(luaStatePointer, -2, "players");
+    if (!fIsUnregistering) {
+        PushStringArrayTo(luaStatePointer, fSanctionedProductUserIds);
+        lua_setfield(luaStatePointer, -2, "sanctionedPlayers");
+    }
+    lua_pushboolean(luaStatePointer, (fResult != EOS_EResult::EOS_Success) ? 1 : 0);
+    lua_setfield(luaStatePointer, -2, "isError");
+    lua_pushinteger(luaStatePointer, (int) fResult);
+    lua_setfield(luaStatePointer, -2, "resultCode");
+
+    return true;
+}
+
+//---------------------------------------------------------------------------------
+// DispatchIngestStatEventTask Class Members
+//---------------------------------------------------------------------------------
+
+const char DispatchIngestStatEventTask::kLuaEventName[] = "ingestStat";
+
+DispatchIngestStatEventTask::DispatchIngestStatEventTask()
+        : fResult(EOS_EResult::EOS_UnexpectedError) {
+}
+
+DispatchIngestStatEventTask::~DispatchIngestStatEventTask() {
+}
+
+void DispatchIngestStatEventTask::AcquireEventDataFrom(
+        const char *productUserId, EOS_EResult resultCode, const std::vector<std::string> &statNames) {
+    fProductUserId = productUserId ? productUserId : "";
+    fResult = resultCode;
+    fStatNames = statNames;
+}
+
+const char *DispatchIngestStatEventTask::GetLuaEventName() const {
+    return kLuaEventName;
+}
+
+bool DispatchIngestStatEventTask::PushLuaEventTableTo(lua_State *luaStatePointer) const {
+    // Validate.
+    if (!luaStatePointer) {
+        return false;
+    }
+
+    // Push the event data to Lua.
+    CoronaLuaNewEvent(luaStatePointer, kLuaEventName);
+    lua_pushstring(luaStatePointer, fProductUserId.c_str());
+    lua_setfield(luaStatePointer, -2, "productUserId");
+    PushStringArrayTo(luaStatePointer, fStatNames);
+    lua_setfield(luaStatePointer, -2, "stats");
+    lua_pushboolean(luaStatePointer, (fResult != EOS_EResult::EOS_Success) ? 1 : 0);
+    lua_setfield(luaStatePointer, -2, "isError");
+    lua_pushinteger(luaStatePointer, (int) fResult);
+    lua_setfield(luaStatePointer, -2, "resultCode");
+
+    return true;
+}
+
+//---------------------------------------------------------------------------------
+// DispatchPlayerSanctionsEventTask Class Members
+//---------------------------------------------------------------------------------
+
+const char DispatchPlayerSanctionsEventTask::kLuaEventName[] = "playerSanctions";
+
+DispatchPlayerSanctionsEventTask::DispatchPlayerSanctionsEventTask()
+        : fResult(EOS_EResult::EOS_UnexpectedError) {
+}
+
+DispatchPlayerSanctionsEventTask::~DispatchPlayerSanctionsEventTask() {
+}
+
+void DispatchPlayerSanctionsEventTask::AcquireEventDataFrom(
+        const char *productUserId, EOS_EResult resultCode, const std::vector<Sanction> &sanctions) {
+    fProductUserId = productUserId ? productUserId : "";
+    fResult = resultCode;
+    fSanctions = sanctions;
+}
+
+const char *DispatchPlayerSanctionsEventTask::GetLuaEventName() const {
+    return kLuaEventName;
+}
+
+bool DispatchPlayerSanctionsEventTask::PushLuaEventTableTo(lua_State *luaStatePointer) const {
+    // Validate.
+    if (!luaStatePointer) {
+        return false;
+    }
+
+    // Push the event data to Lua.
+    CoronaLuaNewEvent(luaStatePointer, kLuaEventName);
+    lua_pushstring(luaStatePointer, fProductUserId.c_str());
+    lua_setfield(luaStatePointer, -2, "productUserId");
+    lua_pushboolean(luaStatePointer, fSanctions.empty() ? 0 : 1);
+    lua_setfield(luaStatePointer, -2, "isSanctioned");
+    lua_createtable(luaStatePointer, (int) fSanctions.size(), 0);
+    for (int index = 0; index < (int) fSanctions.size(); index++) {
+        const Sanction &sanction = fSanctions.at(index);
+        lua_createtable(luaStatePointer, 0, 4);
+        lua_pushstring(luaStatePointer, sanction.Action.c_str());
+        lua_setfield(luaStatePointer, -2, "action");
+        lua_pushstring(luaStatePointer, sanction.ReferenceId.c_str());
+        lua_setfield(luaStatePointer, -2, "referenceId");
+        lua_pushnumber(luaStatePointer, (lua_Number) sanction.TimePlaced);
+        lua_setfield(luaStatePointer, -2, "timePlaced");
+        if (sanction.TimeExpires > 0) {
+            lua_pushnumber(luaStatePointer, (lua_Number) sanction.TimeExpires);
+            lua_setfield(luaStatePointer, -2, "timeExpires");
+        }
+        lua_rawseti(luaStatePointer, -2, index + 1);
+    }
+    lua_setfield(luaStatePointer, -2, "sanctions");
+    lua_pushboolean(luaStatePointer, (fResult != EOS_EResult::EOS_Success) ? 1 : 0);
+    lua_setfield(luaStatePointer, -2, "isError");
+    lua_pushinteger(luaStatePointer, (int) fResult);
+    lua_setfield(luaStatePointer, -2, "resultCode");
+
+    return true;
+}
+
+//---------------------------------------------------------------------------------
+// DispatchAntiCheatMessageEventTask Class Members
+//---------------------------------------------------------------------------------
+
+const char DispatchAntiCheatMessageEventTask::kLuaEventName[] = "antiCheatMessage";
+
+DispatchAntiCheatMessageEventTask::DispatchAntiCheatMessageEventTask() {
+}
+
+DispatchAntiCheatMessageEventTask::~DispatchAntiCheatMessageEventTask() {
+}
+
+void DispatchAntiCheatMessageEventTask::AcquireEventDataFrom(
+        const char *productUserId, const void *messageData, uint32_t messageByteCount) {
+    fProductUserId = productUserId ? productUserId : "";
+    if (messageData && (messageByteCount > 0)) {
+        fMessageData.assign((const char *) messageData, messageByteCount);
+    } else {
+        fMessageData.clear();
+    }
+}
+
+const char *DispatchAntiCheatMessageEventTask::GetLuaEventName() const {
+    return kLuaEventName;
+}
+
+bool DispatchAntiCheatMessageEventTask::PushLuaEventTableTo(lua_State *luaStatePointer) const {
+    // Validate.
+    if (!luaStatePointer) {
+        return false;
+    }
+
+    // Push the event data to Lua, which must send the message to the player's client over the game's own network.
+    CoronaLuaNewEvent(luaStatePointer, kLuaEventName);
+    lua_pushstring(luaStatePointer, fProductUserId.c_str());
+    lua_setfield(luaStatePointer, -2, "productUserId");
+    lua_pushlstring(luaStatePointer, fMessageData.data(), fMessageData.size());
+    lua_setfield(luaStatePointer, -2, "data");
+
+    return true;
+}
+
+//---------------------------------------------------------------------------------
+// DispatchAntiCheatActionEventTask Class Members
+//---------------------------------------------------------------------------------
+
+const char DispatchAntiCheatActionEventTask::kLuaEventName[] = "antiCheatAction";
+
+DispatchAntiCheatActionEventTask::DispatchAntiCheatActionEventTask()
+        : fAction(EOS_EAntiCheatCommonClientAction::EOS_ACCCA_Invalid),
+          fReasonCode(EOS_EAntiCheatCommonClientActionReason::EOS_ACCCAR_Invalid) {
+}
+
+DispatchAntiCheatActionEventTask::~DispatchAntiCheatActionEventTask() {
+}
+
+void DispatchAntiCheatActionEventTask::AcquireEventDataFrom(
+        const char *productUserId, const EOS_AntiCheatCommon_OnClientActionRequiredCallbackInfo *Data) {
+    fProductUserId = productUserId ? productUserId : "";
+    if (Data) {
+        fAction = Data->ClientAction;
+        fReasonCode = Data->ActionReasonCode;
+        fReasonDetails = Data->ActionReasonDetailsString ? Data->ActionReasonDetailsString : "";
+    }
+}
+
+const char *DispatchAntiCheatActionEventTask::GetLuaEventName() const {
+    return kLuaEventName;
+}
+
+bool DispatchAntiCheatActionEventTask::PushLuaEventTableTo(lua_State *luaStatePointer) const {
+    // Validate.
+    if (!luaStatePointer) {
+        return false;
+    }
+
+    // Push the event data to Lua.
+    CoronaLuaNewEvent(luaStatePointer, kLuaEventName);
+    lua_pushstring(luaStatePointer, fProductUserId.c_str());
+    lua_setfield(luaStatePointer, -2, "productUserId");
+    lua_pushstring(
+            luaStatePointer,
+            (fAction == EOS_EAntiCheatCommonClientAction::EOS_ACCCA_RemovePlayer) ? "removePlayer" : "unknown");
+    lua_setfield(luaStatePointer, -2, "action");
+    lua_pushinteger(luaStatePointer, (int) fReasonCode);
+    lua_setfield(luaStatePointer, -2, "reasonCode");
+    lua_pushstring(luaStatePointer, fReasonDetails.c_str());
+    lua_setfield(luaStatePointer, -2, "reasonDetails");
+
+    return true;
+}
+
+bool DispatchAntiCheatActionEventTask::CanBeDropped() const {
+    // The game must act on it, since the anti-cheat interface does not ask again.
+    return false;
+}
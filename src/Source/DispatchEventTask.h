@@ -15,7 +15,12 @@
 #include <string>
 #include <vector>
 #include "eos_sdk.h"
+#include "eos_anticheatcommon_types.h"
+#include "EcomTokenCache.h"
 #include "EosLuaInterface.h"
+#include "InflightOperationRegistry.h"
+#include "PurchaseJournal.h"
+#include "StartupPipeline.h"
 
 // Forward declarations.
 extern "C"
@@ -41,6 +46,7 @@ class BaseDispatchEventTask
 		void SetLuaEventDispatcher(const std::shared_ptr<LuaEventDispatcher>& dispatcherPointer);
 		virtual const char* GetLuaEventName() const = 0;
 		virtual bool PushLuaEventTableTo(lua_State* luaStatePointer) const = 0;
+		virtual bool CanBeDropped() const;
 		bool Execute();
 
 	private:
@@ -77,13 +83,15 @@ public:
 	DispatchLoginResponseEventTask();
 	virtual ~DispatchLoginResponseEventTask();
 
-	void AcquireEventDataFrom(const EOS_Auth_LoginCallbackInfo* Data);
+	void AcquireEventDataFrom(const EOS_Auth_LoginCallbackInfo* Data, uint32_t userHandle);
 	virtual const char* GetLuaEventName() const;
 	virtual bool PushLuaEventTableTo(lua_State* luaStatePointer) const;
+	virtual bool CanBeDropped() const;
 
 private:
 	EOS_EResult fResult;
 	char fSelectedAccountID[EOS_EPICACCOUNTID_MAX_LENGTH + 1];
+	uint32_t fUserHandle;
 };
 
 /** Dispatches an Epic "EOS_Ecom_QueryOffersCallbackInfo" event and its data to Lua. */
@@ -102,7 +110,9 @@ public:
 private:
 	EOS_EResult fResult;
 	char fSelectedAccountID[EOS_EPICACCOUNTID_MAX_LENGTH + 1];
-    std::vector<EOSOfferData> fOffers;
+	EOS_EpicAccountId fLocalUserId;
+	uint32_t fOfferCount;
+	bool fIsLazy;
 };
 
 /** Dispatches an Epic "EOS_Ecom_CheckoutCallbackInfo" event and its data to Lua. */
@@ -117,6 +127,9 @@ public:
     void AcquireEventDataFrom(const EOS_Ecom_CheckoutCallbackInfo* Data);
     virtual const char* GetLuaEventName() const;
     virtual bool PushLuaEventTableTo(lua_State* luaStatePointer) const;
+    virtual bool CanBeDropped() const;
+    const char* GetSelectedAccountId() const;
+    const std::vector<EOSEntitlementData>& GetEntitlements() const;
 
 private:
     EOS_EResult fResult;
@@ -141,4 +154,272 @@ private:
     EOS_EResult fResult;
     char fSelectedAccountID[EOS_EPICACCOUNTID_MAX_LENGTH + 1];
     std::vector<EOSEntitlementData> fEntitlements;
-};
\ No newline at end of file
+};
+
+/** Dispatches the result of redeeming one entitlement via EOS_Ecom_RedeemEntitlements() to Lua. */
+class DispatchFinishTransactionEventTask : public BaseDispatchEventTask
+{
+public:
+    static const char kLuaEventName[];
+
+    DispatchFinishTransactionEventTask();
+    virtual ~DispatchFinishTransactionEventTask();
+
+    void AcquireEventDataFrom(const EOS_Ecom_RedeemEntitlementsCallbackInfo* Data, const std::string& entitlementId);
+    virtual const char* GetLuaEventName() const;
+    virtual bool PushLuaEventTableTo(lua_State* luaStatePointer) const;
+    virtual bool CanBeDropped() const;
+
+private:
+    EOS_EResult fResult;
+    std::string fEntitlementId;
+};
+
+/**
+  Dispatches a "storeTransaction" event to Lua for purchases recorded by the PurchaseJournal
+  that were not finished via eos.finishTransaction() before the app last exited.
+ */
+class DispatchJournaledTransactionsEventTask : public BaseDispatchEventTask
+{
+public:
+    static const char kLuaEventName[];
+
+    DispatchJournaledTransactionsEventTask();
+    virtual ~DispatchJournaledTransactionsEventTask();
+
+    void AcquireEventDataFrom(const std::vector<PurchaseJournal::Transaction>& transactions);
+    virtual const char* GetLuaEventName() const;
+    virtual bool PushLuaEventTableTo(lua_State* luaStatePointer) const;
+    virtual bool CanBeDropped() const;
+
+private:
+    std::vector<PurchaseJournal::Transaction> fTransactions;
+};
+
+/** Dispatches the result of an EOS_Ecom_QueryOwnershipToken() or EOS_Ecom_QueryEntitlementToken() call to Lua. */
+class DispatchEcomTokenEventTask : public BaseDispatchEventTask
+{
+public:
+    static const char kOwnershipTokenLuaEventName[];
+    static const char kEntitlementTokenLuaEventName[];
+
+    DispatchEcomTokenEventTask();
+    virtual ~DispatchEcomTokenEventTask();
+
+    void AcquireEventDataFrom(
+            EcomTokenCache::TokenType type, EOS_EResult resultCode, const std::vector<std::string>& ids,
+            const std::string& token, int64_t expirationTime, uint32_t userHandle);
+    virtual const char* GetLuaEventName() const;
+    virtual bool PushLuaEventTableTo(lua_State* luaStatePointer) const;
+
+private:
+    EcomTokenCache::TokenType fType;
+    EOS_EResult fResult;
+    std::vector<std::string> fIds;
+    std::string fToken;
+    int64_t fExpirationTime;
+    uint32_t fUserHandle;
+};
+
+/** Dispatches a "productImage" event to Lua once an offer or item image has been downloaded to the cache. */
+class DispatchProductImageEventTask : public BaseDispatchEventTask
+{
+public:
+    static const char kLuaEventName[];
+
+    DispatchProductImageEventTask();
+    virtual ~DispatchProductImageEventTask();
+
+    void AcquireEventDataFrom(
+            const std::string& productId, const std::string& imageType, const std::string& url, const std::string& path);
+    virtual const char* GetLuaEventName() const;
+    virtual bool PushLuaEventTableTo(lua_State* luaStatePointer) const;
+
+private:
+    std::string fProductId;
+    std::string fImageType;
+    std::string fUrl;
+
+    /** Local path to the cached image. Empty if the download failed. */
+    std::string fPath;
+};
+
+/** Dispatches a "startup" event to Lua providing the timeline of the StartupPipeline's stages. */
+class DispatchStartupEventTask : public BaseDispatchEventTask
+{
+public:
+    static const char kLuaEventName[];
+
+    DispatchStartupEventTask();
+    virtual ~DispatchStartupEventTask();
+
+    void AcquireEventDataFrom(const std::vector<StartupPipeline::StageTiming>& stages);
+    virtual const char* GetLuaEventName() const;
+    virtual bool PushLuaEventTableTo(lua_State* luaStatePointer) const;
+
+private:
+    std::vector<StartupPipeline::StageTiming> fStages;
+};
+
+/** Dispatches a "connectLoginResponse" event to Lua once the ConnectSession has logged into the Connect interface. */
+class DispatchConnectLoginEventTask : public BaseDispatchEventTask
+{
+public:
+    static const char kLuaEventName[];
+
+    DispatchConnectLoginEventTask();
+    virtual ~DispatchConnectLoginEventTask();
+
+    void AcquireEventDataFrom(EOS_EResult resultCode, const char* productUserId, bool isRefresh);
+    virtual const char* GetLuaEventName() const;
+    virtual bool PushLuaEventTableTo(lua_State* luaStatePointer) const;
+
+private:
+    EOS_EResult fResult;
+
+    /** String form of the logged in EOS_ProductUserId. Empty if the login failed. */
+    std::string fProductUserId;
+
+    /** Set true if this login extended a session that was about to expire. */
+    bool fIsRefresh;
+};
+
+class DispatchOperationTimeoutEventTask : public BaseDispatchEventTask
+{
+public:
+    static const char kLuaEventName[];
+
+    DispatchOperationTimeoutEventTask();
+    virtual ~DispatchOperationTimeoutEventTask();
+
+    void AcquireEventDataFrom(const InflightOperationRegistry::Operation& operation);
+    virtual const char* GetLuaEventName() const;
+    virtual bool PushLuaEventTableTo(lua_State* luaStatePointer) const;
+
+private:
+    uint64_t fOperationId;
+
+    /** Name of the Lua API that started the operation, such as "loadProducts". */
+    std::string fOperationName;
+
+    /** Time in seconds between the operation's start and its deadline. */
+    double fElapsedTime;
+};
+
+/** Dispatches a "sessionPlayers" event to Lua once a batch of players was registered with or unregistered from a session. */
+class DispatchSessionPlayersEventTask : public BaseDispatchEventTask
+{
+public:
+    static const char kLuaEventName[];
+
+    DispatchSessionPlayersEventTask();
+    virtual ~DispatchSessionPlayersEventTask();
+
+    void AcquireEventDataFrom(
+            bool isUnregistering, const std::string& sessionName, EOS_EResult resultCode,
+            const std::vector<std::string>& productUserIds, const std::vector<std::string>& sanctionedProductUserIds);
+    virtual const char* GetLuaEventName() const;
+    virtual bool PushLuaEventTableTo(lua_State* luaStatePointer) const;
+
+private:
+    bool fIsUnregistering;
+    std::string fSessionName;
+    EOS_EResult fResult;
+
+    /** The players that were registered or unregistered. */
+    std::vector<std::string> fProductUserIds;
+
+    /** The players that failed to register because they are sanctioned. */
+    std::vector<std::string> fSanctionedProductUserIds;
+};
+
+/** Dispatches an "ingestStat" event to Lua if a player's batch of stats failed to be ingested. */
+class DispatchIngestStatEventTask : public BaseDispatchEventTask
+{
+public:
+    static const char kLuaEventName[];
+
+    DispatchIngestStatEventTask();
+    virtual ~DispatchIngestStatEventTask();
+
+    void AcquireEventDataFrom(
+            const char* productUserId, EOS_EResult resultCode, const std::vector<std::string>& statNames);
+    virtual const char* GetLuaEventName() const;
+    virtual bool PushLuaEventTableTo(lua_State* luaStatePointer) const;
+
+private:
+    std::string fProductUserId;
+    EOS_EResult fResult;
+    std::vector<std::string> fStatNames;
+};
+
+/** Dispatches a "playerSanctions" event to Lua providing a player's active sanctions. */
+class DispatchPlayerSanctionsEventTask : public BaseDispatchEventTask
+{
+public:
+    static const char kLuaEventName[];
+
+    /** Copy of an EOS_Sanctions_PlayerSanction. */
+    struct Sanction
+    {
+        std::string Action;
+        std::string ReferenceId;
+        int64_t TimePlaced;
+
+        /** Zero if the sanction is permanent. */
+        int64_t TimeExpires;
+    };
+
+    DispatchPlayerSanctionsEventTask();
+    virtual ~DispatchPlayerSanctionsEventTask();
+
+    void AcquireEventDataFrom(const char* productUserId, EOS_EResult resultCode, const std::vector<Sanction>& sanctions);
+    virtual const char* GetLuaEventName() const;
+    virtual bool PushLuaEventTableTo(lua_State* luaStatePointer) const;
+
+private:
+    std::string fProductUserId;
+    EOS_EResult fResult;
+    std::vector<Sanction> fSanctions;
+};
+
+/** Dispatches an "antiCheatMessage" event to Lua with a message that the game must send to a player's client. */
+class DispatchAntiCheatMessageEventTask : public BaseDispatchEventTask
+{
+public:
+    static const char kLuaEventName[];
+
+    DispatchAntiCheatMessageEventTask();
+    virtual ~DispatchAntiCheatMessageEventTask();
+
+    void AcquireEventDataFrom(const char* productUserId, const void* messageData, uint32_t messageByteCount);
+    virtual const char* GetLuaEventName() const;
+    virtual bool PushLuaEventTableTo(lua_State* luaStatePointer) const;
+
+private:
+    std::string fProductUserId;
+
+    /** The opaque binary message, pushed to Lua as a string. */
+    std::string fMessageData;
+};
+
+/** Dispatches an "antiCheatAction" event to Lua when the anti-cheat interface requires a player to be removed. */
+class DispatchAntiCheatActionEventTask : public BaseDispatchEventTask
+{
+public:
+    static const char kLuaEventName[];
+
+    DispatchAntiCheatActionEventTask();
+    virtual ~DispatchAntiCheatActionEventTask();
+
+    void AcquireEventDataFrom(const char* productUserId, const EOS_AntiCheatCommon_OnClientActionRequiredCallbackInfo* Data);
+    virtual const char* GetLuaEventName() const;
+    virtual bool PushLuaEventTableTo(lua_State* luaStatePointer) const;
+    virtual bool CanBeDropped() const;
+
+private:
+    std::string fProductUserId;
+    EOS_EAntiCheatCommonClientAction fAction;
+    EOS_EAntiCheatCommonClientActionReason fReasonCode;
+    std::string fReasonDetails;
+};
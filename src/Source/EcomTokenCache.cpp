@@ -0,0 +1,285 @@
+// ----------------------------------------------------------------------------
+//
+// EcomTokenCache.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#include "EcomTokenCache.h"
+#include "CoronaLua.h"
+#include "DispatchEventTask.h"
+#include "JsonWebToken.h"
+#include "RuntimeContext.h"
+#include "eos_ecom.h"
+#include <algorithm>
+#include <ctime>
+#include <unordered_set>
+
+
+/** Stores a collection of all EcomTokenCache instances that currently exist in the application. */
+static std::unordered_set<EcomTokenCache*> sEcomTokenCacheCollection;
+
+/** Lifetime assumed for tokens whose "exp" claim cannot be read. */
+static const std::chrono::seconds kDefaultTokenLifetime(300);
+
+/** How long to wait before re-querying a token after a failed query. */
+static const std::chrono::seconds kQueryRetryDelay(30);
+
+/** Tokens not requested by Lua within this time stop being refreshed in the background. */
+static const std::chrono::minutes kIdleRefreshLimit(30);
+
+
+EcomTokenCache::EcomTokenCache(RuntimeContext* contextPointer, EOS_EpicAccountId localUserId)
+:	fContextPointer(contextPointer),
+	fLocalUserId(localUserId),
+	fGeneration(0)
+{
+	// Add this class instance to the global collection.
+	sEcomTokenCacheCollection.insert(this);
+}
+
+EcomTokenCache::~EcomTokenCache()
+{
+	// Remove this class instance from the global collection.
+	// Note: In-flight query callbacks check this collection and will do nothing once it is removed.
+	sEcomTokenCacheCollection.erase(this);
+}
+
+bool EcomTokenCache::GetTokens(
+	TokenType type, const std::vector<std::string>& ids, const char* catalogNamespace,
+	std::vector<std::string>& outTokens)
+{
+	outTokens.clear();
+
+	// Validate.
+	if (!fContextPointer || !fLocalUserId)
+	{
+		return false;
+	}
+	if ((type == TokenType::kOwnership) && ids.empty())
+	{
+		return false;
+	}
+
+	// Sort the IDs so that the same set of IDs always maps to the same chunks.
+	std::vector<std::string> sortedIds(ids);
+	std::sort(sortedIds.begin(), sortedIds.end());
+	sortedIds.erase(std::unique(sortedIds.begin(), sortedIds.end()), sortedIds.end());
+	size_t chunkSize = (type == TokenType::kOwnership) ?
+			EOS_ECOM_QUERYOWNERSHIPTOKEN_MAX_CATALOGITEM_IDS : EOS_ECOM_QUERYENTITLEMENTTOKEN_MAX_ENTITLEMENT_IDS;
+
+	// Fetch each chunk's token, querying the ones not cached.
+	auto currentTime = std::chrono::steady_clock::now();
+	int64_t currentUnixTime = (int64_t)time(nullptr);
+	bool isEveryTokenCached = true;
+	size_t chunkStartIndex = 0;
+	do
+	{
+		size_t chunkEndIndex = std::min(chunkStartIndex + chunkSize, sortedIds.size());
+
+		std::string key((type == TokenType::kOwnership) ? "O" : "E");
+		if (catalogNamespace)
+		{
+			key.append(catalogNamespace);
+		}
+		key.append("\n");
+		for (size_t index = chunkStartIndex; index < chunkEndIndex; index++)
+		{
+			key.append(sortedIds[index]);
+			key.append(",");
+		}
+
+		auto entryIterator = fEntries.find(key);
+		if (entryIterator == fEntries.end())
+		{
+			CacheEntry entry;
+			entry.Type = type;
+			entry.Ids.assign(sortedIds.begin() + chunkStartIndex, sortedIds.begin() + chunkEndIndex);
+			entry.CatalogNamespace = catalogNamespace ? catalogNamespace : "";
+			entry.ExpirationTime = 0;
+			entry.RefreshTime = currentTime;
+			entry.IsQueryInFlight = false;
+			entryIterator = fEntries.emplace(key, entry).first;
+		}
+		CacheEntry& entry = entryIterator->second;
+		entry.LastRequestTime = currentTime;
+		if (!entry.Token.empty() && (entry.ExpirationTime > currentUnixTime))
+		{
+			outTokens.push_back(entry.Token);
+		}
+		else
+		{
+			// Note: Failed queries are not retried until their retry delay has elapsed.
+			isEveryTokenCached = false;
+			if (!entry.IsQueryInFlight && (currentTime >= entry.RefreshTime))
+			{
+				StartQuery(key, entry);
+			}
+		}
+
+		chunkStartIndex = chunkEndIndex;
+	} while (chunkStartIndex < sortedIds.size());
+
+	if (!isEveryTokenCached)
+	{
+		outTokens.clear();
+	}
+	return isEveryTokenCached;
+}
+
+void EcomTokenCache::Update()
+{
+	if (fEntries.empty() || !fContextPointer)
+	{
+		return;
+	}
+
+	// Refresh tokens due for a refresh, unless Lua has not used them in a while.
+	auto currentTime = std::chrono::steady_clock::now();
+	int64_t currentUnixTime = (int64_t)time(nullptr);
+	for (auto entryIterator = fEntries.begin(); entryIterator != fEntries.end();)
+	{
+		CacheEntry& entry = entryIterator->second;
+		if (entry.IsQueryInFlight || (currentTime < entry.RefreshTime))
+		{
+			++entryIterator;
+		}
+		else if ((currentTime - entry.LastRequestTime) < kIdleRefreshLimit)
+		{
+			StartQuery(entryIterator->first, entry);
+			++entryIterator;
+		}
+		else if (entry.ExpirationTime <= currentUnixTime)
+		{
+			entryIterator = fEntries.erase(entryIterator);
+		}
+		else
+		{
+			++entryIterator;
+		}
+	}
+}
+
+void EcomTokenCache::Clear()
+{
+	fEntries.clear();
+	fGeneration++;
+}
+
+void EcomTokenCache::StartQuery(const std::string& key, CacheEntry& entry)
+{
+	if (!fContextPointer->fPlatformHandle || !fLocalUserId)
+	{
+		return;
+	}
+	EOS_HEcom EcomHandle = EOS_Platform_GetEcomInterface(fContextPointer->fPlatformHandle);
+
+	// Note: The request is deleted by the query's callback.
+	auto requestPointer = new QueryRequest{ this, key, fGeneration };
+	std::vector<const char*> ids;
+	ids.reserve(entry.Ids.size());
+	for (auto&& id : entry.Ids)
+	{
+		ids.push_back(id.c_str());
+	}
+	entry.IsQueryInFlight = true;
+
+	if (entry.Type == TokenType::kOwnership)
+	{
+		EOS_Ecom_QueryOwnershipTokenOptions QueryOptions{ 0 };
+		QueryOptions.ApiVersion = EOS_ECOM_QUERYOWNERSHIPTOKEN_API_LATEST;
+		QueryOptions.LocalUserId = fLocalUserId;
+		QueryOptions.CatalogItemIds = ids.empty() ? nullptr : &ids[0];
+		QueryOptions.CatalogItemIdCount = (uint32_t)ids.size();
+		QueryOptions.CatalogNamespace = entry.CatalogNamespace.empty() ? nullptr : entry.CatalogNamespace.c_str();
+		EOS_Ecom_QueryOwnershipToken(EcomHandle, &QueryOptions, requestPointer, &EcomTokenCache::OnQueryOwnershipTokenResponse);
+	}
+	else
+	{
+		EOS_Ecom_QueryEntitlementTokenOptions QueryOptions{ 0 };
+		QueryOptions.ApiVersion = EOS_ECOM_QUERYENTITLEMENTTOKEN_API_LATEST;
+		QueryOptions.LocalUserId = fLocalUserId;
+		QueryOptions.EntitlementNames = ids.empty() ? nullptr : &ids[0];
+		QueryOptions.EntitlementNameCount = (uint32_t)ids.size();
+		EOS_Ecom_QueryEntitlementToken(EcomHandle, &QueryOptions, requestPointer, &EcomTokenCache::OnQueryEntitlementTokenResponse);
+	}
+}
+
+void EcomTokenCache::OnQueryEnded(const QueryRequest& request, EOS_EResult resultCode, const char* token)
+{
+	// Ignore queries started before the cache was last cleared.
+	if (request.Generation != fGeneration)
+	{
+		return;
+	}
+	auto entryIterator = fEntries.find(request.Key);
+	if (entryIterator == fEntries.end())
+	{
+		return;
+	}
+	CacheEntry& entry = entryIterator->second;
+	entry.IsQueryInFlight = false;
+
+	// Cache the new token and schedule its refresh after 3/4 of its lifetime.
+	// Note: A failed query keeps the last token, which may still be valid, and retries later.
+	auto currentTime = std::chrono::steady_clock::now();
+	bool wasSuccessful = (resultCode == EOS_EResult::EOS_Success) && token && (token[0] != '\0');
+	if (wasSuccessful)
+	{
+		int64_t currentUnixTime = (int64_t)time(nullptr);
+		int64_t expirationTime = 0;
+		if (!JsonWebToken::GetExpirationTime(token, expirationTime))
+		{
+			expirationTime = currentUnixTime + (int64_t)kDefaultTokenLifetime.count();
+		}
+		int64_t lifetimeInSeconds = std::max(expirationTime - currentUnixTime, (int64_t)0);
+		entry.Token = token;
+		entry.ExpirationTime = expirationTime;
+		entry.RefreshTime = currentTime + std::chrono::seconds((lifetimeInSeconds * 3) / 4);
+	}
+	else
+	{
+		CoronaLog("[EOS SDK] Token query failed : %d", resultCode);
+		entry.RefreshTime = currentTime + kQueryRetryDelay;
+	}
+
+	// Dispatch the result to Lua.
+	auto taskPointer = new DispatchEcomTokenEventTask();
+	taskPointer->SetLuaEventDispatcher(fContextPointer->GetLuaEventDispatcher());
+	taskPointer->AcquireEventDataFrom(
+			entry.Type, resultCode, entry.Ids, wasSuccessful ? entry.Token : std::string(), entry.ExpirationTime,
+			fContextPointer->GetLocalUsers().FindBy(fLocalUserId));
+	fContextPointer->QueueDispatchEventTask(std::shared_ptr<BaseDispatchEventTask>(taskPointer));
+}
+
+void EOS_CALL EcomTokenCache::OnQueryOwnershipTokenResponse(const EOS_Ecom_QueryOwnershipTokenCallbackInfo* Data)
+{
+	if (!Data || !EOS_EResult_IsOperationComplete(Data->ResultCode))
+	{
+		return;
+	}
+
+	auto requestPointer = (QueryRequest*)Data->ClientData;
+	if (requestPointer && (sEcomTokenCacheCollection.find(requestPointer->CachePointer) != sEcomTokenCacheCollection.end()))
+	{
+		requestPointer->CachePointer->OnQueryEnded(*requestPointer, Data->ResultCode, Data->OwnershipToken);
+	}
+	delete requestPointer;
+}
+
+void EOS_CALL EcomTokenCache::OnQueryEntitlementTokenResponse(const EOS_Ecom_QueryEntitlementTokenCallbackInfo* Data)
+{
+	if (!Data || !EOS_EResult_IsOperationComplete(Data->ResultCode))
+	{
+		return;
+	}
+
+	auto requestPointer = (QueryRequest*)Data->ClientData;
+	if (requestPointer && (sEcomTokenCacheCollection.find(requestPointer->CachePointer) != sEcomTokenCacheCollection.end()))
+	{
+		requestPointer->CachePointer->OnQueryEnded(*requestPointer, Data->ResultCode, Data->EntitlementToken);
+	}
+	delete requestPointer;
+}
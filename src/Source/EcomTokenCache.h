@@ -0,0 +1,123 @@
+// ----------------------------------------------------------------------------
+//
+// EcomTokenCache.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "eos_sdk.h"
+#include "eos_ecom_types.h"
+
+// Forward declarations.
+class RuntimeContext;
+
+
+/**
+  Caches the ownership and entitlement tokens returned by EOS_Ecom_QueryOwnershipToken() and
+  EOS_Ecom_QueryEntitlementToken(), which a game's backend uses to verify purchases.
+
+  Requested IDs are sorted and split into chunks of up to EOS_ECOM_QUERYOWNERSHIPTOKEN_MAX_CATALOGITEM_IDS or
+  EOS_ECOM_QUERYENTITLEMENTTOKEN_MAX_ENTITLEMENT_IDS, and each chunk is cached as its own token along with
+  the token's parsed "exp" claim. Tokens are re-queried in the background once 3/4 of their lifetime
+  has elapsed, so a cached token is normally available whenever Lua asks for it.
+
+  Tokens that are not requested by Lua for a while stop being refreshed and are dropped once expired.
+  Each local user has its own cache, owned by the runtime context's LocalUserTable and dropped once the user logs out.
+ */
+class EcomTokenCache
+{
+	public:
+		/** The kind of token cached. */
+		enum class TokenType
+		{
+			kOwnership,
+			kEntitlement
+		};
+
+		/**
+		  Creates a new token cache.
+		  @param contextPointer The runtime context used to query EOS and dispatch events. Cannot be null.
+		  @param localUserId The logged in account whose tokens are cached.
+		 */
+		EcomTokenCache(RuntimeContext* contextPointer, EOS_EpicAccountId localUserId);
+
+		/** Stops handling in-flight queries. */
+		virtual ~EcomTokenCache();
+
+		/**
+		  Fetches the cached tokens covering the given IDs, querying EOS for the chunks not cached yet.
+		  A "ownershipToken" or "entitlementToken" event is dispatched to Lua as each query completes.
+		  @param type The kind of token to fetch.
+		  @param ids Catalog item IDs for ownership tokens or entitlement names for entitlement tokens.
+		             An empty collection requests an entitlement token covering all entitlements.
+		  @param catalogNamespace Catalog namespace for ownership tokens. Can be null.
+		  @param outTokens Receives 1 token per chunk if all of them are cached and unexpired.
+		  @return Returns true if all tokens were provided. Returns false if at least 1 is being queried,
+		          in which case "outTokens" is left empty, or if the user is not logged in.
+		 */
+		bool GetTokens(
+				TokenType type, const std::vector<std::string>& ids, const char* catalogNamespace,
+				std::vector<std::string>& outTokens);
+
+		/** To be called every frame. Refreshes tokens that are close to expiring. */
+		void Update();
+
+		/** Drops all cached tokens. In-flight queries will not be cached when they complete. */
+		void Clear();
+
+	private:
+		/** Copy constructor deleted to prevent it from being called. */
+		EcomTokenCache(const EcomTokenCache&) = delete;
+
+		/** Method deleted to prevent the copy operator from being used. */
+		void operator=(const EcomTokenCache&) = delete;
+
+		/** A token covering 1 chunk of IDs. */
+		struct CacheEntry
+		{
+			TokenType Type;
+			std::vector<std::string> Ids;
+			std::string CatalogNamespace;
+			std::string Token;
+
+			/** The token's "exp" claim in seconds since the Unix epoch. Zero if no token is cached. */
+			int64_t ExpirationTime;
+
+			std::chrono::steady_clock::time_point RefreshTime;
+			std::chrono::steady_clock::time_point LastRequestTime;
+			bool IsQueryInFlight;
+		};
+
+		/** Passed as client data to the EOS query functions. */
+		struct QueryRequest
+		{
+			EcomTokenCache* CachePointer;
+			std::string Key;
+			uint32_t Generation;
+		};
+
+		void StartQuery(const std::string& key, CacheEntry& entry);
+		void OnQueryEnded(const QueryRequest& request, EOS_EResult resultCode, const char* token);
+		static void EOS_CALL OnQueryOwnershipTokenResponse(const EOS_Ecom_QueryOwnershipTokenCallbackInfo* Data);
+		static void EOS_CALL OnQueryEntitlementTokenResponse(const EOS_Ecom_QueryEntitlementTokenCallbackInfo* Data);
+
+		RuntimeContext* fContextPointer;
+
+		/** The account the cached tokens belong to. */
+		EOS_EpicAccountId fLocalUserId;
+
+		/** Incremented by Clear() so that queries started before it are ignored when they complete. */
+		uint32_t fGeneration;
+
+		/** Cached tokens, indexed by token type, catalog namespace and chunk of IDs. */
+		std::unordered_map<std::string, CacheEntry> fEntries;
+};
@@ -11,6 +11,7 @@
 #include "CoronaMacros.h"
 #include "DispatchEventTask.h"
 #include "LuaEventDispatcher.h"
+#include "PlatformRegistry.h"
 #include "PluginConfigLuaSettings.h"
 #include "RuntimeContext.h"
 #include <cmath>
@@ -32,6 +33,7 @@ extern "C"
 #include "eos_auth.h"
 #include "eos_ecom.h"
 #include "PlatformCommandLine.h"
+#include "SecureTokenStore.h"
 #include "EosLuaInterface.h"
 
 #if ALLOW_RESERVED_PLATFORM_OPTIONS
@@ -79,6 +81,12 @@ extern "C"
  */
 static std::thread::id sMainThreadId;
 
+/**
+  Name of the Epic refresh token in the SecureTokenStore, which is unique per product.
+  Empty if desktop persistent login is disabled via the "config.lua" file or not supported.
+ */
+static std::string sRefreshTokenName;
+
 //---------------------------------------------------------------------------------
 // Private Static Functions
 //---------------------------------------------------------------------------------
@@ -108,30 +116,14 @@ bool IsRunningInCoronaSimulator(lua_State *luaStatePointer) {
 }
 
 RuntimeContext *GetRuntimeContextFromLuaState(lua_State *L) {
-    RuntimeContext *context = nullptr;
-
-    // Try to get from the Lua registry (safe, hidden)
-    lua_getfield(L, LUA_REGISTRYINDEX, "__runtimeContext");
-    if (lua_isuserdata(L, -1)) {
-        context = static_cast<RuntimeContext *>(lua_touserdata(L, -1));
-    }
-    lua_pop(L, 1); // Always pop from stack
-
-    // If not found in the registry, try to get from the global variable
-    if (!context) {
-        lua_getglobal(L, "__runtimeContext");
-        if (lua_isuserdata(L, -1)) {
-            context = static_cast<RuntimeContext *>(lua_touserdata(L, -1));
-        }
-        lua_pop(L, 1);
-    }
-
-    // Debug log (optional)
-    if (!context) {
-        printf("[Lua] Error: RuntimeContext not found!\n");
+    // The plugin's Lua functions receive their runtime context as their 1st upvalue via luaL_openlib().
+    // Note: This must only be called by those functions, since any other C closure's upvalue could be pushed here.
+    if (lua_islightuserdata(L, lua_upvalueindex(1))) {
+        return static_cast<RuntimeContext *>(lua_touserdata(L, lua_upvalueindex(1)));
     }
 
-    return context;
+    // Otherwise, look the context up by Lua state.
+    return RuntimeContext::GetInstanceBy(L);
 }
 
 /**
@@ -152,10 +144,25 @@ void EOS_CALL onEOSLogMessageReceived(const EOS_LogMessage *InMsg) {
     }
 }
 
+#if !defined(__ANDROID__) && !(defined(__APPLE__) && TARGET_OS_IPHONE)
+static void StoreRefreshTokenOf(RuntimeContext *contextPointer, EOS_EpicAccountId localUserId);
+#endif
+
 void EOS_CALL onLoginCallback(const EOS_Auth_LoginCallbackInfo *Data) {
+    // Ignore the result if the runtime context was deleted, since its platform may be shared with other contexts.
     RuntimeContext *contextPointer = (RuntimeContext *) Data->ClientData;
+    if (!RuntimeContext::IsAlive(contextPointer)) {
+        return;
+    }
+    if (EOS_EResult_IsOperationComplete(Data->ResultCode)) {
+        contextPointer->GetRequestScheduler().OnResultReceived(RequestScheduler::Interface::kAuth, Data->ResultCode);
+    }
     if (Data->ResultCode == EOS_EResult::EOS_Success) {
         contextPointer->fAccountId = Data->SelectedAccountId;
+        contextPointer->GetLocalUsers().Add(Data->SelectedAccountId);
+#if !defined(__ANDROID__) && !(defined(__APPLE__) && TARGET_OS_IPHONE)
+        StoreRefreshTokenOf(contextPointer, Data->LocalUserId);
+#endif
     }
 
     if (EOS_EResult_IsOperationComplete(Data->ResultCode)) {
@@ -163,57 +170,163 @@ void EOS_CALL onLoginCallback(const EOS_Auth_LoginCallbackInfo *Data) {
     }
 }
 
-//---------------------------------------------------------------------------------
-// Lua API Handlers
-//---------------------------------------------------------------------------------
-/** UserInfo eos.getAuthIdToken() */
-extern "C" int InitializeSDK(lua_State *luaStatePointer, EOS_InitializeOptions SDKOptions) {
-    // If this plugin instance is being loaded while another one already exists, then make sure that they're
-    // both running on the same thread to avoid race conditions since EOS's event handlers are global.
-    // Note: This can only happen if multiple Corona runtimes are running at the same time.
-    if (RuntimeContext::GetInstanceCount() > 0) {
-        if (std::this_thread::get_id() != sMainThreadId) {
-            luaL_error(luaStatePointer,
-                       "Cannot load another instance of 'plugin.eos' from another thread.");
-            return 0;
+/** Time after which an Ecom query started by Lua is reported as timed out, covering its retries. */
+static const std::chrono::seconds kEcomQueryTimeout(60);
+
+/** Time after which a checkout or account portal login is reported as timed out, since the user interacts with it. */
+static const std::chrono::minutes kInteractiveOperationTimeout(10);
+
+/** Client data of an account portal login, tracked by the runtime context's in-flight operation registry. */
+struct AccountPortalLogin {
+    RuntimeContext *ContextPointer;
+    uint64_t OperationId;
+};
+
+void EOS_CALL onAccountPortalLoginCallback(const EOS_Auth_LoginCallbackInfo *Data) {
+    auto loginPointer = (AccountPortalLogin *) Data->ClientData;
+    if (!loginPointer) {
+        return;
+    }
+    if (!RuntimeContext::IsAlive(loginPointer->ContextPointer)) {
+        if (EOS_EResult_IsOperationComplete(Data->ResultCode)) {
+            delete loginPointer;
         }
-    } else {
-        sMainThreadId = std::this_thread::get_id();
+        return;
     }
 
-    // Create a new runtime context used to receive EOS's event and dispatch them to Lua.
-    // Also used to ensure that the EOS overlay is rendered when requested on Windows.
-    auto contextPointer = new RuntimeContext(luaStatePointer);
-    if (!contextPointer) {
-        return 0;
+    // Handle the result like any other login, on behalf of the runtime context.
+    // Note: The result is delivered even if Lua cancelled the login, since the user may have logged in.
+    EOS_Auth_LoginCallbackInfo LoginData = *Data;
+    LoginData.ClientData = loginPointer->ContextPointer;
+    if (EOS_EResult_IsOperationComplete(Data->ResultCode)) {
+        loginPointer->ContextPointer->GetInflightOperations().End(loginPointer->OperationId);
+        delete loginPointer;
     }
-    lua_pushlightuserdata(luaStatePointer, contextPointer);
-    lua_setfield(luaStatePointer, LUA_REGISTRYINDEX,
-                 "__runtimeContext"); // Store in the registry under a unique key (cannot be modified by Lua scripts)
+    onLoginCallback(&LoginData);
+}
 
-    // Fetch the EOS properties from the "config.lua" file.
-    PluginConfigLuaSettings configLuaSettings;
-    configLuaSettings.LoadFrom(luaStatePointer);
-    
+/**
+  Starts logging in the user via the Epic account portal, which is displayed in a browser or web view.
+  @param contextPointer The plugin's runtime context, which receives the login's result.
+  @param operationId ID of the login in the context's in-flight operation registry. Zero if not tracked.
+ */
+static void StartAccountPortalLogin(RuntimeContext *contextPointer, uint64_t operationId) {
+    contextPointer->GetStartupPipeline().OnStageStarted(StartupPipeline::Stage::kLogin);
+
+    // Rate limited, so that repeated taps on a login button do not open a burst of portal requests.
+    contextPointer->GetRequestScheduler().Submit(RequestScheduler::Interface::kAuth, [contextPointer, operationId]() {
+        if (!contextPointer->fAuthHandle) {
+            contextPointer->GetInflightOperations().End(operationId);
+            return;
+        }
+
+        EOS_Auth_Credentials Credentials = {};
+        Credentials.ApiVersion = EOS_AUTH_CREDENTIALS_API_LATEST;
+        Credentials.Type = EOS_ELoginCredentialType::EOS_LCT_AccountPortal;
+        Credentials.Id = nullptr;
+        Credentials.Token = nullptr;
+
+ #if (defined(__APPLE__) && TARGET_OS_IPHONE)
+        // For iOS 13+ we need to pass the applications protocol implementation for ASWebAuthenticationPresentationContextProviding
+        // We bridge this to the C++ API using CFBridgingRetain, the EOS SDK will always release the bridged value as part of the contract
+        // NOTE: The SDK will consume this data before the scope is lost
+        EOS_IOS_Auth_CredentialsOptions CredentialsOptions = {};
+        CredentialsOptions.ApiVersion = EOS_IOS_AUTH_CREDENTIALSOPTIONS_API_LATEST;
+        CredentialsOptions.PresentationContextProviding = (void*)CreateWebAuthContextProvider(); // SDK will release when consumed
+        Credentials.SystemAuthCredentialsOptions = (void*)&CredentialsOptions;
+ #endif
+        EOS_Auth_LoginOptions LoginOptions = {};
+        LoginOptions.ApiVersion = EOS_AUTH_LOGIN_API_LATEST;
+        LoginOptions.ScopeFlags = EOS_EAuthScopeFlags::EOS_AS_BasicProfile;
+        LoginOptions.Credentials = &Credentials;
+
+        auto loginPointer = new AccountPortalLogin{ contextPointer, operationId };
+        EOS_Auth_Login(contextPointer->fAuthHandle, &LoginOptions, loginPointer, onAccountPortalLoginCallback);
+    });
+}
+
+#if !defined(__ANDROID__) && !(defined(__APPLE__) && TARGET_OS_IPHONE)
+/**
+  Stores the refresh token of the given logged in user in the SecureTokenStore, to log in with
+  on the next launch. Does nothing if desktop persistent login is disabled.
+  @param contextPointer The plugin's runtime context.
+  @param localUserId The Epic account that has logged in.
+ */
+static void StoreRefreshTokenOf(RuntimeContext *contextPointer, EOS_EpicAccountId localUserId) {
+    if (sRefreshTokenName.empty() || !contextPointer->fAuthHandle) {
+        return;
+    }
+
+    EOS_Auth_CopyUserAuthTokenOptions CopyTokenOptions = {};
+    CopyTokenOptions.ApiVersion = EOS_AUTH_COPYUSERAUTHTOKEN_API_LATEST;
+    EOS_Auth_Token *UserAuthToken = nullptr;
+    if (EOS_Auth_CopyUserAuthToken(contextPointer->fAuthHandle, &CopyTokenOptions, localUserId, &UserAuthToken) ==
+        EOS_EResult::EOS_Success) {
+        if (UserAuthToken->RefreshToken && !SecureTokenStore::Save(sRefreshTokenName.c_str(), UserAuthToken->RefreshToken)) {
+            CoronaLog("WARNING: [EOS SDK] Failed to store the refresh token.");
+        }
+        EOS_Auth_Token_Release(UserAuthToken);
+    }
+}
+
+void EOS_CALL onRefreshTokenLoginCallback(const EOS_Auth_LoginCallbackInfo *Data) {
+    if (!EOS_EResult_IsOperationComplete(Data->ResultCode)) {
+        return;
+    }
+
+    // Report the result as usual if logged in, or if the token might still be valid once online again.
+    bool isTransientFailure =
+            (Data->ResultCode == EOS_EResult::EOS_NoConnection) ||
+            (Data->ResultCode == EOS_EResult::EOS_TimedOut) ||
+            (Data->ResultCode == EOS_EResult::EOS_ServiceFailure) ||
+            (Data->ResultCode == EOS_EResult::EOS_TooManyRequests);
+    if ((Data->ResultCode == EOS_EResult::EOS_Success) || isTransientFailure) {
+        onLoginCallback(Data);
+        return;
+    }
+
+    // The stored token was rejected. Forget it and fall back to the account portal.
+    // Note: Lua receives the "loginResponse" event of the portal login instead of this one.
+    CoronaLog("[EOS SDK] Stored refresh token was rejected (%d). Falling back to the account portal.",
+              (int) Data->ResultCode);
+    SecureTokenStore::Remove(sRefreshTokenName.c_str());
+    if (RuntimeContext::IsAlive((RuntimeContext *) Data->ClientData)) {
+        StartAccountPortalLogin((RuntimeContext *) Data->ClientData, 0);
+    }
+}
+#endif
+
+/**
+  Initializes the EOS SDK, creates the platform and starts logging in the user, if possible.
+  Called by InitializeSDK() when the plugin is loaded, or on a later frame if initialization is deferred.
+  @param luaStatePointer Lua state to report errors to.
+  @param contextPointer The plugin's runtime context, which receives the platform handle.
+  @param configLuaSettings The plugin's settings loaded from the "config.lua" file.
+  @param SDKOptions Options to initialize the SDK with, not including the product name and version.
+ */
+static void StartEos(
+        lua_State *luaStatePointer, RuntimeContext *contextPointer,
+        const PluginConfigLuaSettings &configLuaSettings, EOS_InitializeOptions SDKOptions) {
     //Load SDKOptions from config.lua
     SDKOptions.ProductName = configLuaSettings.GetStringProductName();
     SDKOptions.ProductVersion = configLuaSettings.GetStringProductVersion();
+    auto &startupPipeline = contextPointer->GetStartupPipeline();
 
-    // Initialize our connection with EOS if this is the first plugin instance.
-    // Note: This avoid initializing twice in case multiple plugin instances exist at the same time.
-    if (RuntimeContext::GetInstanceCount() == 1) {
-        EOS_EResult InitResult = EOS_Initialize(&SDKOptions);
+    // Initialize our connection with EOS if no other plugin instance has done so yet.
+    // Note: The SDK can only be initialized once per process, even if multiple plugin instances exist at the same time.
+    if (!PlatformRegistry::IsSdkInitialized()) {
+        EOS_EResult InitResult = PlatformRegistry::InitializeSdk(SDKOptions);
         if (InitResult == EOS_EResult::EOS_InvalidParameters) {
             CoronaLuaError(luaStatePointer, "[EOS SDK] Init Failed! Invalid Parameters");
-            return 0;
+            return;
         } else if (InitResult == EOS_EResult::EOS_Android_JavaVMNotStored) {
             CoronaLuaError(luaStatePointer, "[EOS SDK] Init Failed! Java VM not stored");
-            return 0;
+            return;
         } else if (InitResult ==
                    EOS_EResult::EOS_AlreadyConfigured) // TODO: Apparently this happens the first time the simulator reloads, should probably prevent reaching this state though
         {
             CoronaLog("WARNING: [EOS SDK] Init Failed! Already Configured");
-            return 1;
+            return;
         }
 
         CoronaLog("[EOS SDK] Initialized. Setting Logging Callback ...");
@@ -223,17 +336,23 @@ extern "C" int InitializeSDK(lua_State *luaStatePointer, EOS_InitializeOptions S
         } else {
             CoronaLog("[EOS SDK] Logging Callback Set");
         }
+    }
 
-        // Create platform instance
+    // Create the platform, or share the one created by another plugin instance with the same IDs.
+    {
         EOS_Platform_Options PlatformOptions = {};
         PlatformOptions.ApiVersion = EOS_PLATFORM_OPTIONS_API_LATEST;
-        PlatformOptions.bIsServer = false;
+        PlatformOptions.bIsServer = configLuaSettings.IsServer() ? EOS_TRUE : EOS_FALSE;
         PlatformOptions.EncryptionKey = configLuaSettings.GetStringEncryptionKey();
         PlatformOptions.OverrideCountryCode = nullptr;
         PlatformOptions.OverrideLocaleCode = nullptr;
         PlatformOptions.Flags =
                 EOS_PF_WINDOWS_ENABLE_OVERLAY_D3D9 | EOS_PF_WINDOWS_ENABLE_OVERLAY_D3D10 |
                 EOS_PF_WINDOWS_ENABLE_OVERLAY_OPENGL; // Enable overlay support for D3D9/10 and OpenGL. This sample uses D3D11 or SDL.
+        if (configLuaSettings.IsServer()) {
+            // A headless server has no overlay to render.
+            PlatformOptions.Flags = EOS_PF_DISABLE_OVERLAY;
+        }
         // PlatformOptions.CacheDirectory = FUtils::GetTempDirectory();
 
         PlatformOptions.ProductId = configLuaSettings.GetStringProductId();
@@ -266,11 +385,27 @@ extern "C" int InitializeSDK(lua_State *luaStatePointer, EOS_InitializeOptions S
         PlatformOptions.Reserved = NULL;
 #endif // ALLOW_RESERVED_PLATFORM_OPTIONS
 
-        EOS_HPlatform platformHandle = EOS_Platform_Create(&PlatformOptions);
+        PlatformRegistry::Key platformKey;
+        platformKey.ProductId = configLuaSettings.GetStringProductId();
+        platformKey.SandboxId = configLuaSettings.GetStringSandboxId();
+        platformKey.DeploymentId = configLuaSettings.GetStringDeploymentId();
+        platformKey.InstanceName = configLuaSettings.GetStringPlatformInstance();
+        platformKey.IsServer = configLuaSettings.IsServer();
+
+        startupPipeline.OnStageStarted(StartupPipeline::Stage::kPlatform);
+        EOS_HPlatform platformHandle = PlatformRegistry::Acquire(platformKey, PlatformOptions);
         if (!platformHandle) {
             CoronaLuaError(luaStatePointer, "Failed to initialize connection with Epic client.");
         }
         contextPointer->fPlatformHandle = platformHandle;
+        startupPipeline.OnStageEnded(
+                StartupPipeline::Stage::kPlatform,
+                platformHandle ? EOS_EResult::EOS_Success : EOS_EResult::EOS_UnexpectedError);
+    }
+
+    // A dedicated server runs with its client credentials alone. Its players log in on their own devices.
+    if (configLuaSettings.IsServer()) {
+        return;
     }
 
 #ifndef EOS_STEAM_ENABLED
@@ -287,8 +422,18 @@ extern "C" int InitializeSDK(lua_State *luaStatePointer, EOS_InitializeOptions S
     LoginOptions.ApiVersion = EOS_AUTH_LOGIN_API_LATEST;
     LoginOptions.Credentials = &Credentials;
 
+    startupPipeline.OnStageStarted(StartupPipeline::Stage::kLogin);
     EOS_Auth_Login(contextPointer->fAuthHandle, &LoginOptions, contextPointer, onLoginCallback);
 #else
+    if (contextPointer->fPlatformHandle) {
+        contextPointer->fAuthHandle = EOS_Platform_GetAuthInterface(contextPointer->fPlatformHandle);
+    }
+    sRefreshTokenName.clear();
+    if (configLuaSettings.IsPersistentLoginEnabled() && SecureTokenStore::IsSupported()) {
+        sRefreshTokenName = std::string("plugin.eos.") + configLuaSettings.GetStringProductId() + ".refreshToken";
+    }
+    bool isLoggingIn = false;
+
    auto launcherAuthTypeLaunchArg = CMDLine::Map().find("AUTH_TYPE");
        auto launcherAuthPasswordLaunchArg = CMDLine::Map().find("AUTH_PASSWORD");
        if (contextPointer->fPlatformHandle && launcherAuthTypeLaunchArg != CMDLine::End() && launcherAuthPasswordLaunchArg != CMDLine::End()) {
@@ -297,8 +442,6 @@ extern "C" int InitializeSDK(lua_State *luaStatePointer, EOS_InitializeOptions S
        		std::string launcherAuthPassword = launcherAuthPasswordLaunchArg->second;
        		if (!launcherAuthPassword.empty())
        		{
-       			contextPointer->fAuthHandle = EOS_Platform_GetAuthInterface(contextPointer->fPlatformHandle);
-    
        			EOS_Auth_Credentials Credentials = {};
        			Credentials.ApiVersion = EOS_AUTH_CREDENTIALS_API_LATEST;
     
@@ -311,24 +454,164 @@ extern "C" int InitializeSDK(lua_State *luaStatePointer, EOS_InitializeOptions S
        			Credentials.Token = launcherAuthPassword.c_str();
        			LoginOptions.Credentials = &Credentials;
     
+       			startupPipeline.OnStageStarted(StartupPipeline::Stage::kLogin);
        			EOS_Auth_Login(contextPointer->fAuthHandle, &LoginOptions, contextPointer, onLoginCallback);
+       			isLoggingIn = true;
        		}
        	}
        }
+
+    // If not launched by the Epic launcher, log in with the refresh token stored by the last successful login.
+    // Note: This is a single backend call. The account portal is only displayed if the token is rejected.
+    std::string refreshToken;
+    if (!isLoggingIn && contextPointer->fAuthHandle && SecureTokenStore::Load(sRefreshTokenName.c_str(), refreshToken)) {
+        EOS_Auth_Credentials Credentials = {};
+        Credentials.ApiVersion = EOS_AUTH_CREDENTIALS_API_LATEST;
+        Credentials.Type = EOS_ELoginCredentialType::EOS_LCT_RefreshToken;
+        Credentials.Id = nullptr;
+        Credentials.Token = refreshToken.c_str();
+
+        EOS_Auth_LoginOptions LoginOptions = {};
+        LoginOptions.ApiVersion = EOS_AUTH_LOGIN_API_LATEST;
+        LoginOptions.ScopeFlags = EOS_EAuthScopeFlags::EOS_AS_BasicProfile;
+        LoginOptions.Credentials = &Credentials;
+
+        startupPipeline.OnStageStarted(StartupPipeline::Stage::kLogin);
+        EOS_Auth_Login(contextPointer->fAuthHandle, &LoginOptions, contextPointer, onRefreshTokenLoginCallback);
+    }
 #endif
 #endif
+}
+
+/**
+  Queues a call to the given Lua API function to be made again once EOS has been initialized,
+  if initialization has been deferred via the "config.lua" file and has not happened yet.
+  @param luaStatePointer Lua state providing the call's arguments.
+  @param contextPointer The plugin's runtime context.
+  @param luaFunction The Lua API function being called.
+  @return Returns true if the call was queued, in which case true has been pushed as its return value.
+          Returns false if EOS is already initialized, in which case the call should proceed.
+ */
+static bool QueueCallIfDeferred(lua_State *luaStatePointer, RuntimeContext *contextPointer, lua_CFunction luaFunction) {
+    if (!contextPointer->IsInitializationDeferred()) {
+        return false;
+    }
+    contextPointer->QueueDeferredCall(luaStatePointer, luaFunction);
+    lua_pushboolean(luaStatePointer, 1);
+    return true;
+}
+
+/**
+  Fetches the local user that a Lua API call acts on behalf of.
+  @param luaStatePointer Lua state providing the call's arguments.
+  @param luaStackIndex Stack index of the optional user handle argument returned by eos.getLocalUsers().
+  @param contextPointer The plugin's runtime context.
+  @return Returns the user with the given handle, or the last user to log in if no handle was given.
+          Returns null if that user is not logged in.
+ */
+static LocalUserTable::LocalUser *GetLocalUserFrom(
+        lua_State *luaStatePointer, int luaStackIndex, RuntimeContext *contextPointer) {
+    auto &localUsers = contextPointer->GetLocalUsers();
+    if (lua_type(luaStatePointer, luaStackIndex) == LUA_TNUMBER) {
+        return localUsers.GetBy((LocalUserTable::Handle) lua_tonumber(luaStatePointer, luaStackIndex));
+    }
+    return localUsers.GetBy(localUsers.FindBy(contextPointer->fAccountId));
+}
+
+//---------------------------------------------------------------------------------
+// Lua API Handlers
+//---------------------------------------------------------------------------------
+/** UserInfo eos.getAuthIdToken() */
+extern "C" int InitializeSDK(lua_State *luaStatePointer, EOS_InitializeOptions SDKOptions) {
+    // If this plugin instance is being loaded while another one already exists, then make sure that they're
+    // both running on the same thread to avoid race conditions since EOS's event handlers are global.
+    // Note: This can only happen if multiple Corona runtimes are running at the same time.
+    if (RuntimeContext::GetInstanceCount() > 0) {
+        if (std::this_thread::get_id() != sMainThreadId) {
+            luaL_error(luaStatePointer,
+                       "Cannot load another instance of 'plugin.eos' from another thread.");
+            return 0;
+        }
+    } else {
+        sMainThreadId = std::this_thread::get_id();
+    }
+
+    // Create a new runtime context used to receive EOS's event and dispatch them to Lua.
+    // Also used to ensure that the EOS overlay is rendered when requested on Windows.
+    // Note: The context maps itself to the Lua state, for the lookups made outside of the plugin's Lua functions.
+    auto contextPointer = new RuntimeContext(luaStatePointer);
+    if (!contextPointer) {
+        return 0;
+    }
+
+    // Fetch the EOS properties from the snapshot of the "config.lua" file, or from the file itself if it changed.
+    PluginConfigLuaSettings configLuaSettings;
+    configLuaSettings.LoadFromSnapshotOrConfig(luaStatePointer);
+
+    // Open the purchase journal and offline queue, which are kept apart per "platformInstance" name.
+    contextPointer->OpenPurchaseStorage(configLuaSettings.GetStringPlatformInstance());
+
+    // Download offer images to the caches directory after eos.loadProducts() if enabled in "config.lua".
+    if (configLuaSettings.IsProductImagePrefetchEnabled()) {
+        contextPointer->EnableOfferImageCache(configLuaSettings.GetImageCacheMaxBytes());
+    }
+
+    // Provide "loadProducts" offers via a lazy proxy instead of an array, if enabled in "config.lua".
+    contextPointer->SetLazyProductCatalogEnabled(configLuaSettings.IsLazyProductCatalogEnabled());
+
+    // Run the startup stages enabled in "config.lua" natively once the user has logged in.
+    auto &startupPipeline = contextPointer->GetStartupPipeline();
+    startupPipeline.SetStageEnabled(StartupPipeline::Stage::kLoadProducts, configLuaSettings.IsStartupLoadProductsEnabled());
+    startupPipeline.SetStageEnabled(StartupPipeline::Stage::kRestore, configLuaSettings.IsStartupRestoreEnabled());
+
+    // Log into the Connect interface after each Auth login, if enabled in "config.lua".
+    contextPointer->GetConnectSession().SetEnabled(configLuaSettings.IsConnectLoginEnabled());
+    startupPipeline.SetStageEnabled(StartupPipeline::Stage::kConnectLogin, configLuaSettings.IsConnectLoginEnabled());
+
+    // Hold the events received while suspended and pace them once resumed, as set in "config.lua".
+    contextPointer->SetBackgroundSettings(
+            configLuaSettings.GetSuspendedEventLimit(), configLuaSettings.IsDroppingOldestSuspendedEvents(),
+            configLuaSettings.GetResumeEventsPerFrame());
+
+    // Spread the garbage collection caused by large event bursts over several frames, if enabled in "config.lua".
+    auto &luaGcPacer = contextPointer->GetLuaGcPacer();
+    luaGcPacer.SetStepFrameCount(configLuaSettings.GetGcStepFrameCount());
+    luaGcPacer.SetPausingDuringDispatch(configLuaSettings.IsGcPausedDuringDispatch());
+    luaGcPacer.SetEnabled(configLuaSettings.IsGcPacingEnabled());
+
+    // Handle per-player sessions, stats, sanctions and anti-cheat instead of a local user, if set in "config.lua".
+    // Note: A server never logs in, so the stages and Connect session depending on a login are disabled.
+    contextPointer->GetDedicatedServer().SetEnabled(configLuaSettings.IsServer());
+    if (configLuaSettings.IsServer()) {
+        startupPipeline.SetStageEnabled(StartupPipeline::Stage::kLogin, false);
+        startupPipeline.SetStageEnabled(StartupPipeline::Stage::kConnectLogin, false);
+        startupPipeline.SetStageEnabled(StartupPipeline::Stage::kLoadProducts, false);
+        startupPipeline.SetStageEnabled(StartupPipeline::Stage::kRestore, false);
+        contextPointer->GetConnectSession().SetEnabled(false);
+    }
+
+    // Defer initializing EOS until first use, or until the configured delay has elapsed, if enabled in "config.lua".
+    // Note: The settings are copied since the initializer is invoked on a later frame.
+    if (configLuaSettings.IsInitializationDeferred()) {
+        auto settingsPointer = std::make_shared<PluginConfigLuaSettings>(configLuaSettings);
+        contextPointer->DeferInitialization([contextPointer, settingsPointer, SDKOptions]() {
+            StartEos(contextPointer->GetMainLuaState(), contextPointer, *settingsPointer, SDKOptions);
+        }, configLuaSettings.GetInitializationDelay());
+    } else {
+        StartEos(luaStatePointer, contextPointer, configLuaSettings, SDKOptions);
+    }
 
     return 1;
 }
 
-/** UserInfo eos.isLoggedOn() */
+/** UserInfo eos.isLoggedOn([userHandle]) */
 extern "C" int OnIsLoggedOn(lua_State *luaStatePointer) {
     auto contextPointer = GetRuntimeContextFromLuaState(luaStatePointer);
     if (!contextPointer) {
         return 0;
     }
 
-    if (!contextPointer->fAccountId) {
+    if (!GetLocalUserFrom(luaStatePointer, 1, contextPointer)) {
         lua_pushboolean(luaStatePointer, 0);
         return 1;
     }
@@ -342,7 +625,7 @@ extern "C" int OnIsLoggedOn(lua_State *luaStatePointer) {
     return 1;
 }
 
-/** UserInfo eos.loginWithAccountPortal() */
+/** operationId eos.loginWithAccountPortal() */
 extern "C" int OnLoginWithAccountPortal(lua_State *luaStatePointer) {
     // Fetch this plugin's runtime context associated with the calling Lua state.
     auto contextPointer = GetRuntimeContextFromLuaState(luaStatePointer);
@@ -350,32 +633,42 @@ extern "C" int OnLoginWithAccountPortal(lua_State *luaStatePointer) {
         return 0;
     }
 
-    EOS_Auth_Credentials Credentials = {};
-    Credentials.ApiVersion = EOS_AUTH_CREDENTIALS_API_LATEST;
-    Credentials.Type = EOS_ELoginCredentialType::EOS_LCT_AccountPortal;
-    Credentials.Id = nullptr;
-    Credentials.Token = nullptr;
+    // Call this function again once EOS has been initialized, if deferred.
+    if (QueueCallIfDeferred(luaStatePointer, contextPointer, OnLoginWithAccountPortal)) {
+        return 1;
+    }
 
- #if (defined(__APPLE__) && TARGET_OS_IPHONE)
-    // For iOS 13+ we need to pass the applications protocol implementation for ASWebAuthenticationPresentationContextProviding
-    // We bridge this to the C++ API using CFBridgingRetain, the EOS SDK will always release the bridged value as part of the contract
-    // NOTE: The SDK will consume this data before the scope is lost
-    EOS_IOS_Auth_CredentialsOptions CredentialsOptions = {};
-    CredentialsOptions.ApiVersion = EOS_IOS_AUTH_CREDENTIALSOPTIONS_API_LATEST;
-    CredentialsOptions.PresentationContextProviding = (void*)CreateWebAuthContextProvider(); // SDK will release when consumed
-    Credentials.SystemAuthCredentialsOptions = (void*)&CredentialsOptions;
- #endif
-    EOS_Auth_LoginOptions LoginOptions = {};
-    LoginOptions.ApiVersion = EOS_AUTH_LOGIN_API_LATEST;
-    LoginOptions.ScopeFlags = EOS_EAuthScopeFlags::EOS_AS_BasicProfile;
-    LoginOptions.Credentials = &Credentials;
+    uint64_t operationId = contextPointer->GetInflightOperations().Begin(
+            "loginWithAccountPortal", kInteractiveOperationTimeout);
+    StartAccountPortalLogin(contextPointer, operationId);
+    lua_pushnumber(luaStatePointer, (lua_Number) operationId);
+    return 1;
+}
 
-    EOS_Auth_Login(contextPointer->fAuthHandle, &LoginOptions, contextPointer, onLoginCallback);
+/** bool eos.loginWithDeviceId([displayName]) */
+extern "C" int OnLoginWithDeviceId(lua_State *luaStatePointer) {
+    // Fetch this plugin's runtime context associated with the calling Lua state.
+    auto contextPointer = GetRuntimeContextFromLuaState(luaStatePointer);
+    if (!contextPointer) {
+        return 0;
+    }
 
+    // Call this function again once EOS has been initialized, if deferred.
+    if (QueueCallIfDeferred(luaStatePointer, contextPointer, OnLoginWithDeviceId)) {
+        return 1;
+    }
+
+    // Log in anonymously as a guest. The result is dispatched as a "connectLoginResponse" event.
+    const char *displayName = nullptr;
+    if (lua_type(luaStatePointer, 1) == LUA_TSTRING) {
+        displayName = lua_tostring(luaStatePointer, 1);
+    }
+    bool wasStarted = contextPointer->GetConnectSession().LoginWithDeviceId(displayName);
+    lua_pushboolean(luaStatePointer, wasStarted ? 1 : 0);
     return 1;
 }
 
-/** UserInfo eos.getAuthIdToken() */
+/** UserInfo eos.getAuthIdToken([userHandle]) */
 extern "C" int OnGetAuthIdToken(lua_State *luaStatePointer) {
     // Validate.
     if (!luaStatePointer) {
@@ -388,20 +681,13 @@ extern "C" int OnGetAuthIdToken(lua_State *luaStatePointer) {
         return 0;
     }
 
-    auto eosAccountId = contextPointer->fAccountId;
-    if (!eosAccountId) {
+    auto userPointer = GetLocalUserFrom(luaStatePointer, 1, contextPointer);
+    if (!userPointer) {
         return 0;
     }
 
-    EOS_Auth_CopyIdTokenOptions CopyTokenOptions = {0};
-    CopyTokenOptions.ApiVersion = EOS_AUTH_COPYUSERAUTHTOKEN_API_LATEST;
-    CopyTokenOptions.AccountId = eosAccountId;
-
-    EOS_Auth_IdToken *outIdToken;
-    if (EOS_Auth_CopyIdToken(contextPointer->fAuthHandle, &CopyTokenOptions, &outIdToken) ==
-        EOS_EResult::EOS_Success) {
-        lua_pushstring(luaStatePointer, outIdToken->JsonWebToken);
-        EOS_Auth_IdToken_Release(outIdToken);
+    // Push the user's cached token string, which is only copied from EOS again once it changes or expires.
+    if (userPointer->AuthIdTokenCachePointer->PushTo(luaStatePointer)) {
         return 1;
     } else {
         CoronaLog("WARNING: [EOS SDK] User Auth Token is invalid");
@@ -409,6 +695,181 @@ extern "C" int OnGetAuthIdToken(lua_State *luaStatePointer) {
     }
 }
 
+/** stats eos.getRequestStats() */
+extern "C" int OnGetRequestStats(lua_State *luaStatePointer) {
+    // Validate.
+    if (!luaStatePointer) {
+        return 0;
+    }
+
+    // Fetch this plugin's runtime context associated with the calling Lua state.
+    auto contextPointer = GetRuntimeContextFromLuaState(luaStatePointer);
+    if (!contextPointer) {
+        return 0;
+    }
+
+    // Push a table of each interface's request counters, keyed by interface name such as "ecom".
+    auto &scheduler = contextPointer->GetRequestScheduler();
+    lua_createtable(luaStatePointer, 0, (int) RequestScheduler::Interface::kCount);
+    for (int index = 0; index < (int) RequestScheduler::Interface::kCount; index++) {
+        auto interfaceType = (RequestScheduler::Interface) index;
+        const RequestScheduler::Counters &counters = scheduler.GetCounters(interfaceType);
+        lua_createtable(luaStatePointer, 0, 7);
+        lua_pushnumber(luaStatePointer, (lua_Number) counters.Submitted);
+        lua_setfield(luaStatePointer, -2, "submitted");
+        lua_pushnumber(luaStatePointer, (lua_Number) counters.Sent);
+        lua_setfield(luaStatePointer, -2, "sent");
+        lua_pushnumber(luaStatePointer, (lua_Number) counters.Deferred);
+        lua_setfield(luaStatePointer, -2, "deferred");
+        lua_pushnumber(luaStatePointer, (lua_Number) counters.Retried);
+        lua_setfield(luaStatePointer, -2, "retried");
+        lua_pushnumber(luaStatePointer, (lua_Number) counters.Throttled);
+        lua_setfield(luaStatePointer, -2, "throttled");
+        lua_pushnumber(luaStatePointer, (lua_Number) counters.GaveUp);
+        lua_setfield(luaStatePointer, -2, "gaveUp");
+        lua_pushnumber(luaStatePointer, (lua_Number) scheduler.GetQueuedCount(interfaceType));
+        lua_setfield(luaStatePointer, -2, "queued");
+        lua_setfield(luaStatePointer, -2, RequestScheduler::GetInterfaceName(interfaceType));
+    }
+    return 1;
+}
+
+/** bool eos.cancel(operationId) */
+extern "C" int OnCancelOperation(lua_State *luaStatePointer) {
+    // Validate.
+    if (!luaStatePointer) {
+        return 0;
+    }
+    if (lua_type(luaStatePointer, 1) != LUA_TNUMBER) {
+        CoronaLuaError(luaStatePointer, "1st argument must be an operation ID returned by this plugin.");
+        lua_pushboolean(luaStatePointer, 0);
+        return 1;
+    }
+
+    // Fetch this plugin's runtime context associated with the calling Lua state.
+    auto contextPointer = GetRuntimeContextFromLuaState(luaStatePointer);
+    if (!contextPointer) {
+        return 0;
+    }
+
+    // Stop tracking the operation. EOS cannot abort these calls, so late query results are ignored instead.
+    auto operationId = (uint64_t) lua_tonumber(luaStatePointer, 1);
+    bool wasCancelled = contextPointer->GetInflightOperations().Cancel(operationId);
+    lua_pushboolean(luaStatePointer, wasCancelled ? 1 : 0);
+    return 1;
+}
+
+/** operations eos.getInflight() */
+extern "C" int OnGetInflight(lua_State *luaStatePointer) {
+    // Validate.
+    if (!luaStatePointer) {
+        return 0;
+    }
+
+    // Fetch this plugin's runtime context associated with the calling Lua state.
+    auto contextPointer = GetRuntimeContextFromLuaState(luaStatePointer);
+    if (!contextPointer) {
+        return 0;
+    }
+
+    // Push an array of the operations awaiting their callback, ordered from oldest to newest.
+    auto currentTime = std::chrono::steady_clock::now();
+    const auto &operations = contextPointer->GetInflightOperations().GetOperations();
+    lua_createtable(luaStatePointer, (int) operations.size(), 0);
+    int index = 1;
+    for (auto &&operation : operations) {
+        lua_createtable(luaStatePointer, 0, 5);
+        lua_pushnumber(luaStatePointer, (lua_Number) operation.Id);
+        lua_setfield(luaStatePointer, -2, "operationId");
+        lua_pushstring(luaStatePointer, operation.Name.c_str());
+        lua_setfield(luaStatePointer, -2, "operation");
+        lua_pushnumber(luaStatePointer, std::chrono::duration<double>(currentTime - operation.StartTime).count());
+        lua_setfield(luaStatePointer, -2, "elapsedTime");
+        lua_pushnumber(luaStatePointer, std::chrono::duration<double>(operation.Deadline - operation.StartTime).count());
+        lua_setfield(luaStatePointer, -2, "timeout");
+        lua_pushboolean(luaStatePointer, operation.HasTimedOut ? 1 : 0);
+        lua_setfield(luaStatePointer, -2, "isTimedOut");
+        lua_rawseti(luaStatePointer, -2, index++);
+    }
+    return 1;
+}
+
+/** productUserId eos.getProductUserId([userHandle]) */
+extern "C" int OnGetProductUserId(lua_State *luaStatePointer) {
+    // Validate.
+    if (!luaStatePointer) {
+        return 0;
+    }
+
+    // Fetch this plugin's runtime context associated with the calling Lua state.
+    auto contextPointer = GetRuntimeContextFromLuaState(luaStatePointer);
+    if (!contextPointer) {
+        return 0;
+    }
+
+    // Push the ID of the user's last Connect login. Nil if not logged into the Connect interface.
+    // Note: The ID cached by the Connect session is pushed when no user handle is given, which covers device ID logins.
+    auto &connectSession = contextPointer->GetConnectSession();
+    if (lua_type(luaStatePointer, 1) == LUA_TNUMBER) {
+        auto userPointer = GetLocalUserFrom(luaStatePointer, 1, contextPointer);
+        char stringBuffer[EOS_PRODUCTUSERID_MAX_LENGTH + 1];
+        int32_t stringLength = (int32_t) sizeof(stringBuffer);
+        if (!userPointer || !userPointer->ProductUserId ||
+            (EOS_ProductUserId_ToString(userPointer->ProductUserId, stringBuffer, &stringLength) != EOS_EResult::EOS_Success)) {
+            lua_pushnil(luaStatePointer);
+            return 1;
+        }
+        lua_pushstring(luaStatePointer, stringBuffer);
+        return 1;
+    }
+    if (!connectSession.GetProductUserId() || ('\0' == connectSession.GetProductUserIdString()[0])) {
+        lua_pushnil(luaStatePointer);
+        return 1;
+    }
+    lua_pushstring(luaStatePointer, connectSession.GetProductUserIdString());
+    return 1;
+}
+
+/** users eos.getLocalUsers() */
+extern "C" int OnGetLocalUsers(lua_State *luaStatePointer) {
+    // Validate.
+    if (!luaStatePointer) {
+        return 0;
+    }
+
+    // Fetch this plugin's runtime context associated with the calling Lua state.
+    auto contextPointer = GetRuntimeContextFromLuaState(luaStatePointer);
+    if (!contextPointer) {
+        return 0;
+    }
+
+    // Push an array of the logged in users, whose handles can be passed to the other APIs to act on their behalf.
+    auto &localUsers = contextPointer->GetLocalUsers();
+    auto userHandles = localUsers.GetHandles();
+    lua_createtable(luaStatePointer, (int) userHandles.size(), 0);
+    int index = 1;
+    for (auto &&userHandle : userHandles) {
+        auto userPointer = localUsers.GetBy(userHandle);
+        char stringBuffer[EOS_PRODUCTUSERID_MAX_LENGTH + 1];
+        int32_t stringLength = (int32_t) sizeof(stringBuffer);
+        lua_createtable(luaStatePointer, 0, 3);
+        lua_pushnumber(luaStatePointer, (lua_Number) userHandle);
+        lua_setfield(luaStatePointer, -2, "userHandle");
+        if (EOS_EpicAccountId_ToString(userPointer->AccountId, stringBuffer, &stringLength) == EOS_EResult::EOS_Success) {
+            lua_pushstring(luaStatePointer, stringBuffer);
+            lua_setfield(luaStatePointer, -2, "accountId");
+        }
+        stringLength = (int32_t) sizeof(stringBuffer);
+        if (userPointer->ProductUserId &&
+            (EOS_ProductUserId_ToString(userPointer->ProductUserId, stringBuffer, &stringLength) == EOS_EResult::EOS_Success)) {
+            lua_pushstring(luaStatePointer, stringBuffer);
+            lua_setfield(luaStatePointer, -2, "productUserId");
+        }
+        lua_rawseti(luaStatePointer, -2, index++);
+    }
+    return 1;
+}
+
 /** bool eos.setNotificationPosition(positionName) */
 int OnSetNotificationPosition(lua_State *luaStatePointer) {
     // Validate.
@@ -449,6 +910,11 @@ int OnSetNotificationPosition(lua_State *luaStatePointer) {
         return 0;
     }
 
+    // Call this function again once EOS has been initialized, if deferred.
+    if (QueueCallIfDeferred(luaStatePointer, contextPointer, OnSetNotificationPosition)) {
+        return 1;
+    }
+
     auto eosPlatformHandle = contextPointer->fPlatformHandle;
     if (eosPlatformHandle) {
         // Change EOS's notification position with given setting.
@@ -527,18 +993,76 @@ int OnFakeIAPInit(lua_State *luaStatePointer) {
     return 0;
 }
 
+/**
+  Client data of an Ecom request sent via the runtime context's request scheduler.
+  Its callback ignores the result once the context is deleted, since a shared platform outlives the context.
+ */
+struct ScheduledEcomRequest {
+    RuntimeContext *ContextPointer;
+    EOS_EpicAccountId AccountId;
+
+    /** Number of times the request has been sent, including this time. */
+    int AttemptCount;
+
+    /** ID of the request in the runtime context's in-flight operation registry. */
+    uint64_t OperationId;
+};
+
+void EOS_CALL QueryStoreCompleteCallbackFn(const EOS_Ecom_QueryOffersCallbackInfo *OfferData);
+
+static void SendQueryOffers(
+        RuntimeContext *contextPointer, EOS_EpicAccountId eosAccountId, int attemptCount, uint64_t operationId) {
+    if (!contextPointer->fPlatformHandle) {
+        contextPointer->GetInflightOperations().End(operationId);
+        return;
+    }
+
+    EOS_HEcom EcomHandle = EOS_Platform_GetEcomInterface(contextPointer->fPlatformHandle);
+
+    EOS_Ecom_QueryOffersOptions QueryOptions{0};
+    QueryOptions.ApiVersion = EOS_ECOM_QUERYOFFERS_API_LATEST;
+    QueryOptions.LocalUserId = eosAccountId;
+    QueryOptions.OverrideCatalogNamespace = nullptr;
+
+    auto queryPointer = new ScheduledEcomRequest{ contextPointer, eosAccountId, attemptCount, operationId };
+    EOS_Ecom_QueryOffers(EcomHandle, &QueryOptions, queryPointer, QueryStoreCompleteCallbackFn);
+}
+
 void EOS_CALL QueryStoreCompleteCallbackFn(const EOS_Ecom_QueryOffersCallbackInfo *OfferData) {
     if (!EOS_EResult_IsOperationComplete(OfferData->ResultCode)) {
         return;
     }
 
-    auto contextPointer = (RuntimeContext *) OfferData->ClientData;
-    if (contextPointer) {
-        contextPointer->OnLoadProductsResponse(OfferData);
+    std::unique_ptr<ScheduledEcomRequest> queryPointer((ScheduledEcomRequest *) OfferData->ClientData);
+    if (!queryPointer || !RuntimeContext::IsAlive(queryPointer->ContextPointer)) {
+        return;
+    }
+
+    // Ignore the result if Lua cancelled the query via eos.cancel().
+    auto contextPointer = queryPointer->ContextPointer;
+    uint64_t operationId = queryPointer->OperationId;
+    if (!contextPointer->GetInflightOperations().Contains(operationId)) {
+        return;
+    }
+
+    // Query the offers again later if EOS was busy or unreachable, reporting the result once it is final.
+    auto eosAccountId = queryPointer->AccountId;
+    int attemptCount = queryPointer->AttemptCount;
+    bool wasRetried = contextPointer->GetRequestScheduler().ScheduleRetry(
+            RequestScheduler::Interface::kEcom, OfferData->ResultCode, attemptCount,
+            [contextPointer, eosAccountId, attemptCount, operationId]() {
+                SendQueryOffers(contextPointer, eosAccountId, attemptCount + 1, operationId);
+            });
+    if (!wasRetried) {
+        // Note: The event task expects the runtime context as the callback's client data.
+        EOS_Ecom_QueryOffersCallbackInfo ResponseData = *OfferData;
+        ResponseData.ClientData = contextPointer;
+        contextPointer->GetInflightOperations().End(operationId);
+        contextPointer->OnLoadProductsResponse(&ResponseData);
     }
 }
 
-/** bool eos.loadProducts() */
+/** operationId eos.loadProducts([userHandle]) */
 extern "C" int OnLoadProducts(lua_State *luaStatePointer) {
     // Do not continue if the 1st argument is not a Lua function.
 //    if (!lua_isfunction(luaStatePointer, 1)) {
@@ -553,25 +1077,29 @@ extern "C" int OnLoadProducts(lua_State *luaStatePointer) {
         return 0;
     }
 
+    // Call this function again once EOS has been initialized, if deferred.
+    if (QueueCallIfDeferred(luaStatePointer, contextPointer, OnLoadProducts)) {
+        return 1;
+    }
+
     auto eosPlatformHandle = contextPointer->fPlatformHandle;
     if (!eosPlatformHandle) {
         return 0;
     }
 
-    auto eosAccountId = contextPointer->fAccountId;
-    if (!eosAccountId) {
+    auto userPointer = GetLocalUserFrom(luaStatePointer, 1, contextPointer);
+    if (!userPointer) {
         return 0;
     }
+    auto eosAccountId = userPointer->AccountId;
 
-    EOS_HEcom EcomHandle = EOS_Platform_GetEcomInterface(eosPlatformHandle);
-
-    EOS_Ecom_QueryOffersOptions QueryOptions{0};
-    QueryOptions.ApiVersion = EOS_ECOM_QUERYOFFERS_API_LATEST;
-    QueryOptions.LocalUserId = eosAccountId;
-    QueryOptions.OverrideCatalogNamespace = nullptr;
-
-    EOS_Ecom_QueryOffers(EcomHandle, &QueryOptions, contextPointer, QueryStoreCompleteCallbackFn);
+    uint64_t operationId = contextPointer->GetInflightOperations().Begin("loadProducts", kEcomQueryTimeout);
+    contextPointer->GetRequestScheduler().Submit(
+            RequestScheduler::Interface::kEcom, [contextPointer, eosAccountId, operationId]() {
+                SendQueryOffers(contextPointer, eosAccountId, 1, operationId);
+            });
 
+    lua_pushnumber(luaStatePointer, (lua_Number) operationId);
     return 1;
 }
 
@@ -580,24 +1108,53 @@ void EOS_CALL CheckoutCompleteCallbackFn(const EOS_Ecom_CheckoutCallbackInfo *Ch
         return;
     }
 
-    if (CheckoutData->ResultCode != EOS_EResult::EOS_Success) {
+    std::unique_ptr<ScheduledEcomRequest> checkoutPointer((ScheduledEcomRequest *) CheckoutData->ClientData);
+    if (!checkoutPointer || !RuntimeContext::IsAlive(checkoutPointer->ContextPointer)) {
         return;
     }
 
-    auto contextPointer = (RuntimeContext *) CheckoutData->ClientData;
-    if (contextPointer) {
-        contextPointer->OnCheckoutProductResponse(CheckoutData);
-    }
+    // Checkouts are not idempotent, so they are never retried. Only count throttled ones.
+    // Note: The result is delivered even if Lua cancelled the checkout, since the purchase may have gone through.
+    auto contextPointer = checkoutPointer->ContextPointer;
+    contextPointer->GetRequestScheduler().OnResultReceived(RequestScheduler::Interface::kEcom, CheckoutData->ResultCode);
+    contextPointer->GetInflightOperations().End(checkoutPointer->OperationId);
+
+    // Failed and cancelled checkouts are delivered too, as "storeTransaction" events flagged as errors.
+    // Note: The event task expects the runtime context as the callback's client data.
+    EOS_Ecom_CheckoutCallbackInfo ResponseData = *CheckoutData;
+    ResponseData.ClientData = contextPointer;
+    contextPointer->OnCheckoutProductResponse(&ResponseData);
 }
 
-/** bool eos.purchase() */
+/** operationId eos.purchase(offerId [, userHandle]) or eos.purchase({offerId1, offerId2, ...} [, userHandle]) */
 extern "C" int OnPurchaseProduct(lua_State *luaStatePointer) {
-    // Do not continue if the 1st argument is not a Lua function.
-    if (!lua_isstring(luaStatePointer, 1)) {
-        CoronaLuaError(luaStatePointer, "1st argument must be a Lua String.");
+    // Collect the offer IDs to check out, either a single string or an array of strings.
+    // Note: The strings are copied since the checkout can be sent on a later frame if rate limited.
+    std::vector<std::string> offerIds;
+    if (lua_type(luaStatePointer, 1) == LUA_TSTRING) {
+        offerIds.push_back(lua_tostring(luaStatePointer, 1));
+    } else if (lua_istable(luaStatePointer, 1)) {
+        int offerCount = (int) lua_objlen(luaStatePointer, 1);
+        if (offerCount < 1 || offerCount > EOS_ECOM_CHECKOUT_MAX_ENTRIES) {
+            CoronaLuaError(luaStatePointer, "1st argument must contain between 1 and %d offer IDs.",
+                           EOS_ECOM_CHECKOUT_MAX_ENTRIES);
+            return 0;
+        }
+        offerIds.reserve(offerCount);
+        for (int index = 1; index <= offerCount; index++) {
+            lua_rawgeti(luaStatePointer, 1, index);
+            if (lua_type(luaStatePointer, -1) != LUA_TSTRING) {
+                lua_pop(luaStatePointer, 1);
+                CoronaLuaError(luaStatePointer, "Offer ID at index %d is not a Lua String.", index);
+                return 0;
+            }
+            offerIds.push_back(lua_tostring(luaStatePointer, -1));
+            lua_pop(luaStatePointer, 1);
+        }
+    } else {
+        CoronaLuaError(luaStatePointer, "1st argument must be a Lua String or an array of Lua Strings.");
         return 0;
     }
-    const char* offerId = lua_tostring(luaStatePointer, 1);
 
     // Fetch the runtime context associated with the calling Lua state.
     auto contextPointer = GetRuntimeContextFromLuaState(luaStatePointer);
@@ -605,35 +1162,77 @@ extern "C" int OnPurchaseProduct(lua_State *luaStatePointer) {
         return 0;
     }
 
+    // Call this function again once EOS has been initialized, if deferred.
+    if (QueueCallIfDeferred(luaStatePointer, contextPointer, OnPurchaseProduct)) {
+        return 1;
+    }
+
     auto eosPlatformHandle = contextPointer->fPlatformHandle;
     if (!eosPlatformHandle) {
         return 0;
     }
 
-    auto eosAccountId = contextPointer->fAccountId;
-    if (!eosAccountId) {
+    auto userPointer = GetLocalUserFrom(luaStatePointer, 2, contextPointer);
+    if (!userPointer) {
         return 0;
     }
+    auto eosAccountId = userPointer->AccountId;
+
+    uint64_t operationId = contextPointer->GetInflightOperations().Begin("purchase", kInteractiveOperationTimeout);
+    contextPointer->GetRequestScheduler().Submit(
+            RequestScheduler::Interface::kEcom, [contextPointer, eosAccountId, offerIds, operationId]() {
+                // Note: Once sent, the checkout's callback ends the operation.
+                if (!contextPointer->fPlatformHandle) {
+                    contextPointer->GetInflightOperations().End(operationId);
+                    return;
+                }
+
+                EOS_HEcom EcomHandle = EOS_Platform_GetEcomInterface(contextPointer->fPlatformHandle);
+
+                // All offers are checked out in a single overlay round trip.
+                std::vector<EOS_Ecom_CheckoutEntry> CheckoutEntries;
+                CheckoutEntries.reserve(offerIds.size());
+                for (auto&& offerId : offerIds) {
+                    EOS_Ecom_CheckoutEntry Entry;
+                    Entry.ApiVersion = EOS_ECOM_CHECKOUTENTRY_API_LATEST;
+                    Entry.OfferId = offerId.c_str();
+                    CheckoutEntries.push_back(Entry);
+                }
+
+                EOS_Ecom_CheckoutOptions CheckoutOptions{0};
+                CheckoutOptions.ApiVersion = EOS_ECOM_CHECKOUT_API_LATEST;
+                CheckoutOptions.LocalUserId = eosAccountId;
+                CheckoutOptions.OverrideCatalogNamespace = nullptr;
+                // CheckoutOptions.PreferredOrientation = nullptr;
+                CheckoutOptions.EntryCount = static_cast<uint32_t>(CheckoutEntries.size());
+                CheckoutOptions.Entries = &CheckoutEntries[0];
+
+                auto checkoutPointer = new ScheduledEcomRequest{ contextPointer, eosAccountId, 1, operationId };
+                EOS_Ecom_Checkout(EcomHandle, &CheckoutOptions, checkoutPointer, CheckoutCompleteCallbackFn);
+            });
+
+    lua_pushnumber(luaStatePointer, (lua_Number) operationId);
+    return 1;
+}
 
-    EOS_HEcom EcomHandle = EOS_Platform_GetEcomInterface(eosPlatformHandle);
+void EOS_CALL QueryEntitlementsCompleteCallbackFn(const EOS_Ecom_QueryEntitlementsCallbackInfo *QueryEntitlementsData);
 
-    std::vector<EOS_Ecom_CheckoutEntry> CheckoutEntries;
-    EOS_Ecom_CheckoutEntry Entry;
-    Entry.ApiVersion = EOS_ECOM_CHECKOUTENTRY_API_LATEST;
-    Entry.OfferId = offerId;
-    CheckoutEntries.push_back(Entry);
+static void SendQueryEntitlements(
+        RuntimeContext *contextPointer, EOS_EpicAccountId eosAccountId, int attemptCount, uint64_t operationId) {
+    if (!contextPointer->fPlatformHandle) {
+        contextPointer->GetInflightOperations().End(operationId);
+        return;
+    }
 
-    EOS_Ecom_CheckoutOptions CheckoutOptions{0};
-    CheckoutOptions.ApiVersion = EOS_ECOM_CHECKOUT_API_LATEST;
-    CheckoutOptions.LocalUserId = eosAccountId;
-    CheckoutOptions.OverrideCatalogNamespace = nullptr;
-    // CheckoutOptions.PreferredOrientation = nullptr;
-    CheckoutOptions.EntryCount = static_cast<uint32_t>(CheckoutEntries.size());
-    CheckoutOptions.Entries = &CheckoutEntries[0];
+    EOS_HEcom EcomHandle = EOS_Platform_GetEcomInterface(contextPointer->fPlatformHandle);
 
-    EOS_Ecom_Checkout(EcomHandle, &CheckoutOptions, contextPointer, CheckoutCompleteCallbackFn);
+    EOS_Ecom_QueryEntitlementsOptions QueryOptions{ 0 };
+    QueryOptions.ApiVersion = EOS_ECOM_QUERYENTITLEMENTS_API_LATEST;
+    QueryOptions.LocalUserId = eosAccountId;
+    QueryOptions.bIncludeRedeemed = true;
 
-    return 1;
+    auto queryPointer = new ScheduledEcomRequest{ contextPointer, eosAccountId, attemptCount, operationId };
+    EOS_Ecom_QueryEntitlements(EcomHandle, &QueryOptions, queryPointer, QueryEntitlementsCompleteCallbackFn);
 }
 
 void EOS_CALL QueryEntitlementsCompleteCallbackFn(const EOS_Ecom_QueryEntitlementsCallbackInfo *QueryEntitlementsData) {
@@ -641,17 +1240,42 @@ void EOS_CALL QueryEntitlementsCompleteCallbackFn(const EOS_Ecom_QueryEntitlemen
         return;
     }
 
-    if (QueryEntitlementsData->ResultCode != EOS_EResult::EOS_Success) {
+    std::unique_ptr<ScheduledEcomRequest> queryPointer((ScheduledEcomRequest *) QueryEntitlementsData->ClientData);
+    if (!queryPointer || !RuntimeContext::IsAlive(queryPointer->ContextPointer)) {
         return;
     }
 
-    auto contextPointer = (RuntimeContext *) QueryEntitlementsData->ClientData;
-    if (contextPointer) {
-        contextPointer->OnQueryEntitlementsResponse(QueryEntitlementsData);
+    // Ignore the result if Lua cancelled the query via eos.cancel().
+    auto contextPointer = queryPointer->ContextPointer;
+    uint64_t operationId = queryPointer->OperationId;
+    if (!contextPointer->GetInflightOperations().Contains(operationId)) {
+        return;
     }
+
+    // Query the entitlements again later if EOS was busy or unreachable.
+    auto eosAccountId = queryPointer->AccountId;
+    int attemptCount = queryPointer->AttemptCount;
+    bool wasRetried = contextPointer->GetRequestScheduler().ScheduleRetry(
+            RequestScheduler::Interface::kEcom, QueryEntitlementsData->ResultCode, attemptCount,
+            [contextPointer, eosAccountId, attemptCount, operationId]() {
+                SendQueryEntitlements(contextPointer, eosAccountId, attemptCount + 1, operationId);
+            });
+    if (wasRetried) {
+        return;
+    }
+    contextPointer->GetInflightOperations().End(operationId);
+
+    if (QueryEntitlementsData->ResultCode != EOS_EResult::EOS_Success) {
+        return;
+    }
+
+    // Note: The event task expects the runtime context as the callback's client data.
+    EOS_Ecom_QueryEntitlementsCallbackInfo ResponseData = *QueryEntitlementsData;
+    ResponseData.ClientData = contextPointer;
+    contextPointer->OnQueryEntitlementsResponse(&ResponseData);
 }
 
-/** bool eos.restore() */
+/** operationId eos.restore([userHandle]) */
 extern "C" int OnRestorePurchases(lua_State *luaStatePointer) {
     // Fetch the runtime context associated with the calling Lua state.
     auto contextPointer = GetRuntimeContextFromLuaState(luaStatePointer);
@@ -659,33 +1283,385 @@ extern "C" int OnRestorePurchases(lua_State *luaStatePointer) {
         return 0;
     }
 
+    // Call this function again once EOS has been initialized, if deferred.
+    if (QueueCallIfDeferred(luaStatePointer, contextPointer, OnRestorePurchases)) {
+        return 1;
+    }
+
     auto eosPlatformHandle = contextPointer->fPlatformHandle;
     if (!eosPlatformHandle) {
         return 0;
     }
 
-    auto eosAccountId = contextPointer->fAccountId;
-    if (!eosAccountId) {
+    auto userPointer = GetLocalUserFrom(luaStatePointer, 1, contextPointer);
+    if (!userPointer) {
         return 0;
     }
+    auto eosAccountId = userPointer->AccountId;
 
-    EOS_HEcom EcomHandle = EOS_Platform_GetEcomInterface(eosPlatformHandle);
+    uint64_t operationId = contextPointer->GetInflightOperations().Begin("restore", kEcomQueryTimeout);
+    contextPointer->GetRequestScheduler().Submit(
+            RequestScheduler::Interface::kEcom, [contextPointer, eosAccountId, operationId]() {
+                SendQueryEntitlements(contextPointer, eosAccountId, 1, operationId);
+            });
 
-    EOS_Ecom_QueryEntitlementsOptions QueryOptions{ 0 };
-    QueryOptions.ApiVersion = EOS_ECOM_QUERYENTITLEMENTS_API_LATEST;
-    QueryOptions.LocalUserId = eosAccountId;
-    QueryOptions.bIncludeRedeemed = true;
+    lua_pushnumber(luaStatePointer, (lua_Number) operationId);
+    return 1;
+}
 
-    EOS_Ecom_QueryEntitlements(EcomHandle, &QueryOptions, contextPointer, QueryEntitlementsCompleteCallbackFn);
+/** bool eos.finishTransaction(transaction [, userHandle]) or eos.finishTransaction(entitlementId [, userHandle]) */
+extern "C" int OnFinishTransaction(lua_State *luaStatePointer) {
+    // Fetch the entitlement ID from a "storeTransaction" transaction table or from a string.
+    const char *entitlementId = nullptr;
+    if (lua_istable(luaStatePointer, 1)) {
+        lua_getfield(luaStatePointer, 1, "identifier");
+        if (lua_type(luaStatePointer, -1) == LUA_TSTRING) {
+            entitlementId = lua_tostring(luaStatePointer, -1);
+        }
+        lua_pop(luaStatePointer, 1);
+    } else if (lua_type(luaStatePointer, 1) == LUA_TSTRING) {
+        entitlementId = lua_tostring(luaStatePointer, 1);
+    }
+    if (!entitlementId) {
+        CoronaLuaError(luaStatePointer, "1st argument must be a transaction table or an entitlement ID.");
+        lua_pushboolean(luaStatePointer, 0);
+        return 1;
+    }
+
+    // Fetch the runtime context associated with the calling Lua state.
+    auto contextPointer = GetRuntimeContextFromLuaState(luaStatePointer);
+    if (!contextPointer) {
+        return 0;
+    }
 
+    // Queue the entitlement to be redeemed with the user's next batch.
+    auto userPointer = GetLocalUserFrom(luaStatePointer, 2, contextPointer);
+    if (!userPointer) {
+        lua_pushboolean(luaStatePointer, 0);
+        return 1;
+    }
+    bool wasQueued = contextPointer->QueueEntitlementRedemption(entitlementId, userPointer->AccountId);
+    lua_pushboolean(luaStatePointer, wasQueued ? 1 : 0);
     return 1;
 }
 
-/** bool eos.finishTransaction() */
-extern "C" int OnFinishTransaction(lua_State *luaStatePointer) {
+/**
+  Pushes the given tokens to Lua as an array, or nil if the tokens are still being queried.
+  @param luaStatePointer Lua state to push the result to.
+  @param wasCached Set true if "tokens" provides every requested token.
+  @param tokens The tokens fetched from the EcomTokenCache.
+ */
+static void PushEcomTokensTo(lua_State *luaStatePointer, bool wasCached, const std::vector<std::string> &tokens) {
+    if (!wasCached) {
+        lua_pushnil(luaStatePointer);
+        return;
+    }
+    lua_createtable(luaStatePointer, (int) tokens.size(), 0);
+    for (int index = 0; index < (int) tokens.size(); index++) {
+        lua_pushstring(luaStatePointer, tokens.at(index).c_str());
+        lua_rawseti(luaStatePointer, -2, index + 1);
+    }
+}
+
+/**
+  Copies the strings of the Lua array at the given stack index.
+  @param luaStatePointer Lua state to read the array from.
+  @param luaStackIndex Stack index of the array.
+  @param outStrings Receives the strings.
+  @return Returns true if every element of the array is a string. Returns false if not, after raising a Lua error.
+ */
+static bool CopyLuaStringArray(lua_State *luaStatePointer, int luaStackIndex, std::vector<std::string> &outStrings) {
+    int count = (int) lua_objlen(luaStatePointer, luaStackIndex);
+    outStrings.reserve(count);
+    for (int index = 1; index <= count; index++) {
+        lua_rawgeti(luaStatePointer, luaStackIndex, index);
+        if (lua_type(luaStatePointer, -1) != LUA_TSTRING) {
+            lua_pop(luaStatePointer, 1);
+            CoronaLuaError(luaStatePointer, "Array element at index %d is not a Lua String.", index);
+            return false;
+        }
+        outStrings.push_back(lua_tostring(luaStatePointer, -1));
+        lua_pop(luaStatePointer, 1);
+    }
+    return true;
+}
+
+/** tokens eos.getOwnershipToken(catalogItemIds [, catalogNamespace [, userHandle]]) */
+extern "C" int OnGetOwnershipToken(lua_State *luaStatePointer) {
+    // Fetch the catalog item IDs.
+    std::vector<std::string> catalogItemIds;
+    if (lua_type(luaStatePointer, 1) == LUA_TSTRING) {
+        catalogItemIds.push_back(lua_tostring(luaStatePointer, 1));
+    } else if (!lua_istable(luaStatePointer, 1) || (lua_objlen(luaStatePointer, 1) < 1)) {
+        CoronaLuaError(luaStatePointer, "1st argument must be a catalog item ID or an array of catalog item IDs.");
+        return 0;
+    } else if (!CopyLuaStringArray(luaStatePointer, 1, catalogItemIds)) {
+        return 0;
+    }
+    const char *catalogNamespace = nullptr;
+    if (lua_type(luaStatePointer, 2) == LUA_TSTRING) {
+        catalogNamespace = lua_tostring(luaStatePointer, 2);
+    }
+
+    // Fetch the runtime context associated with the calling Lua state.
+    auto contextPointer = GetRuntimeContextFromLuaState(luaStatePointer);
+    if (!contextPointer) {
+        return 0;
+    }
+
+    auto userPointer = GetLocalUserFrom(luaStatePointer, 3, contextPointer);
+    if (!userPointer) {
+        return 0;
+    }
+
+    // Return the user's cached tokens, or nil if an "ownershipToken" event will follow.
+    std::vector<std::string> tokens;
+    bool wasCached = userPointer->EcomTokenCachePointer->GetTokens(
+            EcomTokenCache::TokenType::kOwnership, catalogItemIds, catalogNamespace, tokens);
+    PushEcomTokensTo(luaStatePointer, wasCached, tokens);
+    return 1;
+}
+
+/** tokens eos.getEntitlementToken([entitlementNames [, userHandle]]) */
+extern "C" int OnGetEntitlementToken(lua_State *luaStatePointer) {
+    // Fetch the entitlement names. No names requests a token covering all of the user's entitlements.
+    std::vector<std::string> entitlementNames;
+    if (lua_type(luaStatePointer, 1) == LUA_TSTRING) {
+        entitlementNames.push_back(lua_tostring(luaStatePointer, 1));
+    } else if (lua_istable(luaStatePointer, 1)) {
+        if (!CopyLuaStringArray(luaStatePointer, 1, entitlementNames)) {
+            return 0;
+        }
+    } else if (!lua_isnoneornil(luaStatePointer, 1)) {
+        CoronaLuaError(luaStatePointer, "1st argument must be an entitlement name or an array of entitlement names.");
+        return 0;
+    }
+
+    // Fetch the runtime context associated with the calling Lua state.
+    auto contextPointer = GetRuntimeContextFromLuaState(luaStatePointer);
+    if (!contextPointer) {
+        return 0;
+    }
+
+    auto userPointer = GetLocalUserFrom(luaStatePointer, 2, contextPointer);
+    if (!userPointer) {
+        return 0;
+    }
+
+    // Return the user's cached tokens, or nil if an "entitlementToken" event will follow.
+    std::vector<std::string> tokens;
+    bool wasCached = userPointer->EcomTokenCachePointer->GetTokens(
+            EcomTokenCache::TokenType::kEntitlement, entitlementNames, nullptr, tokens);
+    PushEcomTokensTo(luaStatePointer, wasCached, tokens);
+    return 1;
+}
+
+/** bool eos.addPlayer(productUserId [, {sessionName=, ipAddress=}]) */
+extern "C" int OnAddPlayer(lua_State *luaStatePointer) {
+    // Fetch the arguments.
+    if (lua_type(luaStatePointer, 1) != LUA_TSTRING) {
+        CoronaLuaError(luaStatePointer, "1st argument must be a product user ID string.");
+        return 0;
+    }
+    std::string sessionName;
+    std::string ipAddress;
+    if (lua_istable(luaStatePointer, 2)) {
+        lua_getfield(luaStatePointer, 2, "sessionName");
+        if (lua_type(luaStatePointer, -1) == LUA_TSTRING) {
+            sessionName = lua_tostring(luaStatePointer, -1);
+        }
+        lua_pop(luaStatePointer, 1);
+        lua_getfield(luaStatePointer, 2, "ipAddress");
+        if (lua_type(luaStatePointer, -1) == LUA_TSTRING) {
+            ipAddress = lua_tostring(luaStatePointer, -1);
+        }
+        lua_pop(luaStatePointer, 1);
+    }
+
+    // Fetch the runtime context associated with the calling Lua state.
+    auto contextPointer = GetRuntimeContextFromLuaState(luaStatePointer);
+    if (!contextPointer) {
+        return 0;
+    }
+    if (QueueCallIfDeferred(luaStatePointer, contextPointer, OnAddPlayer)) {
+        return 1;
+    }
+
+    // Start tracking the player. Returns false if not running as a server.
+    bool wasAdded = contextPointer->GetDedicatedServer().AddPlayer(
+            lua_tostring(luaStatePointer, 1), sessionName.c_str(), ipAddress.c_str());
+    lua_pushboolean(luaStatePointer, wasAdded ? 1 : 0);
+    return 1;
+}
+
+/** bool eos.removePlayer(productUserId) */
+extern "C" int OnRemovePlayer(lua_State *luaStatePointer) {
+    if (lua_type(luaStatePointer, 1) != LUA_TSTRING) {
+        CoronaLuaError(luaStatePointer, "1st argument must be a product user ID string.");
+        return 0;
+    }
+
+    // Fetch the runtime context associated with the calling Lua state.
+    auto contextPointer = GetRuntimeContextFromLuaState(luaStatePointer);
+    if (!contextPointer) {
+        return 0;
+    }
+    if (QueueCallIfDeferred(luaStatePointer, contextPointer, OnRemovePlayer)) {
+        return 1;
+    }
+
+    bool wasRemoved = contextPointer->GetDedicatedServer().RemovePlayer(lua_tostring(luaStatePointer, 1));
+    lua_pushboolean(luaStatePointer, wasRemoved ? 1 : 0);
+    return 1;
+}
+
+/** bool eos.ingestStat(productUserId, statName, amount) */
+extern "C" int OnIngestStat(lua_State *luaStatePointer) {
+    // Fetch the arguments.
+    if (lua_type(luaStatePointer, 1) != LUA_TSTRING) {
+        CoronaLuaError(luaStatePointer, "1st argument must be a product user ID string.");
+        return 0;
+    }
+    if (lua_type(luaStatePointer, 2) != LUA_TSTRING) {
+        CoronaLuaError(luaStatePointer, "2nd argument must be a stat name string.");
+        return 0;
+    }
+    if (lua_type(luaStatePointer, 3) != LUA_TNUMBER) {
+        CoronaLuaError(luaStatePointer, "3rd argument must be the amount to ingest.");
+        return 0;
+    }
+
+    // Fetch the runtime context associated with the calling Lua state.
+    auto contextPointer = GetRuntimeContextFromLuaState(luaStatePointer);
+    if (!contextPointer) {
+        return 0;
+    }
+    if (QueueCallIfDeferred(luaStatePointer, contextPointer, OnIngestStat)) {
+        return 1;
+    }
+
+    // Queue the amount. It is summed with the player's other ingests of the stat and sent with the next batch.
+    bool wasQueued = contextPointer->GetDedicatedServer().IngestStat(
+            lua_tostring(luaStatePointer, 1), lua_tostring(luaStatePointer, 2),
+            (int32_t) lua_tonumber(luaStatePointer, 3));
+    lua_pushboolean(luaStatePointer, wasQueued ? 1 : 0);
+    return 1;
+}
+
+/** players eos.getPlayers() */
+extern "C" int OnGetPlayers(lua_State *luaStatePointer) {
+    // Validate.
+    if (!luaStatePointer) {
+        return 0;
+    }
+
+    // Fetch the runtime context associated with the calling Lua state.
+    auto contextPointer = GetRuntimeContextFromLuaState(luaStatePointer);
+    if (!contextPointer) {
+        return 0;
+    }
+
+    // Push an array of the players tracked by the dedicated server. Empty if not running as a server.
+    auto &players = contextPointer->GetDedicatedServer().GetPlayers();
+    lua_createtable(luaStatePointer, (int) players.GetCount(), 0);
+    for (size_t index = 0; index < players.GetCount(); index++) {
+        auto &player = players.GetAt(index);
+        lua_createtable(luaStatePointer, 0, 5);
+        lua_pushstring(luaStatePointer, player.ProductUserIdString);
+        lua_setfield(luaStatePointer, -2, "productUserId");
+        if (!player.SessionName.empty()) {
+            lua_pushstring(luaStatePointer, player.SessionName.c_str());
+            lua_setfield(luaStatePointer, -2, "sessionName");
+        }
+        lua_pushboolean(luaStatePointer, (player.Flags & ServerPlayerTable::kIsRegisteredWithSession) ? 1 : 0);
+        lua_setfield(luaStatePointer, -2, "isRegisteredWithSession");
+        lua_pushboolean(luaStatePointer, (player.Flags & ServerPlayerTable::kIsRegisteredWithAntiCheat) ? 1 : 0);
+        lua_setfield(luaStatePointer, -2, "isRegisteredWithAntiCheat");
+        lua_pushboolean(luaStatePointer, (player.Flags & ServerPlayerTable::kIsSanctioned) ? 1 : 0);
+        lua_setfield(luaStatePointer, -2, "isSanctioned");
+        lua_rawseti(luaStatePointer, -2, (int) index + 1);
+    }
+    return 1;
+}
+
+/** bool eos.beginAntiCheatSession([{serverName=, registerTimeout=}]) */
+extern "C" int OnBeginAntiCheatSession(lua_State *luaStatePointer) {
+    // Fetch the optional settings.
+    std::string serverName;
+    uint32_t registerTimeout = 60;
+    if (lua_istable(luaStatePointer, 1)) {
+        lua_getfield(luaStatePointer, 1, "serverName");
+        if (lua_type(luaStatePointer, -1) == LUA_TSTRING) {
+            serverName = lua_tostring(luaStatePointer, -1);
+        }
+        lua_pop(luaStatePointer, 1);
+        lua_getfield(luaStatePointer, 1, "registerTimeout");
+        if (lua_type(luaStatePointer, -1) == LUA_TNUMBER) {
+            lua_Number value = lua_tonumber(luaStatePointer, -1);
+            registerTimeout = (value > 0) ? (uint32_t) value : 0;
+        }
+        lua_pop(luaStatePointer, 1);
+    }
+
+    // Fetch the runtime context associated with the calling Lua state.
+    auto contextPointer = GetRuntimeContextFromLuaState(luaStatePointer);
+    if (!contextPointer) {
+        return 0;
+    }
+    if (QueueCallIfDeferred(luaStatePointer, contextPointer, OnBeginAntiCheatSession)) {
+        return 1;
+    }
+
+    bool hasBegun = contextPointer->GetDedicatedServer().BeginAntiCheatSession(serverName.c_str(), registerTimeout);
+    lua_pushboolean(luaStatePointer, hasBegun ? 1 : 0);
+    return 1;
+}
+
+/** eos.endAntiCheatSession() */
+extern "C" int OnEndAntiCheatSession(lua_State *luaStatePointer) {
+    // Fetch the runtime context associated with the calling Lua state.
+    auto contextPointer = GetRuntimeContextFromLuaState(luaStatePointer);
+    if (!contextPointer) {
+        return 0;
+    }
+    if (QueueCallIfDeferred(luaStatePointer, contextPointer, OnEndAntiCheatSession)) {
+        return 1;
+    }
+
+    contextPointer->GetDedicatedServer().EndAntiCheatSession();
     return 0;
 }
 
+/** bool eos.receiveAntiCheatMessage(productUserId, data) */
+extern "C" int OnReceiveAntiCheatMessage(lua_State *luaStatePointer) {
+    // Fetch the arguments.
+    if (lua_type(luaStatePointer, 1) != LUA_TSTRING) {
+        CoronaLuaError(luaStatePointer, "1st argument must be a product user ID string.");
+        return 0;
+    }
+    if (lua_type(luaStatePointer, 2) != LUA_TSTRING) {
+        CoronaLuaError(luaStatePointer, "2nd argument must be the message's data string.");
+        return 0;
+    }
+
+    // Fetch the runtime context associated with the calling Lua state.
+    auto contextPointer = GetRuntimeContextFromLuaState(luaStatePointer);
+    if (!contextPointer) {
+        return 0;
+    }
+    if (QueueCallIfDeferred(luaStatePointer, contextPointer, OnReceiveAntiCheatMessage)) {
+        return 1;
+    }
+
+    // Pass the message received from the player's anti-cheat client to EOS.
+    size_t byteCount = 0;
+    const char *data = lua_tolstring(luaStatePointer, 2, &byteCount);
+    bool wasReceived = contextPointer->GetDedicatedServer().ReceiveAntiCheatMessage(
+            lua_tostring(luaStatePointer, 1), data, (uint32_t) byteCount);
+    lua_pushboolean(luaStatePointer, wasReceived ? 1 : 0);
+    return 1;
+}
+
 /** eos.addEventListener(eventName, listener) */
 extern "C" int OnAddEventListener(lua_State *luaStatePointer) {
     // Validate.
@@ -853,12 +1829,26 @@ CORONA_EXPORT int luaopen_plugin_eos(lua_State *luaStatePointer) {
     SDKOptions.Reserved = nullptr;
     SDKOptions.SystemInitializeOptions = nullptr;
     SDKOptions.OverrideThreadAffinity = nullptr;
-    
+
+    return OpenPluginLibrary(luaStatePointer, SDKOptions);
+}
+
+/**
+  Initializes this plugin with EOS and pushes the plugin's Lua table, whose functions are the C functions above.
+  Called by luaopen_plugin_eos(), and on Android by the Java LuaLoader with Android's initialization options,
+  so that Lua calls this plugin's API without going through Java.
+ */
+extern "C" int OpenPluginLibrary(lua_State *luaStatePointer, EOS_InitializeOptions SDKOptions) {
+    // Validate.
+    if (!luaStatePointer) {
+        return 0;
+    }
+
     InitializeSDK(luaStatePointer, SDKOptions);
 
     // Push this plugin's Lua table and all of its functions to the top of the Lua stack.
     // Note: The RuntimeContext pointer is pushed as an upvalue to all of these functions via luaL_openlib().
-    auto contextPointer = GetRuntimeContextFromLuaState(luaStatePointer);
+    auto contextPointer = RuntimeContext::GetInstanceBy(luaStatePointer);
     {
         const struct luaL_Reg luaFunctions[] =
                 {
@@ -866,7 +1856,13 @@ CORONA_EXPORT int luaopen_plugin_eos(lua_State *luaStatePointer) {
                         {"removeEventListener",     OnRemoveEventListener},
                         {"isLoggedOn",              OnIsLoggedOn},
                         {"getAuthIdToken",          OnGetAuthIdToken},
+                        {"getProductUserId",        OnGetProductUserId},
+                        {"getLocalUsers",           OnGetLocalUsers},
+                        {"getRequestStats",         OnGetRequestStats},
+                        {"getInflight",             OnGetInflight},
+                        {"cancel",                  OnCancelOperation},
                         {"loginWithAccountPortal",  OnLoginWithAccountPortal},
+                        {"loginWithDeviceId",       OnLoginWithDeviceId},
                         {"setNotificationPosition", OnSetNotificationPosition},
 
                         {"init",                    OnFakeIAPInit},
@@ -874,6 +1870,16 @@ CORONA_EXPORT int luaopen_plugin_eos(lua_State *luaStatePointer) {
                         {"purchase",                OnPurchaseProduct},
                         {"restore",                 OnRestorePurchases},
                         {"finishTransaction",       OnFinishTransaction},
+                        {"getOwnershipToken",       OnGetOwnershipToken},
+                        {"getEntitlementToken",     OnGetEntitlementToken},
+
+                        {"addPlayer",               OnAddPlayer},
+                        {"removePlayer",            OnRemovePlayer},
+                        {"ingestStat",              OnIngestStat},
+                        {"getPlayers",              OnGetPlayers},
+                        {"beginAntiCheatSession",   OnBeginAntiCheatSession},
+                        {"endAntiCheatSession",     OnEndAntiCheatSession},
+                        {"receiveAntiCheatMessage", OnReceiveAntiCheatMessage},
 
                         // { "setAchievementUnlocked", OnSetAchievementUnlocked },
                         {nullptr,                   nullptr}
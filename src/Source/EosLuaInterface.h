@@ -20,20 +20,6 @@ struct EOSEntitlementData
     bool bRedeemed;
 };
 
-struct EOSOfferData
-{
-    /** The EOS_Ecom_CatalogOfferId */
-    std::string Id;
-    /** The title */
-    std::string Title;
-    /** The description */
-    std::string Description;
-    /** The localizedPrice */
-    std::string localizedPrice;
-    /** True if the price was properly retrieved */
-    bool bPriceValid;
-};
-
 struct EOSTransactionData
 {
     /** The EOS_Ecom_EntitlementId */
@@ -46,15 +32,31 @@ struct EOSTransactionData
 
 // Declare the function so other .cpp files can call it
 extern "C" int InitializeSDK(lua_State* luaStatePointer, EOS_InitializeOptions SDKOptions);
+extern "C" int OpenPluginLibrary(lua_State* luaStatePointer, EOS_InitializeOptions SDKOptions);
 extern "C" int OnIsLoggedOn(lua_State* luaStatePointer);
 extern "C" int OnAddEventListener(lua_State* luaStatePointer);
 extern "C" int OnRemoveEventListener(lua_State* luaStatePointer);
 extern "C" int OnLoginWithAccountPortal(lua_State* luaStatePointer);
+extern "C" int OnLoginWithDeviceId(lua_State* luaStatePointer);
 extern "C" int OnGetAuthIdToken(lua_State* luaStatePointer);
+extern "C" int OnGetProductUserId(lua_State* luaStatePointer);
+extern "C" int OnGetLocalUsers(lua_State* luaStatePointer);
+extern "C" int OnGetRequestStats(lua_State* luaStatePointer);
+extern "C" int OnGetInflight(lua_State* luaStatePointer);
+extern "C" int OnCancelOperation(lua_State* luaStatePointer);
 
 extern "C" int OnLoadProducts(lua_State* luaStatePointer);
 extern "C" int OnPurchaseProduct(lua_State* luaStatePointer);
 extern "C" int OnRestorePurchases(lua_State* luaStatePointer);
 extern "C" int OnFinishTransaction(lua_State* luaStatePointer);
+extern "C" int OnGetOwnershipToken(lua_State* luaStatePointer);
+extern "C" int OnGetEntitlementToken(lua_State* luaStatePointer);
+extern "C" int OnAddPlayer(lua_State* luaStatePointer);
+extern "C" int OnRemovePlayer(lua_State* luaStatePointer);
+extern "C" int OnIngestStat(lua_State* luaStatePointer);
+extern "C" int OnGetPlayers(lua_State* luaStatePointer);
+extern "C" int OnBeginAntiCheatSession(lua_State* luaStatePointer);
+extern "C" int OnEndAntiCheatSession(lua_State* luaStatePointer);
+extern "C" int OnReceiveAntiCheatMessage(lua_State* luaStatePointer);
 
 #endif // EOS_LUA_INTERFACE_H
\ No newline at end of file
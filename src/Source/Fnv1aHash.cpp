@@ -0,0 +1,55 @@
+// ----------------------------------------------------------------------------
+//
+// Fnv1aHash.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#include "Fnv1aHash.h"
+
+
+/** FNV-1a 32-bit prime. */
+static const uint32_t kPrime32 = 16777619U;
+
+/** FNV-1a 64-bit prime. */
+static const uint64_t kPrime64 = 1099511628211ULL;
+
+
+const uint32_t Fnv1aHash::kOffsetBasis32 = 2166136261U;
+
+const uint64_t Fnv1aHash::kOffsetBasis64 = 14695981039346656037ULL;
+
+uint32_t Fnv1aHash::Hash32(const void* bytes, size_t byteCount, uint32_t hash)
+{
+	auto bytePointer = (const unsigned char*)bytes;
+	for (size_t index = 0; index < byteCount; index++)
+	{
+		hash ^= bytePointer[index];
+		hash *= kPrime32;
+	}
+	return hash;
+}
+
+uint32_t Fnv1aHash::Hash32(const char* text)
+{
+	uint32_t hash = kOffsetBasis32;
+	for (; *text; text++)
+	{
+		hash ^= (unsigned char)*text;
+		hash *= kPrime32;
+	}
+	return hash;
+}
+
+uint64_t Fnv1aHash::Hash64(const void* bytes, size_t byteCount, uint64_t hash)
+{
+	auto bytePointer = (const unsigned char*)bytes;
+	for (size_t index = 0; index < byteCount; index++)
+	{
+		hash ^= bytePointer[index];
+		hash *= kPrime64;
+	}
+	return hash;
+}
@@ -0,0 +1,55 @@
+// ----------------------------------------------------------------------------
+//
+// Fnv1aHash.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+
+/**
+  Computes FNV-1a hashes, used for this plugin's file checksums, cache keys and hash table lookups.
+
+  FNV-1a is fast on short inputs and good enough for detecting torn writes and spreading keys,
+  but it is not a cryptographic hash and must not be used to authenticate data.
+ */
+class Fnv1aHash
+{
+	public:
+		/** 32-bit offset basis, which is the hash of zero bytes. */
+		static const uint32_t kOffsetBasis32;
+
+		/** 64-bit offset basis, which is the hash of zero bytes. */
+		static const uint64_t kOffsetBasis64;
+
+		/**
+		  Computes the 32-bit hash of the given bytes.
+		  @param bytes The bytes to hash. Can be null if "byteCount" is zero.
+		  @param byteCount Number of bytes to hash.
+		  @param hash The hash to continue from, such as the result of hashing the preceding bytes.
+		  @return Returns the hash.
+		 */
+		static uint32_t Hash32(const void* bytes, size_t byteCount, uint32_t hash = kOffsetBasis32);
+
+		/**
+		  Computes the 32-bit hash of the given null terminated string.
+		  @param text The string to hash. Cannot be null.
+		  @return Returns the hash.
+		 */
+		static uint32_t Hash32(const char* text);
+
+		/**
+		  Computes the 64-bit hash of the given bytes.
+		  @param bytes The bytes to hash. Can be null if "byteCount" is zero.
+		  @param byteCount Number of bytes to hash.
+		  @param hash The hash to continue from, such as the result of hashing the preceding bytes.
+		  @return Returns the hash.
+		 */
+		static uint64_t Hash64(const void* bytes, size_t byteCount, uint64_t hash = kOffsetBasis64);
+};
@@ -0,0 +1,95 @@
+// ----------------------------------------------------------------------------
+//
+// InflightOperationRegistry.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#include "InflightOperationRegistry.h"
+
+
+InflightOperationRegistry::InflightOperationRegistry()
+:	fNextOperationId(1)
+{
+}
+
+InflightOperationRegistry::~InflightOperationRegistry()
+{
+}
+
+uint64_t InflightOperationRegistry::Begin(const char* name, std::chrono::milliseconds timeout)
+{
+	auto currentTime = std::chrono::steady_clock::now();
+	Operation operation;
+	operation.Id = fNextOperationId++;
+	operation.Name = name ? name : "";
+	operation.StartTime = currentTime;
+	operation.Deadline = currentTime + timeout;
+	operation.HasTimedOut = false;
+	fOperations.push_back(operation);
+	return operation.Id;
+}
+
+bool InflightOperationRegistry::End(uint64_t operationId)
+{
+	if (0 == operationId)
+	{
+		return true;
+	}
+	for (auto iterator = fOperations.begin(); iterator != fOperations.end(); ++iterator)
+	{
+		if (iterator->Id == operationId)
+		{
+			fOperations.erase(iterator);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool InflightOperationRegistry::Cancel(uint64_t operationId)
+{
+	return (operationId != 0) && End(operationId);
+}
+
+bool InflightOperationRegistry::Contains(uint64_t operationId) const
+{
+	if (0 == operationId)
+	{
+		return true;
+	}
+	for (auto&& operation : fOperations)
+	{
+		if (operation.Id == operationId)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+std::vector<InflightOperationRegistry::Operation> InflightOperationRegistry::TakeTimedOut()
+{
+	std::vector<Operation> timedOutOperations;
+	if (fOperations.empty())
+	{
+		return timedOutOperations;
+	}
+	auto currentTime = std::chrono::steady_clock::now();
+	for (auto&& operation : fOperations)
+	{
+		if (!operation.HasTimedOut && (currentTime >= operation.Deadline))
+		{
+			operation.HasTimedOut = true;
+			timedOutOperations.push_back(operation);
+		}
+	}
+	return timedOutOperations;
+}
+
+const std::vector<InflightOperationRegistry::Operation>& InflightOperationRegistry::GetOperations() const
+{
+	return fOperations;
+}
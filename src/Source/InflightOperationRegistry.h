@@ -0,0 +1,103 @@
+// ----------------------------------------------------------------------------
+//
+// InflightOperationRegistry.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+/**
+  Keeps a record of every asynchronous EOS operation started by Lua until its callback is received.
+
+  Each operation gets an ID, which the Lua API returns, along with its start time and a deadline.
+  TakeTimedOut() is expected to be called once per frame by a watchdog which reports operations whose
+  deadline has passed, so that Lua does not wait forever on a callback that EOS lost. Lua can then cancel
+  the operation, which stops tracking it and causes its late result to be ignored where that is safe.
+ */
+class InflightOperationRegistry
+{
+	public:
+		/** An operation that has been started and has not ended yet. */
+		struct Operation
+		{
+			/** Unique ID of the operation. Never zero. */
+			uint64_t Id;
+
+			/** Name of the Lua API that started the operation, such as "loadProducts". */
+			std::string Name;
+
+			std::chrono::steady_clock::time_point StartTime;
+			std::chrono::steady_clock::time_point Deadline;
+
+			/** Set true once the watchdog has reported that the deadline has passed. */
+			bool HasTimedOut;
+		};
+
+		InflightOperationRegistry();
+		virtual ~InflightOperationRegistry();
+
+		/**
+		  Starts tracking a new operation.
+		  @param name Name of the Lua API starting the operation. Expected to be a string literal.
+		  @param timeout Time after which the operation is reported as timed out if it has not ended yet.
+		  @return Returns the operation's unique ID.
+		 */
+		uint64_t Begin(const char* name, std::chrono::milliseconds timeout);
+
+		/**
+		  Stops tracking the given operation, to be called when its callback has been received.
+		  @param operationId ID returned by Begin(). Zero for operations that were never tracked.
+		  @return Returns true if the operation's result should be delivered.
+		          Returns false if the operation was cancelled, in which case its result should be ignored.
+		 */
+		bool End(uint64_t operationId);
+
+		/**
+		  Stops tracking the given operation before its callback has been received.
+		  @param operationId ID returned by Begin().
+		  @return Returns true if the operation was cancelled. Returns false if it already ended or was not found.
+		 */
+		bool Cancel(uint64_t operationId);
+
+		/**
+		  Determines if the given operation is still being tracked.
+		  @param operationId ID returned by Begin(). Zero for operations that were never tracked.
+		  @return Returns true if the operation has not ended or been cancelled, or if given zero.
+		 */
+		bool Contains(uint64_t operationId) const;
+
+		/**
+		  Fetches the operations whose deadline has passed since the last call, for the watchdog to report.
+		  The operations are still tracked afterwards, since their callback might still arrive.
+		  @return Returns the newly timed out operations. Empty if none.
+		 */
+		std::vector<Operation> TakeTimedOut();
+
+		/**
+		  Fetches every operation currently being tracked, for eos.getInflight().
+		  @return Returns the tracked operations, ordered from oldest to newest.
+		 */
+		const std::vector<Operation>& GetOperations() const;
+
+	private:
+		/** Copy constructor deleted to prevent it from being called. */
+		InflightOperationRegistry(const InflightOperationRegistry&) = delete;
+
+		/** Method deleted to prevent the copy operator from being used. */
+		void operator=(const InflightOperationRegistry&) = delete;
+
+		/** The tracked operations, ordered by ID. Expected to hold a handful of entries at most. */
+		std::vector<Operation> fOperations;
+
+		/** ID to be assigned to the next operation. */
+		uint64_t fNextOperationId;
+};
@@ -0,0 +1,117 @@
+// ----------------------------------------------------------------------------
+//
+// JsonWebToken.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#include "JsonWebToken.h"
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+
+bool JsonWebToken::GetExpirationTime(const char* token, int64_t& outExpirationTime)
+{
+	// Validate.
+	if (!token)
+	{
+		return false;
+	}
+
+	// Decode the payload between the token's 1st and 2nd dots.
+	const char* payloadStartPointer = strchr(token, '.');
+	if (!payloadStartPointer)
+	{
+		return false;
+	}
+	payloadStartPointer++;
+	const char* payloadEndPointer = strchr(payloadStartPointer, '.');
+	if (!payloadEndPointer)
+	{
+		return false;
+	}
+	std::string payload;
+	if (!DecodeBase64Url(payloadStartPointer, (size_t)(payloadEndPointer - payloadStartPointer), payload))
+	{
+		return false;
+	}
+
+	// Find the "exp" claim's numeric value.
+	// Note: EOS tokens are flat JSON objects, so a key search is enough without a full JSON parser.
+	size_t keyIndex = payload.find("\"exp\"");
+	if (keyIndex == std::string::npos)
+	{
+		return false;
+	}
+	const char* valuePointer = payload.c_str() + keyIndex + 5;
+	while (isspace((unsigned char)*valuePointer))
+	{
+		valuePointer++;
+	}
+	if (*valuePointer != ':')
+	{
+		return false;
+	}
+	valuePointer++;
+	char* valueEndPointer = nullptr;
+	long long expirationTime = strtoll(valuePointer, &valueEndPointer, 10);
+	if ((valueEndPointer == valuePointer) || (expirationTime <= 0))
+	{
+		return false;
+	}
+	outExpirationTime = (int64_t)expirationTime;
+	return true;
+}
+
+bool JsonWebToken::DecodeBase64Url(const char* text, size_t length, std::string& outBytes)
+{
+	outBytes.clear();
+	outBytes.reserve((length * 3) / 4);
+	uint32_t bitBuffer = 0;
+	int bitCount = 0;
+	for (size_t index = 0; index < length; index++)
+	{
+		char character = text[index];
+		uint32_t value;
+		if ((character >= 'A') && (character <= 'Z'))
+		{
+			value = (uint32_t)(character - 'A');
+		}
+		else if ((character >= 'a') && (character <= 'z'))
+		{
+			value = (uint32_t)(character - 'a') + 26;
+		}
+		else if ((character >= '0') && (character <= '9'))
+		{
+			value = (uint32_t)(character - '0') + 52;
+		}
+		else if ((character == '-') || (character == '+'))
+		{
+			value = 62;
+		}
+		else if ((character == '_') || (character == '/'))
+		{
+			value = 63;
+		}
+		else if (character == '=')
+		{
+			break;
+		}
+		else
+		{
+			return false;
+		}
+
+		bitBuffer = (bitBuffer << 6) | value;
+		bitCount += 6;
+		if (bitCount >= 8)
+		{
+			bitCount -= 8;
+			outBytes.push_back((char)((bitBuffer >> bitCount) & 0xFF));
+		}
+	}
+	return true;
+}
@@ -0,0 +1,45 @@
+// ----------------------------------------------------------------------------
+//
+// JsonWebToken.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+
+/**
+  Reads claims from the JSON web tokens returned by EOS, such as ID, ownership and entitlement tokens.
+
+  Only the token's payload is decoded. Its signature is not verified, since that is the job of the
+  backend the token is sent to. The plugin only needs the claims to know when to refresh a token.
+ */
+class JsonWebToken
+{
+	public:
+		/**
+		  Fetches the "exp" claim of the given token.
+		  @param token The token in its "header.payload.signature" compact form.
+		  @param outExpirationTime Receives the expiration time in seconds since the Unix epoch.
+		  @return Returns true if the claim was found. Returns false if given a null or malformed token.
+		 */
+		static bool GetExpirationTime(const char* token, int64_t& outExpirationTime);
+
+	private:
+		/** Static class which cannot be instantiated. */
+		JsonWebToken() = delete;
+
+		/**
+		  Decodes the given base64url encoded text, with or without padding.
+		  @param text The text to decode.
+		  @param length Number of characters in "text".
+		  @param outBytes Receives the decoded bytes.
+		  @return Returns true if decoded. Returns false if the text contains invalid characters.
+		 */
+		static bool DecodeBase64Url(const char* text, size_t length, std::string& outBytes);
+};
@@ -0,0 +1,216 @@
+// ----------------------------------------------------------------------------
+//
+// LocalUserTable.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#include "LocalUserTable.h"
+#include "RuntimeContext.h"
+#include "eos_auth.h"
+
+
+/** Number of bits of a handle holding the user's slot index plus 1. The bits above hold the slot's generation. */
+static const int kHandleIndexBitCount = 16;
+
+
+LocalUserTable::LocalUserTable(RuntimeContext* contextPointer)
+:	fContextPointer(contextPointer),
+	fAuthHandle(nullptr),
+	fLoginStatusChangedNotificationId(EOS_INVALID_NOTIFICATIONID)
+{
+}
+
+LocalUserTable::~LocalUserTable()
+{
+	Clear();
+}
+
+LocalUserTable::Handle LocalUserTable::Add(EOS_EpicAccountId accountId)
+{
+	// Validate.
+	if (!accountId)
+	{
+		return 0;
+	}
+
+	// Return the account's handle if it is already in the table.
+	Handle userHandle = FindBy(accountId);
+	if (userHandle)
+	{
+		return userHandle;
+	}
+
+	// Reuse the first free slot, or add one if all are taken.
+	size_t slotIndex = 0;
+	while ((slotIndex < fSlots.size()) && fSlots[slotIndex].UserPointer)
+	{
+		slotIndex++;
+	}
+	if (slotIndex >= ((size_t)1 << kHandleIndexBitCount) - 1)
+	{
+		return 0;
+	}
+	if (slotIndex == fSlots.size())
+	{
+		fSlots.emplace_back();
+		fSlots.back().Generation = 0;
+	}
+	Slot& slot = fSlots[slotIndex];
+
+	// Create the user and its caches.
+	auto userPointer = new LocalUser();
+	userPointer->UserHandle = ((Handle)slot.Generation << kHandleIndexBitCount) | (Handle)(slotIndex + 1);
+	userPointer->AccountId = accountId;
+	userPointer->ProductUserId = nullptr;
+	userPointer->IsLoggedOut = false;
+	userPointer->AuthIdTokenCachePointer.reset(new AuthIdTokenCache(fContextPointer, accountId));
+	userPointer->EcomTokenCachePointer.reset(new EcomTokenCache(fContextPointer, accountId));
+	slot.UserPointer.reset(userPointer);
+	return userPointer->UserHandle;
+}
+
+LocalUserTable::Handle LocalUserTable::FindBy(EOS_EpicAccountId accountId) const
+{
+	if (!accountId)
+	{
+		return 0;
+	}
+	for (auto&& slot : fSlots)
+	{
+		if (slot.UserPointer && (slot.UserPointer->AccountId == accountId) && !slot.UserPointer->IsLoggedOut)
+		{
+			return slot.UserPointer->UserHandle;
+		}
+	}
+	return 0;
+}
+
+LocalUserTable::LocalUser* LocalUserTable::GetBy(Handle userHandle) const
+{
+	// Decode the slot index, and check that the slot still holds the user the handle was issued for.
+	size_t slotIndex = (size_t)(userHandle & (((Handle)1 << kHandleIndexBitCount) - 1));
+	if ((0 == slotIndex) || (slotIndex > fSlots.size()))
+	{
+		return nullptr;
+	}
+	LocalUser* userPointer = fSlots[slotIndex - 1].UserPointer.get();
+	if (!userPointer || (userPointer->UserHandle != userHandle) || userPointer->IsLoggedOut)
+	{
+		return nullptr;
+	}
+	return userPointer;
+}
+
+void LocalUserTable::SetProductUserId(EOS_EpicAccountId accountId, EOS_ProductUserId productUserId)
+{
+	LocalUser* userPointer = GetBy(FindBy(accountId));
+	if (userPointer)
+	{
+		userPointer->ProductUserId = productUserId;
+	}
+}
+
+std::vector<LocalUserTable::Handle> LocalUserTable::GetHandles() const
+{
+	std::vector<Handle> userHandles;
+	for (auto&& slot : fSlots)
+	{
+		if (slot.UserPointer && !slot.UserPointer->IsLoggedOut)
+		{
+			userHandles.push_back(slot.UserPointer->UserHandle);
+		}
+	}
+	return userHandles;
+}
+
+void LocalUserTable::Update()
+{
+	if (!fContextPointer)
+	{
+		return;
+	}
+	SetAuthHandle(fContextPointer->fAuthHandle);
+
+	// Remove the users who logged out since the last frame.
+	// Note: This is not done by the login status callback, since their caches unsubscribe from EOS when deleted.
+	for (auto&& slot : fSlots)
+	{
+		if (slot.UserPointer && slot.UserPointer->IsLoggedOut)
+		{
+			slot.UserPointer.reset();
+			slot.Generation++;
+		}
+	}
+
+	// Refresh each user's tokens that are close to expiring.
+	for (auto&& slot : fSlots)
+	{
+		if (slot.UserPointer)
+		{
+			slot.UserPointer->AuthIdTokenCachePointer->Update();
+			slot.UserPointer->EcomTokenCachePointer->Update();
+		}
+	}
+}
+
+void LocalUserTable::Clear()
+{
+	for (auto&& slot : fSlots)
+	{
+		if (slot.UserPointer)
+		{
+			slot.UserPointer->AuthIdTokenCachePointer->SetAuthHandle(nullptr);
+			slot.UserPointer.reset();
+			slot.Generation++;
+		}
+	}
+	SetAuthHandle(nullptr);
+}
+
+void LocalUserTable::SetAuthHandle(EOS_HAuth authHandle)
+{
+	if (authHandle == fAuthHandle)
+	{
+		return;
+	}
+
+	// Unsubscribe from the last auth interface.
+	if (fAuthHandle && (fLoginStatusChangedNotificationId != EOS_INVALID_NOTIFICATIONID))
+	{
+		EOS_Auth_RemoveNotifyLoginStatusChanged(fAuthHandle, fLoginStatusChangedNotificationId);
+	}
+	fLoginStatusChangedNotificationId = EOS_INVALID_NOTIFICATIONID;
+
+	// Subscribe to the new auth interface.
+	fAuthHandle = authHandle;
+	if (fAuthHandle)
+	{
+		EOS_Auth_AddNotifyLoginStatusChangedOptions NotifyOptions{ 0 };
+		NotifyOptions.ApiVersion = EOS_AUTH_ADDNOTIFYLOGINSTATUSCHANGED_API_LATEST;
+		fLoginStatusChangedNotificationId = EOS_Auth_AddNotifyLoginStatusChanged(
+				fAuthHandle, &NotifyOptions, this, &LocalUserTable::OnLoginStatusChanged);
+	}
+}
+
+void EOS_CALL LocalUserTable::OnLoginStatusChanged(const EOS_Auth_LoginStatusChangedCallbackInfo* Data)
+{
+	if (!Data || (Data->CurrentStatus != EOS_ELoginStatus::EOS_LS_NotLoggedIn))
+	{
+		return;
+	}
+	auto tablePointer = (LocalUserTable*)Data->ClientData;
+	if (!tablePointer)
+	{
+		return;
+	}
+	for (auto&& slot : tablePointer->fSlots)
+	{
+		if (slot.UserPointer && (slot.UserPointer->AccountId == Data->LocalUserId))
+		{
+			slot.UserPointer->IsLoggedOut = true;
+		}
+	}
+}
@@ -0,0 +1,146 @@
+// ----------------------------------------------------------------------------
+//
+// LocalUserTable.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include "AuthIdTokenCache.h"
+#include "EcomTokenCache.h"
+#include "eos_sdk.h"
+#include "eos_auth_types.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Forward declarations.
+class RuntimeContext;
+
+
+/**
+  Holds the state of every Epic account logged in on this device, such as during couch co-op sessions.
+
+  Each local user is given a compact handle, which the Lua API accepts to act on behalf of that user and which
+  encodes the user's slot index along with a generation count, so that a stale handle never resolves to the
+  user who took over its slot. Every user has its own ID token and Ecom token caches, so that the queries of
+  several users proceed side by side instead of evicting each other's tokens.
+
+  Users are added once logged in and removed on the frame after EOS reports that they have logged out.
+ */
+class LocalUserTable
+{
+	public:
+		/** Identifies a local user. Zero is never a valid handle. */
+		typedef uint32_t Handle;
+
+		/** The state belonging to 1 logged in Epic account. */
+		struct LocalUser
+		{
+			/** This user's handle, as returned to Lua. */
+			Handle UserHandle;
+
+			/** The logged in Epic account. */
+			EOS_EpicAccountId AccountId;
+
+			/** The account's product user, once it has logged into the Connect interface. Null until then. */
+			EOS_ProductUserId ProductUserId;
+
+			/** Set true once EOS has reported that the account logged out. The user is removed on the next update. */
+			bool IsLoggedOut;
+
+			/** Caches this user's ID token. */
+			std::unique_ptr<AuthIdTokenCache> AuthIdTokenCachePointer;
+
+			/** Caches this user's ownership and entitlement tokens. */
+			std::unique_ptr<EcomTokenCache> EcomTokenCachePointer;
+		};
+
+		/**
+		  Creates a new empty table.
+		  @param contextPointer The runtime context the users' caches query EOS through. Cannot be null.
+		 */
+		LocalUserTable(RuntimeContext* contextPointer);
+
+		/** Unsubscribes from EOS. Clear() must be called before the EOS platform is released. */
+		virtual ~LocalUserTable();
+
+		/**
+		  Adds the given logged in account, unless it is already in the table.
+		  @param accountId The account that has logged in.
+		  @return Returns the user's handle. Returns zero if given a null account.
+		 */
+		Handle Add(EOS_EpicAccountId accountId);
+
+		/**
+		  Fetches the handle of the given account.
+		  @param accountId The account to look up.
+		  @return Returns the account's handle. Returns zero if the account is not logged in.
+		 */
+		Handle FindBy(EOS_EpicAccountId accountId) const;
+
+		/**
+		  Fetches the user with the given handle.
+		  @param userHandle Handle returned by Add() or FindBy().
+		  @return Returns the user. Returns null if the handle is invalid, stale or belongs to a user who logged out.
+		 */
+		LocalUser* GetBy(Handle userHandle) const;
+
+		/**
+		  Records the product user that the given account has logged into the Connect interface as.
+		  @param accountId The logged in account.
+		  @param productUserId The account's product user. Set to null once its Connect session has ended.
+		 */
+		void SetProductUserId(EOS_EpicAccountId accountId, EOS_ProductUserId productUserId);
+
+		/**
+		  Fetches the handles of all logged in users.
+		  @return Returns the handles, ordered by slot.
+		 */
+		std::vector<Handle> GetHandles() const;
+
+		/**
+		  To be called every frame. Removes the users who logged out and refreshes the other users' tokens.
+		  Also subscribes to the context's auth interface once EOS has been initialized.
+		 */
+		void Update();
+
+		/** Removes every user and unsubscribes from EOS. */
+		void Clear();
+
+	private:
+		/** Copy constructor deleted to prevent it from being called. */
+		LocalUserTable(const LocalUserTable&) = delete;
+
+		/** Method deleted to prevent the copy operator from being used. */
+		void operator=(const LocalUserTable&) = delete;
+
+		/** A place in the table, which is reused once its user has been removed. */
+		struct Slot
+		{
+			/** The user in this slot. Null if the slot is free. */
+			std::unique_ptr<LocalUser> UserPointer;
+
+			/** Incremented every time the slot is freed, so that handles to its last user stop resolving. */
+			uint16_t Generation;
+		};
+
+		/**
+		  Sets the auth interface to receive login status notifications from.
+		  @param authHandle The auth interface. Set to null to unsubscribe.
+		 */
+		void SetAuthHandle(EOS_HAuth authHandle);
+
+		/** Called by EOS when a local user's login status changes. */
+		static void EOS_CALL OnLoginStatusChanged(const EOS_Auth_LoginStatusChangedCallbackInfo* Data);
+
+		RuntimeContext* fContextPointer;
+		EOS_HAuth fAuthHandle;
+		EOS_NotificationId fLoginStatusChangedNotificationId;
+
+		/** The users, indexed by the slot index encoded in their handle. Expected to hold a handful at most. */
+		std::vector<Slot> fSlots;
+};
@@ -0,0 +1,146 @@
+// ----------------------------------------------------------------------------
+//
+// LocalizedPriceFormatter.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#include "LocalizedPriceFormatter.h"
+#include <cstring>
+#include <unordered_map>
+
+
+/** Powers of ten used to split a price into its whole and fractional parts. 10^19 is the largest uint64_t power. */
+static const uint64_t kPowersOfTen[] =
+{
+	1ULL,
+	10ULL,
+	100ULL,
+	1000ULL,
+	10000ULL,
+	100000ULL,
+	1000000ULL,
+	10000000ULL,
+	100000000ULL,
+	1000000000ULL,
+	10000000000ULL,
+	100000000000ULL,
+	1000000000000ULL,
+	10000000000000ULL,
+	100000000000000ULL,
+	1000000000000000ULL,
+	10000000000000000ULL,
+	100000000000000000ULL,
+	1000000000000000000ULL,
+	10000000000000000000ULL,
+};
+
+/** Number of entries in the kPowersOfTen table. */
+static const uint32_t kMaxDecimalPoint = (uint32_t)(sizeof(kPowersOfTen) / sizeof(kPowersOfTen[0])) - 1;
+
+/** Currency symbols known by this formatter. Symbols are UTF-8 encoded. */
+static const struct
+{
+	const char* CurrencyCode;
+	const char* Symbol;
+}
+kKnownCurrencySymbols[] =
+{
+	{ "USD", "$" },
+	{ "CAD", "CA$" },
+	{ "AUD", "A$" },
+	{ "NZD", "NZ$" },
+	{ "MXN", "MX$" },
+	{ "BRL", "R$" },
+	{ "EUR", "\xE2\x82\xAC" },
+	{ "GBP", "\xC2\xA3" },
+	{ "JPY", "\xC2\xA5" },
+	{ "CNY", "CN\xC2\xA5" },
+	{ "KRW", "\xE2\x82\xA9" },
+	{ "INR", "\xE2\x82\xB9" },
+	{ "RUB", "\xE2\x82\xBD" },
+	{ "TRY", "\xE2\x82\xBA" },
+	{ "PLN", "z\xC5\x82" },
+	{ "CHF", "CHF " },
+};
+
+
+const LocalizedPriceFormatter::CurrencyFormat& LocalizedPriceFormatter::GetCurrencyFormat(const char* currencyCode)
+{
+	static std::unordered_map<std::string, CurrencyFormat> sCurrencyFormatCache;
+
+	if (!currencyCode)
+	{
+		currencyCode = "";
+	}
+
+	// Return the cached format if this currency was formatted before.
+	auto iterator = sCurrencyFormatCache.find(currencyCode);
+	if (iterator != sCurrencyFormatCache.end())
+	{
+		return iterator->second;
+	}
+
+	// Resolve the currency's format. Unknown currencies keep the plugin's original "CODE1234.99" output.
+	CurrencyFormat format;
+	format.Prefix = currencyCode;
+	format.DecimalSeparator = '.';
+	format.GroupSeparator = '\0';
+	for (auto&& knownCurrency : kKnownCurrencySymbols)
+	{
+		if (!strcmp(knownCurrency.CurrencyCode, currencyCode))
+		{
+			format.Prefix = knownCurrency.Symbol;
+			format.GroupSeparator = ',';
+			break;
+		}
+	}
+	return sCurrencyFormatCache.emplace(std::string(currencyCode), format).first->second;
+}
+
+std::string LocalizedPriceFormatter::Format(const char* currencyCode, uint64_t price, uint32_t decimalPoint)
+{
+	const CurrencyFormat& format = GetCurrencyFormat(currencyCode);
+	if (decimalPoint > kMaxDecimalPoint)
+	{
+		decimalPoint = kMaxDecimalPoint;
+	}
+
+	// Split the price into its whole and fractional parts.
+	uint64_t wholePart = price / kPowersOfTen[decimalPoint];
+	uint64_t fractionalPart = price % kPowersOfTen[decimalPoint];
+
+	// Write the digits backwards. Worst case is 20 whole digits, 6 group separators,
+	// a decimal separator and 19 fractional digits.
+	char buffer[48];
+	char* writePointer = buffer + sizeof(buffer);
+	for (uint32_t index = 0; index < decimalPoint; index++)
+	{
+		*--writePointer = (char)('0' + (fractionalPart % 10));
+		fractionalPart /= 10;
+	}
+	if (decimalPoint > 0)
+	{
+		*--writePointer = format.DecimalSeparator;
+	}
+	int digitCount = 0;
+	do
+	{
+		if (format.GroupSeparator && (digitCount > 0) && ((digitCount % 3) == 0))
+		{
+			*--writePointer = format.GroupSeparator;
+		}
+		*--writePointer = (char)('0' + (wholePart % 10));
+		wholePart /= 10;
+		digitCount++;
+	} while (wholePart > 0);
+
+	std::string result;
+	result.reserve(format.Prefix.size() + (buffer + sizeof(buffer) - writePointer) + format.Suffix.size());
+	result.append(format.Prefix);
+	result.append(writePointer, buffer + sizeof(buffer));
+	result.append(format.Suffix);
+	return result;
+}
@@ -0,0 +1,58 @@
+// ----------------------------------------------------------------------------
+//
+// LocalizedPriceFormatter.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+
+/**
+  Formats EOS integer prices such as EOS_Ecom_CatalogOffer::CurrentPrice64 into display strings.
+
+  Prices are split into whole and fractional parts with integer math against a power-of-ten table,
+  so large prices never pass through a floating point value and cannot be rounded.
+
+  The symbol and separators used for a currency are resolved once per ISO 4217 currency code and cached.
+  Currencies without a known symbol are prefixed with their currency code, such as "XYZ12.34".
+ */
+class LocalizedPriceFormatter
+{
+	public:
+		/**
+		  Formats the given price.
+		  @param currencyCode ISO 4217 currency code such as "USD". Can be null or empty.
+		  @param price Price in the currency's smallest unit, such as cents.
+		  @param decimalPoint Number of digits in "price" that belong after the decimal separator.
+		  @return Returns the formatted price, such as "$1,234.99".
+		 */
+		static std::string Format(const char* currencyCode, uint64_t price, uint32_t decimalPoint);
+
+	private:
+		/** Static class which cannot be instantiated. */
+		LocalizedPriceFormatter() = delete;
+
+		/** Symbol and separators used to format one currency. */
+		struct CurrencyFormat
+		{
+			std::string Prefix;
+			std::string Suffix;
+			char DecimalSeparator;
+
+			/** Thousands separator. Set to '\0' to not group digits. */
+			char GroupSeparator;
+		};
+
+		/**
+		  Fetches the cached format for the given currency code, resolving and caching it on first use.
+		  @param currencyCode ISO 4217 currency code. Can be null.
+		  @return Returns a reference to the cached format, which stays valid for the lifetime of the process.
+		 */
+		static const CurrencyFormat& GetCurrencyFormat(const char* currencyCode);
+};
@@ -0,0 +1,141 @@
+// ----------------------------------------------------------------------------
+//
+// LuaGcPacer.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#include "LuaGcPacer.h"
+#include <algorithm>
+extern "C"
+{
+#	include "lua.h"
+}
+
+
+/**
+  Bursts allocating less than this many kilobytes are left to Lua's own incremental collector,
+  which already keeps up with the few tables that typical events push.
+ */
+static const size_t kMinBurstKilobytes = 64;
+
+
+LuaGcPacer::LuaGcPacer()
+:	fIsEnabled(false),
+	fIsPausingDuringDispatch(false),
+	fStepFrameCount(10),
+	fIsPaused(false),
+	fIsDispatching(false),
+	fDispatchStartByteCount(0),
+	fPendingKilobytes(0),
+	fKilobytesPerStep(0)
+{
+}
+
+LuaGcPacer::~LuaGcPacer()
+{
+}
+
+void LuaGcPacer::SetEnabled(bool value)
+{
+	fIsEnabled = value;
+	if (!value)
+	{
+		fPendingKilobytes = 0;
+	}
+}
+
+bool LuaGcPacer::IsEnabled() const
+{
+	return fIsEnabled;
+}
+
+void LuaGcPacer::SetPausingDuringDispatch(bool value)
+{
+	fIsPausingDuringDispatch = value;
+}
+
+bool LuaGcPacer::IsPausingDuringDispatch() const
+{
+	return fIsPausingDuringDispatch;
+}
+
+void LuaGcPacer::SetStepFrameCount(uint32_t value)
+{
+	fStepFrameCount = std::max(value, (uint32_t)1);
+}
+
+uint32_t LuaGcPacer::GetStepFrameCount() const
+{
+	return fStepFrameCount;
+}
+
+size_t LuaGcPacer::GetPendingKilobytes() const
+{
+	return fPendingKilobytes;
+}
+
+void LuaGcPacer::BeginDispatch(lua_State* luaStatePointer)
+{
+	if (!fIsEnabled || !luaStatePointer || fIsDispatching)
+	{
+		return;
+	}
+	fIsDispatching = true;
+	fDispatchStartByteCount = GetByteCountOf(luaStatePointer);
+	if (fIsPausingDuringDispatch)
+	{
+		lua_gc(luaStatePointer, LUA_GCSTOP, 0);
+		fIsPaused = true;
+	}
+}
+
+void LuaGcPacer::EndDispatch(lua_State* luaStatePointer)
+{
+	if (!fIsDispatching || !luaStatePointer)
+	{
+		return;
+	}
+	fIsDispatching = false;
+
+	// Measure the memory allocated by the dispatched events' tables and listeners.
+	// Note: Any step the collector ran during dispatch lowers this, which is fine, since that work is already done.
+	size_t byteCount = GetByteCountOf(luaStatePointer);
+	size_t allocatedKilobytes = (byteCount > fDispatchStartByteCount) ? ((byteCount - fDispatchStartByteCount) / 1024) : 0;
+	if (fIsPaused)
+	{
+		lua_gc(luaStatePointer, LUA_GCRESTART, 0);
+		fIsPaused = false;
+	}
+	if (allocatedKilobytes < kMinBurstKilobytes)
+	{
+		return;
+	}
+
+	// Spread the collection work over the next frames, on top of the work still pending from earlier bursts.
+	fPendingKilobytes += allocatedKilobytes;
+	fKilobytesPerStep = std::max((fPendingKilobytes + fStepFrameCount - 1) / fStepFrameCount, (size_t)1);
+}
+
+void LuaGcPacer::Update(lua_State* luaStatePointer)
+{
+	if (!fIsEnabled || !luaStatePointer || (fPendingKilobytes < 1))
+	{
+		return;
+	}
+
+	// Step the collector by this frame's share.
+	// Note: LUA_GCSTEP returns 1 once a cycle completes, in which case the burst's garbage has been collected.
+	size_t stepKilobytes = std::min(fKilobytesPerStep, fPendingKilobytes);
+	int hasFinishedCycle = lua_gc(luaStatePointer, LUA_GCSTEP, (int)std::min(stepKilobytes, (size_t)0x7FFFFFFF));
+	fPendingKilobytes = hasFinishedCycle ? 0 : (fPendingKilobytes - stepKilobytes);
+}
+
+size_t LuaGcPacer::GetByteCountOf(lua_State* luaStatePointer)
+{
+	size_t kilobytes = (size_t)lua_gc(luaStatePointer, LUA_GCCOUNT, 0);
+	size_t remainderBytes = (size_t)lua_gc(luaStatePointer, LUA_GCCOUNTB, 0);
+	return (kilobytes * 1024) + remainderBytes;
+}
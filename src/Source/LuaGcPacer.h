@@ -0,0 +1,136 @@
+// ----------------------------------------------------------------------------
+//
+// LuaGcPacer.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Forward declarations.
+extern "C"
+{
+	struct lua_State;
+}
+
+
+/**
+  Spreads the garbage collection work caused by a burst of dispatched events over the following frames.
+
+  A single "loadProducts" or "storeTransaction" event can push thousands of Lua tables and strings, which
+  would otherwise make the collector run a large step in the middle of gameplay. The amount of memory Lua
+  allocated while dispatching the frame's events is measured via LUA_GCCOUNT, and that many kilobytes of
+  collection work are performed via LUA_GCSTEP in equal parts over the configured number of frames.
+
+  The collector can also be paused via LUA_GCSTOP while the events are dispatched, so that no step runs
+  while the event tables are being built. It is restarted right after the dispatch. This must not be
+  enabled if the app stops the collector itself, since it would then be restarted.
+ */
+class LuaGcPacer
+{
+	public:
+		/** Creates a new disabled pacer. */
+		LuaGcPacer();
+
+		virtual ~LuaGcPacer();
+
+		/**
+		  Enables or disables pacing, as set by the "gcPacing" table in the "config.lua" file.
+		  @param value Set true to step the collector after event bursts.
+		 */
+		void SetEnabled(bool value);
+
+		/**
+		  Determines if pacing is enabled.
+		  @return Returns true if enabled.
+		 */
+		bool IsEnabled() const;
+
+		/**
+		  Sets whether the collector is stopped while events are dispatched.
+		  @param value Set true to stop the collector during dispatch.
+		 */
+		void SetPausingDuringDispatch(bool value);
+
+		/**
+		  Determines if the collector is stopped while events are dispatched.
+		  @return Returns true if stopped during dispatch.
+		 */
+		bool IsPausingDuringDispatch() const;
+
+		/**
+		  Sets the number of frames that the collection work caused by a burst is spread over.
+		  @param value The number of frames. Values less than 1 are treated as 1.
+		 */
+		void SetStepFrameCount(uint32_t value);
+
+		/**
+		  Fetches the number of frames that the collection work caused by a burst is spread over.
+		  @return Returns the number of frames.
+		 */
+		uint32_t GetStepFrameCount() const;
+
+		/**
+		  Fetches the collection work still to be performed over the next frames.
+		  @return Returns the number of kilobytes left to step the collector by.
+		 */
+		size_t GetPendingKilobytes() const;
+
+		/**
+		  To be called before the frame's events are dispatched.
+		  Records Lua's memory usage and stops the collector, if pausing during dispatch.
+		  @param luaStatePointer The Lua state the events are dispatched to.
+		 */
+		void BeginDispatch(lua_State* luaStatePointer);
+
+		/**
+		  To be called after the frame's events were dispatched.
+		  Restarts the collector and schedules collection work for the memory allocated since BeginDispatch().
+		  @param luaStatePointer The Lua state the events were dispatched to.
+		 */
+		void EndDispatch(lua_State* luaStatePointer);
+
+		/**
+		  To be called every frame. Steps the collector by this frame's share of the pending work, if any.
+		  @param luaStatePointer The Lua state to collect garbage in.
+		 */
+		void Update(lua_State* luaStatePointer);
+
+	private:
+		/** Copy constructor deleted to prevent it from being called. */
+		LuaGcPacer(const LuaGcPacer&) = delete;
+
+		/** Method deleted to prevent the copy operator from being used. */
+		void operator=(const LuaGcPacer&) = delete;
+
+		/**
+		  Fetches the number of bytes of memory in use by the given Lua state.
+		  @param luaStatePointer The Lua state to query.
+		  @return Returns the number of bytes in use.
+		 */
+		static size_t GetByteCountOf(lua_State* luaStatePointer);
+
+		bool fIsEnabled;
+		bool fIsPausingDuringDispatch;
+		uint32_t fStepFrameCount;
+
+		/** Set true between BeginDispatch() and EndDispatch() if the collector was stopped. */
+		bool fIsPaused;
+
+		/** Set true between BeginDispatch() and EndDispatch(). */
+		bool fIsDispatching;
+
+		/** Lua's memory usage when BeginDispatch() was last called. */
+		size_t fDispatchStartByteCount;
+
+		/** Kilobytes of collection work left to perform. */
+		size_t fPendingKilobytes;
+
+		/** Kilobytes of collection work performed per frame until "fPendingKilobytes" reaches zero. */
+		size_t fKilobytesPerStep;
+};
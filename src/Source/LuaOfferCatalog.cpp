@@ -0,0 +1,220 @@
+// ----------------------------------------------------------------------------
+//
+// LuaOfferCatalog.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#include "LuaOfferCatalog.h"
+#include "CoronaLua.h"
+#include "LocalizedPriceFormatter.h"
+#include "RuntimeContext.h"
+#include "eos_ecom.h"
+#include <string>
+extern "C"
+{
+#	include "lua.h"
+#	include "lauxlib.h"
+}
+
+
+const char LuaOfferCatalog::kLuaMetatableName[] = "plugin.eos.offerCatalog";
+
+bool LuaOfferCatalog::PushTo(lua_State* luaStatePointer, EOS_EpicAccountId localUserId, uint32_t offerCount, bool isLazy)
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return false;
+	}
+
+	// Copy all offers into a regular array, unless the proxy was requested.
+	// Note: Offers that fail to copy are skipped, so that the array has no holes.
+	if (!isLazy)
+	{
+		auto contextPointer = RuntimeContext::GetInstanceBy(luaStatePointer);
+		lua_createtable(luaStatePointer, (int)offerCount, 0);
+		if (contextPointer && contextPointer->fPlatformHandle)
+		{
+			int productCount = 0;
+			for (uint32_t offerIndex = 0; offerIndex < offerCount; offerIndex++)
+			{
+				if (PushProductTo(luaStatePointer, contextPointer, localUserId, offerIndex))
+				{
+					lua_rawseti(luaStatePointer, -2, ++productCount);
+				}
+			}
+		}
+		return true;
+	}
+
+	// Create the proxy userdata.
+	auto fieldsPointer = (UserdataFields*)lua_newuserdata(luaStatePointer, sizeof(UserdataFields));
+	fieldsPointer->LocalUserId = localUserId;
+	fieldsPointer->OfferCount = offerCount;
+
+	// Give the proxy an environment table used to cache the product tables that have been read.
+	lua_createtable(luaStatePointer, (int)offerCount, 0);
+	lua_setfenv(luaStatePointer, -2);
+
+	// Assign the proxy's metatable, creating it the first time.
+	if (luaL_newmetatable(luaStatePointer, kLuaMetatableName))
+	{
+		lua_pushcfunction(luaStatePointer, OnIndex);
+		lua_setfield(luaStatePointer, -2, "__index");
+		lua_pushcfunction(luaStatePointer, OnLength);
+		lua_setfield(luaStatePointer, -2, "__len");
+	}
+	lua_setmetatable(luaStatePointer, -2);
+	return true;
+}
+
+int LuaOfferCatalog::OnIndex(lua_State* luaStatePointer)
+{
+	// Validate.
+	auto fieldsPointer = (UserdataFields*)luaL_checkudata(luaStatePointer, 1, kLuaMetatableName);
+	if (!fieldsPointer || (lua_type(luaStatePointer, 2) != LUA_TNUMBER))
+	{
+		return 0;
+	}
+	int offerIndex = (int)lua_tointeger(luaStatePointer, 2);
+	if ((offerIndex < 1) || (offerIndex > (int)fieldsPointer->OfferCount))
+	{
+		return 0;
+	}
+
+	// Return the cached product table if this offer was read before.
+	lua_getfenv(luaStatePointer, 1);
+	lua_rawgeti(luaStatePointer, -1, offerIndex);
+	if (!lua_isnil(luaStatePointer, -1))
+	{
+		return 1;
+	}
+	lua_pop(luaStatePointer, 1);
+
+	// Copy the offer out of the SDK's cache.
+	auto contextPointer = RuntimeContext::GetInstanceBy(luaStatePointer);
+	if (!contextPointer || !contextPointer->fPlatformHandle)
+	{
+		return 0;
+	}
+	if (!PushProductTo(luaStatePointer, contextPointer, fieldsPointer->LocalUserId, (uint32_t)(offerIndex - 1)))
+	{
+		return 0;
+	}
+
+	// Cache the product table in the proxy's environment table and return it.
+	lua_pushvalue(luaStatePointer, -1);
+	lua_rawseti(luaStatePointer, -3, offerIndex);
+	return 1;
+}
+
+bool LuaOfferCatalog::PushProductTo(
+		lua_State* luaStatePointer, RuntimeContext* contextPointer, EOS_EpicAccountId localUserId, uint32_t offerIndex)
+{
+	EOS_HEcom EcomHandle = EOS_Platform_GetEcomInterface(contextPointer->fPlatformHandle);
+
+	EOS_Ecom_CopyOfferByIndexOptions IndexOptions{0};
+	IndexOptions.ApiVersion = EOS_ECOM_COPYOFFERBYINDEX_API_LATEST;
+	IndexOptions.LocalUserId = localUserId;
+	IndexOptions.OfferIndex = offerIndex;
+	EOS_Ecom_CatalogOffer* Offer = nullptr;
+	EOS_EResult CopyResult = EOS_Ecom_CopyOfferByIndex(EcomHandle, &IndexOptions, &Offer);
+	switch (CopyResult)
+	{
+		case EOS_EResult::EOS_Success:
+		case EOS_EResult::EOS_Ecom_CatalogOfferPriceInvalid:
+		case EOS_EResult::EOS_Ecom_CatalogOfferStale:
+			break;
+		default:
+			CoronaLog("[EOS SDK] Offer[%d] invalid : %d", IndexOptions.OfferIndex, CopyResult);
+			return false;
+	}
+
+	// Convert the offer to a Lua product table.
+	lua_createtable(luaStatePointer, 0, 11);
+
+	lua_pushstring(luaStatePointer, Offer->TitleText ? Offer->TitleText : "");
+	lua_setfield(luaStatePointer, -2, "title");
+
+	lua_pushstring(luaStatePointer, "");
+	lua_setfield(luaStatePointer, -2, "description");
+
+	lua_pushstring(luaStatePointer, Offer->Id ? Offer->Id : "");
+	lua_setfield(luaStatePointer, -2, "productIdentifier");
+
+	std::string localizedPrice = LocalizedPriceFormatter::Format(
+			Offer->CurrencyCode, Offer->CurrentPrice64, Offer->DecimalPoint);
+	lua_pushlstring(luaStatePointer, localizedPrice.c_str(), localizedPrice.size());
+	lua_setfield(luaStatePointer, -2, "localizedPrice");
+
+	lua_pushboolean(luaStatePointer, Offer->PriceResult == EOS_EResult::EOS_Success);
+	lua_setfield(luaStatePointer, -2, "priceIsValid");
+
+	// Raw price fields let Lua sort and filter products without parsing "localizedPrice".
+	// Note: Prices above 2^53 lose precision as Lua numbers, which is far beyond any real price.
+	lua_pushnumber(luaStatePointer, (lua_Number)Offer->CurrentPrice64);
+	lua_setfield(luaStatePointer, -2, "currentPrice64");
+
+	lua_pushnumber(luaStatePointer, (lua_Number)Offer->OriginalPrice64);
+	lua_setfield(luaStatePointer, -2, "originalPrice64");
+
+	lua_pushinteger(luaStatePointer, (lua_Integer)Offer->DecimalPoint);
+	lua_setfield(luaStatePointer, -2, "decimalPoint");
+
+	lua_pushstring(luaStatePointer, Offer->CurrencyCode ? Offer->CurrencyCode : "");
+	lua_setfield(luaStatePointer, -2, "currencyCode");
+
+	// Add the offer's key images. Images already downloaded by the image cache provide their local "path".
+	EOS_Ecom_GetOfferImageInfoCountOptions ImageCountOptions{0};
+	ImageCountOptions.ApiVersion = EOS_ECOM_GETOFFERIMAGEINFOCOUNT_API_LATEST;
+	ImageCountOptions.LocalUserId = localUserId;
+	ImageCountOptions.OfferId = Offer->Id;
+	uint32_t ImageCount = Offer->Id ? EOS_Ecom_GetOfferImageInfoCount(EcomHandle, &ImageCountOptions) : 0;
+	auto imageCachePointer = contextPointer->GetOfferImageCache();
+	lua_createtable(luaStatePointer, (int)ImageCount, 0);
+	for (uint32_t ImageIndex = 0; ImageIndex < ImageCount; ImageIndex++)
+	{
+		EOS_Ecom_CopyOfferImageInfoByIndexOptions ImageOptions{0};
+		ImageOptions.ApiVersion = EOS_ECOM_COPYOFFERIMAGEINFOBYINDEX_API_LATEST;
+		ImageOptions.LocalUserId = localUserId;
+		ImageOptions.OfferId = Offer->Id;
+		ImageOptions.ImageInfoIndex = ImageIndex;
+		EOS_Ecom_KeyImageInfo* ImageInfo = nullptr;
+		if (EOS_Ecom_CopyOfferImageInfoByIndex(EcomHandle, &ImageOptions, &ImageInfo) != EOS_EResult::EOS_Success)
+		{
+			continue;
+		}
+
+		lua_createtable(luaStatePointer, 0, 5);
+		lua_pushstring(luaStatePointer, ImageInfo->Type ? ImageInfo->Type : "");
+		lua_setfield(luaStatePointer, -2, "type");
+		lua_pushstring(luaStatePointer, ImageInfo->Url ? ImageInfo->Url : "");
+		lua_setfield(luaStatePointer, -2, "url");
+		lua_pushinteger(luaStatePointer, (lua_Integer)ImageInfo->Width);
+		lua_setfield(luaStatePointer, -2, "width");
+		lua_pushinteger(luaStatePointer, (lua_Integer)ImageInfo->Height);
+		lua_setfield(luaStatePointer, -2, "height");
+		std::string imagePath;
+		if (imageCachePointer && imageCachePointer->GetCachedPath(ImageInfo->Url, imagePath))
+		{
+			lua_pushlstring(luaStatePointer, imagePath.c_str(), imagePath.size());
+			lua_setfield(luaStatePointer, -2, "path");
+		}
+		lua_rawseti(luaStatePointer, -2, (int)lua_objlen(luaStatePointer, -2) + 1);
+		EOS_Ecom_KeyImageInfo_Release(ImageInfo);
+	}
+	lua_setfield(luaStatePointer, -2, "images");
+
+	EOS_Ecom_CatalogOffer_Release(Offer);
+	return true;
+}
+
+int LuaOfferCatalog::OnLength(lua_State* luaStatePointer)
+{
+	auto fieldsPointer = (UserdataFields*)luaL_checkudata(luaStatePointer, 1, kLuaMetatableName);
+	lua_pushinteger(luaStatePointer, fieldsPointer ? (lua_Integer)fieldsPointer->OfferCount : 0);
+	return 1;
+}
@@ -0,0 +1,86 @@
+// ----------------------------------------------------------------------------
+//
+// LuaOfferCatalog.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstdint>
+#include "eos_sdk.h"
+
+// Forward declarations.
+class RuntimeContext;
+extern "C"
+{
+	struct lua_State;
+}
+
+
+/**
+  Provides the "products" array of a "loadProducts" event.
+
+  By default, every offer is copied out of the EOS SDK's offer cache into a regular Lua array of product tables,
+  which works with ipairs(), pairs(), next(), the table library and json.encode().
+
+  If the "lazyProducts" field is set true in the "config.lua" file, a Lua userdata proxy is provided instead.
+  Indexing the proxy with a 1-based offer index copies that offer out of the EOS SDK's offer cache
+  via EOS_Ecom_CopyOfferByIndex() and converts it to a Lua product table. The product table is cached
+  in the proxy's environment table, so every offer is only copied and formatted once no matter how
+  many times Lua reads it. Offers that are never read are never copied.
+
+  The proxy supports the Lua length operator, so "#event.products" and "event.products[i]" work as they
+  would on a regular array. Since it is not a table, Lua 5.1's ipairs(), pairs(), next(), the table library and
+  json.encode() cannot iterate it, so listeners must loop from 1 to "#event.products" instead. A lazily filled
+  table would not help, since Lua 5.1's ipairs() and the length operator ignore a table's metamethods.
+  Offer indexes refer to the SDK's offer cache, which is only valid until the next eos.loadProducts() call completes.
+ */
+class LuaOfferCatalog
+{
+	public:
+		/** Unique name of the Lua metatable assigned to the proxy userdata. */
+		static const char kLuaMetatableName[];
+
+		/**
+		  Pushes the offers as a new Lua array of product tables, or as a new proxy, to the top of the Lua stack.
+		  @param luaStatePointer Lua state to push the products to.
+		  @param localUserId The Epic account the offers were queried for.
+		  @param offerCount Number of offers returned by EOS_Ecom_GetOfferCount().
+		  @param isLazy Set true to push a proxy copying offers when read. Set false to copy them all now.
+		  @return Returns true if pushed. Returns false if given a null Lua state.
+		 */
+		static bool PushTo(lua_State* luaStatePointer, EOS_EpicAccountId localUserId, uint32_t offerCount, bool isLazy);
+
+	private:
+		/** Static class which cannot be instantiated. */
+		LuaOfferCatalog() = delete;
+
+		/** Data stored in the proxy's Lua userdata memory block. */
+		struct UserdataFields
+		{
+			EOS_EpicAccountId LocalUserId;
+			uint32_t OfferCount;
+		};
+
+		/**
+		  Copies the given offer out of the SDK's offer cache and pushes it to Lua as a product table.
+		  @param luaStatePointer Lua state to push the product table to.
+		  @param contextPointer The runtime context owning the Lua state. Cannot be null.
+		  @param localUserId The Epic account the offers were queried for.
+		  @param offerIndex Zero-based index of the offer in the SDK's offer cache.
+		  @return Returns true if the table was pushed. Returns false if the offer could not be copied,
+		          in which case nothing is pushed.
+		 */
+		static bool PushProductTo(
+				lua_State* luaStatePointer, RuntimeContext* contextPointer,
+				EOS_EpicAccountId localUserId, uint32_t offerIndex);
+
+		/** Called when Lua reads "products[index]". Pushes the product table or nil. */
+		static int OnIndex(lua_State* luaStatePointer);
+
+		/** Called when Lua evaluates "#products". */
+		static int OnLength(lua_State* luaStatePointer);
+};
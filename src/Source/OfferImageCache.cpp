@@ -0,0 +1,402 @@
+// ----------------------------------------------------------------------------
+//
+// OfferImageCache.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#include "OfferImageCache.h"
+#include "CoronaLua.h"
+#include "DispatchEventTask.h"
+#include "Fnv1aHash.h"
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+extern "C"
+{
+#	include "lua.h"
+}
+
+
+/** Name of the file in system.CachesDirectory storing the cache's index. */
+static const char kIndexFileName[] = "eos-image-cache.index";
+
+/** Prefix of all image file names written to system.CachesDirectory by this cache. */
+static const char kImageFileNamePrefix[] = "eos-image-";
+
+/** Stores a collection of all OfferImageCache instances that currently exist in the application. */
+static std::unordered_set<OfferImageCache*> sOfferImageCacheCollection;
+
+
+/** Formats the given hash as a 16 character hexadecimal string. */
+static std::string ToHexString(uint64_t value)
+{
+	char stringBuffer[17];
+	snprintf(stringBuffer, sizeof(stringBuffer), "%016llx", (unsigned long long)value);
+	return std::string(stringBuffer);
+}
+
+/** Fetches the image file extension from the given URL's path, such as ".png". Defaults to ".png". */
+static std::string GetFileExtensionFrom(const std::string& url)
+{
+	size_t pathEndIndex = url.find_first_of("?#");
+	if (pathEndIndex == std::string::npos)
+	{
+		pathEndIndex = url.size();
+	}
+	size_t dotIndex = url.rfind('.', pathEndIndex);
+	size_t slashIndex = url.rfind('/', pathEndIndex);
+	if ((dotIndex != std::string::npos) && ((slashIndex == std::string::npos) || (dotIndex > slashIndex)))
+	{
+		std::string extension = url.substr(dotIndex, pathEndIndex - dotIndex);
+		for (auto&& character : extension)
+		{
+			character = (char)tolower((unsigned char)character);
+		}
+		if ((extension == ".png") || (extension == ".jpg") || (extension == ".jpeg"))
+		{
+			return extension;
+		}
+	}
+	return std::string(".png");
+}
+
+
+OfferImageCache::OfferImageCache(
+	lua_State* luaStatePointer, const std::shared_ptr<LuaEventDispatcher>& dispatcherPointer, uint64_t maxBytes)
+:	fLuaStatePointer(luaStatePointer),
+	fLuaEventDispatcherPointer(dispatcherPointer),
+	fIndex(maxBytes)
+{
+	// Fetch the path to Corona's caches directory via the index file's path.
+	if (fLuaStatePointer)
+	{
+		int luaStackTop = lua_gettop(fLuaStatePointer);
+		lua_getglobal(fLuaStatePointer, "system");
+		if (lua_istable(fLuaStatePointer, -1))
+		{
+			lua_getfield(fLuaStatePointer, -1, "pathForFile");
+			if (lua_isfunction(fLuaStatePointer, -1))
+			{
+				lua_pushstring(fLuaStatePointer, kIndexFileName);
+				lua_getfield(fLuaStatePointer, -3, "CachesDirectory");
+				if ((CoronaLuaDoCall(fLuaStatePointer, 2, 1) == 0) && (lua_type(fLuaStatePointer, -1) == LUA_TSTRING))
+				{
+					std::string indexFilePath(lua_tostring(fLuaStatePointer, -1));
+					size_t fileNameLength = strlen(kIndexFileName);
+					if (indexFilePath.size() > fileNameLength)
+					{
+						fDirectoryPath = indexFilePath.substr(0, indexFilePath.size() - fileNameLength - 1);
+					}
+				}
+			}
+		}
+		lua_settop(fLuaStatePointer, luaStackTop);
+	}
+	if (fDirectoryPath.empty())
+	{
+		CoronaLog("[EOS SDK] Image cache disabled. Unable to fetch the caches directory.");
+	}
+
+	// Load the previous session's cached files.
+	LoadIndex();
+	EvictLeastRecentlyUsed();
+
+	// Add this class instance to the global collection.
+	sOfferImageCacheCollection.insert(this);
+}
+
+OfferImageCache::~OfferImageCache()
+{
+	// Remove this class instance from the global collection.
+	// Note: In-flight download listeners check this collection and will do nothing once it is removed.
+	sOfferImageCacheCollection.erase(this);
+
+	SaveIndex();
+}
+
+bool OfferImageCache::GetCachedPath(const char* url, std::string& outPath)
+{
+	// Validate.
+	if (!url || ('\0' == url[0]))
+	{
+		return false;
+	}
+
+	// Find the file holding the given URL's image and flag it as the most recently used.
+	// Note: Files are only checked for on disk when the index is loaded, since this is called per offer image.
+	auto filePointer = fIndex.FindByUrlHash(Fnv1aHash::Hash64(url, strlen(url)));
+	if (!filePointer)
+	{
+		return false;
+	}
+	outPath = GetPathFor(filePointer->FileName);
+	return true;
+}
+
+void OfferImageCache::Prefetch(const char* url, const char* productId, const char* imageType)
+{
+	// Validate.
+	if (!url || ('\0' == url[0]) || fDirectoryPath.empty())
+	{
+		return;
+	}
+
+	// Do not download images that are already cached, queued or being downloaded.
+	uint64_t urlHash = Fnv1aHash::Hash64(url, strlen(url));
+	if (fIndex.ContainsUrlHash(urlHash))
+	{
+		return;
+	}
+	if ((fQueuedUrlHashes.find(urlHash) != fQueuedUrlHashes.end()) ||
+	    (fActiveDownloads.find(urlHash) != fActiveDownloads.end()))
+	{
+		return;
+	}
+
+	// Queue the download.
+	DownloadRequest request;
+	request.UrlHash = urlHash;
+	request.Url = url;
+	request.ProductId = productId ? productId : "";
+	request.ImageType = imageType ? imageType : "";
+	fQueuedDownloads.push_back(request);
+	fQueuedUrlHashes.insert(urlHash);
+	StartQueuedDownloads();
+}
+
+std::string OfferImageCache::GetPathFor(const std::string& fileName) const
+{
+	std::string path(fDirectoryPath);
+	path.append("/");
+	path.append(fileName);
+	return path;
+}
+
+void OfferImageCache::LoadIndex()
+{
+	if (fDirectoryPath.empty() || !fIndex.LoadFrom(GetPathFor(kIndexFileName).c_str()))
+	{
+		return;
+	}
+
+	// Drop files the OS deleted while clearing caches between launches.
+	std::vector<uint64_t> missingContentHashes;
+	for (auto&& file : fIndex.GetFiles())
+	{
+		FILE* filePointer = fopen(GetPathFor(file.FileName).c_str(), "rb");
+		if (filePointer)
+		{
+			fclose(filePointer);
+		}
+		else
+		{
+			missingContentHashes.push_back(file.ContentHash);
+		}
+	}
+	for (auto&& contentHash : missingContentHashes)
+	{
+		fIndex.Remove(contentHash);
+	}
+}
+
+void OfferImageCache::SaveIndex()
+{
+	if (!fIndex.IsDirty() || fDirectoryPath.empty())
+	{
+		return;
+	}
+	if (!fIndex.SaveTo(GetPathFor(kIndexFileName).c_str()))
+	{
+		CoronaLog("[EOS SDK] Failed to write the image cache index.");
+	}
+}
+
+void OfferImageCache::EvictLeastRecentlyUsed()
+{
+	for (auto&& fileName : fIndex.EvictLeastRecentlyUsed())
+	{
+		remove(GetPathFor(fileName).c_str());
+	}
+}
+
+void OfferImageCache::StartQueuedDownloads()
+{
+	while (!fQueuedDownloads.empty() && (fActiveDownloads.size() < (size_t)kMaxConcurrentDownloads))
+	{
+		DownloadRequest request = fQueuedDownloads.front();
+		fQueuedDownloads.pop_front();
+		fQueuedUrlHashes.erase(request.UrlHash);
+
+		// Fetch Corona's network.download() function.
+		lua_getglobal(fLuaStatePointer, "network");
+		if (!lua_istable(fLuaStatePointer, -1))
+		{
+			lua_pop(fLuaStatePointer, 1);
+			CoronaLog("[EOS SDK] Image cache disabled. The 'network' library is not available.");
+			fQueuedDownloads.clear();
+			fQueuedUrlHashes.clear();
+			return;
+		}
+		lua_getfield(fLuaStatePointer, -1, "download");
+		lua_remove(fLuaStatePointer, -2);
+
+		// Call network.download(url, "GET", listener, params, fileName, system.CachesDirectory).
+		// The listener is a closure holding this cache and the URL hash, since Corona gives it no request context.
+		std::string urlHashString = ToHexString(request.UrlHash);
+		std::string downloadFileName(kImageFileNamePrefix);
+		downloadFileName.append(urlHashString);
+		downloadFileName.append(".download");
+		lua_pushstring(fLuaStatePointer, request.Url.c_str());
+		lua_pushstring(fLuaStatePointer, "GET");
+		lua_pushlightuserdata(fLuaStatePointer, this);
+		lua_pushstring(fLuaStatePointer, urlHashString.c_str());
+		lua_pushcclosure(fLuaStatePointer, &OfferImageCache::OnDownloadEvent, 2);
+		lua_newtable(fLuaStatePointer);
+		lua_pushstring(fLuaStatePointer, downloadFileName.c_str());
+		lua_getglobal(fLuaStatePointer, "system");
+		lua_getfield(fLuaStatePointer, -1, "CachesDirectory");
+		lua_remove(fLuaStatePointer, -2);
+		fActiveDownloads[request.UrlHash] = request;
+		int luaStackTop = lua_gettop(fLuaStatePointer) - 7;
+		if (CoronaLuaDoCall(fLuaStatePointer, 6, 0) != 0)
+		{
+			CoronaLog("[EOS SDK] Failed to download image: %s", request.Url.c_str());
+			fActiveDownloads.erase(request.UrlHash);
+		}
+		lua_settop(fLuaStatePointer, luaStackTop);
+	}
+}
+
+void OfferImageCache::OnDownloadEnded(uint64_t urlHash, bool isError)
+{
+	// Fetch the download's request.
+	auto downloadIterator = fActiveDownloads.find(urlHash);
+	if (downloadIterator == fActiveDownloads.end())
+	{
+		return;
+	}
+	DownloadRequest request = downloadIterator->second;
+	fActiveDownloads.erase(downloadIterator);
+
+	std::string downloadFileName(kImageFileNamePrefix);
+	downloadFileName.append(ToHexString(urlHash));
+	downloadFileName.append(".download");
+	std::string downloadFilePath = GetPathFor(downloadFileName);
+
+	// Hash the downloaded file's content.
+	uint64_t contentHash = Fnv1aHash::kOffsetBasis64;
+	uint64_t fileSize = 0;
+	if (!isError)
+	{
+		FILE* filePointer = fopen(downloadFilePath.c_str(), "rb");
+		if (filePointer)
+		{
+			unsigned char readBuffer[16384];
+			size_t bytesRead;
+			while ((bytesRead = fread(readBuffer, 1, sizeof(readBuffer), filePointer)) > 0)
+			{
+				contentHash = Fnv1aHash::Hash64(readBuffer, bytesRead, contentHash);
+				fileSize += bytesRead;
+			}
+			fclose(filePointer);
+		}
+		isError = (0 == fileSize);
+	}
+
+	// Move the file to its content-addressed name, unless an identical image is already cached.
+	std::string filePath;
+	if (!isError)
+	{
+		auto cachedFilePointer = fIndex.FindByContentHash(contentHash);
+		if (cachedFilePointer)
+		{
+			remove(downloadFilePath.c_str());
+			filePath = GetPathFor(cachedFilePointer->FileName);
+			fIndex.Add(urlHash, contentHash, fileSize, cachedFilePointer->FileName);
+		}
+		else
+		{
+			std::string fileName(kImageFileNamePrefix);
+			fileName.append(ToHexString(contentHash));
+			fileName.append(GetFileExtensionFrom(request.Url));
+			filePath = GetPathFor(fileName);
+			remove(filePath.c_str());
+			if (rename(downloadFilePath.c_str(), filePath.c_str()) == 0)
+			{
+				fIndex.Add(urlHash, contentHash, fileSize, fileName);
+			}
+			else
+			{
+				isError = true;
+			}
+		}
+		EvictLeastRecentlyUsed();
+		SaveIndex();
+	}
+	if (isError)
+	{
+		remove(downloadFilePath.c_str());
+		filePath.clear();
+	}
+
+	// Dispatch a "productImage" event to Lua.
+	auto taskPointer = new DispatchProductImageEventTask();
+	taskPointer->SetLuaEventDispatcher(fLuaEventDispatcherPointer);
+	taskPointer->AcquireEventDataFrom(request.ProductId, request.ImageType, request.Url, filePath);
+	taskPointer->Execute();
+	delete taskPointer;
+
+	// Start the next queued download.
+	StartQueuedDownloads();
+}
+
+int OfferImageCache::OnDownloadEvent(lua_State* luaStatePointer)
+{
+	// Validate.
+	if (!luaStatePointer || !lua_istable(luaStatePointer, 1))
+	{
+		return 0;
+	}
+
+	// Ignore the event if the cache was destroyed while downloading.
+	auto cachePointer = (OfferImageCache*)lua_touserdata(luaStatePointer, lua_upvalueindex(1));
+	if (sOfferImageCacheCollection.find(cachePointer) == sOfferImageCacheCollection.end())
+	{
+		return 0;
+	}
+	auto urlHashString = lua_tostring(luaStatePointer, lua_upvalueindex(2));
+	if (!urlHashString)
+	{
+		return 0;
+	}
+	uint64_t urlHash = (uint64_t)strtoull(urlHashString, nullptr, 16);
+
+	// Only handle the final "ended" phase.
+	lua_getfield(luaStatePointer, 1, "phase");
+	auto phaseName = lua_tostring(luaStatePointer, -1);
+	bool hasEnded = !phaseName || !strcmp(phaseName, "ended");
+	lua_pop(luaStatePointer, 1);
+	if (!hasEnded)
+	{
+		return 0;
+	}
+
+	// Treat network failures and non-2xx HTTP responses as errors.
+	lua_getfield(luaStatePointer, 1, "isError");
+	bool isError = lua_toboolean(luaStatePointer, -1) ? true : false;
+	lua_pop(luaStatePointer, 1);
+	lua_getfield(luaStatePointer, 1, "status");
+	int statusCode = (int)lua_tointeger(luaStatePointer, -1);
+	lua_pop(luaStatePointer, 1);
+	if ((statusCode < 200) || (statusCode >= 300))
+	{
+		isError = true;
+	}
+
+	cachePointer->OnDownloadEnded(urlHash, isError);
+	return 0;
+}
@@ -0,0 +1,111 @@
+// ----------------------------------------------------------------------------
+//
+// OfferImageCache.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include "LuaEventDispatcher.h"
+#include "OfferImageIndex.h"
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Forward declarations.
+extern "C"
+{
+	struct lua_State;
+}
+
+
+/**
+  Size-capped, least-recently-used image cache stored in Corona's system.CachesDirectory.
+
+  Images are downloaded via Corona's native network.download() API, which transfers data on its own worker
+  threads. At most kMaxConcurrentDownloads run at the same time, and the rest wait in a queue.
+
+  Every downloaded file is renamed after a hash of its content, so offers and items that share an image
+  share 1 file on disk. An OfferImageIndex maps URL hashes to content hashes and keeps the LRU order
+  between launches. The least recently used files are deleted once the total size exceeds the cap.
+  Files are only checked for on disk when the index is loaded, so lookups never touch the file system.
+
+  A "productImage" event is dispatched to Lua when a download finishes, providing the local file path.
+ */
+class OfferImageCache
+{
+	public:
+		/** Maximum number of downloads in flight at the same time. */
+		static const int kMaxConcurrentDownloads = 4;
+
+		/**
+		  Creates a new image cache bound to the given Lua state and loads its index from disk.
+		  @param luaStatePointer Lua state used to call network.download() and system.pathForFile().
+		  @param dispatcherPointer Dispatcher used to send "productImage" events to Lua.
+		  @param maxBytes Total size of cached files above which the least recently used files are deleted.
+		 */
+		OfferImageCache(
+				lua_State* luaStatePointer, const std::shared_ptr<LuaEventDispatcher>& dispatcherPointer,
+				uint64_t maxBytes);
+
+		/** Saves the index and stops handling in-flight downloads. */
+		virtual ~OfferImageCache();
+
+		/**
+		  Fetches the local path of a cached image and marks it as recently used.
+		  @param url The image URL.
+		  @param outPath Receives the image's absolute file path if cached.
+		  @return Returns true if the image is cached. Returns false if not or if given a null URL.
+		 */
+		bool GetCachedPath(const char* url, std::string& outPath);
+
+		/**
+		  Queues the given image to be downloaded if it is not already cached or being downloaded.
+		  @param url The image URL.
+		  @param productId The offer or item ID the image belongs to. Passed back via the "productImage" event.
+		  @param imageType The EOS_Ecom_KeyImageInfo type, such as "home_thumbnail".
+		 */
+		void Prefetch(const char* url, const char* productId, const char* imageType);
+
+	private:
+		/** Copy constructor deleted to prevent it from being called. */
+		OfferImageCache(const OfferImageCache&) = delete;
+
+		/** Method deleted to prevent the copy operator from being used. */
+		void operator=(const OfferImageCache&) = delete;
+
+		/** An image waiting to be downloaded or being downloaded. */
+		struct DownloadRequest
+		{
+			uint64_t UrlHash;
+			std::string Url;
+			std::string ProductId;
+			std::string ImageType;
+		};
+
+		std::string GetPathFor(const std::string& fileName) const;
+		void LoadIndex();
+		void SaveIndex();
+		void EvictLeastRecentlyUsed();
+		void StartQueuedDownloads();
+		void OnDownloadEnded(uint64_t urlHash, bool isError);
+		static int OnDownloadEvent(lua_State* luaStatePointer);
+
+		lua_State* fLuaStatePointer;
+		std::shared_ptr<LuaEventDispatcher> fLuaEventDispatcherPointer;
+		std::string fDirectoryPath;
+
+		/** Cached files in LRU order. Saved to the index file in system.CachesDirectory. */
+		OfferImageIndex fIndex;
+
+		std::deque<DownloadRequest> fQueuedDownloads;
+		std::unordered_map<uint64_t, DownloadRequest> fActiveDownloads;
+		std::unordered_set<uint64_t> fQueuedUrlHashes;
+};
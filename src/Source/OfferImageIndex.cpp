@@ -0,0 +1,233 @@
+// ----------------------------------------------------------------------------
+//
+// OfferImageIndex.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#include "OfferImageIndex.h"
+#include "AtomicFile.h"
+#include <cstdio>
+#include <iterator>
+
+
+OfferImageIndex::OfferImageIndex(uint64_t maxBytes)
+:	fMaxBytes(maxBytes),
+	fTotalBytes(0),
+	fIsDirty(false)
+{
+}
+
+OfferImageIndex::~OfferImageIndex()
+{
+}
+
+const OfferImageIndex::File* OfferImageIndex::FindByUrlHash(uint64_t urlHash)
+{
+	auto urlIterator = fContentHashByUrlHash.find(urlHash);
+	if (urlIterator == fContentHashByUrlHash.end())
+	{
+		return nullptr;
+	}
+	auto fileIterator = fFilesByContentHash.find(urlIterator->second);
+	if (fileIterator == fFilesByContentHash.end())
+	{
+		fContentHashByUrlHash.erase(urlIterator);
+		return nullptr;
+	}
+
+	// Flag the file as the most recently used, unless it already is.
+	if (fileIterator->second != fFiles.begin())
+	{
+		fFiles.splice(fFiles.begin(), fFiles, fileIterator->second);
+		fIsDirty = true;
+	}
+	return &(*fileIterator->second);
+}
+
+const OfferImageIndex::File* OfferImageIndex::FindByContentHash(uint64_t contentHash) const
+{
+	auto fileIterator = fFilesByContentHash.find(contentHash);
+	return (fileIterator != fFilesByContentHash.end()) ? &(*fileIterator->second) : nullptr;
+}
+
+bool OfferImageIndex::ContainsUrlHash(uint64_t urlHash) const
+{
+	return (fContentHashByUrlHash.find(urlHash) != fContentHashByUrlHash.end());
+}
+
+void OfferImageIndex::Add(uint64_t urlHash, uint64_t contentHash, uint64_t size, const std::string& fileName)
+{
+	auto fileIterator = fFilesByContentHash.find(contentHash);
+	if (fileIterator == fFilesByContentHash.end())
+	{
+		File file;
+		file.ContentHash = contentHash;
+		file.Size = size;
+		file.FileName = fileName;
+		fFiles.push_front(file);
+		fileIterator = fFilesByContentHash.emplace(contentHash, fFiles.begin()).first;
+		fTotalBytes += size;
+	}
+	else
+	{
+		fFiles.splice(fFiles.begin(), fFiles, fileIterator->second);
+	}
+
+	// Map the URL to the file, moving it off the file it was mapped to before, if any.
+	auto urlIterator = fContentHashByUrlHash.find(urlHash);
+	if ((urlIterator != fContentHashByUrlHash.end()) && (urlIterator->second != contentHash))
+	{
+		auto oldFileIterator = fFilesByContentHash.find(urlIterator->second);
+		if (oldFileIterator != fFilesByContentHash.end())
+		{
+			auto& urlHashes = oldFileIterator->second->UrlHashes;
+			for (auto iterator = urlHashes.begin(); iterator != urlHashes.end(); ++iterator)
+			{
+				if (*iterator == urlHash)
+				{
+					urlHashes.erase(iterator);
+					break;
+				}
+			}
+		}
+	}
+	if ((urlIterator == fContentHashByUrlHash.end()) || (urlIterator->second != contentHash))
+	{
+		fileIterator->second->UrlHashes.push_back(urlHash);
+		fContentHashByUrlHash[urlHash] = contentHash;
+	}
+	fIsDirty = true;
+}
+
+void OfferImageIndex::Remove(uint64_t contentHash)
+{
+	auto fileIterator = fFilesByContentHash.find(contentHash);
+	if (fileIterator == fFilesByContentHash.end())
+	{
+		return;
+	}
+	for (auto&& urlHash : fileIterator->second->UrlHashes)
+	{
+		fContentHashByUrlHash.erase(urlHash);
+	}
+	fTotalBytes -= fileIterator->second->Size;
+	fFiles.erase(fileIterator->second);
+	fFilesByContentHash.erase(fileIterator);
+	fIsDirty = true;
+}
+
+std::vector<std::string> OfferImageIndex::EvictLeastRecentlyUsed()
+{
+	std::vector<std::string> fileNames;
+	while ((fTotalBytes > fMaxBytes) && (fFiles.size() > 1))
+	{
+		fileNames.push_back(fFiles.back().FileName);
+		Remove(fFiles.back().ContentHash);
+	}
+	return fileNames;
+}
+
+const std::list<OfferImageIndex::File>& OfferImageIndex::GetFiles() const
+{
+	return fFiles;
+}
+
+uint64_t OfferImageIndex::GetTotalBytes() const
+{
+	return fTotalBytes;
+}
+
+bool OfferImageIndex::IsDirty() const
+{
+	return fIsDirty;
+}
+
+bool OfferImageIndex::LoadFrom(const char* filePath)
+{
+	// Validate.
+	if (!filePath)
+	{
+		return false;
+	}
+
+	FILE* filePointer = fopen(filePath, "r");
+	if (!filePointer)
+	{
+		return false;
+	}
+
+	// Files are listed from most to least recently used, followed by the URLs mapped to them.
+	char lineBuffer[512];
+	while (fgets(lineBuffer, sizeof(lineBuffer), filePointer))
+	{
+		unsigned long long contentHash = 0;
+		unsigned long long otherValue = 0;
+		char fileName[256];
+		if (sscanf(lineBuffer, "F %llx %llu %255s", &contentHash, &otherValue, fileName) == 3)
+		{
+			if (fFilesByContentHash.find(contentHash) == fFilesByContentHash.end())
+			{
+				File file;
+				file.ContentHash = contentHash;
+				file.Size = otherValue;
+				file.FileName = fileName;
+				fFiles.push_back(file);
+				fFilesByContentHash[contentHash] = std::prev(fFiles.end());
+				fTotalBytes += file.Size;
+			}
+		}
+		else if (sscanf(lineBuffer, "U %llx %llx", &otherValue, &contentHash) == 2)
+		{
+			auto fileIterator = fFilesByContentHash.find(contentHash);
+			if ((fileIterator != fFilesByContentHash.end()) && !ContainsUrlHash(otherValue))
+			{
+				fContentHashByUrlHash[otherValue] = contentHash;
+				fileIterator->second->UrlHashes.push_back(otherValue);
+			}
+		}
+	}
+	fclose(filePointer);
+	return true;
+}
+
+bool OfferImageIndex::SaveTo(const char* filePath)
+{
+	// Validate.
+	if (!filePath)
+	{
+		return false;
+	}
+
+	// Write the index beside the old one and then swap it in.
+	std::string temporaryFilePath(filePath);
+	temporaryFilePath.append(".tmp");
+	FILE* filePointer = fopen(temporaryFilePath.c_str(), "w");
+	if (!filePointer)
+	{
+		return false;
+	}
+	for (auto&& file : fFiles)
+	{
+		fprintf(filePointer, "F %016llx %llu %s\n",
+				(unsigned long long)file.ContentHash, (unsigned long long)file.Size, file.FileName.c_str());
+	}
+	for (auto&& file : fFiles)
+	{
+		for (auto&& urlHash : file.UrlHashes)
+		{
+			fprintf(filePointer, "U %016llx %016llx\n",
+					(unsigned long long)urlHash, (unsigned long long)file.ContentHash);
+		}
+	}
+	bool wasWritten = (fclose(filePointer) == 0);
+	if (!wasWritten || !AtomicFile::Replace(temporaryFilePath.c_str(), filePath))
+	{
+		remove(temporaryFilePath.c_str());
+		return false;
+	}
+	fIsDirty = false;
+	return true;
+}
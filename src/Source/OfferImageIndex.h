@@ -0,0 +1,141 @@
+// ----------------------------------------------------------------------------
+//
+// OfferImageIndex.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+/**
+  In-memory index of the OfferImageCache's files, kept in least-recently-used order and capped in total size.
+
+  Maps URL hashes to the content-addressed files holding their images, so that URLs serving the same image
+  share 1 file. Does not touch the image files themselves, which lets the cache's bookkeeping be checked
+  without Corona's network.download() API. The index is saved to a small text file between launches.
+ */
+class OfferImageIndex
+{
+	public:
+		/** A cached file, named after the hash of its content. */
+		struct File
+		{
+			uint64_t ContentHash;
+			uint64_t Size;
+			std::string FileName;
+			std::vector<uint64_t> UrlHashes;
+		};
+
+		/**
+		  Creates an empty index.
+		  @param maxBytes Total size of the indexed files above which EvictLeastRecentlyUsed() removes files.
+		 */
+		OfferImageIndex(uint64_t maxBytes);
+
+		virtual ~OfferImageIndex();
+
+		/**
+		  Fetches the file holding the given URL's image and flags it as the most recently used.
+		  @param urlHash Hash of the image's URL.
+		  @return Returns the file. Returns null if the URL is not indexed.
+		 */
+		const File* FindByUrlHash(uint64_t urlHash);
+
+		/**
+		  Fetches the file with the given content hash without changing the LRU order.
+		  @param contentHash Hash of the file's content.
+		  @return Returns the file. Returns null if not indexed.
+		 */
+		const File* FindByContentHash(uint64_t contentHash) const;
+
+		/**
+		  Determines if the given URL's image is indexed, without changing the LRU order.
+		  @param urlHash Hash of the image's URL.
+		  @return Returns true if indexed.
+		 */
+		bool ContainsUrlHash(uint64_t urlHash) const;
+
+		/**
+		  Maps the given URL to the given file, adding the file if not indexed yet, and flags the file as the
+		  most recently used.
+		  @param urlHash Hash of the image's URL.
+		  @param contentHash Hash of the file's content.
+		  @param size Size of the file in bytes. Ignored if the file is already indexed.
+		  @param fileName Name of the file. Ignored if the file is already indexed.
+		 */
+		void Add(uint64_t urlHash, uint64_t contentHash, uint64_t size, const std::string& fileName);
+
+		/**
+		  Removes the given file and the URLs mapped to it.
+		  @param contentHash Hash of the file's content. Ignored if not indexed.
+		 */
+		void Remove(uint64_t contentHash);
+
+		/**
+		  Removes the least recently used files until the total size is within the cap.
+		  The most recently used file is always kept, even if it is larger than the cap by itself.
+		  @return Returns the names of the removed files, which the caller must delete.
+		 */
+		std::vector<std::string> EvictLeastRecentlyUsed();
+
+		/**
+		  Fetches the indexed files.
+		  @return Returns the files ordered from most to least recently used.
+		 */
+		const std::list<File>& GetFiles() const;
+
+		/**
+		  Fetches the total size of the indexed files.
+		  @return Returns the size in bytes.
+		 */
+		uint64_t GetTotalBytes() const;
+
+		/**
+		  Determines if the index changed since it was last loaded or saved.
+		  @return Returns true if changed.
+		 */
+		bool IsDirty() const;
+
+		/**
+		  Adds the files and URLs listed in the given index file, appending them in least-recently-used order.
+		  @param filePath Path to the index file.
+		  @return Returns true if the file was read. Returns false if it does not exist.
+		 */
+		bool LoadFrom(const char* filePath);
+
+		/**
+		  Writes the index to the given file, replacing it in 1 step so a crash never leaves a partial index.
+		  @param filePath Path to the index file.
+		  @return Returns true if written.
+		 */
+		bool SaveTo(const char* filePath);
+
+	private:
+		/** Copy constructor deleted to prevent it from being called. */
+		OfferImageIndex(const OfferImageIndex&) = delete;
+
+		/** Method deleted to prevent the copy operator from being used. */
+		void operator=(const OfferImageIndex&) = delete;
+
+		uint64_t fMaxBytes;
+		uint64_t fTotalBytes;
+		bool fIsDirty;
+
+		/** Indexed files ordered from most to least recently used. */
+		std::list<File> fFiles;
+
+		/** Indexed files by content hash. */
+		std::unordered_map<uint64_t, std::list<File>::iterator> fFilesByContentHash;
+
+		/** Content hash of the file holding each URL's image, by URL hash. */
+		std::unordered_map<uint64_t, uint64_t> fContentHashByUrlHash;
+};
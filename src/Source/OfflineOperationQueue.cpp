@@ -0,0 +1,174 @@
+// ----------------------------------------------------------------------------
+//
+// OfflineOperationQueue.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#include "OfflineOperationQueue.h"
+#include "AtomicFile.h"
+#include "CoronaLua.h"
+#include "Fnv1aHash.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+
+/** Record names of the operation types, indexed by the OfflineOperationQueue::OperationType enum. */
+static const char* kOperationTypeNames[] = { "R" };
+
+
+OfflineOperationQueue::OfflineOperationQueue()
+:	fHasUncommittedChanges(false)
+{
+}
+
+OfflineOperationQueue::~OfflineOperationQueue()
+{
+	Commit();
+}
+
+bool OfflineOperationQueue::Open(const char* filePath)
+{
+	// Validate.
+	if (!filePath || ('\0' == filePath[0]))
+	{
+		return false;
+	}
+	fFilePath = filePath;
+	fOperations.clear();
+	fHasUncommittedChanges = false;
+
+	// Load the operations held by the last launch.
+	FILE* filePointer = fopen(filePath, "r");
+	if (!filePointer)
+	{
+		return true;
+	}
+	char lineBuffer[512];
+	while (fgets(lineBuffer, sizeof(lineBuffer), filePointer))
+	{
+		// Split off the record's checksum, skipping torn or corrupted records.
+		char* checksumPointer = strrchr(lineBuffer, '#');
+		if (!checksumPointer)
+		{
+			continue;
+		}
+		unsigned int checksum = 0;
+		if ((sscanf(checksumPointer + 1, "%8x", &checksum) != 1) ||
+		    (checksum != Fnv1aHash::Hash32(lineBuffer, (size_t)(checksumPointer - lineBuffer))))
+		{
+			continue;
+		}
+		*checksumPointer = '\0';
+
+		// Parse the record, skipping types written by a newer version of this plugin.
+		char typeName[16];
+		char accountId[128];
+		char payload[256];
+		if (sscanf(lineBuffer, "%15s %127s %255s", typeName, accountId, payload) != 3)
+		{
+			continue;
+		}
+		for (size_t index = 0; index < (sizeof(kOperationTypeNames) / sizeof(kOperationTypeNames[0])); index++)
+		{
+			if (strcmp(typeName, kOperationTypeNames[index]) == 0)
+			{
+				Hold(Operation{ (OperationType)index, accountId, payload });
+				break;
+			}
+		}
+	}
+	fclose(filePointer);
+	fHasUncommittedChanges = false;
+	return true;
+}
+
+void OfflineOperationQueue::Hold(const Operation& operation)
+{
+	// Validate.
+	if (operation.AccountId.empty() || operation.Payload.empty())
+	{
+		return;
+	}
+
+	// Do not hold the same operation twice, since replaying it once has the same effect.
+	for (auto&& heldOperation : fOperations)
+	{
+		if ((heldOperation.Type == operation.Type) && (heldOperation.Payload == operation.Payload) &&
+		    (heldOperation.AccountId == operation.AccountId))
+		{
+			return;
+		}
+	}
+	fOperations.push_back(operation);
+	fHasUncommittedChanges = true;
+}
+
+std::vector<OfflineOperationQueue::Operation> OfflineOperationQueue::TakeBatch(
+	OperationType type, const std::string& accountId, size_t maxCount)
+{
+	std::vector<Operation> operations;
+	for (auto iterator = fOperations.begin(); (iterator != fOperations.end()) && (operations.size() < maxCount);)
+	{
+		if ((iterator->Type == type) && (iterator->AccountId == accountId))
+		{
+			operations.push_back(*iterator);
+			iterator = fOperations.erase(iterator);
+			fHasUncommittedChanges = true;
+		}
+		else
+		{
+			++iterator;
+		}
+	}
+	return operations;
+}
+
+size_t OfflineOperationQueue::GetCount() const
+{
+	return fOperations.size();
+}
+
+void OfflineOperationQueue::Commit()
+{
+	if (!fHasUncommittedChanges || fFilePath.empty())
+	{
+		return;
+	}
+	fHasUncommittedChanges = false;
+
+	// Delete the file once the queue has been drained.
+	if (fOperations.empty())
+	{
+		remove(fFilePath.c_str());
+		return;
+	}
+
+	// Write the queue beside the old file and then swap it in, so a crash while writing leaves either intact.
+	std::string temporaryFilePath(fFilePath);
+	temporaryFilePath.append(".tmp");
+	FILE* filePointer = fopen(temporaryFilePath.c_str(), "w");
+	if (!filePointer)
+	{
+		CoronaLog("[EOS SDK] Failed to write the offline operation queue.");
+		return;
+	}
+	for (auto&& operation : fOperations)
+	{
+		std::string record(kOperationTypeNames[(size_t)operation.Type]);
+		record.append(" ");
+		record.append(operation.AccountId);
+		record.append(" ");
+		record.append(operation.Payload);
+		fprintf(filePointer, "%s#%08x\n", record.c_str(), Fnv1aHash::Hash32(record.c_str(), record.size()));
+	}
+	bool wasWritten = (fclose(filePointer) == 0);
+	if (!wasWritten || !AtomicFile::Replace(temporaryFilePath.c_str(), fFilePath.c_str()))
+	{
+		remove(temporaryFilePath.c_str());
+		CoronaLog("[EOS SDK] Failed to write the offline operation queue.");
+	}
+}
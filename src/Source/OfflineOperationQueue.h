@@ -0,0 +1,92 @@
+// ----------------------------------------------------------------------------
+//
+// OfflineOperationQueue.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+
+/**
+  Persistent queue of idempotent EOS operations held back while the device is offline.
+
+  Operations that would fail with EOS_NoConnection are held here instead of being sent and lost, and are
+  handed back in batches by TakeBatch() once the network is back. The queue is written to disk by Commit(),
+  which is expected to be called once per frame, so operations held when the app exits are replayed on
+  the next launch.
+
+  Each record ends with a checksum, so a record torn by a crash while writing is ignored when loaded.
+ */
+class OfflineOperationQueue
+{
+	public:
+		/** Type of an operation, which determines how its payload is replayed. */
+		enum class OperationType
+		{
+			/** Redeems the EOS_Ecom_EntitlementId given as the payload via EOS_Ecom_RedeemEntitlements(). */
+			kRedeemEntitlement
+		};
+
+		/** An operation held until the network is back. */
+		struct Operation
+		{
+			OperationType Type;
+
+			/** String form of the Epic account that the operation must be replayed for. */
+			std::string AccountId;
+
+			/** The operation's argument, such as an entitlement ID. Cannot contain whitespace. */
+			std::string Payload;
+		};
+
+		OfflineOperationQueue();
+		virtual ~OfflineOperationQueue();
+
+		/**
+		  Loads the operations held by the last launch from the given file, which Commit() writes to afterwards.
+		  @param filePath Absolute path to the queue's file. It is created once an operation is held.
+		  @return Returns true if the path was set. Returns false if given a null or empty path.
+		 */
+		bool Open(const char* filePath);
+
+		/**
+		  Holds the given operation until TakeBatch() returns it. Ignored if the same operation is already held.
+		  @param operation The operation to hold. Ignored if its account ID or payload is empty.
+		 */
+		void Hold(const Operation& operation);
+
+		/**
+		  Removes and returns the oldest held operations of the given type and account.
+		  @param type The type of operations to take.
+		  @param accountId String form of the Epic account to take operations for.
+		  @param maxCount Maximum number of operations to take.
+		  @return Returns the operations taken, ordered from oldest to newest.
+		 */
+		std::vector<Operation> TakeBatch(OperationType type, const std::string& accountId, size_t maxCount);
+
+		/**
+		  Fetches the number of operations currently held.
+		  @return Returns the number of held operations. Returns zero if the queue is empty.
+		 */
+		size_t GetCount() const;
+
+		/** Rewrites the queue's file if operations were held or taken since the last call. */
+		void Commit();
+
+	private:
+		/** Copy constructor deleted to prevent it from being called. */
+		OfflineOperationQueue(const OfflineOperationQueue&) = delete;
+
+		/** Method deleted to prevent the copy operator from being used. */
+		void operator=(const OfflineOperationQueue&) = delete;
+
+		std::string fFilePath;
+		std::vector<Operation> fOperations;
+		bool fHasUncommittedChanges;
+};
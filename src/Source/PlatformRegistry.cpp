@@ -0,0 +1,166 @@
+// ----------------------------------------------------------------------------
+//
+// PlatformRegistry.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#include "PlatformRegistry.h"
+#include <chrono>
+#include <vector>
+
+
+/** A platform shared by 1 or more runtime contexts. */
+struct PlatformEntry
+{
+	PlatformRegistry::Key Key;
+	EOS_HPlatform PlatformHandle;
+	int ReferenceCount;
+	std::chrono::steady_clock::time_point LastTickTime;
+	bool HasTicked;
+};
+
+/**
+  Shortest time between 2 ticks of the same platform, well under 1 frame at 240 FPS.
+  Ticks requested sooner come from the other runtimes sharing the platform on the same frame.
+ */
+static const std::chrono::milliseconds kMinTickInterval(3);
+
+/** The platforms that currently exist. There are only ever a handful, so they are searched linearly. */
+static std::vector<PlatformEntry> sPlatformEntries;
+
+/** Set true once EOS_Initialize() succeeded. Set false by EOS_Shutdown(). */
+static bool sIsSdkInitialized = false;
+
+
+bool PlatformRegistry::Key::operator==(const Key& key) const
+{
+	return (IsServer == key.IsServer) && (ProductId == key.ProductId) && (SandboxId == key.SandboxId) &&
+			(DeploymentId == key.DeploymentId) && (InstanceName == key.InstanceName);
+}
+
+bool PlatformRegistry::IsSdkInitialized()
+{
+	return sIsSdkInitialized;
+}
+
+EOS_EResult PlatformRegistry::InitializeSdk(const EOS_InitializeOptions& options)
+{
+	if (sIsSdkInitialized)
+	{
+		return EOS_EResult::EOS_Success;
+	}
+	EOS_EResult result = EOS_Initialize(&options);
+	sIsSdkInitialized = (result == EOS_EResult::EOS_Success);
+	return result;
+}
+
+void PlatformRegistry::ShutdownSdk()
+{
+	for (auto&& entry : sPlatformEntries)
+	{
+		EOS_Platform_Release(entry.PlatformHandle);
+	}
+	sPlatformEntries.clear();
+	if (sIsSdkInitialized)
+	{
+		EOS_Shutdown();
+		sIsSdkInitialized = false;
+	}
+}
+
+EOS_HPlatform PlatformRegistry::Acquire(const Key& key, const EOS_Platform_Options& options)
+{
+	// Share the existing platform, if any.
+	for (auto&& entry : sPlatformEntries)
+	{
+		if (entry.Key == key)
+		{
+			entry.ReferenceCount++;
+			return entry.PlatformHandle;
+		}
+	}
+
+	// Create a new platform.
+	EOS_HPlatform platformHandle = EOS_Platform_Create(&options);
+	if (!platformHandle)
+	{
+		return nullptr;
+	}
+	PlatformEntry entry;
+	entry.Key = key;
+	entry.PlatformHandle = platformHandle;
+	entry.ReferenceCount = 1;
+	entry.HasTicked = false;
+	sPlatformEntries.push_back(entry);
+	return platformHandle;
+}
+
+void PlatformRegistry::Release(EOS_HPlatform platformHandle)
+{
+	if (!platformHandle)
+	{
+		return;
+	}
+
+	for (auto iterator = sPlatformEntries.begin(); iterator != sPlatformEntries.end(); ++iterator)
+	{
+		if (iterator->PlatformHandle == platformHandle)
+		{
+			iterator->ReferenceCount--;
+			if (iterator->ReferenceCount <= 0)
+			{
+				sPlatformEntries.erase(iterator);
+				EOS_Platform_Release(platformHandle);
+			}
+			return;
+		}
+	}
+}
+
+bool PlatformRegistry::Tick(EOS_HPlatform platformHandle)
+{
+	if (!platformHandle)
+	{
+		return false;
+	}
+
+	for (auto&& entry : sPlatformEntries)
+	{
+		if (entry.PlatformHandle == platformHandle)
+		{
+			// Skip the tick if another runtime sharing this platform has just ticked it.
+			auto currentTime = std::chrono::steady_clock::now();
+			if (entry.HasTicked && ((currentTime - entry.LastTickTime) < kMinTickInterval))
+			{
+				return false;
+			}
+			entry.LastTickTime = currentTime;
+			entry.HasTicked = true;
+
+			// Note: The entry is not referenced after the tick, since a callback may add or remove platforms.
+			EOS_Platform_Tick(platformHandle);
+			return true;
+		}
+	}
+	return false;
+}
+
+int PlatformRegistry::GetReferenceCountOf(EOS_HPlatform platformHandle)
+{
+	for (auto&& entry : sPlatformEntries)
+	{
+		if (entry.PlatformHandle == platformHandle)
+		{
+			return entry.ReferenceCount;
+		}
+	}
+	return 0;
+}
+
+int PlatformRegistry::GetPlatformCount()
+{
+	return (int)sPlatformEntries.size();
+}
@@ -0,0 +1,95 @@
+// ----------------------------------------------------------------------------
+//
+// PlatformRegistry.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include "eos_sdk.h"
+#include <string>
+
+
+/**
+  Owns the process-wide EOS SDK initialization and the EOS platforms shared by this plugin's runtime contexts.
+
+  Platforms are reference counted and keyed by product, sandbox and deployment ID, plus an optional instance
+  name set via the "platformInstance" field in the "config.lua" file. Runtimes using the same key share 1
+  platform, while runtimes given distinct instance names get platforms of their own, such as when testing
+  several sandboxes' storefronts in parallel in 1 process.
+
+  Each runtime context ticks its platform every frame, so a shared platform would be ticked once per runtime.
+  Tick() skips the ticks requested within a short interval of the last one, so that every platform is ticked
+  at its own owners' pace but at most about once per frame.
+
+  All methods must be called on the thread running Lua, since EOS invokes callbacks on the thread ticking it.
+ */
+class PlatformRegistry
+{
+	public:
+		/** Identifies a platform. Platforms are only shared between runtimes providing equal keys. */
+		struct Key
+		{
+			std::string ProductId;
+			std::string SandboxId;
+			std::string DeploymentId;
+			std::string InstanceName;
+			bool IsServer;
+
+			bool operator==(const Key& key) const;
+		};
+
+		/**
+		  Determines if EOS_Initialize() has succeeded and EOS_Shutdown() has not been called since.
+		  @return Returns true if the EOS SDK is initialized.
+		 */
+		static bool IsSdkInitialized();
+
+		/**
+		  Calls EOS_Initialize() with the given options, unless already initialized.
+		  @param options The options to initialize the SDK with.
+		  @return Returns EOS_Success if initialized, now or before. Otherwise returns EOS_Initialize()'s error.
+		 */
+		static EOS_EResult InitializeSdk(const EOS_InitializeOptions& options);
+
+		/** Releases every remaining platform and calls EOS_Shutdown(), if initialized. */
+		static void ShutdownSdk();
+
+		/**
+		  Fetches the platform for the given key, creating it if it does not exist yet.
+		  Every successful call must be balanced by a call to Release().
+		  @param key Identifies the platform to share.
+		  @param options The options to create the platform with, if not created yet.
+		  @return Returns the platform's handle. Returns null if EOS_Platform_Create() failed.
+		 */
+		static EOS_HPlatform Acquire(const Key& key, const EOS_Platform_Options& options);
+
+		/**
+		  Releases a reference to the given platform, releasing the platform itself once no runtime uses it.
+		  @param platformHandle Handle returned by Acquire(). Ignored if null.
+		 */
+		static void Release(EOS_HPlatform platformHandle);
+
+		/**
+		  Ticks the given platform, unless it was ticked within the last few milliseconds.
+		  @param platformHandle Handle returned by Acquire(). Ignored if null.
+		  @return Returns true if the platform was ticked.
+		 */
+		static bool Tick(EOS_HPlatform platformHandle);
+
+		/**
+		  Fetches the number of runtimes sharing the given platform.
+		  @param platformHandle Handle returned by Acquire().
+		  @return Returns the platform's reference count. Returns zero if not in the registry.
+		 */
+		static int GetReferenceCountOf(EOS_HPlatform platformHandle);
+
+		/**
+		  Fetches the number of platforms that currently exist.
+		  @return Returns the number of platforms.
+		 */
+		static int GetPlatformCount();
+};
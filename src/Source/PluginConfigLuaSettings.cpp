@@ -8,12 +8,181 @@
 // ----------------------------------------------------------------------------
 
 #include "PluginConfigLuaSettings.h"
+#include "AtomicFile.h"
 #include "CoronaLua.h"
+#include "Fnv1aHash.h"
+#include <cstdio>
+#include <cstring>
 #include <sstream>
 #include <string>
+#include <sys/stat.h>
+
+
+/** Default size cap of the on-disk offer image cache. */
+static const uint64_t kDefaultImageCacheMaxBytes = 32 * 1024 * 1024;
+
+/** Default number of events held while the app is suspended, past which the overflow policy applies. */
+static const uint32_t kDefaultSuspendedEventLimit = 100;
+
+/** Default number of held events dispatched per frame once the app resumes. */
+static const uint32_t kDefaultResumeEventsPerFrame = 8;
+
+/** Default number of frames that the garbage collection work caused by an event burst is spread over. */
+static const uint32_t kDefaultGcStepFrameCount = 10;
+
+/** Name of the settings snapshot file in Corona's system.CachesDirectory. */
+static const char kSnapshotFileName[] = "eos-config.snapshot";
+
+/** Identifies a settings snapshot file. */
+static const char kSnapshotMagic[4] = { 'E', 'O', 'S', 'C' };
+
+/**
+  Layout version of the settings snapshot. Must be incremented whenever a setting is added to,
+  removed from or reordered in ReadSnapshotFrom() and WriteSnapshotTo().
+ */
+static const uint32_t kSnapshotFormatVersion = 8;
+
+
+/**
+  Fetches the path to the given file via Lua's system.pathForFile().
+  @param luaStatePointer The Lua state to call system.pathForFile() with.
+  @param fileName Name of the file.
+  @param directoryName Name of the "system" directory constant, such as "CachesDirectory".
+  @param outPath Receives the file's path.
+  @return Returns true if the path was fetched. Returns false if the file or directory does not exist.
+ */
+static bool GetPathFor(lua_State* luaStatePointer, const char* fileName, const char* directoryName, std::string& outPath)
+{
+	bool wasFetched = false;
+	int luaStackTop = lua_gettop(luaStatePointer);
+	lua_getglobal(luaStatePointer, "system");
+	if (lua_istable(luaStatePointer, -1))
+	{
+		lua_getfield(luaStatePointer, -1, "pathForFile");
+		if (lua_isfunction(luaStatePointer, -1))
+		{
+			lua_pushstring(luaStatePointer, fileName);
+			lua_getfield(luaStatePointer, -3, directoryName);
+			if ((CoronaLuaDoCall(luaStatePointer, 2, 1) == 0) && (lua_type(luaStatePointer, -1) == LUA_TSTRING))
+			{
+				outPath = lua_tostring(luaStatePointer, -1);
+				wasFetched = true;
+			}
+		}
+	}
+	lua_settop(luaStatePointer, luaStackTop);
+	return wasFetched;
+}
+
+/**
+  Hashes the current "config.lua" file, or the app's "resource.car" where "config.lua" is compiled into it.
+  @param luaStatePointer The Lua state used to resolve the file paths.
+  @param outHash Receives the hash, which also covers the snapshot format version.
+  @return Returns true if hashed. Returns false if neither file can be read on this platform.
+ */
+static bool GetConfigHash(lua_State* luaStatePointer, uint64_t& outHash)
+{
+	uint64_t hash = Fnv1aHash::Hash64(&kSnapshotFormatVersion, sizeof(kSnapshotFormatVersion));
+	std::string filePath;
+	if (GetPathFor(luaStatePointer, "config.lua", "ResourceDirectory", filePath))
+	{
+		FILE* filePointer = fopen(filePath.c_str(), "rb");
+		if (filePointer)
+		{
+			char buffer[4096];
+			size_t byteCount;
+			while ((byteCount = fread(buffer, 1, sizeof(buffer), filePointer)) > 0)
+			{
+				hash = Fnv1aHash::Hash64(buffer, byteCount, hash);
+			}
+			fclose(filePointer);
+			outHash = hash;
+			return true;
+		}
+	}
+#if !defined(__ANDROID__)
+	// Note: A new build or install of the app replaces this archive, which changes its size or modification time.
+	if (GetPathFor(luaStatePointer, "resource.car", "ResourceDirectory", filePath))
+	{
+		struct stat fileStatus;
+		if (stat(filePath.c_str(), &fileStatus) == 0)
+		{
+			uint64_t fileSize = (uint64_t)fileStatus.st_size;
+			int64_t modificationTime = (int64_t)fileStatus.st_mtime;
+			hash = Fnv1aHash::Hash64(&fileSize, sizeof(fileSize), hash);
+			hash = Fnv1aHash::Hash64(&modificationTime, sizeof(modificationTime), hash);
+			outHash = hash;
+			return true;
+		}
+	}
+#endif
+	return false;
+}
+
+/** Appends the given string to a snapshot buffer, prefixed by its length. */
+static void AppendSnapshotString(std::string& buffer, const std::string& value)
+{
+	uint32_t length = (uint32_t)value.size();
+	buffer.append((const char*)&length, sizeof(length));
+	buffer.append(value);
+}
+
+template<class TValue>
+/** Appends the given value's bytes to a snapshot buffer. */
+static void AppendSnapshotValue(std::string& buffer, const TValue& value)
+{
+	buffer.append((const char*)&value, sizeof(value));
+}
+
+/** Reads values back from a snapshot buffer in the order they were appended. */
+struct SnapshotReader
+{
+	const char* Position;
+	const char* End;
+
+	bool ReadString(std::string& value)
+	{
+		uint32_t length = 0;
+		if (!ReadValue(length) || ((size_t)(End - Position) < length))
+		{
+			return false;
+		}
+		value.assign(Position, length);
+		Position += length;
+		return true;
+	}
+
+	template<class TValue>
+	bool ReadValue(TValue& value)
+	{
+		if ((size_t)(End - Position) < sizeof(value))
+		{
+			return false;
+		}
+		memcpy(&value, Position, sizeof(value));
+		Position += sizeof(value);
+		return true;
+	}
+};
 
 
 PluginConfigLuaSettings::PluginConfigLuaSettings()
+:	fIsProductImagePrefetchEnabled(false),
+	fImageCacheMaxBytes(kDefaultImageCacheMaxBytes),
+	fIsLazyProductCatalogEnabled(false),
+	fIsStartupLoadProductsEnabled(false),
+	fIsStartupRestoreEnabled(false),
+	fIsInitializationDeferred(false),
+	fInitializationDelay(-1.0),
+	fIsPersistentLoginEnabled(true),
+	fIsConnectLoginEnabled(false),
+	fSuspendedEventLimit(kDefaultSuspendedEventLimit),
+	fIsDroppingOldestSuspendedEvents(true),
+	fResumeEventsPerFrame(kDefaultResumeEventsPerFrame),
+	fIsServer(false),
+	fIsGcPacingEnabled(false),
+	fGcStepFrameCount(kDefaultGcStepFrameCount),
+	fIsGcPausedDuringDispatch(false)
 {
 }
 
@@ -176,6 +345,183 @@ void PluginConfigLuaSettings::SetStringProductVersion(const char* stringId)
     }
 }
 
+bool PluginConfigLuaSettings::IsProductImagePrefetchEnabled() const
+{
+	return fIsProductImagePrefetchEnabled;
+}
+
+void PluginConfigLuaSettings::SetProductImagePrefetchEnabled(bool value)
+{
+	fIsProductImagePrefetchEnabled = value;
+}
+
+uint64_t PluginConfigLuaSettings::GetImageCacheMaxBytes() const
+{
+	return fImageCacheMaxBytes;
+}
+
+void PluginConfigLuaSettings::SetImageCacheMaxBytes(uint64_t value)
+{
+	fImageCacheMaxBytes = value;
+}
+
+bool PluginConfigLuaSettings::IsLazyProductCatalogEnabled() const
+{
+	return fIsLazyProductCatalogEnabled;
+}
+
+void PluginConfigLuaSettings::SetLazyProductCatalogEnabled(bool value)
+{
+	fIsLazyProductCatalogEnabled = value;
+}
+
+bool PluginConfigLuaSettings::IsStartupLoadProductsEnabled() const
+{
+	return fIsStartupLoadProductsEnabled;
+}
+
+void PluginConfigLuaSettings::SetStartupLoadProductsEnabled(bool value)
+{
+	fIsStartupLoadProductsEnabled = value;
+}
+
+bool PluginConfigLuaSettings::IsStartupRestoreEnabled() const
+{
+	return fIsStartupRestoreEnabled;
+}
+
+void PluginConfigLuaSettings::SetStartupRestoreEnabled(bool value)
+{
+	fIsStartupRestoreEnabled = value;
+}
+
+bool PluginConfigLuaSettings::IsInitializationDeferred() const
+{
+	return fIsInitializationDeferred;
+}
+
+void PluginConfigLuaSettings::SetInitializationDeferred(bool value)
+{
+	fIsInitializationDeferred = value;
+}
+
+double PluginConfigLuaSettings::GetInitializationDelay() const
+{
+	return fInitializationDelay;
+}
+
+void PluginConfigLuaSettings::SetInitializationDelay(double value)
+{
+	fInitializationDelay = value;
+}
+
+bool PluginConfigLuaSettings::IsPersistentLoginEnabled() const
+{
+	return fIsPersistentLoginEnabled;
+}
+
+void PluginConfigLuaSettings::SetPersistentLoginEnabled(bool value)
+{
+	fIsPersistentLoginEnabled = value;
+}
+
+bool PluginConfigLuaSettings::IsConnectLoginEnabled() const
+{
+	return fIsConnectLoginEnabled;
+}
+
+void PluginConfigLuaSettings::SetConnectLoginEnabled(bool value)
+{
+	fIsConnectLoginEnabled = value;
+}
+
+uint32_t PluginConfigLuaSettings::GetSuspendedEventLimit() const
+{
+	return fSuspendedEventLimit;
+}
+
+void PluginConfigLuaSettings::SetSuspendedEventLimit(uint32_t value)
+{
+	fSuspendedEventLimit = value;
+}
+
+bool PluginConfigLuaSettings::IsDroppingOldestSuspendedEvents() const
+{
+	return fIsDroppingOldestSuspendedEvents;
+}
+
+void PluginConfigLuaSettings::SetDroppingOldestSuspendedEvents(bool value)
+{
+	fIsDroppingOldestSuspendedEvents = value;
+}
+
+uint32_t PluginConfigLuaSettings::GetResumeEventsPerFrame() const
+{
+	return fResumeEventsPerFrame;
+}
+
+void PluginConfigLuaSettings::SetResumeEventsPerFrame(uint32_t value)
+{
+	fResumeEventsPerFrame = value;
+}
+
+bool PluginConfigLuaSettings::IsServer() const
+{
+	return fIsServer;
+}
+
+void PluginConfigLuaSettings::SetServer(bool value)
+{
+	fIsServer = value;
+}
+
+const char* PluginConfigLuaSettings::GetStringPlatformInstance() const
+{
+	return fStringPlatformInstance.c_str();
+}
+
+void PluginConfigLuaSettings::SetStringPlatformInstance(const char* stringId)
+{
+	if (stringId)
+	{
+		fStringPlatformInstance = stringId;
+	}
+	else
+	{
+		fStringPlatformInstance.clear();
+	}
+}
+
+bool PluginConfigLuaSettings::IsGcPacingEnabled() const
+{
+	return fIsGcPacingEnabled;
+}
+
+void PluginConfigLuaSettings::SetGcPacingEnabled(bool value)
+{
+	fIsGcPacingEnabled = value;
+}
+
+uint32_t PluginConfigLuaSettings::GetGcStepFrameCount() const
+{
+	return fGcStepFrameCount;
+}
+
+void PluginConfigLuaSettings::SetGcStepFrameCount(uint32_t value)
+{
+	fGcStepFrameCount = value;
+}
+
+bool PluginConfigLuaSettings::IsGcPausedDuringDispatch() const
+{
+	return fIsGcPausedDuringDispatch;
+}
+
+void PluginConfigLuaSettings::SetGcPausedDuringDispatch(bool value)
+{
+	fIsGcPausedDuringDispatch = value;
+}
+
 void PluginConfigLuaSettings::Reset()
 {
 	fStringAppId.clear();
@@ -183,6 +529,219 @@ void PluginConfigLuaSettings::Reset()
 	fStringClientSecret.clear();
     fStringProductName.clear();
     fStringProductVersion.clear();
+	fIsProductImagePrefetchEnabled = false;
+	fImageCacheMaxBytes = kDefaultImageCacheMaxBytes;
+	fIsLazyProductCatalogEnabled = false;
+	fIsStartupLoadProductsEnabled = false;
+	fIsStartupRestoreEnabled = false;
+	fIsInitializationDeferred = false;
+	fInitializationDelay = -1.0;
+	fIsPersistentLoginEnabled = true;
+	fIsConnectLoginEnabled = false;
+	fSuspendedEventLimit = kDefaultSuspendedEventLimit;
+	fIsDroppingOldestSuspendedEvents = true;
+	fResumeEventsPerFrame = kDefaultResumeEventsPerFrame;
+	fIsServer = false;
+	fStringPlatformInstance.clear();
+	fIsGcPacingEnabled = false;
+	fGcStepFrameCount = kDefaultGcStepFrameCount;
+	fIsGcPausedDuringDispatch = false;
+}
+
+bool PluginConfigLuaSettings::LoadFromSnapshotOrConfig(lua_State* luaStatePointer)
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return false;
+	}
+
+	// Load the snapshot if it was written for the current "config.lua" file.
+	uint64_t configHash = 0;
+	std::string snapshotPath;
+	bool canUseSnapshot =
+			GetConfigHash(luaStatePointer, configHash) &&
+			GetPathFor(luaStatePointer, kSnapshotFileName, "CachesDirectory", snapshotPath);
+	if (canUseSnapshot && ReadSnapshotFrom(snapshotPath.c_str(), configHash))
+	{
+		// The snapshot never contains the client secret and encryption key, so fetch them from "config.lua".
+		PluginConfigLuaSettings configSettings;
+		bool wasLoaded = configSettings.LoadFrom(luaStatePointer);
+		fStringEncryptionKey = configSettings.fStringEncryptionKey;
+		fStringClientSecret = configSettings.fStringClientSecret;
+		return wasLoaded;
+	}
+
+	// Otherwise evaluate "config.lua" and snapshot its settings for the next launch.
+	// Note: No snapshot is written if this plugin's table was not found, so that LoadFrom() reports it every time.
+	bool wasLoaded = LoadFrom(luaStatePointer);
+	if (wasLoaded && canUseSnapshot)
+	{
+		WriteSnapshotTo(snapshotPath.c_str(), configHash);
+	}
+	return wasLoaded;
+}
+
+bool PluginConfigLuaSettings::ReadSnapshotFrom(const char* filePath, uint64_t configHash)
+{
+	// Validate.
+	if (!filePath || ('\0' == filePath[0]))
+	{
+		return false;
+	}
+
+	// Read the entire file at once.
+	FILE* filePointer = fopen(filePath, "rb");
+	if (!filePointer)
+	{
+		return false;
+	}
+	std::string buffer;
+	if (fseek(filePointer, 0, SEEK_END) == 0)
+	{
+		long fileSize = ftell(filePointer);
+		if ((fileSize > 0) && (fseek(filePointer, 0, SEEK_SET) == 0))
+		{
+			buffer.resize((size_t)fileSize);
+			if (fread(&buffer[0], 1, buffer.size(), filePointer) != buffer.size())
+			{
+				buffer.clear();
+			}
+		}
+	}
+	fclose(filePointer);
+
+	// Verify the header.
+	SnapshotReader reader{ buffer.data(), buffer.data() + buffer.size() };
+	char magic[sizeof(kSnapshotMagic)];
+	uint32_t formatVersion = 0;
+	uint64_t snapshotConfigHash = 0;
+	if (!reader.ReadValue(magic) || memcmp(magic, kSnapshotMagic, sizeof(magic)) ||
+	    !reader.ReadValue(formatVersion) || (formatVersion != kSnapshotFormatVersion) ||
+	    !reader.ReadValue(snapshotConfigHash) || (snapshotConfigHash != configHash))
+	{
+		return false;
+	}
+
+	// Read the settings into a copy, so that a truncated file leaves this object unchanged.
+	PluginConfigLuaSettings settings;
+	uint8_t isProductImagePrefetchEnabled = 0;
+	uint8_t isLazyProductCatalogEnabled = 0;
+	uint8_t isStartupLoadProductsEnabled = 0;
+	uint8_t isStartupRestoreEnabled = 0;
+	uint8_t isInitializationDeferred = 0;
+	uint8_t isPersistentLoginEnabled = 0;
+	uint8_t isConnectLoginEnabled = 0;
+	uint8_t isDroppingOldestSuspendedEvents = 0;
+	uint8_t isServer = 0;
+	uint8_t isGcPacingEnabled = 0;
+	uint8_t isGcPausedDuringDispatch = 0;
+	bool wasRead =
+			reader.ReadString(settings.fStringAppId) &&
+			reader.ReadString(settings.fStringProductId) &&
+			reader.ReadString(settings.fStringSandboxId) &&
+			reader.ReadString(settings.fStringDeploymentId) &&
+			reader.ReadString(settings.fStringClientId) &&
+			reader.ReadString(settings.fStringProductName) &&
+			reader.ReadString(settings.fStringProductVersion) &&
+			reader.ReadValue(isProductImagePrefetchEnabled) &&
+			reader.ReadValue(settings.fImageCacheMaxBytes) &&
+			reader.ReadValue(isLazyProductCatalogEnabled) &&
+			reader.ReadValue(isStartupLoadProductsEnabled) &&
+			reader.ReadValue(isStartupRestoreEnabled) &&
+			reader.ReadValue(isInitializationDeferred) &&
+			reader.ReadValue(settings.fInitializationDelay) &&
+			reader.ReadValue(isPersistentLoginEnabled) &&
+			reader.ReadValue(isConnectLoginEnabled) &&
+			reader.ReadValue(settings.fSuspendedEventLimit) &&
+			reader.ReadValue(isDroppingOldestSuspendedEvents) &&
+			reader.ReadValue(settings.fResumeEventsPerFrame) &&
+			reader.ReadValue(isServer) &&
+			reader.ReadString(settings.fStringPlatformInstance) &&
+			reader.ReadValue(isGcPacingEnabled) &&
+			reader.ReadValue(settings.fGcStepFrameCount) &&
+			reader.ReadValue(isGcPausedDuringDispatch) &&
+			(reader.Position == reader.End);
+	if (!wasRead)
+	{
+		return false;
+	}
+	settings.fIsProductImagePrefetchEnabled = (isProductImagePrefetchEnabled != 0);
+	settings.fIsLazyProductCatalogEnabled = (isLazyProductCatalogEnabled != 0);
+	settings.fIsStartupLoadProductsEnabled = (isStartupLoadProductsEnabled != 0);
+	settings.fIsStartupRestoreEnabled = (isStartupRestoreEnabled != 0);
+	settings.fIsInitializationDeferred = (isInitializationDeferred != 0);
+	settings.fIsPersistentLoginEnabled = (isPersistentLoginEnabled != 0);
+	settings.fIsConnectLoginEnabled = (isConnectLoginEnabled != 0);
+	settings.fIsDroppingOldestSuspendedEvents = (isDroppingOldestSuspendedEvents != 0);
+	settings.fIsServer = (isServer != 0);
+	settings.fIsGcPacingEnabled = (isGcPacingEnabled != 0);
+	settings.fIsGcPausedDuringDispatch = (isGcPausedDuringDispatch != 0);
+	settings.fStringEncryptionKey = fStringEncryptionKey;
+	settings.fStringClientSecret = fStringClientSecret;
+	*this = settings;
+	return true;
+}
+
+bool PluginConfigLuaSettings::WriteSnapshotTo(const char* filePath, uint64_t configHash) const
+{
+	// Validate.
+	if (!filePath || ('\0' == filePath[0]))
+	{
+		return false;
+	}
+
+	// Serialize the header and settings.
+	// Note: The snapshot is only ever read back on the device that wrote it, so native byte order is used.
+	// Note: The client secret and encryption key are left out, since system.CachesDirectory is not protected.
+	std::string buffer;
+	buffer.append(kSnapshotMagic, sizeof(kSnapshotMagic));
+	AppendSnapshotValue(buffer, kSnapshotFormatVersion);
+	AppendSnapshotValue(buffer, configHash);
+	AppendSnapshotString(buffer, fStringAppId);
+	AppendSnapshotString(buffer, fStringProductId);
+	AppendSnapshotString(buffer, fStringSandboxId);
+	AppendSnapshotString(buffer, fStringDeploymentId);
+	AppendSnapshotString(buffer, fStringClientId);
+	AppendSnapshotString(buffer, fStringProductName);
+	AppendSnapshotString(buffer, fStringProductVersion);
+	AppendSnapshotValue(buffer, (uint8_t)(fIsProductImagePrefetchEnabled ? 1 : 0));
+	AppendSnapshotValue(buffer, fImageCacheMaxBytes);
+	AppendSnapshotValue(buffer, (uint8_t)(fIsLazyProductCatalogEnabled ? 1 : 0));
+	AppendSnapshotValue(buffer, (uint8_t)(fIsStartupLoadProductsEnabled ? 1 : 0));
+	AppendSnapshotValue(buffer, (uint8_t)(fIsStartupRestoreEnabled ? 1 : 0));
+	AppendSnapshotValue(buffer, (uint8_t)(fIsInitializationDeferred ? 1 : 0));
+	AppendSnapshotValue(buffer, fInitializationDelay);
+	AppendSnapshotValue(buffer, (uint8_t)(fIsPersistentLoginEnabled ? 1 : 0));
+	AppendSnapshotValue(buffer, (uint8_t)(fIsConnectLoginEnabled ? 1 : 0));
+	AppendSnapshotValue(buffer, fSuspendedEventLimit);
+	AppendSnapshotValue(buffer, (uint8_t)(fIsDroppingOldestSuspendedEvents ? 1 : 0));
+	AppendSnapshotValue(buffer, fResumeEventsPerFrame);
+	AppendSnapshotValue(buffer, (uint8_t)(fIsServer ? 1 : 0));
+	AppendSnapshotString(buffer, fStringPlatformInstance);
+	AppendSnapshotValue(buffer, (uint8_t)(fIsGcPacingEnabled ? 1 : 0));
+	AppendSnapshotValue(buffer, fGcStepFrameCount);
+	AppendSnapshotValue(buffer, (uint8_t)(fIsGcPausedDuringDispatch ? 1 : 0));
+
+	// Write to a temporary file first, so that an interrupted write never leaves a partial snapshot behind.
+	std::string temporaryFilePath(filePath);
+	temporaryFilePath.append(".tmp");
+	FILE* filePointer = fopen(temporaryFilePath.c_str(), "wb");
+	if (!filePointer)
+	{
+		return false;
+	}
+	bool wasWritten = (fwrite(buffer.data(), 1, buffer.size(), filePointer) == buffer.size());
+	wasWritten = (fclose(filePointer) == 0) && wasWritten;
+	if (wasWritten)
+	{
+		wasWritten = AtomicFile::Replace(temporaryFilePath.c_str(), filePath);
+	}
+	if (!wasWritten)
+	{
+		remove(temporaryFilePath.c_str());
+	}
+	return wasWritten;
 }
 
 bool PluginConfigLuaSettings::LoadFrom(lua_State* luaStatePointer)
@@ -363,7 +922,159 @@ bool PluginConfigLuaSettings::LoadFrom(lua_State* luaStatePointer)
                 }
                 lua_pop(luaStatePointer, 1);
                 
+				// Fetch the flag enabling offer image downloads after eos.loadProducts().
+				lua_getfield(luaStatePointer, -1, "prefetchProductImages");
+				if (lua_type(luaStatePointer, -1) == LUA_TBOOLEAN)
+				{
+					fIsProductImagePrefetchEnabled = lua_toboolean(luaStatePointer, -1) ? true : false;
+				}
+				lua_pop(luaStatePointer, 1);
+
+				// Fetch the offer image cache's size cap in bytes.
+				lua_getfield(luaStatePointer, -1, "imageCacheMaxBytes");
+				if (lua_type(luaStatePointer, -1) == LUA_TNUMBER)
+				{
+					auto numberValue = lua_tonumber(luaStatePointer, -1);
+					if (numberValue > 0)
+					{
+						fImageCacheMaxBytes = (uint64_t)numberValue;
+					}
+				}
+				lua_pop(luaStatePointer, 1);
+
+				// Fetch the flag providing "loadProducts" offers through a lazy proxy instead of a table.
+				lua_getfield(luaStatePointer, -1, "lazyProducts");
+				if (lua_type(luaStatePointer, -1) == LUA_TBOOLEAN)
+				{
+					fIsLazyProductCatalogEnabled = lua_toboolean(luaStatePointer, -1) ? true : false;
+				}
+				lua_pop(luaStatePointer, 1);
+
+				// Fetch the stages to run natively as soon as the user has logged in.
+				lua_getfield(luaStatePointer, -1, "startup");
+				if (lua_istable(luaStatePointer, -1))
+				{
+					lua_getfield(luaStatePointer, -1, "loadProducts");
+					fIsStartupLoadProductsEnabled = lua_toboolean(luaStatePointer, -1) ? true : false;
+					lua_pop(luaStatePointer, 1);
+
+					lua_getfield(luaStatePointer, -1, "restore");
+					fIsStartupRestoreEnabled = lua_toboolean(luaStatePointer, -1) ? true : false;
+					lua_pop(luaStatePointer, 1);
+				}
+				lua_pop(luaStatePointer, 1);
+
+				// Fetch the flag deferring EOS initialization until first use, and the optional delay in seconds
+				// after which to initialize anyway.
+				lua_getfield(luaStatePointer, -1, "deferInitialization");
+				if (lua_type(luaStatePointer, -1) == LUA_TBOOLEAN)
+				{
+					fIsInitializationDeferred = lua_toboolean(luaStatePointer, -1) ? true : false;
+				}
+				lua_pop(luaStatePointer, 1);
+				lua_getfield(luaStatePointer, -1, "initializationDelay");
+				if (lua_type(luaStatePointer, -1) == LUA_TNUMBER)
+				{
+					fInitializationDelay = lua_tonumber(luaStatePointer, -1);
+				}
+				lua_pop(luaStatePointer, 1);
+
+				// Fetch the flag storing the Epic refresh token on desktop platforms to log in with on the next launch.
+				lua_getfield(luaStatePointer, -1, "persistentLogin");
+				if (lua_type(luaStatePointer, -1) == LUA_TBOOLEAN)
+				{
+					fIsPersistentLoginEnabled = lua_toboolean(luaStatePointer, -1) ? true : false;
+				}
+				lua_pop(luaStatePointer, 1);
+
+				// Fetch the flag logging into the Connect interface after each Auth login.
+				lua_getfield(luaStatePointer, -1, "connectLogin");
+				if (lua_type(luaStatePointer, -1) == LUA_TBOOLEAN)
+				{
+					fIsConnectLoginEnabled = lua_toboolean(luaStatePointer, -1) ? true : false;
+				}
+				lua_pop(luaStatePointer, 1);
+
+				// Fetch how EOS is ticked while the app is suspended, how many events are held until it resumes,
+				// which are dropped past that, and how many are dispatched per frame once resumed.
+				lua_getfield(luaStatePointer, -1, "background");
+				if (lua_istable(luaStatePointer, -1))
+				{
+					lua_getfield(luaStatePointer, -1, "eventLimit");
+					if ((lua_type(luaStatePointer, -1) == LUA_TNUMBER) && (lua_tonumber(luaStatePointer, -1) >= 1))
+					{
+						fSuspendedEventLimit = (uint32_t)lua_tonumber(luaStatePointer, -1);
+					}
+					lua_pop(luaStatePointer, 1);
+
+					lua_getfield(luaStatePointer, -1, "overflow");
+					if (lua_type(luaStatePointer, -1) == LUA_TSTRING)
+					{
+						auto stringValue = lua_tostring(luaStatePointer, -1);
+						if (!strcmp(stringValue, "dropOldest"))
+						{
+							fIsDroppingOldestSuspendedEvents = true;
+						}
+						else if (!strcmp(stringValue, "dropNewest"))
+						{
+							fIsDroppingOldestSuspendedEvents = false;
+						}
+					}
+					lua_pop(luaStatePointer, 1);
+
+					lua_getfield(luaStatePointer, -1, "resumeEventsPerFrame");
+					if ((lua_type(luaStatePointer, -1) == LUA_TNUMBER) && (lua_tonumber(luaStatePointer, -1) >= 1))
+					{
+						fResumeEventsPerFrame = (uint32_t)lua_tonumber(luaStatePointer, -1);
+					}
+					lua_pop(luaStatePointer, 1);
+				}
+				lua_pop(luaStatePointer, 1);
+
+				// Fetch the flag running as a dedicated server, which creates a server platform and never logs in a user.
+				lua_getfield(luaStatePointer, -1, "server");
+				if (lua_type(luaStatePointer, -1) == LUA_TBOOLEAN)
+				{
+					fIsServer = lua_toboolean(luaStatePointer, -1) ? true : false;
+				}
+				lua_pop(luaStatePointer, 1);
+
+				// Fetch the name of the platform instance to use. Runtimes only share a platform if these names match.
+				lua_getfield(luaStatePointer, -1, "platformInstance");
+				if (lua_type(luaStatePointer, -1) == LUA_TSTRING)
+				{
+					auto stringValue = lua_tostring(luaStatePointer, -1);
+					if (stringValue)
+					{
+						fStringPlatformInstance = stringValue;
+					}
+				}
+				lua_pop(luaStatePointer, 1);
+
+				// Fetch the settings spreading the garbage collection caused by large event bursts over several frames.
+				lua_getfield(luaStatePointer, -1, "gcPacing");
+				if (lua_istable(luaStatePointer, -1))
+				{
+					fIsGcPacingEnabled = true;
+
+					lua_getfield(luaStatePointer, -1, "stepFrames");
+					if ((lua_type(luaStatePointer, -1) == LUA_TNUMBER) && (lua_tonumber(luaStatePointer, -1) >= 1))
+					{
+						fGcStepFrameCount = (uint32_t)lua_tonumber(luaStatePointer, -1);
+					}
+					lua_pop(luaStatePointer, 1);
+
+					lua_getfield(luaStatePointer, -1, "pauseDuringDispatch");
+					if (lua_type(luaStatePointer, -1) == LUA_TBOOLEAN)
+					{
+						fIsGcPausedDuringDispatch = lua_toboolean(luaStatePointer, -1) ? true : false;
+					}
+					lua_pop(luaStatePointer, 1);
+				}
+				lua_pop(luaStatePointer, 1);
+
 				// *** In the future, other "config.lua" plugin settings can be loaded here. ***
+				// *** They must also be added to ReadSnapshotFrom() and WriteSnapshotTo(). ***
 			}
 			lua_pop(luaStatePointer, 1);
 		}
@@ -9,6 +9,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
 extern "C"
 {
@@ -21,6 +22,10 @@ extern "C"
 
   Will ensure that the "config.lua" file is removed from the Lua package manager
   and the file's "application" Lua global is nil'ed out if not loaded before.
+
+  The resolved settings can also be written to a binary snapshot which LoadFromSnapshotOrConfig() reads
+  back on later launches instead of parsing "config.lua", for as long as "config.lua" is unchanged.
+  The client secret and encryption key are never written to the snapshot and are always read from "config.lua".
  */
 class PluginConfigLuaSettings
 {
@@ -46,10 +51,76 @@ class PluginConfigLuaSettings
         void SetStringProductName(const char* stringId);
         const char* GetStringProductVersion() const;
         void SetStringProductVersion(const char* stringId);
+		bool IsProductImagePrefetchEnabled() const;
+		void SetProductImagePrefetchEnabled(bool value);
+		uint64_t GetImageCacheMaxBytes() const;
+		void SetImageCacheMaxBytes(uint64_t value);
+		bool IsLazyProductCatalogEnabled() const;
+		void SetLazyProductCatalogEnabled(bool value);
+		bool IsStartupLoadProductsEnabled() const;
+		void SetStartupLoadProductsEnabled(bool value);
+		bool IsStartupRestoreEnabled() const;
+		void SetStartupRestoreEnabled(bool value);
+		bool IsInitializationDeferred() const;
+		void SetInitializationDeferred(bool value);
+		double GetInitializationDelay() const;
+		void SetInitializationDelay(double value);
+		bool IsPersistentLoginEnabled() const;
+		void SetPersistentLoginEnabled(bool value);
+		bool IsConnectLoginEnabled() const;
+		void SetConnectLoginEnabled(bool value);
+		uint32_t GetSuspendedEventLimit() const;
+		void SetSuspendedEventLimit(uint32_t value);
+		bool IsDroppingOldestSuspendedEvents() const;
+		void SetDroppingOldestSuspendedEvents(bool value);
+		uint32_t GetResumeEventsPerFrame() const;
+		void SetResumeEventsPerFrame(uint32_t value);
+		bool IsServer() const;
+		void SetServer(bool value);
+		const char* GetStringPlatformInstance() const;
+		void SetStringPlatformInstance(const char* stringId);
+		bool IsGcPacingEnabled() const;
+		void SetGcPacingEnabled(bool value);
+		uint32_t GetGcStepFrameCount() const;
+		void SetGcStepFrameCount(uint32_t value);
+		bool IsGcPausedDuringDispatch() const;
+		void SetGcPausedDuringDispatch(bool value);
         
 		void Reset();
 		bool LoadFrom(lua_State* luaStatePointer);
 
+		/**
+		  Loads the settings from the snapshot in system.CachesDirectory if it was written for the current
+		  "config.lua" file. Otherwise loads them via LoadFrom() and writes a new snapshot for the next launch.
+		  Either way, the client secret and encryption key are read from the "config.lua" file via LoadFrom().
+
+		  The snapshot is keyed by a hash of the "config.lua" file's contents. Where that file is compiled into
+		  the app, the size and modification time of the app's "resource.car" are hashed instead. On Android,
+		  where neither is readable without extracting it from the APK, this always calls LoadFrom().
+		  @param luaStatePointer Lua state used to resolve paths via system.pathForFile() and to load "config.lua".
+		  @return Returns true if this plugin's settings table was found in the "config.lua" file.
+		 */
+		bool LoadFromSnapshotOrConfig(lua_State* luaStatePointer);
+
+		/**
+		  Loads the settings from the given snapshot file via a single read.
+		  Leaves the client secret and encryption key unchanged, since they are not part of the snapshot.
+		  @param filePath Path to the snapshot file.
+		  @param configHash Hash of the "config.lua" file that the snapshot must have been written for.
+		  @return Returns true if loaded. Returns false if the file does not exist, is corrupt, or was written
+		          for another "config.lua" or snapshot format, in which case the settings are left unchanged.
+		 */
+		bool ReadSnapshotFrom(const char* filePath, uint64_t configHash);
+
+		/**
+		  Writes the settings to the given snapshot file, replacing the last one.
+		  The client secret and encryption key are not written.
+		  @param filePath Path to the snapshot file.
+		  @param configHash Hash of the "config.lua" file the settings were loaded from.
+		  @return Returns true if written.
+		 */
+		bool WriteSnapshotTo(const char* filePath, uint64_t configHash) const;
+
 	private:
 		std::string fStringEncryptionKey;
 		std::string fStringAppId;
@@ -60,4 +131,21 @@ class PluginConfigLuaSettings
 		std::string fStringClientSecret;
         std::string fStringProductName;
         std::string fStringProductVersion;
+		bool fIsProductImagePrefetchEnabled;
+		uint64_t fImageCacheMaxBytes;
+		bool fIsLazyProductCatalogEnabled;
+		bool fIsStartupLoadProductsEnabled;
+		bool fIsStartupRestoreEnabled;
+		bool fIsInitializationDeferred;
+		double fInitializationDelay;
+		bool fIsPersistentLoginEnabled;
+		bool fIsConnectLoginEnabled;
+		uint32_t fSuspendedEventLimit;
+		bool fIsDroppingOldestSuspendedEvents;
+		uint32_t fResumeEventsPerFrame;
+		bool fIsServer;
+		std::string fStringPlatformInstance;
+		bool fIsGcPacingEnabled;
+		uint32_t fGcStepFrameCount;
+		bool fIsGcPausedDuringDispatch;
 };
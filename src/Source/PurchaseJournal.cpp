@@ -0,0 +1,238 @@
+// ----------------------------------------------------------------------------
+//
+// PurchaseJournal.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#include "PurchaseJournal.h"
+#include "AtomicFile.h"
+#include "CoronaLua.h"
+#include "Fnv1aHash.h"
+#include <cstdint>
+#include <cstring>
+#ifdef _WIN32
+#	include <io.h>
+#else
+#	include <unistd.h>
+#endif
+
+
+/**
+  Forces the OS to write the given file's data to disk.
+  @param filePointer The file to flush. Its stdio buffer must already be flushed.
+ */
+static void SyncToDisk(FILE* filePointer)
+{
+#ifdef _WIN32
+	_commit(_fileno(filePointer));
+#else
+	fsync(fileno(filePointer));
+#endif
+}
+
+
+PurchaseJournal::PurchaseJournal()
+:	fFilePointer(nullptr),
+	fHasUncommittedRecords(false)
+{
+}
+
+PurchaseJournal::~PurchaseJournal()
+{
+	Close();
+}
+
+bool PurchaseJournal::Open(const char* filePath)
+{
+	// Validate.
+	if (!filePath || ('\0' == filePath[0]))
+	{
+		return false;
+	}
+
+	// Close the last journal, if open.
+	Close();
+	fPendingTransactions.clear();
+	fFilePath = filePath;
+
+	// Replay the journal's records to find the transactions that were never acknowledged.
+	FILE* filePointer = fopen(filePath, "r");
+	if (filePointer)
+	{
+		char lineBuffer[512];
+		while (fgets(lineBuffer, sizeof(lineBuffer), filePointer))
+		{
+			// Split off the record's checksum, skipping torn or corrupted records.
+			char* checksumPointer = strrchr(lineBuffer, '#');
+			if (!checksumPointer)
+			{
+				continue;
+			}
+			unsigned int checksum = 0;
+			if ((sscanf(checksumPointer + 1, "%8x", &checksum) != 1) ||
+			    (checksum != Fnv1aHash::Hash32(lineBuffer, (size_t)(checksumPointer - lineBuffer))))
+			{
+				continue;
+			}
+			*checksumPointer = '\0';
+
+			// Apply the record.
+			char entitlementId[128];
+			char catalogItemId[128];
+			char accountId[128];
+			if (sscanf(lineBuffer, "P %127s %127s %127s", entitlementId, catalogItemId, accountId) == 3)
+			{
+				bool isPending = false;
+				for (auto&& transaction : fPendingTransactions)
+				{
+					if (transaction.EntitlementId == entitlementId)
+					{
+						isPending = true;
+						break;
+					}
+				}
+				if (!isPending)
+				{
+					fPendingTransactions.push_back(Transaction{ entitlementId, catalogItemId, accountId });
+				}
+			}
+			else if (sscanf(lineBuffer, "A %127s", entitlementId) == 1)
+			{
+				for (auto iterator = fPendingTransactions.begin(); iterator != fPendingTransactions.end(); ++iterator)
+				{
+					if (iterator->EntitlementId == entitlementId)
+					{
+						fPendingTransactions.erase(iterator);
+						break;
+					}
+				}
+			}
+		}
+		fclose(filePointer);
+	}
+
+	// Compact the journal down to its pending records.
+	// Note: The compacted journal is written beside the old one and then swapped in, so a crash while
+	//       compacting leaves either the old or the new journal intact.
+	std::string compactFilePath(fFilePath);
+	compactFilePath.append(".tmp");
+	fFilePointer = fopen(compactFilePath.c_str(), "w");
+	if (!fFilePointer)
+	{
+		CoronaLog("[EOS SDK] Failed to open the purchase journal.");
+		return false;
+	}
+	for (auto&& transaction : fPendingTransactions)
+	{
+		WriteRecord("P " + transaction.EntitlementId + " " + transaction.CatalogItemId + " " + transaction.AccountId);
+	}
+	fHasUncommittedRecords = true;
+	Commit();
+	fclose(fFilePointer);
+	fFilePointer = nullptr;
+	if (!AtomicFile::Replace(compactFilePath.c_str(), fFilePath.c_str()))
+	{
+		CoronaLog("[EOS SDK] Failed to compact the purchase journal.");
+		return false;
+	}
+
+	// Open the compacted journal for appending.
+	fFilePointer = fopen(fFilePath.c_str(), "a");
+	if (!fFilePointer)
+	{
+		CoronaLog("[EOS SDK] Failed to open the purchase journal.");
+		return false;
+	}
+	return true;
+}
+
+void PurchaseJournal::Close()
+{
+	if (fFilePointer)
+	{
+		Commit();
+		fclose(fFilePointer);
+		fFilePointer = nullptr;
+	}
+}
+
+void PurchaseJournal::AppendPending(const Transaction& transaction)
+{
+	// Validate.
+	if (!fFilePointer || transaction.EntitlementId.empty())
+	{
+		return;
+	}
+
+	// Do not record the same entitlement twice.
+	for (auto&& pendingTransaction : fPendingTransactions)
+	{
+		if (pendingTransaction.EntitlementId == transaction.EntitlementId)
+		{
+			return;
+		}
+	}
+
+	// Note: IDs are written space separated, so empty IDs are written as "-" to keep the record parsable.
+	Transaction pendingTransaction(transaction);
+	if (pendingTransaction.CatalogItemId.empty())
+	{
+		pendingTransaction.CatalogItemId = "-";
+	}
+	if (pendingTransaction.AccountId.empty())
+	{
+		pendingTransaction.AccountId = "-";
+	}
+	fPendingTransactions.push_back(pendingTransaction);
+	WriteRecord(
+			"P " + pendingTransaction.EntitlementId + " " + pendingTransaction.CatalogItemId +
+			" " + pendingTransaction.AccountId);
+}
+
+void PurchaseJournal::AppendAcknowledged(const char* entitlementId)
+{
+	// Validate.
+	if (!fFilePointer || !entitlementId)
+	{
+		return;
+	}
+
+	// Only record entitlements that are still pending.
+	for (auto iterator = fPendingTransactions.begin(); iterator != fPendingTransactions.end(); ++iterator)
+	{
+		if (iterator->EntitlementId == entitlementId)
+		{
+			fPendingTransactions.erase(iterator);
+			WriteRecord(std::string("A ") + entitlementId);
+			return;
+		}
+	}
+}
+
+void PurchaseJournal::Commit()
+{
+	if (fFilePointer && fHasUncommittedRecords)
+	{
+		fflush(fFilePointer);
+		SyncToDisk(fFilePointer);
+		fHasUncommittedRecords = false;
+	}
+}
+
+const std::vector<PurchaseJournal::Transaction>& PurchaseJournal::GetPendingTransactions() const
+{
+	return fPendingTransactions;
+}
+
+void PurchaseJournal::WriteRecord(const std::string& record)
+{
+	if (!fFilePointer)
+	{
+		return;
+	}
+	fprintf(fFilePointer, "%s#%08x\n", record.c_str(), Fnv1aHash::Hash32(record.c_str(), record.size()));
+	fHasUncommittedRecords = true;
+}
@@ -0,0 +1,97 @@
+// ----------------------------------------------------------------------------
+//
+// PurchaseJournal.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+
+/**
+  Append-only journal of purchased entitlements that have not been finished via eos.finishTransaction() yet.
+
+  Every entitlement received from a checkout is appended as a "pending" record, and every entitlement
+  redeemed is appended as an "acknowledged" record. Records are buffered and written to disk together
+  by Commit(), which is expected to be called once per frame before events are dispatched to Lua, so
+  that a burst of records costs 1 flush to disk instead of 1 per record.
+
+  Each record ends with a checksum, so a record torn by a crash while writing is ignored when loaded.
+  Open() compacts the journal down to its pending records, which are the transactions that need to be
+  delivered to Lua again after the app was killed before finishing them.
+ */
+class PurchaseJournal
+{
+	public:
+		/** A purchased entitlement recorded in the journal. */
+		struct Transaction
+		{
+			/** The EOS_Ecom_EntitlementId, provided to Lua as the transaction's "identifier". */
+			std::string EntitlementId;
+
+			/** The EOS_Ecom_CatalogItemId, provided to Lua as the transaction's "productIdentifier". */
+			std::string CatalogItemId;
+
+			/** String form of the Epic account that made the purchase. */
+			std::string AccountId;
+		};
+
+		PurchaseJournal();
+		virtual ~PurchaseJournal();
+
+		/**
+		  Loads the journal's pending transactions from the given file, compacts it and opens it for appending.
+		  @param filePath Absolute path to the journal file. It is created if it does not exist.
+		  @return Returns true if the journal was opened. Returns false if given a null path or on file I/O error.
+		 */
+		bool Open(const char* filePath);
+
+		/** Commits buffered records and closes the journal file. */
+		void Close();
+
+		/**
+		  Records the given entitlement as purchased but not finished yet.
+		  Ignored if the entitlement is already pending.
+		  @param transaction The entitlement to record.
+		 */
+		void AppendPending(const Transaction& transaction);
+
+		/**
+		  Records the given entitlement as finished, so that it is not delivered again on the next launch.
+		  @param entitlementId The EOS_Ecom_EntitlementId. Ignored if null or not pending.
+		 */
+		void AppendAcknowledged(const char* entitlementId);
+
+		/** Flushes all records appended since the last call to disk. Does nothing if there are none. */
+		void Commit();
+
+		/**
+		  Fetches all pending transactions, ordered from oldest to newest.
+		  @return Returns the pending transactions. Returns an empty collection if the journal is not open.
+		 */
+		const std::vector<Transaction>& GetPendingTransactions() const;
+
+	private:
+		/** Copy constructor deleted to prevent it from being called. */
+		PurchaseJournal(const PurchaseJournal&) = delete;
+
+		/** Method deleted to prevent the copy operator from being used. */
+		void operator=(const PurchaseJournal&) = delete;
+
+		/**
+		  Writes the given record followed by its checksum to the journal file's buffer.
+		  @param record The record's text, without its checksum or line ending.
+		 */
+		void WriteRecord(const std::string& record);
+
+		std::string fFilePath;
+		FILE* fFilePointer;
+		bool fHasUncommittedRecords;
+		std::vector<Transaction> fPendingTransactions;
+};
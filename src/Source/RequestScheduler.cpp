@@ -0,0 +1,200 @@
+// ----------------------------------------------------------------------------
+//
+// RequestScheduler.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#include "RequestScheduler.h"
+#include <algorithm>
+
+
+/** Names of the interfaces in eos.getRequestStats(), indexed by the RequestScheduler::Interface enum. */
+static const char* kInterfaceNames[] = { "auth", "connect", "ecom", "sessions", "stats", "sanctions" };
+static_assert(
+		(sizeof(kInterfaceNames) / sizeof(kInterfaceNames[0])) == (size_t)RequestScheduler::Interface::kCount,
+		"Every RequestScheduler::Interface must have a name.");
+
+/**
+  Sustained request rate and burst size of each interface, indexed by the RequestScheduler::Interface enum.
+  Auth logins are rare and interactive. Ecom queries come in bursts from store screens.
+  Dedicated servers make a stats ingest and a sanctions query per player, which arrive in waves as matches
+  start and end, while session registrations are already batched across players.
+ */
+static const double kTokensPerSecond[] = { 1.0, 2.0, 5.0, 5.0, 20.0, 10.0 };
+static const double kBucketCapacities[] = { 3.0, 5.0, 10.0, 10.0, 50.0, 30.0 };
+
+/** Number of times a failed request is retried before its failure is reported. */
+static const int kMaxRetryCount = 4;
+
+/** Delay before the 1st retry, doubled on every retry after that. */
+static const std::chrono::milliseconds kBaseRetryDelay(500);
+
+/** Longest delay between retries. */
+static const std::chrono::milliseconds kMaxRetryDelay(30000);
+
+
+RequestScheduler::RequestScheduler()
+:	fRandomGenerator((std::minstd_rand::result_type)std::chrono::steady_clock::now().time_since_epoch().count())
+{
+	// Start every bucket full, so that the requests made on startup are sent right away.
+	auto currentTime = std::chrono::steady_clock::now();
+	for (size_t index = 0; index < (size_t)Interface::kCount; index++)
+	{
+		Bucket& bucket = fBuckets[index];
+		bucket.TokensPerSecond = kTokensPerSecond[index];
+		bucket.Capacity = kBucketCapacities[index];
+		bucket.TokenCount = bucket.Capacity;
+		bucket.RefillTime = currentTime;
+		bucket.Totals = Counters{ 0, 0, 0, 0, 0, 0 };
+	}
+}
+
+RequestScheduler::~RequestScheduler()
+{
+}
+
+void RequestScheduler::Submit(Interface interfaceType, const std::function<void()>& send)
+{
+	// Validate.
+	if ((interfaceType >= Interface::kCount) || !send)
+	{
+		return;
+	}
+
+	// Send right away if nothing is waiting ahead of this request and a token is left.
+	Bucket& bucket = fBuckets[(size_t)interfaceType];
+	auto currentTime = std::chrono::steady_clock::now();
+	Refill(bucket, currentTime);
+	bucket.Totals.Submitted++;
+	if (bucket.Requests.empty() && (bucket.TokenCount >= 1.0))
+	{
+		bucket.TokenCount -= 1.0;
+		bucket.Totals.Sent++;
+		send();
+		return;
+	}
+
+	// Otherwise send it once a token has refilled.
+	bucket.Totals.Deferred++;
+	bucket.Requests.push_back(QueuedRequest{ send, currentTime });
+}
+
+bool RequestScheduler::ScheduleRetry(
+	Interface interfaceType, EOS_EResult resultCode, int attemptCount, const std::function<void()>& send)
+{
+	// Validate.
+	if ((interfaceType >= Interface::kCount) || !send)
+	{
+		return false;
+	}
+	OnResultReceived(interfaceType, resultCode);
+	if (!IsTransientFailure(resultCode))
+	{
+		return false;
+	}
+	Bucket& bucket = fBuckets[(size_t)interfaceType];
+	if (attemptCount > kMaxRetryCount)
+	{
+		bucket.Totals.GaveUp++;
+		return false;
+	}
+
+	// Wait between half and all of the exponentially growing delay, so that clients failing together
+	// do not all retry at the same moment.
+	auto delay = kBaseRetryDelay * (1 << std::min(std::max(attemptCount - 1, 0), 16));
+	if (delay > kMaxRetryDelay)
+	{
+		delay = kMaxRetryDelay;
+	}
+	std::uniform_int_distribution<long long> distribution((long long)delay.count() / 2, (long long)delay.count());
+	auto sendTime = std::chrono::steady_clock::now() + std::chrono::milliseconds(distribution(fRandomGenerator));
+	bucket.Retries.push_back(QueuedRequest{ send, sendTime });
+	bucket.Totals.Retried++;
+	return true;
+}
+
+void RequestScheduler::OnResultReceived(Interface interfaceType, EOS_EResult resultCode)
+{
+	if ((interfaceType < Interface::kCount) && (resultCode == EOS_EResult::EOS_TooManyRequests))
+	{
+		fBuckets[(size_t)interfaceType].Totals.Throttled++;
+	}
+}
+
+void RequestScheduler::Update()
+{
+	auto currentTime = std::chrono::steady_clock::now();
+	for (auto&& bucket : fBuckets)
+	{
+		// Move the retries that are due ahead of the requests that have not been sent at all yet.
+		for (auto iterator = bucket.Retries.begin(); iterator != bucket.Retries.end();)
+		{
+			if (currentTime >= iterator->SendTime)
+			{
+				bucket.Requests.push_front(*iterator);
+				iterator = bucket.Retries.erase(iterator);
+			}
+			else
+			{
+				++iterator;
+			}
+		}
+
+		// Send as many waiting requests as there are tokens.
+		// Note: A request is popped before being sent, since sending it can submit another request.
+		Refill(bucket, currentTime);
+		while (!bucket.Requests.empty() && (bucket.TokenCount >= 1.0))
+		{
+			auto send = bucket.Requests.front().Send;
+			bucket.Requests.pop_front();
+			bucket.TokenCount -= 1.0;
+			bucket.Totals.Sent++;
+			send();
+		}
+	}
+}
+
+const RequestScheduler::Counters& RequestScheduler::GetCounters(Interface interfaceType) const
+{
+	return fBuckets[std::min((size_t)interfaceType, (size_t)Interface::kCount - 1)].Totals;
+}
+
+size_t RequestScheduler::GetQueuedCount(Interface interfaceType) const
+{
+	if (interfaceType >= Interface::kCount)
+	{
+		return 0;
+	}
+	const Bucket& bucket = fBuckets[(size_t)interfaceType];
+	return bucket.Requests.size() + bucket.Retries.size();
+}
+
+const char* RequestScheduler::GetInterfaceName(Interface interfaceType)
+{
+	if (interfaceType >= Interface::kCount)
+	{
+		return "";
+	}
+	return kInterfaceNames[(size_t)interfaceType];
+}
+
+bool RequestScheduler::IsTransientFailure(EOS_EResult resultCode)
+{
+	return
+			(resultCode == EOS_EResult::EOS_TooManyRequests) ||
+			(resultCode == EOS_EResult::EOS_TimedOut) ||
+			(resultCode == EOS_EResult::EOS_ServiceFailure);
+}
+
+void RequestScheduler::Refill(Bucket& bucket, std::chrono::steady_clock::time_point currentTime)
+{
+	std::chrono::duration<double> elapsedTime = currentTime - bucket.RefillTime;
+	bucket.RefillTime = currentTime;
+	if (elapsedTime.count() > 0)
+	{
+		bucket.TokenCount = std::min(bucket.Capacity, bucket.TokenCount + (elapsedTime.count() * bucket.TokensPerSecond));
+	}
+}
@@ -0,0 +1,173 @@
+// ----------------------------------------------------------------------------
+//
+// RequestScheduler.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <random>
+#include <vector>
+#include "eos_sdk.h"
+
+
+/**
+  Paces the EOS requests made by this plugin via a token bucket per EOS interface, and retries idempotent
+  requests that failed with a transient error after a jittered, exponentially growing delay.
+
+  Requests submitted while their interface's bucket is empty are queued and sent as tokens refill on later
+  frames, so that a burst of Lua calls is smoothed out instead of being rejected by EOS with
+  EOS_TooManyRequests. Update() is expected to be called once per frame.
+ */
+class RequestScheduler
+{
+	public:
+		/** An EOS interface with its own request budget. */
+		enum class Interface
+		{
+			kAuth,
+			kConnect,
+			kEcom,
+			kSessions,
+			kStats,
+			kSanctions,
+
+			/** Number of interfaces. Not an interface. */
+			kCount
+		};
+
+		/** Running totals of an interface's requests, as provided to Lua by eos.getRequestStats(). */
+		struct Counters
+		{
+			/** Number of requests submitted, not counting retries. */
+			uint64_t Submitted;
+
+			/** Number of requests sent to EOS, including retries. */
+			uint64_t Sent;
+
+			/** Number of requests that had to wait for a token before being sent. */
+			uint64_t Deferred;
+
+			/** Number of retries scheduled after a transient failure. */
+			uint64_t Retried;
+
+			/** Number of EOS_TooManyRequests results received. */
+			uint64_t Throttled;
+
+			/** Number of requests that still failed with a transient error after the last retry. */
+			uint64_t GaveUp;
+		};
+
+		RequestScheduler();
+		virtual ~RequestScheduler();
+
+		/**
+		  Sends the given request now if its interface has a token left, or else once one has refilled.
+		  @param interfaceType The EOS interface the request is made to.
+		  @param send Function making the EOS call. Invoked on the main thread.
+		 */
+		void Submit(Interface interfaceType, const std::function<void()>& send);
+
+		/**
+		  Schedules the given request to be sent again if the given result is a transient failure and the
+		  request has not been retried too many times yet. Only to be used for idempotent requests.
+		  @param interfaceType The EOS interface the request was made to.
+		  @param resultCode The result the request's callback received.
+		  @param attemptCount Number of times the request has been sent so far.
+		  @param send Function making the EOS call again.
+		  @return Returns true if a retry was scheduled, in which case the caller must not report the result.
+		          Returns false if the result is final and should be reported.
+		 */
+		bool ScheduleRetry(
+				Interface interfaceType, EOS_EResult resultCode, int attemptCount, const std::function<void()>& send);
+
+		/**
+		  Counts the given result received by a request that is not retried, such as EOS_TooManyRequests.
+		  @param interfaceType The EOS interface the request was made to.
+		  @param resultCode The result the request's callback received.
+		 */
+		void OnResultReceived(Interface interfaceType, EOS_EResult resultCode);
+
+		/** To be called every frame. Refills the buckets and sends the queued requests that are due. */
+		void Update();
+
+		/**
+		  Fetches the given interface's running totals.
+		  @param interfaceType The EOS interface.
+		  @return Returns the interface's counters.
+		 */
+		const Counters& GetCounters(Interface interfaceType) const;
+
+		/**
+		  Fetches the number of requests currently waiting to be sent to the given interface, including retries.
+		  @param interfaceType The EOS interface.
+		  @return Returns the number of waiting requests.
+		 */
+		size_t GetQueuedCount(Interface interfaceType) const;
+
+		/**
+		  Fetches the name of the given interface, as used by eos.getRequestStats().
+		  @param interfaceType The EOS interface.
+		  @return Returns the interface's name, such as "ecom". Returns an empty string if invalid.
+		 */
+		static const char* GetInterfaceName(Interface interfaceType);
+
+		/**
+		  Determines if the given result is a transient failure worth retrying.
+		  @param resultCode The result to check.
+		  @return Returns true for EOS_TooManyRequests, EOS_TimedOut and EOS_ServiceFailure.
+		 */
+		static bool IsTransientFailure(EOS_EResult resultCode);
+
+	private:
+		/** Copy constructor deleted to prevent it from being called. */
+		RequestScheduler(const RequestScheduler&) = delete;
+
+		/** Method deleted to prevent the copy operator from being used. */
+		void operator=(const RequestScheduler&) = delete;
+
+		/** A request waiting to be sent. */
+		struct QueuedRequest
+		{
+			std::function<void()> Send;
+
+			/** Time before which the request must not be sent, used to delay retries. */
+			std::chrono::steady_clock::time_point SendTime;
+		};
+
+		/** The token bucket, queue and counters of 1 interface. */
+		struct Bucket
+		{
+			double TokensPerSecond;
+			double Capacity;
+			double TokenCount;
+			std::chrono::steady_clock::time_point RefillTime;
+
+			/** Requests waiting for a token, in the order submitted. */
+			std::deque<QueuedRequest> Requests;
+
+			/** Retries waiting for their delay to elapse, before they are moved to the front of "Requests". */
+			std::vector<QueuedRequest> Retries;
+
+			Counters Totals;
+		};
+
+		/**
+		  Adds the tokens accumulated since the bucket's last refill, up to its capacity.
+		  @param bucket The bucket to refill.
+		  @param currentTime The current time.
+		 */
+		static void Refill(Bucket& bucket, std::chrono::steady_clock::time_point currentTime);
+
+		Bucket fBuckets[(size_t)Interface::kCount];
+
+		/** Generates the jitter applied to retry delays. */
+		std::minstd_rand fRandomGenerator;
+};
@@ -10,21 +10,175 @@
 #include "RuntimeContext.h"
 #include "CoronaLua.h"
 #include "DispatchEventTask.h"
+#include "PlatformRegistry.h"
+#include "eos_ecom.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstring>
 #include <exception>
+#include <iterator>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <unordered_set>
 extern "C"
 {
 #	include "lua.h"
+#	include "lauxlib.h"
 }
 
 
+/**
+  Guards the RuntimeContext collection and map below, since GetInstanceBy() can be called from any thread.
+ */
+static std::mutex sRuntimeContextMutex;
+
 /** Stores a collection of all RuntimeContext instances that currently exist in the application. */
 static std::unordered_set<RuntimeContext*> sRuntimeContextCollection;
 
+/** Maps each main Lua state to its RuntimeContext, for the lookups made outside of the plugin's Lua functions. */
+static std::unordered_map<lua_State*, RuntimeContext*> sRuntimeContextMap;
+
+/** How long queued entitlements wait for more IDs before a partial batch is redeemed. */
+static const std::chrono::milliseconds kRedemptionFlushDelay(2000);
+
+/** Number of times a batch is re-sent after a transient failure before reporting an error to Lua. */
+static const int kMaxRedemptionAttempts = 4;
+
+/** Name of the purchase journal file in Corona's system.DocumentsDirectory. */
+static const char kPurchaseJournalFileName[] = "eos-purchase-journal.log";
+
+/** Name of the offline operation queue file in Corona's system.DocumentsDirectory. */
+static const char kOfflineQueueFileName[] = "eos-offline-queue.log";
+
+/** Time between replayed batches of held operations, so that a long backlog is not sent in a burst. */
+static const std::chrono::milliseconds kOfflineReplayInterval(1000);
+
+/**
+  How long to wait before trying held operations again after EOS reported no connection.
+  Used on platforms that do not report network changes, where the next attempt is the only way to find out.
+ */
+static const std::chrono::seconds kOfflineProbeDelay(30);
+
+/** The last status posted via RuntimeContext::PostNetworkStatus(). Negative if none posted yet. */
+static std::atomic<int> sPostedNetworkStatus(-1);
+
+/**
+  Fetches the string form of the given Epic account ID.
+  @param accountId The account ID to convert.
+  @return Returns the account ID's string form. Returns an empty string if null or invalid.
+ */
+static std::string ToString(EOS_EpicAccountId accountId)
+{
+	char stringBuffer[EOS_EPICACCOUNTID_MAX_LENGTH + 1];
+	int32_t stringLength = (int32_t)sizeof(stringBuffer);
+	if (!accountId || (EOS_EpicAccountId_ToString(accountId, stringBuffer, &stringLength) != EOS_EResult::EOS_Success))
+	{
+		return std::string();
+	}
+	return std::string(stringBuffer);
+}
+
+/** Name of the file recording that this device's ID was created, in Corona's system.DocumentsDirectory. */
+static const char kDeviceIdStateFileName[] = "eos-device-id.state";
+
+/**
+  The purchase journals and offline operation queues opened by the runtime contexts, by file path.
+  Runtime contexts using the same files share 1 instance, so that no file is opened for appending twice.
+ */
+static std::unordered_map<std::string, std::weak_ptr<PurchaseJournal>> sPurchaseJournalsByPath;
+static std::unordered_map<std::string, std::weak_ptr<OfflineOperationQueue>> sOfflineQueuesByPath;
+
+
+/**
+  Fetches the path to the given file in Corona's system.DocumentsDirectory via Lua's system.pathForFile().
+  @param luaStatePointer The Lua state to call system.pathForFile() with.
+  @param fileName Name of the file.
+  @param outPath Receives the file's path.
+  @return Returns true if the path was fetched.
+ */
+static bool GetDocumentsPathFor(lua_State* luaStatePointer, const char* fileName, std::string& outPath)
+{
+	bool wasFetched = false;
+	int luaStackTop = lua_gettop(luaStatePointer);
+	lua_getglobal(luaStatePointer, "system");
+	if (lua_istable(luaStatePointer, -1))
+	{
+		lua_getfield(luaStatePointer, -1, "pathForFile");
+		if (lua_isfunction(luaStatePointer, -1))
+		{
+			lua_pushstring(luaStatePointer, fileName);
+			lua_getfield(luaStatePointer, -3, "DocumentsDirectory");
+			if ((CoronaLuaDoCall(luaStatePointer, 2, 1) == 0) && (lua_type(luaStatePointer, -1) == LUA_TSTRING))
+			{
+				outPath = lua_tostring(luaStatePointer, -1);
+				wasFetched = true;
+			}
+		}
+	}
+	lua_settop(luaStatePointer, luaStackTop);
+	return wasFetched;
+}
+
+/**
+  Fetches the name of a file in Corona's system.DocumentsDirectory, suffixed by the given platform instance name.
+  @param fileName Name of the file used by the default platform, such as "eos-purchase-journal.log".
+  @param instanceName The "platformInstance" name set in "config.lua". Null or empty for the default platform.
+  @return Returns the file name, with the instance name inserted before the extension if given.
+ */
+static std::string GetInstanceFileName(const char* fileName, const char* instanceName)
+{
+	std::string instanceFileName(fileName);
+	if (!instanceName || ('\0' == instanceName[0]))
+	{
+		return instanceFileName;
+	}
+
+	// Replace the characters that are not safe in a file name on every platform.
+	std::string suffix("-");
+	for (const char* characterPointer = instanceName; *characterPointer; characterPointer++)
+	{
+		char character = *characterPointer;
+		bool isSafe = isalnum((unsigned char)character) || (character == '-') || (character == '_');
+		suffix.push_back(isSafe ? character : '_');
+	}
+	size_t dotIndex = instanceFileName.rfind('.');
+	instanceFileName.insert((dotIndex != std::string::npos) ? dotIndex : instanceFileName.size(), suffix);
+	return instanceFileName;
+}
+
+/**
+  Fetches the instance of the given class already opened with the given file path, or opens a new one.
+  @param instancesByPath The instances opened so far, by file path.
+  @param filePath Path to the file to open.
+  @param wasOpened Set true if a new instance was opened. Set false if an existing instance was returned.
+  @return Returns the instance opened with the given file path.
+ */
+template<class TFile>
+static std::shared_ptr<TFile> AcquireSharedFile(
+	std::unordered_map<std::string, std::weak_ptr<TFile>>& instancesByPath, const std::string& filePath, bool& wasOpened)
+{
+	auto instancePointer = instancesByPath[filePath].lock();
+	wasOpened = !instancePointer;
+	if (wasOpened)
+	{
+		instancePointer = std::make_shared<TFile>();
+		instancePointer->Open(filePath.c_str());
+		instancesByPath[filePath] = instancePointer;
+	}
+	return instancePointer;
+}
+
 
 RuntimeContext::RuntimeContext(lua_State* luaStatePointer)
-:	fLuaEnterFrameCallback(this, &RuntimeContext::OnCoronaEnterFrame, luaStatePointer)
+:	fLuaEnterFrameCallback(this, &RuntimeContext::OnCoronaEnterFrame, luaStatePointer),
+	fLuaSystemEventCallback(this, &RuntimeContext::OnCoronaSystemEvent, luaStatePointer),
+	fLocalUsers(this),
+	fStartupPipeline(this),
+	fConnectSession(this),
+	fDedicatedServer(this)
 {
 	// Validate.
 	if (!luaStatePointer)
@@ -47,25 +201,84 @@ RuntimeContext::RuntimeContext(lua_State* luaStatePointer)
 
 	// Add Corona runtime event listeners.
 	fLuaEnterFrameCallback.AddToRuntimeEventListeners("enterFrame");
+	fLuaSystemEventCallback.AddToRuntimeEventListeners("system");
 
-	// Add this class instance to the global collection.
-	sRuntimeContextCollection.insert(this);
+	// Add this class instance to the global collection and map its Lua state to it.
+	// Note: If multiple instances share a Lua state, then the first one is kept, like the linear search this replaces.
+	{
+		std::lock_guard<std::mutex> lock(sRuntimeContextMutex);
+		sRuntimeContextCollection.insert(this);
+		sRuntimeContextMap.emplace(luaStatePointer, this);
+	}
 	
 	fAuthHandle = 0;
 	fPlatformHandle = 0;
 	fAccountId = 0;
+	fRedemptionFlushTime = std::chrono::steady_clock::now();
+	fRedemptionRetryTime = fRedemptionFlushTime;
+	fIsNetworkOnline = true;
+	fAppliedNetworkStatus = -1;
+	fOfflineReplayTime = std::chrono::steady_clock::now();
+	fIsSuspended = false;
+	fIsResuming = false;
+	fSuspendedEventLimit = std::numeric_limits<size_t>::max();
+	fIsDroppingOldestSuspendedEvents = true;
+	fResumeEventsPerFrame = std::numeric_limits<size_t>::max();
+	fHeldEventCount = 0;
+	fDroppedSuspendedEventCount = 0;
+	fIsLazyProductCatalogEnabled = false;
+
+	// Let guest logins skip creating the device ID if it was created on an earlier launch.
+	std::string filePath;
+	if (GetDocumentsPathFor(luaStatePointer, kDeviceIdStateFileName, filePath))
+	{
+		fConnectSession.SetDeviceIdStatePath(filePath.c_str());
+	}
+
+	// Note: The purchase journal and offline operation queue stay closed until OpenPurchaseStorage() is called.
+	fPurchaseJournalPointer = std::make_shared<PurchaseJournal>();
+	fOfflineOperationQueuePointer = std::make_shared<OfflineOperationQueue>();
 }
 
 RuntimeContext::~RuntimeContext()
 {
 	// Remove our Corona runtime event listeners.
 	fLuaEnterFrameCallback.RemoveFromRuntimeEventListeners("enterFrame");
+	fLuaSystemEventCallback.RemoveFromRuntimeEventListeners("system");
+
+	// Drop the calls that were never replayed because EOS was never initialized.
+	auto luaStatePointer = GetMainLuaState();
+	for (auto&& deferredCall : fDeferredCalls)
+	{
+		luaL_unref(luaStatePointer, LUA_REGISTRYINDEX, deferredCall.LuaArgumentsReference);
+	}
+	fDeferredCalls.clear();
+
+	// Unsubscribe from EOS notifications before the platform is released.
+	fLocalUsers.Clear();
+	fConnectSession.Shutdown();
+	fDedicatedServer.Shutdown();
 
-    EOS_Platform_Release(fPlatformHandle);
-	EOS_Shutdown();
+	// Release this context's reference to its platform, which is shared with the other contexts using the same IDs.
+	// Note: The SDK cannot be initialized again once shut down, so it is only shut down with the last context.
+	PlatformRegistry::Release(fPlatformHandle);
+	fPlatformHandle = nullptr;
+	if (GetInstanceCount() <= 1)
+	{
+		PlatformRegistry::ShutdownSdk();
+	}
 
-	// Remove this class instance from the global collection.
+	// Remove this class instance from the global collection and unmap its Lua state.
+	std::lock_guard<std::mutex> lock(sRuntimeContextMutex);
 	sRuntimeContextCollection.erase(this);
+	if (luaStatePointer)
+	{
+		auto iterator = sRuntimeContextMap.find(luaStatePointer);
+		if ((iterator != sRuntimeContextMap.end()) && (iterator->second == this))
+		{
+			sRuntimeContextMap.erase(iterator);
+		}
+	}
 }
 
 lua_State* RuntimeContext::GetMainLuaState() const
@@ -90,31 +303,47 @@ RuntimeContext* RuntimeContext::GetInstanceBy(lua_State* luaStatePointer)
 		return nullptr;
 	}
 
-	// If the given Lua state belongs to a coroutine, then use the main Lua state instead.
+	// Look up the given Lua state as is first, since it is rarely a coroutine.
+	RuntimeContext* contextPointer = FindInstanceBy(luaStatePointer);
+	if (contextPointer)
 	{
-		auto mainLuaStatePointer = CoronaLuaGetCoronaThread(luaStatePointer);
-		if (mainLuaStatePointer && (mainLuaStatePointer != luaStatePointer))
-		{
-			luaStatePointer = mainLuaStatePointer;
-		}
+		return contextPointer;
 	}
 
-	// Return the first runtime context instance belonging to the given Lua state.
-	for (auto&& runtimePointer : sRuntimeContextCollection)
+	// If the given Lua state belongs to a coroutine, then look up the main Lua state instead.
+	auto mainLuaStatePointer = CoronaLuaGetCoronaThread(luaStatePointer);
+	if (mainLuaStatePointer && (mainLuaStatePointer != luaStatePointer))
 	{
-		if (runtimePointer && runtimePointer->GetMainLuaState() == luaStatePointer)
-		{
-			return runtimePointer;
-		}
+		return FindInstanceBy(mainLuaStatePointer);
 	}
 	return nullptr;
 }
 
+RuntimeContext* RuntimeContext::FindInstanceBy(lua_State* luaStatePointer)
+{
+	std::lock_guard<std::mutex> lock(sRuntimeContextMutex);
+	auto iterator = sRuntimeContextMap.find(luaStatePointer);
+	return (iterator != sRuntimeContextMap.end()) ? iterator->second : nullptr;
+}
+
 int RuntimeContext::GetInstanceCount()
 {
+	std::lock_guard<std::mutex> lock(sRuntimeContextMutex);
 	return (int)sRuntimeContextCollection.size();
 }
 
+bool RuntimeContext::IsAlive(const RuntimeContext* contextPointer)
+{
+	std::lock_guard<std::mutex> lock(sRuntimeContextMutex);
+	auto iterator = sRuntimeContextCollection.find(const_cast<RuntimeContext*>(contextPointer));
+	return (iterator != sRuntimeContextCollection.end());
+}
+
+void RuntimeContext::PostNetworkStatus(EOS_ENetworkStatus status)
+{
+	sPostedNetworkStatus.store((int)status);
+}
+
 int RuntimeContext::OnCoronaEnterFrame(lua_State* luaStatePointer)
 {
 	// Validate.
@@ -123,25 +352,182 @@ int RuntimeContext::OnCoronaEnterFrame(lua_State* luaStatePointer)
 		return 0;
 	}
 
-	if (fPlatformHandle)
+	// Leave suspended mode in case the resume event has not been received yet, since Corona is running again.
+	if (fIsSuspended)
 	{
-		EOS_Platform_Tick(fPlatformHandle);
+		Resume();
 	}
 
+	// Initialize EOS if deferred, once the delay has elapsed or an API needing it has been called.
+	if (fDeferredInitializer && (std::chrono::steady_clock::now() >= fDeferredInitializationTime))
+	{
+		RunDeferredInitialization();
+	}
+
+	// Pass the network status last posted by the OS to EOS, and replay held operations once back online.
+	int postedNetworkStatus = sPostedNetworkStatus.load();
+	if (fPlatformHandle && (postedNetworkStatus >= 0) && (postedNetworkStatus != fAppliedNetworkStatus))
+	{
+		fAppliedNetworkStatus = postedNetworkStatus;
+		EOS_Platform_SetNetworkStatus(fPlatformHandle, (EOS_ENetworkStatus)postedNetworkStatus);
+		fIsNetworkOnline = ((EOS_ENetworkStatus)postedNetworkStatus == EOS_ENetworkStatus::EOS_NS_Online);
+		if (fIsNetworkOnline)
+		{
+			fOfflineReplayTime = std::chrono::steady_clock::now();
+		}
+	}
+
+	// Tick the platform, unless another runtime context sharing it already did so this frame.
+	// Note: The events EOS delivers on the first tick after resuming are paced along with the ones held while suspended.
+	PlatformRegistry::Tick(fPlatformHandle);
+	if (fIsResuming)
+	{
+		fIsResuming = false;
+		fHeldEventCount = fDispatchEventTaskQueue.size();
+	}
+
+	// Redeem a partial batch of queued entitlements once the flush delay has elapsed.
+	if (!fPendingRedemptions.empty() && (std::chrono::steady_clock::now() >= fRedemptionFlushTime))
+	{
+		FlushEntitlementRedemptions();
+	}
+
+	// Replay operations held while offline, 1 batch at a time.
+	if (fIsNetworkOnline && (fOfflineOperationQueuePointer->GetCount() > 0) && (std::chrono::steady_clock::now() >= fOfflineReplayTime))
+	{
+		ReplayOfflineOperations();
+	}
+
+	// Refresh ID, ownership and entitlement tokens that are close to expiring.
+	// Remove the users who logged out, falling back to another logged in user for APIs given no user handle.
+	fLocalUsers.Update();
+	if (fAccountId && !fLocalUsers.FindBy(fAccountId))
+	{
+		auto userHandles = fLocalUsers.GetHandles();
+		auto userPointer = userHandles.empty() ? nullptr : fLocalUsers.GetBy(userHandles.back());
+		fAccountId = userPointer ? userPointer->AccountId : nullptr;
+	}
+
+	// Retry Connect logins that failed due to a transient error.
+	fConnectSession.Update();
+
+	// Queue the dedicated server's session registration and stat ingest batches that are due.
+	fDedicatedServer.Update();
+
+	// Send the requests that were waiting for their interface's rate limit or for a retry delay.
+	fRequestScheduler.Update();
+
+	// Report operations whose callback is overdue, so that Lua can cancel them instead of waiting forever.
+	for (auto&& operation : fInflightOperations.TakeTimedOut())
+	{
+		auto taskPointer = new DispatchOperationTimeoutEventTask();
+		taskPointer->SetLuaEventDispatcher(fLuaEventDispatcherPointer);
+		taskPointer->AcquireEventDataFrom(operation);
+		QueueDispatchEventTask(std::shared_ptr<BaseDispatchEventTask>(taskPointer));
+	}
+
+	// Write all purchases received this frame to disk before dispatching them to Lua.
+	fPurchaseJournalPointer->Commit();
+	fOfflineOperationQueuePointer->Commit();
+
+	// Collect this frame's share of the garbage left by the last event bursts.
+	fLuaGcPacer.Update(luaStatePointer);
+
 	// Dispatch all queued events received to Lua.
-	while (!fDispatchEventTaskQueue.empty())
+	// Note: The events held while suspended are released a few per frame, so that Lua does not receive them all at once.
+	size_t dispatchCount = fDispatchEventTaskQueue.size();
+	if (fHeldEventCount > 0)
+	{
+		dispatchCount = std::min(dispatchCount, fResumeEventsPerFrame);
+		fHeldEventCount = (fHeldEventCount > dispatchCount) ? (fHeldEventCount - dispatchCount) : 0;
+	}
+	if (dispatchCount < 1)
+	{
+		return 0;
+	}
+	fLuaGcPacer.BeginDispatch(luaStatePointer);
+	for (; (dispatchCount > 0) && !fDispatchEventTaskQueue.empty(); dispatchCount--)
 	{
 		auto dispatchEventTaskPointer = fDispatchEventTaskQueue.front();
-		fDispatchEventTaskQueue.pop();
+		fDispatchEventTaskQueue.pop_front();
 		if (dispatchEventTaskPointer)
 		{
 			dispatchEventTaskPointer->Execute();
 		}
 	}
+	fLuaGcPacer.EndDispatch(luaStatePointer);
 
 	return 0;
 }
 
+int RuntimeContext::OnCoronaSystemEvent(lua_State* luaStatePointer)
+{
+	// Validate.
+	if (!luaStatePointer || !lua_istable(luaStatePointer, 1))
+	{
+		return 0;
+	}
+
+	// Enter or leave suspended mode.
+	lua_getfield(luaStatePointer, 1, "type");
+	auto eventType = lua_tostring(luaStatePointer, -1);
+	if (eventType)
+	{
+		if (!strcmp(eventType, "applicationSuspend"))
+		{
+			Suspend();
+		}
+		else if (!strcmp(eventType, "applicationResume"))
+		{
+			Resume();
+		}
+	}
+	lua_pop(luaStatePointer, 1);
+	return 0;
+}
+
+void RuntimeContext::Suspend()
+{
+	if (fIsSuspended)
+	{
+		return;
+	}
+	fIsSuspended = true;
+	fDroppedSuspendedEventCount = 0;
+
+	// Write the purchases received so far to disk, in case the OS terminates the app while suspended.
+	fPurchaseJournalPointer->Commit();
+	fOfflineOperationQueuePointer->Commit();
+
+	// Note: EOS is not ticked until the app resumes, since its callbacks must run on the thread running Lua.
+	if (fPlatformHandle)
+	{
+		EOS_Platform_SetApplicationStatus(fPlatformHandle, EOS_EApplicationStatus::EOS_AS_BackgroundSuspended);
+	}
+}
+
+void RuntimeContext::Resume()
+{
+	if (!fIsSuspended)
+	{
+		return;
+	}
+
+	// Tell EOS that the app is in the foreground before it is ticked again.
+	fIsSuspended = false;
+	fIsResuming = true;
+	if (fPlatformHandle)
+	{
+		EOS_Platform_SetApplicationStatus(fPlatformHandle, EOS_EApplicationStatus::EOS_AS_Foreground);
+	}
+	if (fDroppedSuspendedEventCount > 0)
+	{
+		CoronaLog("WARNING: [EOS SDK] Dropped %u events received while the app was suspended.",
+				(unsigned)fDroppedSuspendedEventCount);
+		fDroppedSuspendedEventCount = 0;
+	}
+}
+
 template<class TEosEventCallbackParam, class TDispatchEventTask>
 void RuntimeContext::OnHandleGlobalEosEvent(TEosEventCallbackParam* eventDataPointer)
 {
@@ -170,7 +556,7 @@ void RuntimeContext::OnHandleGlobalEosEvent(TEosEventCallbackParam* eventDataPoi
 
 	// Queue the received Epic event data to be dispatched to Lua later.
 	// This ensures that Lua events are only dispatched while Corona is running (ie: not suspended).
-	fDispatchEventTaskQueue.push(std::shared_ptr<BaseDispatchEventTask>(taskPointer));
+	QueueDispatchEventTask(std::shared_ptr<BaseDispatchEventTask>(taskPointer));
 }
 
 //
@@ -211,20 +597,645 @@ void RuntimeContext::OnHandleGlobalEosEvent(TEosEventCallbackParam* eventDataPoi
 
  void RuntimeContext::OnLoginResponse(const EOS_Auth_LoginCallbackInfo* Data)
  {
- 	OnHandleGlobalEosEvent<const EOS_Auth_LoginCallbackInfo*, DispatchLoginResponseEventTask>(&Data);
+	// Dispatch the result along with the handle of the user who logged in, if successful.
+	if (Data)
+	{
+		auto taskPointer = new DispatchLoginResponseEventTask();
+		taskPointer->SetLuaEventDispatcher(fLuaEventDispatcherPointer);
+		taskPointer->AcquireEventDataFrom(Data, fLocalUsers.FindBy(Data->SelectedAccountId));
+		QueueDispatchEventTask(std::shared_ptr<BaseDispatchEventTask>(taskPointer));
+	}
+
+	// Start the startup stages waiting on the login, if this is the first successful login.
+	// Note: The Connect login is started first, so that its stage is running once the login stage has ended.
+	if (Data)
+	{
+		if ((Data->ResultCode == EOS_EResult::EOS_Success) && Data->LocalUserId)
+		{
+			fConnectSession.Login(Data->LocalUserId);
+		}
+		fStartupPipeline.OnLoginEnded(Data->ResultCode, Data->LocalUserId);
+	}
  }
 
 void RuntimeContext::OnLoadProductsResponse(const EOS_Ecom_QueryOffersCallbackInfo* Data)
  {
  	OnHandleGlobalEosEvent<const EOS_Ecom_QueryOffersCallbackInfo*, DispatchLoadProductsEventTask>(&Data);
+	if (fOfferImageCachePointer && Data && (Data->ResultCode == EOS_EResult::EOS_Success))
+	{
+		PrefetchOfferImages(Data->LocalUserId);
+	}
  }
 
 void RuntimeContext::OnCheckoutProductResponse(const EOS_Ecom_CheckoutCallbackInfo* Data)
- {
- 	OnHandleGlobalEosEvent<const EOS_Ecom_CheckoutCallbackInfo*, DispatchStoreTransactionCheckoutEventTask>(&Data);
- }
+{
+	// Validate.
+	if (!Data)
+	{
+		return;
+	}
+
+	// Create and configure the event dispatcher task.
+	auto taskPointer = new DispatchStoreTransactionCheckoutEventTask();
+	taskPointer->SetLuaEventDispatcher(fLuaEventDispatcherPointer);
+	taskPointer->AcquireEventDataFrom(Data);
+
+	// Journal the purchased entitlements so they are delivered again if the app exits before finishing them.
+	for (auto&& entitlement : taskPointer->GetEntitlements())
+	{
+		fPurchaseJournalPointer->AppendPending(PurchaseJournal::Transaction{
+				entitlement.InstanceId, entitlement.CatalogItemId, std::string(taskPointer->GetSelectedAccountId()) });
+	}
+
+	// Queue the received Epic event data to be dispatched to Lua later.
+	QueueDispatchEventTask(std::shared_ptr<BaseDispatchEventTask>(taskPointer));
+}
 
 void RuntimeContext::OnQueryEntitlementsResponse(const EOS_Ecom_QueryEntitlementsCallbackInfo* Data)
  {
  	OnHandleGlobalEosEvent<const EOS_Ecom_QueryEntitlementsCallbackInfo*, DispatchStoreTransactionQueryEntitlementsEventTask>(&Data);
  }
+
+bool RuntimeContext::QueueEntitlementRedemption(const char* entitlementId, EOS_EpicAccountId accountId)
+{
+	// Validate.
+	if (!entitlementId || ('\0' == entitlementId[0]) || !accountId)
+	{
+		return false;
+	}
+
+	// Do not queue the same entitlement twice, nor while its last redemption is still in flight.
+	std::string entitlementIdString(entitlementId);
+	if (IsRedemptionQueued(entitlementIdString))
+	{
+		return true;
+	}
+
+	// Start the flush timer with the first entitlement of a new batch, but not before a backoff ends.
+	if (fPendingRedemptions.empty())
+	{
+		fRedemptionFlushTime = std::max(
+				std::chrono::steady_clock::now() + kRedemptionFlushDelay, fRedemptionRetryTime);
+	}
+	fPendingRedemptions.push_back(PendingRedemption{ entitlementIdString, 0, accountId });
+
+	// Redeem right away if a full batch is ready.
+	if (fPendingRedemptions.size() >= EOS_ECOM_REDEEMENTITLEMENTS_MAX_IDS)
+	{
+		FlushEntitlementRedemptions();
+	}
+	return true;
+}
+
+void RuntimeContext::FlushEntitlementRedemptions()
+{
+	if (fPendingRedemptions.empty() || !fPlatformHandle)
+	{
+		return;
+	}
+
+	// Hold the entitlements while offline instead of sending requests that are bound to fail.
+	if (!fIsNetworkOnline)
+	{
+		HoldEntitlementRedemptions(fPendingRedemptions);
+		fPendingRedemptions.clear();
+		return;
+	}
+
+	// Send nothing until the backoff after a transient failure has elapsed.
+	// Note: The frame loop flushes the queue once "fRedemptionFlushTime", which is never earlier, is reached.
+	if (std::chrono::steady_clock::now() < fRedemptionRetryTime)
+	{
+		return;
+	}
+
+	// Hold the entitlements of an account that logged out, to be redeemed once it logs in again.
+	EOS_EpicAccountId accountId = fPendingRedemptions.front().AccountId;
+	auto isOfAccount = [accountId](const PendingRedemption& entitlement)->bool
+	{
+		return (entitlement.AccountId == accountId);
+	};
+	if (!fLocalUsers.FindBy(accountId))
+	{
+		auto iterator = std::stable_partition(fPendingRedemptions.begin(), fPendingRedemptions.end(), isOfAccount);
+		HoldEntitlementRedemptions(std::vector<PendingRedemption>(fPendingRedemptions.begin(), iterator));
+		fPendingRedemptions.erase(fPendingRedemptions.begin(), iterator);
+		return;
+	}
+
+	// Move up to 1 batch worth of the account's entitlements out of the queue.
+	// Note: The request owns its strings until the callback below deletes it.
+	auto requestPointer = new RedeemEntitlementsRequest();
+	requestPointer->ContextPointer = this;
+	for (auto iterator = fPendingRedemptions.begin(); iterator != fPendingRedemptions.end();)
+	{
+		if (isOfAccount(*iterator) && (requestPointer->Entitlements.size() < EOS_ECOM_REDEEMENTITLEMENTS_MAX_IDS))
+		{
+			requestPointer->Entitlements.push_back(*iterator);
+			iterator = fPendingRedemptions.erase(iterator);
+		}
+		else
+		{
+			++iterator;
+		}
+	}
+	size_t batchSize = requestPointer->Entitlements.size();
+	if (!fPendingRedemptions.empty())
+	{
+		fRedemptionFlushTime = std::chrono::steady_clock::now() + kRedemptionFlushDelay;
+	}
+
+	std::vector<EOS_Ecom_EntitlementId> entitlementIds;
+	entitlementIds.reserve(batchSize);
+	for (auto&& entitlement : requestPointer->Entitlements)
+	{
+		entitlement.AttemptCount++;
+		entitlementIds.push_back(entitlement.EntitlementId.c_str());
+		fInflightRedemptionIds.insert(entitlement.EntitlementId);
+	}
+
+	EOS_Ecom_RedeemEntitlementsOptions RedeemOptions{ 0 };
+	RedeemOptions.ApiVersion = EOS_ECOM_REDEEMENTITLEMENTS_API_LATEST;
+	RedeemOptions.LocalUserId = accountId;
+	RedeemOptions.EntitlementIdCount = static_cast<uint32_t>(entitlementIds.size());
+	RedeemOptions.EntitlementIds = &entitlementIds[0];
+
+	EOS_HEcom EcomHandle = EOS_Platform_GetEcomInterface(fPlatformHandle);
+	EOS_Ecom_RedeemEntitlements(EcomHandle, &RedeemOptions, requestPointer, &RuntimeContext::OnRedeemEntitlementsResponse);
+}
+
+void EOS_CALL RuntimeContext::OnRedeemEntitlementsResponse(const EOS_Ecom_RedeemEntitlementsCallbackInfo* Data)
+{
+	if (!Data || !EOS_EResult_IsOperationComplete(Data->ResultCode))
+	{
+		return;
+	}
+
+	auto requestPointer = (RedeemEntitlementsRequest*)Data->ClientData;
+	if (!requestPointer)
+	{
+		return;
+	}
+	auto contextPointer = requestPointer->ContextPointer;
+	if (!IsAlive(contextPointer))
+	{
+		// The runtime context was destroyed while the request was in flight.
+		delete requestPointer;
+		return;
+	}
+	for (auto&& entitlement : requestPointer->Entitlements)
+	{
+		contextPointer->fInflightRedemptionIds.erase(entitlement.EntitlementId);
+	}
+
+	// Hold the batch if there is no connection, to be redeemed once back online.
+	// Note: Lua receives the "finishTransaction" events once the held entitlements have been redeemed.
+	if (Data->ResultCode == EOS_EResult::EOS_NoConnection)
+	{
+		contextPointer->HoldEntitlementRedemptions(requestPointer->Entitlements);
+		contextPointer->fOfflineReplayTime = std::chrono::steady_clock::now() + kOfflineProbeDelay;
+		delete requestPointer;
+		return;
+	}
+
+	// Transient failures are re-queued, and no batch is sent until an exponentially growing delay has elapsed.
+	bool isTransientFailure =
+			(Data->ResultCode == EOS_EResult::EOS_TooManyRequests) ||
+			(Data->ResultCode == EOS_EResult::EOS_TimedOut) ||
+			(Data->ResultCode == EOS_EResult::EOS_ServiceFailure) ||
+			(Data->ResultCode == EOS_EResult::EOS_NoConnection);
+	for (auto&& entitlement : requestPointer->Entitlements)
+	{
+		if (isTransientFailure && (entitlement.AttemptCount < kMaxRedemptionAttempts))
+		{
+			auto retryTime = std::chrono::steady_clock::now() + (kRedemptionFlushDelay * (1 << entitlement.AttemptCount));
+			contextPointer->fRedemptionRetryTime = std::max(contextPointer->fRedemptionRetryTime, retryTime);
+			contextPointer->fRedemptionFlushTime = std::max(contextPointer->fRedemptionFlushTime, retryTime);
+			contextPointer->fPendingRedemptions.push_back(entitlement);
+			continue;
+		}
+
+		// Stop replaying the entitlement on later launches once redeemed, or once rejected for good.
+		// Note: Entitlements out of attempts after transient failures stay journaled, to be retried next launch.
+		if (!isTransientFailure)
+		{
+			contextPointer->fPurchaseJournalPointer->AppendAcknowledged(entitlement.EntitlementId.c_str());
+		}
+		auto taskPointer = new DispatchFinishTransactionEventTask();
+		taskPointer->SetLuaEventDispatcher(contextPointer->fLuaEventDispatcherPointer);
+		taskPointer->AcquireEventDataFrom(Data, entitlement.EntitlementId);
+		contextPointer->QueueDispatchEventTask(std::shared_ptr<BaseDispatchEventTask>(taskPointer));
+	}
+
+	delete requestPointer;
+}
+
+void RuntimeContext::HoldEntitlementRedemptions(const std::vector<PendingRedemption>& entitlements)
+{
+	for (auto&& entitlement : entitlements)
+	{
+		fOfflineOperationQueuePointer->Hold(OfflineOperationQueue::Operation{
+				OfflineOperationQueue::OperationType::kRedeemEntitlement, ToString(entitlement.AccountId),
+				entitlement.EntitlementId });
+	}
+}
+
+void RuntimeContext::ReplayOfflineOperations()
+{
+	fOfflineReplayTime = std::chrono::steady_clock::now() + kOfflineReplayInterval;
+	if (!fPlatformHandle)
+	{
+		return;
+	}
+
+	// Send up to 1 batch of entitlements held for the first logged in user who has any,
+	// through the regular redemption queue.
+	EOS_EpicAccountId accountId = nullptr;
+	std::vector<OfflineOperationQueue::Operation> operations;
+	for (auto&& userHandle : fLocalUsers.GetHandles())
+	{
+		accountId = fLocalUsers.GetBy(userHandle)->AccountId;
+		operations = fOfflineOperationQueuePointer->TakeBatch(
+				OfflineOperationQueue::OperationType::kRedeemEntitlement, ToString(accountId),
+				EOS_ECOM_REDEEMENTITLEMENTS_MAX_IDS);
+		if (!operations.empty())
+		{
+			break;
+		}
+	}
+	if (operations.empty())
+	{
+		return;
+	}
+	for (auto&& operation : operations)
+	{
+		if (!IsRedemptionQueued(operation.Payload))
+		{
+			fPendingRedemptions.push_back(PendingRedemption{ operation.Payload, 0, accountId });
+		}
+	}
+	FlushEntitlementRedemptions();
+}
+
+bool RuntimeContext::IsRedemptionQueued(const std::string& entitlementId) const
+{
+	if (fInflightRedemptionIds.count(entitlementId) > 0)
+	{
+		return true;
+	}
+	for (auto&& pendingRedemption : fPendingRedemptions)
+	{
+		if (pendingRedemption.EntitlementId == entitlementId)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void RuntimeContext::QueueDispatchEventTask(const std::shared_ptr<BaseDispatchEventTask>& taskPointer)
+{
+	// Validate.
+	if (!taskPointer)
+	{
+		return;
+	}
+
+	// While suspended, hold no more than the configured number of events until the app resumes.
+	// Note: Events which cannot be dropped, such as purchases, are always held, even past the limit.
+	if (fIsSuspended && (fDispatchEventTaskQueue.size() >= fSuspendedEventLimit))
+	{
+		if (!fIsDroppingOldestSuspendedEvents && taskPointer->CanBeDropped())
+		{
+			fDroppedSuspendedEventCount++;
+			return;
+		}
+		auto canBeDropped = [](const std::shared_ptr<BaseDispatchEventTask>& heldTaskPointer)->bool
+		{
+			return !heldTaskPointer || heldTaskPointer->CanBeDropped();
+		};
+		auto iterator = fDispatchEventTaskQueue.end();
+		if (fIsDroppingOldestSuspendedEvents)
+		{
+			iterator = std::find_if(fDispatchEventTaskQueue.begin(), fDispatchEventTaskQueue.end(), canBeDropped);
+		}
+		else
+		{
+			auto reverseIterator = std::find_if(fDispatchEventTaskQueue.rbegin(), fDispatchEventTaskQueue.rend(), canBeDropped);
+			if (reverseIterator != fDispatchEventTaskQueue.rend())
+			{
+				iterator = std::next(reverseIterator).base();
+			}
+		}
+		if (iterator != fDispatchEventTaskQueue.end())
+		{
+			fDispatchEventTaskQueue.erase(iterator);
+			fDroppedSuspendedEventCount++;
+		}
+		else if (taskPointer->CanBeDropped())
+		{
+			fDroppedSuspendedEventCount++;
+			return;
+		}
+	}
+	fDispatchEventTaskQueue.push_back(taskPointer);
+}
+
+void RuntimeContext::SetBackgroundSettings(
+	size_t suspendedEventLimit, bool isDroppingOldestEvents, size_t resumeEventsPerFrame)
+{
+	fSuspendedEventLimit = std::max(suspendedEventLimit, (size_t)1);
+	fIsDroppingOldestSuspendedEvents = isDroppingOldestEvents;
+	fResumeEventsPerFrame = std::max(resumeEventsPerFrame, (size_t)1);
+}
+
+LocalUserTable& RuntimeContext::GetLocalUsers()
+{
+	return fLocalUsers;
+}
+
+ConnectSession& RuntimeContext::GetConnectSession()
+{
+	return fConnectSession;
+}
+
+DedicatedServer& RuntimeContext::GetDedicatedServer()
+{
+	return fDedicatedServer;
+}
+
+LuaGcPacer& RuntimeContext::GetLuaGcPacer()
+{
+	return fLuaGcPacer;
+}
+
+RequestScheduler& RuntimeContext::GetRequestScheduler()
+{
+	return fRequestScheduler;
+}
+
+InflightOperationRegistry& RuntimeContext::GetInflightOperations()
+{
+	return fInflightOperations;
+}
+
+void RuntimeContext::DeferInitialization(const std::function<void()>& initializer, double delayInSeconds)
+{
+	fDeferredInitializer = initializer;
+	if (delayInSeconds >= 0)
+	{
+		fDeferredInitializationTime = std::chrono::steady_clock::now() +
+				std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+						std::chrono::duration<double>(delayInSeconds));
+	}
+	else
+	{
+		fDeferredInitializationTime = std::chrono::steady_clock::time_point::max();
+	}
+}
+
+bool RuntimeContext::IsInitializationDeferred() const
+{
+	return fDeferredInitializer ? true : false;
+}
+
+void RuntimeContext::RequestInitialization()
+{
+	if (fDeferredInitializer)
+	{
+		fDeferredInitializationTime = std::chrono::steady_clock::now();
+	}
+}
+
+void RuntimeContext::QueueDeferredCall(lua_State* luaStatePointer, int(*luaFunction)(lua_State*))
+{
+	// Validate.
+	if (!luaStatePointer || !luaFunction || !fDeferredInitializer)
+	{
+		return;
+	}
+
+	// Copy the call's arguments to an array in the registry, with its length in field "n" since it can contain nils.
+	int argumentCount = lua_gettop(luaStatePointer);
+	lua_createtable(luaStatePointer, argumentCount, 1);
+	for (int index = 1; index <= argumentCount; index++)
+	{
+		lua_pushvalue(luaStatePointer, index);
+		lua_rawseti(luaStatePointer, -2, index);
+	}
+	lua_pushinteger(luaStatePointer, argumentCount);
+	lua_setfield(luaStatePointer, -2, "n");
+	fDeferredCalls.push_back(DeferredCall{ luaFunction, luaL_ref(luaStatePointer, LUA_REGISTRYINDEX) });
+
+	// Initialize on the next frame, since the app is now using the plugin.
+	RequestInitialization();
+}
+
+void RuntimeContext::RunDeferredInitialization()
+{
+	// Invoke the initializer only once.
+	auto initializer = fDeferredInitializer;
+	fDeferredInitializer = nullptr;
+	if (initializer)
+	{
+		initializer();
+	}
+
+	// Replay the calls made before initialization in their original order.
+	auto luaStatePointer = GetMainLuaState();
+	std::vector<DeferredCall> deferredCalls;
+	deferredCalls.swap(fDeferredCalls);
+	for (auto&& deferredCall : deferredCalls)
+	{
+		int luaStackTop = lua_gettop(luaStatePointer);
+		lua_pushlightuserdata(luaStatePointer, this);
+		lua_pushcclosure(luaStatePointer, deferredCall.LuaFunction, 1);
+		lua_rawgeti(luaStatePointer, LUA_REGISTRYINDEX, deferredCall.LuaArgumentsReference);
+		lua_getfield(luaStatePointer, -1, "n");
+		int argumentCount = (int)lua_tointeger(luaStatePointer, -1);
+		lua_pop(luaStatePointer, 1);
+		for (int index = 1; index <= argumentCount; index++)
+		{
+			lua_rawgeti(luaStatePointer, luaStackTop + 2, index);
+		}
+		lua_remove(luaStatePointer, luaStackTop + 2);
+		CoronaLuaDoCall(luaStatePointer, argumentCount, 0);
+		lua_settop(luaStatePointer, luaStackTop);
+		luaL_unref(luaStatePointer, LUA_REGISTRYINDEX, deferredCall.LuaArgumentsReference);
+	}
+}
+
+StartupPipeline& RuntimeContext::GetStartupPipeline()
+{
+	return fStartupPipeline;
+}
+
+void RuntimeContext::OpenPurchaseStorage(const char* platformInstanceName)
+{
+	// Load the operations held while offline by the last launch. They are replayed once a user logs in.
+	auto luaStatePointer = GetMainLuaState();
+	std::string fileName = GetInstanceFileName(kOfflineQueueFileName, platformInstanceName);
+	std::string filePath;
+	bool wasOpened = false;
+	if (GetDocumentsPathFor(luaStatePointer, fileName.c_str(), filePath))
+	{
+		fOfflineOperationQueuePointer = AcquireSharedFile(sOfflineQueuesByPath, filePath, wasOpened);
+	}
+
+	// Open the purchase journal and queue the purchases the app did not finish before it last exited.
+	// Only the runtime context opening the journal first receives them, so that they are not delivered twice.
+	// Note: These are dispatched on the first frame, after "main.lua" has had a chance to add its listeners.
+	fileName = GetInstanceFileName(kPurchaseJournalFileName, platformInstanceName);
+	if (!GetDocumentsPathFor(luaStatePointer, fileName.c_str(), filePath))
+	{
+		return;
+	}
+	fPurchaseJournalPointer = AcquireSharedFile(sPurchaseJournalsByPath, filePath, wasOpened);
+	if (!wasOpened)
+	{
+		return;
+	}
+	std::vector<PurchaseJournal::Transaction> accountTransactions;
+	auto pendingTransactions = fPurchaseJournalPointer->GetPendingTransactions();
+	while (!pendingTransactions.empty())
+	{
+		// Dispatch 1 event per account, since the event only provides 1 "selectedAccountId".
+		const std::string accountId = pendingTransactions.front().AccountId;
+		accountTransactions.clear();
+		for (auto iterator = pendingTransactions.begin(); iterator != pendingTransactions.end();)
+		{
+			if (iterator->AccountId == accountId)
+			{
+				accountTransactions.push_back(*iterator);
+				iterator = pendingTransactions.erase(iterator);
+			}
+			else
+			{
+				++iterator;
+			}
+		}
+		auto taskPointer = new DispatchJournaledTransactionsEventTask();
+		taskPointer->SetLuaEventDispatcher(fLuaEventDispatcherPointer);
+		taskPointer->AcquireEventDataFrom(accountTransactions);
+		fDispatchEventTaskQueue.push_back(std::shared_ptr<BaseDispatchEventTask>(taskPointer));
+	}
+}
+
+void RuntimeContext::EnableOfferImageCache(uint64_t maxBytes)
+{
+	if (!fOfferImageCachePointer)
+	{
+		fOfferImageCachePointer.reset(new OfferImageCache(GetMainLuaState(), fLuaEventDispatcherPointer, maxBytes));
+	}
+}
+
+OfferImageCache* RuntimeContext::GetOfferImageCache() const
+{
+	return fOfferImageCachePointer.get();
+}
+
+void RuntimeContext::SetLazyProductCatalogEnabled(bool value)
+{
+	fIsLazyProductCatalogEnabled = value;
+}
+
+bool RuntimeContext::IsLazyProductCatalogEnabled() const
+{
+	return fIsLazyProductCatalogEnabled;
+}
+
+void RuntimeContext::PrefetchOfferImages(EOS_EpicAccountId localUserId)
+{
+	if (!fOfferImageCachePointer || !fPlatformHandle)
+	{
+		return;
+	}
+	EOS_HEcom EcomHandle = EOS_Platform_GetEcomInterface(fPlatformHandle);
+
+	EOS_Ecom_GetOfferCountOptions CountOptions{ 0 };
+	CountOptions.ApiVersion = EOS_ECOM_GETOFFERCOUNT_API_LATEST;
+	CountOptions.LocalUserId = localUserId;
+	uint32_t OfferCount = EOS_Ecom_GetOfferCount(EcomHandle, &CountOptions);
+	for (uint32_t OfferIndex = 0; OfferIndex < OfferCount; OfferIndex++)
+	{
+		EOS_Ecom_CopyOfferByIndexOptions OfferOptions{ 0 };
+		OfferOptions.ApiVersion = EOS_ECOM_COPYOFFERBYINDEX_API_LATEST;
+		OfferOptions.LocalUserId = localUserId;
+		OfferOptions.OfferIndex = OfferIndex;
+		EOS_Ecom_CatalogOffer* Offer = nullptr;
+		EOS_EResult CopyResult = EOS_Ecom_CopyOfferByIndex(EcomHandle, &OfferOptions, &Offer);
+		switch (CopyResult)
+		{
+			case EOS_EResult::EOS_Success:
+			case EOS_EResult::EOS_Ecom_CatalogOfferPriceInvalid:
+			case EOS_EResult::EOS_Ecom_CatalogOfferStale:
+				break;
+			default:
+				continue;
+		}
+
+		// Queue the offer's key images.
+		EOS_Ecom_GetOfferImageInfoCountOptions OfferImageCountOptions{ 0 };
+		OfferImageCountOptions.ApiVersion = EOS_ECOM_GETOFFERIMAGEINFOCOUNT_API_LATEST;
+		OfferImageCountOptions.LocalUserId = localUserId;
+		OfferImageCountOptions.OfferId = Offer->Id;
+		uint32_t OfferImageCount = EOS_Ecom_GetOfferImageInfoCount(EcomHandle, &OfferImageCountOptions);
+		for (uint32_t ImageIndex = 0; ImageIndex < OfferImageCount; ImageIndex++)
+		{
+			EOS_Ecom_CopyOfferImageInfoByIndexOptions ImageOptions{ 0 };
+			ImageOptions.ApiVersion = EOS_ECOM_COPYOFFERIMAGEINFOBYINDEX_API_LATEST;
+			ImageOptions.LocalUserId = localUserId;
+			ImageOptions.OfferId = Offer->Id;
+			ImageOptions.ImageInfoIndex = ImageIndex;
+			EOS_Ecom_KeyImageInfo* ImageInfo = nullptr;
+			if (EOS_Ecom_CopyOfferImageInfoByIndex(EcomHandle, &ImageOptions, &ImageInfo) == EOS_EResult::EOS_Success)
+			{
+				fOfferImageCachePointer->Prefetch(ImageInfo->Url, Offer->Id, ImageInfo->Type);
+				EOS_Ecom_KeyImageInfo_Release(ImageInfo);
+			}
+		}
+
+		// Queue the key images of the items granted by the offer.
+		EOS_Ecom_GetOfferItemCountOptions ItemCountOptions{ 0 };
+		ItemCountOptions.ApiVersion = EOS_ECOM_GETOFFERITEMCOUNT_API_LATEST;
+		ItemCountOptions.LocalUserId = localUserId;
+		ItemCountOptions.OfferId = Offer->Id;
+		uint32_t ItemCount = EOS_Ecom_GetOfferItemCount(EcomHandle, &ItemCountOptions);
+		for (uint32_t ItemIndex = 0; ItemIndex < ItemCount; ItemIndex++)
+		{
+			EOS_Ecom_CopyOfferItemByIndexOptions ItemOptions{ 0 };
+			ItemOptions.ApiVersion = EOS_ECOM_COPYOFFERITEMBYINDEX_API_LATEST;
+			ItemOptions.LocalUserId = localUserId;
+			ItemOptions.OfferId = Offer->Id;
+			ItemOptions.ItemIndex = ItemIndex;
+			EOS_Ecom_CatalogItem* Item = nullptr;
+			if (EOS_Ecom_CopyOfferItemByIndex(EcomHandle, &ItemOptions, &Item) != EOS_EResult::EOS_Success)
+			{
+				continue;
+			}
+
+			EOS_Ecom_GetItemImageInfoCountOptions ItemImageCountOptions{ 0 };
+			ItemImageCountOptions.ApiVersion = EOS_ECOM_GETITEMIMAGEINFOCOUNT_API_LATEST;
+			ItemImageCountOptions.LocalUserId = localUserId;
+			ItemImageCountOptions.ItemId = Item->Id;
+			uint32_t ItemImageCount = EOS_Ecom_GetItemImageInfoCount(EcomHandle, &ItemImageCountOptions);
+			for (uint32_t ImageIndex = 0; ImageIndex < ItemImageCount; ImageIndex++)
+			{
+				EOS_Ecom_CopyItemImageInfoByIndexOptions ImageOptions{ 0 };
+				ImageOptions.ApiVersion = EOS_ECOM_COPYITEMIMAGEINFOBYINDEX_API_LATEST;
+				ImageOptions.LocalUserId = localUserId;
+				ImageOptions.ItemId = Item->Id;
+				ImageOptions.ImageInfoIndex = ImageIndex;
+				EOS_Ecom_KeyImageInfo* ImageInfo = nullptr;
+				if (EOS_Ecom_CopyItemImageInfoByIndex(EcomHandle, &ImageOptions, &ImageInfo) == EOS_EResult::EOS_Success)
+				{
+					fOfferImageCachePointer->Prefetch(ImageInfo->Url, Offer->Id, ImageInfo->Type);
+					EOS_Ecom_KeyImageInfo_Release(ImageInfo);
+				}
+			}
+			EOS_Ecom_CatalogItem_Release(Item);
+		}
+
+		EOS_Ecom_CatalogOffer_Release(Offer);
+	}
+}
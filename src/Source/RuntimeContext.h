@@ -9,18 +9,32 @@
 
 #pragma once
 
+#include "AuthIdTokenCache.h"
+#include "ConnectSession.h"
+#include "DedicatedServer.h"
 #include "DispatchEventTask.h"
+#include "EcomTokenCache.h"
+#include "InflightOperationRegistry.h"
+#include "LocalUserTable.h"
+#include "LuaGcPacer.h"
 #include "LuaEventDispatcher.h"
 #include "LuaMethodCallback.h"
+#include "OfferImageCache.h"
+#include "OfflineOperationQueue.h"
+#include "PurchaseJournal.h"
+#include "RequestScheduler.h"
+#include "StartupPipeline.h"
+#include <chrono>
+#include <deque>
 #include <functional>
 #include <memory>
-#include <queue>
 #include <type_traits>
 #include <typeinfo>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 #include <set>
+#include <string>
 #include "eos_sdk.h"
 
 // Forward declarations.
@@ -36,6 +50,8 @@ extern "C"
   Automatically polls for and dispatches global Eos events, such as "LoginResponse_t", to Lua.
   Provides easy handling of Steam's CCallResult async operation via this class' AddEventHandlerFor() method.
   Also ensures that Eos events are only dispatched to Lua while the Corona runtime is running (ie: not suspended).
+  EOS is only ticked on the thread running Lua, so it is not ticked while suspended. The events it delivers on the
+  first tick after resuming are dispatched to Lua a few per frame.
  */
 class RuntimeContext
 {
@@ -118,10 +134,13 @@ class RuntimeContext
 		/** Handle for Auth interface */
 		EOS_HAuth fAuthHandle;
 
-		/** Handle for Platform interface*/
+		/** Handle for Platform interface. Shared with the contexts using the same IDs via the PlatformRegistry. */
 		EOS_PlatformHandle* fPlatformHandle;
 
-		/** Handle for logged in account*/
+		/**
+		  Handle for the last account to log in, which APIs act on when Lua does not pass a user handle.
+		  Every logged in account is held by the local user table returned by GetLocalUsers().
+		 */
 		EOS_EpicAccountId fAccountId;
 
 
@@ -152,6 +171,9 @@ class RuntimeContext
 
 		          Returns null if there is no RuntimeContext belonging to the given Lua state, or if there
 		          was one, then it was already delete.
+
+		          Thread safe. Looks the Lua state up in a locked hash map, so the plugin's Lua functions should
+		          prefer the RuntimeContext pointer passed to them as an upvalue, which needs no lookup.
 		 */
 		static RuntimeContext* GetInstanceBy(lua_State* luaStatePointer);
 
@@ -161,12 +183,154 @@ class RuntimeContext
 		 */
 		static int GetInstanceCount();
 
+		/**
+		  Determines if the given runtime context still exists.
+		  To be checked by every EOS callback given a runtime context, since a platform shared with other
+		  runtime contexts keeps invoking callbacks after the context that made the request was deleted.
+		  @param contextPointer The runtime context to check.
+		  @return Returns true if the context exists. Returns false if it was deleted or if given null.
+		 */
+		static bool IsAlive(const RuntimeContext* contextPointer);
+
+		/**
+		  Posts the device's network status, to be passed to EOS_Platform_SetNetworkStatus() by every runtime
+		  context on its next frame. Operations held while offline are replayed once the status is back online.
+		  Can be called from any thread, such as the thread the OS reports network changes on.
+		  @param status The device's current network status.
+		 */
+		static void PostNetworkStatus(EOS_ENetworkStatus status);
+
 		/** Set up global Eos event handlers via their macros. */
 		void OnLoginResponse(const EOS_Auth_LoginCallbackInfo* Data);
 		void OnLoadProductsResponse(const EOS_Ecom_QueryOffersCallbackInfo* Data);
 		void OnCheckoutProductResponse(const EOS_Ecom_CheckoutCallbackInfo* Data);
 		void OnQueryEntitlementsResponse(const EOS_Ecom_QueryEntitlementsCallbackInfo* Data);
 
+		/**
+		  Queues the given entitlement to be redeemed via EOS_Ecom_RedeemEntitlements().
+		  Queued entitlements are redeemed in batches of up to EOS_ECOM_REDEEMENTITLEMENTS_MAX_IDS per account,
+		  either once a batch fills up or once the flush delay has elapsed. A "finishTransaction" event is
+		  dispatched per ID.
+		  @param entitlementId The EOS_Ecom_EntitlementId to redeem. Ignored if null, empty or already queued.
+		  @param accountId The logged in account that owns the entitlement. Ignored if null.
+		  @return Returns true if the entitlement was queued or is already queued.
+		 */
+		bool QueueEntitlementRedemption(const char* entitlementId, EOS_EpicAccountId accountId);
+
+		/**
+		  Queues the given task to dispatch its event to Lua on the next frame, while Corona is running.
+		  @param taskPointer The task to queue. Ignored if null.
+		 */
+		void QueueDispatchEventTask(const std::shared_ptr<BaseDispatchEventTask>& taskPointer);
+
+		/**
+		  Configures how the events received while Corona is suspended, or on the first tick after it resumes, reach Lua.
+		  @param suspendedEventLimit Number of events held while suspended, past which events are dropped.
+		  @param isDroppingOldestEvents Set true to drop the oldest held event past the limit. Set false to drop the newest.
+		  @param resumeEventsPerFrame Number of held events dispatched per frame once the app resumes.
+		 */
+		void SetBackgroundSettings(size_t suspendedEventLimit, bool isDroppingOldestEvents, size_t resumeEventsPerFrame);
+
+		/**
+		  Fetches the table of logged in local users, each holding its own ID token and Ecom token caches.
+		  @return Returns a reference to this context's local user table.
+		 */
+		LocalUserTable& GetLocalUsers();
+
+		/**
+		  Fetches the session logging the Auth interface's user into the Connect interface.
+		  @return Returns a reference to this context's Connect session.
+		 */
+		ConnectSession& GetConnectSession();
+
+		/**
+		  Fetches the per-player operations used when running as a dedicated server.
+		  @return Returns a reference to this context's dedicated server, which is disabled unless in server mode.
+		 */
+		DedicatedServer& GetDedicatedServer();
+
+		/**
+		  Fetches the pacer spreading the garbage collection caused by dispatched event bursts over several frames.
+		  @return Returns a reference to this context's GC pacer, which is disabled unless set in "config.lua".
+		 */
+		LuaGcPacer& GetLuaGcPacer();
+
+		/**
+		  Fetches the scheduler pacing this context's EOS requests and retrying those that failed transiently.
+		  @return Returns a reference to this context's request scheduler.
+		 */
+		RequestScheduler& GetRequestScheduler();
+
+		/**
+		  Fetches the registry of asynchronous operations started by Lua that have not ended yet.
+		  @return Returns a reference to this context's in-flight operation registry.
+		 */
+		InflightOperationRegistry& GetInflightOperations();
+
+		/**
+		  Defers EOS initialization until the given delay has elapsed or until RequestInitialization() is called.
+		  @param initializer Function that initializes EOS and creates the platform. Invoked once on a later frame.
+		  @param delayInSeconds Time after which to initialize, even if no API has been used yet.
+		                        Set to a negative value to only initialize on first use.
+		 */
+		void DeferInitialization(const std::function<void()>& initializer, double delayInSeconds);
+
+		/**
+		  Determines if EOS initialization has been deferred and has not happened yet.
+		  @return Returns true if the deferred initializer has not been invoked yet.
+		 */
+		bool IsInitializationDeferred() const;
+
+		/** Makes the deferred initializer run on the next frame. Does nothing if initialization is not deferred. */
+		void RequestInitialization();
+
+		/**
+		  Queues a call to the given Lua API function with the arguments currently on the Lua stack, to be
+		  made once the deferred initializer has run. Also requests initialization on the next frame.
+		  @param luaStatePointer Lua state providing the call's arguments.
+		  @param luaFunction The Lua API function to call.
+		 */
+		void QueueDeferredCall(lua_State* luaStatePointer, int(*luaFunction)(lua_State*));
+
+		/**
+		  Fetches the pipeline which runs the startup stages enabled in the "config.lua" file.
+		  @return Returns a reference to this context's startup pipeline.
+		 */
+		StartupPipeline& GetStartupPipeline();
+
+		/**
+		  Opens the purchase journal and offline operation queue in system.DocumentsDirectory, and queues the
+		  purchases the app did not finish before it last exited. Runtime contexts given the same platform
+		  instance name share these files, while those given distinct names get files of their own.
+		  @param platformInstanceName The "platformInstance" name set in "config.lua". Null or empty if not set.
+		 */
+		void OpenPurchaseStorage(const char* platformInstanceName);
+
+		/**
+		  Creates the on-disk cache used to download offer and item images after eos.loadProducts() succeeds.
+		  Images are not downloaded unless this method is called.
+		  @param maxBytes Total size of cached images above which the least recently used are deleted.
+		 */
+		void EnableOfferImageCache(uint64_t maxBytes);
+
+		/**
+		  Fetches the offer image cache created by EnableOfferImageCache().
+		  @return Returns a pointer to the image cache. Returns null if image caching is not enabled.
+		 */
+		OfferImageCache* GetOfferImageCache() const;
+
+		/**
+		  Sets whether "loadProducts" events provide their products via a lazy LuaOfferCatalog proxy.
+		  @param value Set true to use the proxy. Set false to provide a regular Lua array, which is the default.
+		 */
+		void SetLazyProductCatalogEnabled(bool value);
+
+		/**
+		  Determines if "loadProducts" events provide their products via a lazy LuaOfferCatalog proxy.
+		  @return Returns true if the proxy is used.
+		 */
+		bool IsLazyProductCatalogEnabled() const;
+
 	private:
 		/** Copy constructor deleted to prevent it from being called. */
 		RuntimeContext(const RuntimeContext&) = delete;
@@ -174,6 +338,13 @@ class RuntimeContext
 		/** Method deleted to prevent the copy operator from being used. */
 		void operator=(const RuntimeContext&) = delete;
 
+		/**
+		  Looks up the RuntimeContext mapped to the given Lua state, without resolving coroutines.
+		  @param luaStatePointer The Lua state to look up.
+		  @return Returns the RuntimeContext created for the given Lua state. Returns null if not found.
+		 */
+		static RuntimeContext* FindInstanceBy(lua_State* luaStatePointer);
+
 		/**
 		  Called when a Lua "enterFrame" event has been dispatched.
 		  @param luaStatePointer Pointer to the Lua state that dispatched the event.
@@ -181,6 +352,79 @@ class RuntimeContext
 		 */
 		int OnCoronaEnterFrame(lua_State* luatStatePointer);
 
+		/**
+		  Called when a Lua "system" event has been dispatched, such as "applicationSuspend" or "applicationResume".
+		  @param luaStatePointer Pointer to the Lua state that dispatched the event.
+		  @return Returns the number of return values pushed to Lua. Returns 0 if no return values were pushed.
+		 */
+		int OnCoronaSystemEvent(lua_State* luaStatePointer);
+
+		/** Tells EOS that the app is suspended and writes the pending purchases to disk, in case the OS terminates the app. */
+		void Suspend();
+
+		/** Tells EOS that the app is in the foreground, before it is ticked again, and paces the held events. */
+		void Resume();
+
+		/** A Lua API call made before EOS was initialized, along with a registry reference to its arguments. */
+		struct DeferredCall
+		{
+			int(*LuaFunction)(lua_State*);
+			int LuaArgumentsReference;
+		};
+
+		/** Runs the deferred initializer and then replays the calls queued before it. */
+		void RunDeferredInitialization();
+
+		/** An entitlement ID waiting to be redeemed along with the number of attempts made so far. */
+		struct PendingRedemption
+		{
+			std::string EntitlementId;
+			int AttemptCount;
+
+			/** The account to redeem the entitlement for. */
+			EOS_EpicAccountId AccountId;
+		};
+
+		/** Batch of entitlements passed as client data to EOS_Ecom_RedeemEntitlements(). */
+		struct RedeemEntitlementsRequest
+		{
+			RuntimeContext* ContextPointer;
+			std::vector<PendingRedemption> Entitlements;
+		};
+
+		/**
+		  Sends up to EOS_ECOM_REDEEMENTITLEMENTS_MAX_IDS queued entitlements of the oldest queued entitlement's
+		  account to EOS_Ecom_RedeemEntitlements(). Does nothing if the queue is empty or while backing off.
+		 */
+		void FlushEntitlementRedemptions();
+
+		/**
+		  Moves the given entitlements to the offline operation queue, to be redeemed once back online
+		  and once their account is logged in.
+		  @param entitlements The entitlements to hold.
+		 */
+		void HoldEntitlementRedemptions(const std::vector<PendingRedemption>& entitlements);
+
+		/** Queues the next batch of operations held while offline to be sent, if any belong to a logged in user. */
+		void ReplayOfflineOperations();
+
+		/**
+		  Determines if the given entitlement is queued or being redeemed.
+		  @param entitlementId The entitlement's ID.
+		  @return Returns true if queued or in flight.
+		 */
+		bool IsRedemptionQueued(const std::string& entitlementId) const;
+
+		/** Called when an EOS_Ecom_RedeemEntitlements() batch has completed. */
+		static void EOS_CALL OnRedeemEntitlementsResponse(const EOS_Ecom_RedeemEntitlementsCallbackInfo* Data);
+
+		/**
+		  Queues the images of all offers returned by eos.loadProducts(), and of the items they contain,
+		  to be downloaded by the offer image cache.
+		  @param localUserId The Epic account the offers were queried for.
+		 */
+		void PrefetchOfferImages(EOS_EpicAccountId localUserId);
+
 		template<class TEosEventCallbackParam, class TDispatchEventTask>
 		/**
 		  To be called by this class' global EOS event handler methods.
@@ -207,12 +451,102 @@ class RuntimeContext
 		/** Lua "enterFrame" listener. */
 		LuaMethodCallback<RuntimeContext> fLuaEnterFrameCallback;
 
+		/** Lua "system" listener, used to detect when Corona is suspended and resumed. */
+		LuaMethodCallback<RuntimeContext> fLuaSystemEventCallback;
+
 		/**
 		  Queue of task objects used to dispatch various Eos related events to Lua.
 		  Native Eos event callbacks are expected to push their event data to this queue to be dispatched
 		  by this context later and only while the Corona runtime is running (ie: not suspended).
 		 */
-		std::queue<std::shared_ptr<BaseDispatchEventTask>> fDispatchEventTaskQueue;
+		std::deque<std::shared_ptr<BaseDispatchEventTask>> fDispatchEventTaskQueue;
+
+		/** Set true between the "applicationSuspend" and "applicationResume" events. */
+		bool fIsSuspended;
+
+		/** Set true by Resume() until the next tick, whose events are then paced along with the held ones. */
+		bool fIsResuming;
+
+		/** Number of events held while suspended before the overflow policy applies. */
+		size_t fSuspendedEventLimit;
+
+		/** Set true to drop the oldest held events past the limit, or false to drop the newest. */
+		bool fIsDroppingOldestSuspendedEvents;
+
+		/** Number of events held while suspended that are dispatched per frame once resumed. */
+		size_t fResumeEventsPerFrame;
+
+		/** Number of events held while suspended that have not been dispatched since the app resumed. */
+		size_t fHeldEventCount;
+
+		/** Number of events dropped since the app was suspended, logged once it resumes. */
+		uint32_t fDroppedSuspendedEventCount;
+
+		/** Initializes EOS on a later frame. Null if initialization was not deferred or has already run. */
+		std::function<void()> fDeferredInitializer;
+
+		/** Time at which the deferred initializer runs, even if no API has been used. */
+		std::chrono::steady_clock::time_point fDeferredInitializationTime;
+
+		/** Lua API calls made before the deferred initializer has run, in the order they were made. */
+		std::vector<DeferredCall> fDeferredCalls;
+
+		/** Entitlements queued by eos.finishTransaction() that have not been sent to EOS yet. */
+		std::vector<PendingRedemption> fPendingRedemptions;
+
+		/** IDs of the entitlements sent to EOS_Ecom_RedeemEntitlements() whose batch has not completed yet. */
+		std::unordered_set<std::string> fInflightRedemptionIds;
+
+		/** Time at which the pending entitlements will be flushed even if a batch has not filled up. */
+		std::chrono::steady_clock::time_point fRedemptionFlushTime;
+
+		/** Time before which no batch is sent, set when a batch failed transiently to back off from EOS. */
+		std::chrono::steady_clock::time_point fRedemptionRetryTime;
+
+		/**
+		  Journal of purchased entitlements not finished by Lua yet, shared with the runtime contexts using the same file.
+		  Committed to disk every frame, before the checkouts received that frame are dispatched to Lua.
+		 */
+		std::shared_ptr<PurchaseJournal> fPurchaseJournalPointer;
+
+		/** Idempotent operations held while offline, persisted until replayed. Shared like the purchase journal. */
+		std::shared_ptr<OfflineOperationQueue> fOfflineOperationQueuePointer;
+
+		/** Set false while the device is offline, during which operations are held instead of being sent. */
+		bool fIsNetworkOnline;
+
+		/** The last status posted via PostNetworkStatus() that was passed to EOS. Negative if none yet. */
+		int fAppliedNetworkStatus;
+
+		/** Time at which the next batch of held operations is replayed. */
+		std::chrono::steady_clock::time_point fOfflineReplayTime;
+
+		/** Rate limits EOS requests per interface and retries the idempotent ones after transient failures. */
+		RequestScheduler fRequestScheduler;
+
+		/** Operations started by Lua and awaiting their callback, scanned every frame for timeouts. */
+		InflightOperationRegistry fInflightOperations;
+
+		/** The logged in local users and their token caches, indexed by the handles passed to Lua. */
+		LocalUserTable fLocalUsers;
+
+		/** Chains the startup stages enabled in "config.lua" and reports their timeline to Lua. */
+		StartupPipeline fStartupPipeline;
+
+		/** Logs into the Connect interface after each Auth login and renews the session before it expires. */
+		ConnectSession fConnectSession;
+
+		/** Tracks connected players and batches their EOS requests when running as a dedicated server. */
+		DedicatedServer fDedicatedServer;
+
+		/** Steps the Lua collector over the frames following large event bursts. */
+		LuaGcPacer fLuaGcPacer;
+
+		/** Downloads and caches offer images. Null if not enabled via the "config.lua" file. */
+		std::unique_ptr<OfferImageCache> fOfferImageCachePointer;
+
+		/** Set true if "loadProducts" events provide a lazy LuaOfferCatalog proxy instead of a product array. */
+		bool fIsLazyProductCatalogEnabled;
 
 };
 
@@ -0,0 +1,154 @@
+// ----------------------------------------------------------------------------
+//
+// SecureTokenStore.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#include "SecureTokenStore.h"
+#if defined(_WIN32)
+#	include <windows.h>
+#	include <wincred.h>
+#	define SECURE_TOKEN_STORE_WINDOWS 1
+#elif defined(__APPLE__)
+#	include <TargetConditionals.h>
+#	if TARGET_OS_OSX
+#		include <Security/Security.h>
+#		define SECURE_TOKEN_STORE_KEYCHAIN 1
+#	endif
+#endif
+
+
+#if SECURE_TOKEN_STORE_KEYCHAIN
+/** Keychain service that all of this plugin's secrets are stored under. */
+static const char kKeychainServiceName[] = "plugin.eos";
+
+/**
+  Creates a Keychain query matching the generic password stored under the given name.
+  @param name The secret's unique name, used as the Keychain item's account.
+  @return Returns a mutable dictionary which the caller must release via CFRelease().
+ */
+static CFMutableDictionaryRef CreateKeychainQueryFor(const char* name)
+{
+	auto query = CFDictionaryCreateMutable(
+			kCFAllocatorDefault, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+	auto serviceName = CFStringCreateWithCString(kCFAllocatorDefault, kKeychainServiceName, kCFStringEncodingUTF8);
+	auto accountName = CFStringCreateWithCString(kCFAllocatorDefault, name, kCFStringEncodingUTF8);
+	CFDictionarySetValue(query, kSecClass, kSecClassGenericPassword);
+	CFDictionarySetValue(query, kSecAttrService, serviceName);
+	CFDictionarySetValue(query, kSecAttrAccount, accountName);
+	CFRelease(serviceName);
+	CFRelease(accountName);
+	return query;
+}
+#endif
+
+
+bool SecureTokenStore::IsSupported()
+{
+#if SECURE_TOKEN_STORE_WINDOWS || SECURE_TOKEN_STORE_KEYCHAIN
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool SecureTokenStore::Load(const char* name, std::string& outToken)
+{
+	// Validate.
+	if (!name || ('\0' == name[0]))
+	{
+		return false;
+	}
+
+#if SECURE_TOKEN_STORE_WINDOWS
+	PCREDENTIALA credentialPointer = nullptr;
+	if (!::CredReadA(name, CRED_TYPE_GENERIC, 0, &credentialPointer) || !credentialPointer)
+	{
+		return false;
+	}
+	bool wasLoaded = (credentialPointer->CredentialBlobSize > 0);
+	if (wasLoaded)
+	{
+		outToken.assign((const char*)credentialPointer->CredentialBlob, credentialPointer->CredentialBlobSize);
+	}
+	::CredFree(credentialPointer);
+	return wasLoaded;
+#elif SECURE_TOKEN_STORE_KEYCHAIN
+	auto query = CreateKeychainQueryFor(name);
+	CFDictionarySetValue(query, kSecReturnData, kCFBooleanTrue);
+	CFDictionarySetValue(query, kSecMatchLimit, kSecMatchLimitOne);
+	CFTypeRef result = nullptr;
+	OSStatus status = SecItemCopyMatching(query, &result);
+	CFRelease(query);
+	if ((status != errSecSuccess) || !result)
+	{
+		return false;
+	}
+	bool wasLoaded = (CFGetTypeID(result) == CFDataGetTypeID()) && (CFDataGetLength((CFDataRef)result) > 0);
+	if (wasLoaded)
+	{
+		outToken.assign((const char*)CFDataGetBytePtr((CFDataRef)result), (size_t)CFDataGetLength((CFDataRef)result));
+	}
+	CFRelease(result);
+	return wasLoaded;
+#else
+	(void)outToken;
+	return false;
+#endif
+}
+
+bool SecureTokenStore::Save(const char* name, const std::string& token)
+{
+	// Validate.
+	if (!name || ('\0' == name[0]) || token.empty())
+	{
+		return false;
+	}
+
+#if SECURE_TOKEN_STORE_WINDOWS
+	if (token.size() > CRED_MAX_CREDENTIAL_BLOB_SIZE)
+	{
+		return false;
+	}
+	CREDENTIALA credential{};
+	credential.Type = CRED_TYPE_GENERIC;
+	credential.TargetName = (LPSTR)name;
+	credential.CredentialBlobSize = (DWORD)token.size();
+	credential.CredentialBlob = (LPBYTE)token.data();
+	credential.Persist = CRED_PERSIST_LOCAL_MACHINE;
+	return ::CredWriteA(&credential, 0) ? true : false;
+#elif SECURE_TOKEN_STORE_KEYCHAIN
+	// Replace the last item, since SecItemAdd() fails if an item with the same name already exists.
+	auto query = CreateKeychainQueryFor(name);
+	SecItemDelete(query);
+	auto tokenData = CFDataCreate(kCFAllocatorDefault, (const UInt8*)token.data(), (CFIndex)token.size());
+	CFDictionarySetValue(query, kSecValueData, tokenData);
+	CFDictionarySetValue(query, kSecAttrAccessible, kSecAttrAccessibleAfterFirstUnlockThisDeviceOnly);
+	OSStatus status = SecItemAdd(query, nullptr);
+	CFRelease(tokenData);
+	CFRelease(query);
+	return (status == errSecSuccess);
+#else
+	return false;
+#endif
+}
+
+void SecureTokenStore::Remove(const char* name)
+{
+	// Validate.
+	if (!name || ('\0' == name[0]))
+	{
+		return;
+	}
+
+#if SECURE_TOKEN_STORE_WINDOWS
+	::CredDeleteA(name, CRED_TYPE_GENERIC, 0);
+#elif SECURE_TOKEN_STORE_KEYCHAIN
+	auto query = CreateKeychainQueryFor(name);
+	SecItemDelete(query);
+	CFRelease(query);
+#endif
+}
@@ -0,0 +1,53 @@
+// ----------------------------------------------------------------------------
+//
+// SecureTokenStore.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <string>
+
+
+/**
+  Stores secrets such as EOS refresh tokens in the operating system's protected credential storage.
+
+  Uses the Credential Manager on Windows and the login Keychain on macOS, which encrypt the secret
+  at rest and only let the current user read it back. Not supported on other platforms, where the
+  EOS SDK persists its own refresh token for EOS_LCT_PersistentAuth logins.
+ */
+class SecureTokenStore
+{
+	public:
+		/**
+		  Determines if secure storage is available on this platform.
+		  @return Returns true on Windows and macOS. Returns false on all other platforms.
+		 */
+		static bool IsSupported();
+
+		/**
+		  Fetches the secret stored under the given name.
+		  @param name Unique name the secret was stored under, such as "plugin.eos.<productId>.refreshToken".
+		  @param outToken Receives the secret.
+		  @return Returns true if the secret was found. Returns false if not found, if given a null or
+		          empty name, or if not supported on this platform.
+		 */
+		static bool Load(const char* name, std::string& outToken);
+
+		/**
+		  Stores the given secret, replacing the last secret stored under the same name.
+		  @param name Unique name to store the secret under.
+		  @param token The secret to store. Cannot be empty.
+		  @return Returns true if the secret was stored. Returns false on failure or if not supported.
+		 */
+		static bool Save(const char* name, const std::string& token);
+
+		/**
+		  Deletes the secret stored under the given name, if any.
+		  @param name Unique name the secret was stored under.
+		 */
+		static void Remove(const char* name);
+};
@@ -0,0 +1,172 @@
+// ----------------------------------------------------------------------------
+//
+// ServerPlayerTable.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#include "ServerPlayerTable.h"
+#include "Fnv1aHash.h"
+#include <cstring>
+
+
+/** Number of index slots allocated for the 1st player. Must be a power of 2. */
+static const size_t kMinSlotCount = 16;
+
+
+ServerPlayerTable::ServerPlayerTable()
+{
+}
+
+ServerPlayerTable::~ServerPlayerTable()
+{
+}
+
+ServerPlayerTable::Player* ServerPlayerTable::Add(const char* productUserIdString)
+{
+	// Validate.
+	if (!productUserIdString || (strlen(productUserIdString) > EOS_PRODUCTUSERID_MAX_LENGTH))
+	{
+		return nullptr;
+	}
+
+	// Return the player if already in the table.
+	Player* playerPointer = FindBy(productUserIdString);
+	if (playerPointer)
+	{
+		return playerPointer;
+	}
+
+	// Fetch the player's product user ID.
+	EOS_ProductUserId productUserId = EOS_ProductUserId_FromString(productUserIdString);
+	if (!productUserId || !EOS_ProductUserId_IsValid(productUserId))
+	{
+		return nullptr;
+	}
+
+	// Grow the index before it is 3/4 full, so that probe sequences stay short.
+	if (((fPlayers.size() + 1) * 4) > (fIndex.size() * 3))
+	{
+		Rehash(fIndex.empty() ? kMinSlotCount : (fIndex.size() * 2));
+	}
+
+	// Add the player.
+	Player player;
+	player.ProductUserId = productUserId;
+	strncpy(player.ProductUserIdString, productUserIdString, sizeof(player.ProductUserIdString));
+	player.ProductUserIdString[sizeof(player.ProductUserIdString) - 1] = '\0';
+	player.Hash = Fnv1aHash::Hash32(player.ProductUserIdString);
+	player.Flags = 0;
+	size_t slotIndex = FindSlotFor(player.ProductUserIdString, player.Hash);
+	fPlayers.push_back(std::move(player));
+	fIndex[slotIndex] = (uint32_t)fPlayers.size();
+	return &fPlayers.back();
+}
+
+ServerPlayerTable::Player* ServerPlayerTable::FindBy(const char* productUserIdString)
+{
+	if (!productUserIdString || fIndex.empty())
+	{
+		return nullptr;
+	}
+	uint32_t playerNumber = fIndex[FindSlotFor(productUserIdString, Fnv1aHash::Hash32(productUserIdString))];
+	return playerNumber ? &fPlayers[playerNumber - 1] : nullptr;
+}
+
+ServerPlayerTable::Player* ServerPlayerTable::FindBy(EOS_ProductUserId productUserId)
+{
+	if (!productUserId || fIndex.empty())
+	{
+		return nullptr;
+	}
+	char stringBuffer[EOS_PRODUCTUSERID_MAX_LENGTH + 1];
+	int32_t stringLength = (int32_t)sizeof(stringBuffer);
+	if (EOS_ProductUserId_ToString(productUserId, stringBuffer, &stringLength) != EOS_EResult::EOS_Success)
+	{
+		return nullptr;
+	}
+	return FindBy(stringBuffer);
+}
+
+bool ServerPlayerTable::Remove(const char* productUserIdString)
+{
+	// Find the player's slot.
+	if (!productUserIdString || fIndex.empty())
+	{
+		return false;
+	}
+	size_t holeSlotIndex = FindSlotFor(productUserIdString, Fnv1aHash::Hash32(productUserIdString));
+	if (!fIndex[holeSlotIndex])
+	{
+		return false;
+	}
+	size_t playerIndex = fIndex[holeSlotIndex] - 1;
+
+	// Empty the slot, shifting back the entries after it that would otherwise no longer be reachable by probing.
+	size_t slotMask = fIndex.size() - 1;
+	for (size_t slotIndex = (holeSlotIndex + 1) & slotMask; fIndex[slotIndex]; slotIndex = (slotIndex + 1) & slotMask)
+	{
+		size_t homeSlotIndex = fPlayers[fIndex[slotIndex] - 1].Hash & slotMask;
+		if (((slotIndex - homeSlotIndex) & slotMask) >= ((slotIndex - holeSlotIndex) & slotMask))
+		{
+			fIndex[holeSlotIndex] = fIndex[slotIndex];
+			holeSlotIndex = slotIndex;
+		}
+	}
+	fIndex[holeSlotIndex] = 0;
+
+	// Move the last player into the removed player's place, keeping the array dense.
+	size_t lastPlayerIndex = fPlayers.size() - 1;
+	if (playerIndex != lastPlayerIndex)
+	{
+		Player& lastPlayer = fPlayers[lastPlayerIndex];
+		fIndex[FindSlotFor(lastPlayer.ProductUserIdString, lastPlayer.Hash)] = (uint32_t)(playerIndex + 1);
+		fPlayers[playerIndex] = std::move(lastPlayer);
+	}
+	fPlayers.pop_back();
+	return true;
+}
+
+size_t ServerPlayerTable::GetCount() const
+{
+	return fPlayers.size();
+}
+
+ServerPlayerTable::Player& ServerPlayerTable::GetAt(size_t index)
+{
+	return fPlayers[index];
+}
+
+void ServerPlayerTable::Clear()
+{
+	fPlayers.clear();
+	fIndex.clear();
+}
+
+size_t ServerPlayerTable::FindSlotFor(const char* productUserIdString, uint32_t hash) const
+{
+	size_t slotMask = fIndex.size() - 1;
+	size_t slotIndex = hash & slotMask;
+	while (fIndex[slotIndex])
+	{
+		const Player& player = fPlayers[fIndex[slotIndex] - 1];
+		if ((player.Hash == hash) && !strcmp(player.ProductUserIdString, productUserIdString))
+		{
+			break;
+		}
+		slotIndex = (slotIndex + 1) & slotMask;
+	}
+	return slotIndex;
+}
+
+void ServerPlayerTable::Rehash(size_t slotCount)
+{
+	fIndex.assign(slotCount, 0);
+	for (size_t playerIndex = 0; playerIndex < fPlayers.size(); playerIndex++)
+	{
+		const Player& player = fPlayers[playerIndex];
+		fIndex[FindSlotFor(player.ProductUserIdString, player.Hash)] = (uint32_t)(playerIndex + 1);
+	}
+}
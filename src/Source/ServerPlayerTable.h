@@ -0,0 +1,155 @@
+// ----------------------------------------------------------------------------
+//
+// ServerPlayerTable.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include "eos_sdk.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+/**
+  Holds the state of every player connected to a dedicated server, keyed by their product user ID.
+
+  Players are stored contiguously so that the per-frame batching passes walk a dense array, and are found
+  via an open addressing index of 32-bit slots probed linearly, which keeps lookups at a hash and one or two
+  probes for the hundreds of players a server hosts. Removing a player moves the last player into its place,
+  so player pointers and indexes are only valid until the next Add() or Remove().
+ */
+class ServerPlayerTable
+{
+	public:
+		/** Flags describing where a player has been registered with EOS. */
+		enum Flags : uint8_t
+		{
+			/** Set once EOS_Sessions_RegisterPlayers() succeeded for the player's session. */
+			kIsRegisteredWithSession = 0x01,
+
+			/** Set while the player is queued to be registered with their session. */
+			kIsSessionRegistrationPending = 0x02,
+
+			/** Set once the player has been registered with the anti-cheat session. */
+			kIsRegisteredWithAntiCheat = 0x04,
+
+			/** Set once the player's active sanctions were queried, whether or not any were found. */
+			kHasQueriedSanctions = 0x08,
+
+			/** Set if the player had at least 1 active sanction when last queried. */
+			kIsSanctioned = 0x10,
+		};
+
+		/** A stat amount waiting to be ingested, with repeated ingests of the same stat summed. */
+		struct PendingStat
+		{
+			std::string StatName;
+			int32_t Amount;
+		};
+
+		/** The state belonging to 1 connected player. */
+		struct Player
+		{
+			/** The player's product user ID. Also passed to the anti-cheat interface as the player's client handle. */
+			EOS_ProductUserId ProductUserId;
+
+			/** String form of "ProductUserId", which the table is keyed by. */
+			char ProductUserIdString[EOS_PRODUCTUSERID_MAX_LENGTH + 1];
+
+			/** Hash of "ProductUserIdString", kept so that the index can be rebuilt without hashing again. */
+			uint32_t Hash;
+
+			/** Combination of the Flags enum's values. */
+			uint8_t Flags;
+
+			/** Name of the session the player is registered with. Empty if none. */
+			std::string SessionName;
+
+			/** IP address passed to the anti-cheat interface. Empty if not known. */
+			std::string IpAddress;
+
+			/** Stats to send with the player's next EOS_Stats_IngestStat() call. */
+			std::vector<PendingStat> PendingStats;
+		};
+
+		/** Creates a new empty table. */
+		ServerPlayerTable();
+		virtual ~ServerPlayerTable();
+
+		/**
+		  Adds the given player, unless already in the table.
+		  @param productUserIdString String form of the player's product user ID.
+		  @return Returns the player, which is newly added if its Flags are zero.
+		          Returns null if the string is not a valid product user ID.
+		 */
+		Player* Add(const char* productUserIdString);
+
+		/**
+		  Fetches the given player.
+		  @param productUserIdString String form of the player's product user ID.
+		  @return Returns the player. Returns null if not in the table.
+		 */
+		Player* FindBy(const char* productUserIdString);
+
+		/**
+		  Fetches the given player.
+		  @param productUserId The player's product user ID, as received from an EOS callback.
+		  @return Returns the player. Returns null if not in the table.
+		 */
+		Player* FindBy(EOS_ProductUserId productUserId);
+
+		/**
+		  Removes the given player.
+		  @param productUserIdString String form of the player's product user ID.
+		  @return Returns true if removed. Returns false if not in the table.
+		 */
+		bool Remove(const char* productUserIdString);
+
+		/**
+		  Fetches the number of players in the table.
+		  @return Returns the number of players.
+		 */
+		size_t GetCount() const;
+
+		/**
+		  Fetches a player by its position in the table's dense array.
+		  @param index Zero based index, less than GetCount().
+		  @return Returns the player at the given index.
+		 */
+		Player& GetAt(size_t index);
+
+		/** Removes every player. */
+		void Clear();
+
+	private:
+		/** Copy constructor deleted to prevent it from being called. */
+		ServerPlayerTable(const ServerPlayerTable&) = delete;
+
+		/** Method deleted to prevent the copy operator from being used. */
+		void operator=(const ServerPlayerTable&) = delete;
+
+		/**
+		  Finds the index slot holding the given player, or the empty slot it would be inserted into.
+		  @param productUserIdString String form of the player's product user ID.
+		  @param hash Hash of the string.
+		  @return Returns the slot's position in "fIndex". Only valid while "fIndex" is not empty.
+		 */
+		size_t FindSlotFor(const char* productUserIdString, uint32_t hash) const;
+
+		/**
+		  Resizes the index to the given number of slots and inserts every player again.
+		  @param slotCount Number of slots, which must be a power of 2 larger than the number of players.
+		 */
+		void Rehash(size_t slotCount);
+
+		/** The players, in no particular order. */
+		std::vector<Player> fPlayers;
+
+		/** Open addressing index of "fPlayers". Each slot holds a player index plus 1, or zero if empty. */
+		std::vector<uint32_t> fIndex;
+};
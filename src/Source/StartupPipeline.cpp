@@ -0,0 +1,265 @@
+// ----------------------------------------------------------------------------
+//
+// StartupPipeline.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#include "StartupPipeline.h"
+#include "CoronaLua.h"
+#include "DispatchEventTask.h"
+#include "RuntimeContext.h"
+#include "eos_ecom.h"
+#include <unordered_set>
+
+
+/** Stores a collection of all StartupPipeline instances that currently exist in the application. */
+static std::unordered_set<StartupPipeline*> sStartupPipelineCollection;
+
+/** Names of the stages in the "startup" event, indexed by the StartupPipeline::Stage enum. */
+static const char* kStageNames[] = { "platform", "login", "connectLogin", "loadProducts", "restore" };
+static_assert(
+		(sizeof(kStageNames) / sizeof(kStageNames[0])) == (size_t)StartupPipeline::Stage::kCount,
+		"Every StartupPipeline::Stage must have a name.");
+
+
+StartupPipeline::StartupPipeline(RuntimeContext* contextPointer)
+:	fContextPointer(contextPointer),
+	fCreationTime(std::chrono::steady_clock::now()),
+	fIsComplete(false),
+	fLocalUserId(nullptr),
+	fLoadProductsAttemptCount(0),
+	fRestoreAttemptCount(0)
+{
+	// Set up every stage, with only the stages that cannot be skipped enabled.
+	fStages.resize((size_t)Stage::kCount);
+	for (size_t index = 0; index < fStages.size(); index++)
+	{
+		StageTiming& timing = fStages[index];
+		timing.Name = kStageNames[index];
+		timing.IsEnabled = false;
+		timing.HasStarted = false;
+		timing.HasEnded = false;
+		timing.ResultCode = EOS_EResult::EOS_NotConfigured;
+		timing.StartTime = std::chrono::milliseconds::zero();
+		timing.EndTime = std::chrono::milliseconds::zero();
+	}
+	fStages[(size_t)Stage::kPlatform].IsEnabled = true;
+	fStages[(size_t)Stage::kLogin].IsEnabled = true;
+
+	// Add this class instance to the global collection.
+	sStartupPipelineCollection.insert(this);
+}
+
+StartupPipeline::~StartupPipeline()
+{
+	// Remove this class instance from the global collection.
+	// Note: In-flight query callbacks check this collection and will do nothing once it is removed.
+	sStartupPipelineCollection.erase(this);
+}
+
+void StartupPipeline::SetStageEnabled(Stage stage, bool value)
+{
+	if ((stage == Stage::kPlatform) || (stage >= Stage::kCount))
+	{
+		return;
+	}
+	fStages[(size_t)stage].IsEnabled = value;
+}
+
+void StartupPipeline::OnStageStarted(Stage stage)
+{
+	if (stage >= Stage::kCount)
+	{
+		return;
+	}
+	StageTiming& timing = fStages[(size_t)stage];
+	if (!timing.HasStarted)
+	{
+		timing.HasStarted = true;
+		timing.StartTime = std::chrono::duration_cast<std::chrono::milliseconds>(
+				std::chrono::steady_clock::now() - fCreationTime);
+	}
+}
+
+void StartupPipeline::OnStageEnded(Stage stage, EOS_EResult resultCode)
+{
+	if (stage >= Stage::kCount)
+	{
+		return;
+	}
+	StageTiming& timing = fStages[(size_t)stage];
+	if (timing.HasEnded)
+	{
+		return;
+	}
+	OnStageStarted(stage);
+	timing.HasEnded = true;
+	timing.ResultCode = resultCode;
+	timing.EndTime = std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now() - fCreationTime);
+	CompleteIfReady();
+}
+
+void StartupPipeline::OnLoginEnded(EOS_EResult resultCode, EOS_EpicAccountId localUserId)
+{
+	// Only the first successful login ends the login stage.
+	if ((resultCode != EOS_EResult::EOS_Success) || !localUserId || fStages[(size_t)Stage::kLogin].HasEnded)
+	{
+		return;
+	}
+	if (!fContextPointer || !fContextPointer->fPlatformHandle)
+	{
+		return;
+	}
+
+	// Start all stages depending on the login before reporting the login stage,
+	// so that the pipeline cannot be considered complete in between.
+	fLocalUserId = localUserId;
+	if (fStages[(size_t)Stage::kLoadProducts].IsEnabled)
+	{
+		OnStageStarted(Stage::kLoadProducts);
+		fContextPointer->GetRequestScheduler().Submit(
+				RequestScheduler::Interface::kEcom, [this]() { SendQueryOffers(); });
+	}
+	if (fStages[(size_t)Stage::kRestore].IsEnabled)
+	{
+		OnStageStarted(Stage::kRestore);
+		fContextPointer->GetRequestScheduler().Submit(
+				RequestScheduler::Interface::kEcom, [this]() { SendQueryEntitlements(); });
+	}
+	OnStageEnded(Stage::kLogin, resultCode);
+}
+
+bool StartupPipeline::IsComplete() const
+{
+	return fIsComplete;
+}
+
+void StartupPipeline::CompleteIfReady()
+{
+	if (fIsComplete || !fContextPointer)
+	{
+		return;
+	}
+
+	// Wait for every enabled stage to complete, unless the platform failed to be created,
+	// in which case no other stage will ever be started.
+	const StageTiming& platformTiming = fStages[(size_t)Stage::kPlatform];
+	bool hasPlatformFailed = platformTiming.HasEnded && (platformTiming.ResultCode != EOS_EResult::EOS_Success);
+	if (!hasPlatformFailed)
+	{
+		for (auto&& timing : fStages)
+		{
+			if (timing.IsEnabled && !timing.HasEnded)
+			{
+				return;
+			}
+		}
+	}
+	fIsComplete = true;
+
+	// Report the timeline to Lua.
+	// Note: This is queued after the events of the last stage, so Lua receives it last.
+	auto taskPointer = new DispatchStartupEventTask();
+	taskPointer->SetLuaEventDispatcher(fContextPointer->GetLuaEventDispatcher());
+	taskPointer->AcquireEventDataFrom(fStages);
+	fContextPointer->QueueDispatchEventTask(std::shared_ptr<BaseDispatchEventTask>(taskPointer));
+}
+
+void StartupPipeline::SendQueryOffers()
+{
+	if (!fContextPointer->fPlatformHandle)
+	{
+		return;
+	}
+	fLoadProductsAttemptCount++;
+
+	EOS_HEcom EcomHandle = EOS_Platform_GetEcomInterface(fContextPointer->fPlatformHandle);
+	EOS_Ecom_QueryOffersOptions QueryOptions{ 0 };
+	QueryOptions.ApiVersion = EOS_ECOM_QUERYOFFERS_API_LATEST;
+	QueryOptions.LocalUserId = fLocalUserId;
+	QueryOptions.OverrideCatalogNamespace = nullptr;
+	EOS_Ecom_QueryOffers(EcomHandle, &QueryOptions, this, &StartupPipeline::OnQueryOffersResponse);
+}
+
+void StartupPipeline::SendQueryEntitlements()
+{
+	if (!fContextPointer->fPlatformHandle)
+	{
+		return;
+	}
+	fRestoreAttemptCount++;
+
+	EOS_HEcom EcomHandle = EOS_Platform_GetEcomInterface(fContextPointer->fPlatformHandle);
+	EOS_Ecom_QueryEntitlementsOptions QueryOptions{ 0 };
+	QueryOptions.ApiVersion = EOS_ECOM_QUERYENTITLEMENTS_API_LATEST;
+	QueryOptions.LocalUserId = fLocalUserId;
+	QueryOptions.bIncludeRedeemed = true;
+	EOS_Ecom_QueryEntitlements(EcomHandle, &QueryOptions, this, &StartupPipeline::OnQueryEntitlementsResponse);
+}
+
+void EOS_CALL StartupPipeline::OnQueryOffersResponse(const EOS_Ecom_QueryOffersCallbackInfo* Data)
+{
+	if (!Data || !EOS_EResult_IsOperationComplete(Data->ResultCode))
+	{
+		return;
+	}
+
+	auto pipelinePointer = (StartupPipeline*)Data->ClientData;
+	if (sStartupPipelineCollection.find(pipelinePointer) == sStartupPipelineCollection.end())
+	{
+		return;
+	}
+
+	// Query again later if EOS was busy or unreachable, ending the stage once the result is final.
+	auto& scheduler = pipelinePointer->fContextPointer->GetRequestScheduler();
+	if (scheduler.ScheduleRetry(
+			RequestScheduler::Interface::kEcom, Data->ResultCode, pipelinePointer->fLoadProductsAttemptCount,
+			[pipelinePointer]() { pipelinePointer->SendQueryOffers(); }))
+	{
+		return;
+	}
+
+	// Dispatch the offers to Lua as if eos.loadProducts() was called.
+	// Note: The event task expects the runtime context as the callback's client data.
+	EOS_Ecom_QueryOffersCallbackInfo OffersData = *Data;
+	OffersData.ClientData = pipelinePointer->fContextPointer;
+	pipelinePointer->fContextPointer->OnLoadProductsResponse(&OffersData);
+	pipelinePointer->OnStageEnded(Stage::kLoadProducts, Data->ResultCode);
+}
+
+void EOS_CALL StartupPipeline::OnQueryEntitlementsResponse(const EOS_Ecom_QueryEntitlementsCallbackInfo* Data)
+{
+	if (!Data || !EOS_EResult_IsOperationComplete(Data->ResultCode))
+	{
+		return;
+	}
+
+	auto pipelinePointer = (StartupPipeline*)Data->ClientData;
+	if (sStartupPipelineCollection.find(pipelinePointer) == sStartupPipelineCollection.end())
+	{
+		return;
+	}
+
+	// Query again later if EOS was busy or unreachable, ending the stage once the result is final.
+	auto& scheduler = pipelinePointer->fContextPointer->GetRequestScheduler();
+	if (scheduler.ScheduleRetry(
+			RequestScheduler::Interface::kEcom, Data->ResultCode, pipelinePointer->fRestoreAttemptCount,
+			[pipelinePointer]() { pipelinePointer->SendQueryEntitlements(); }))
+	{
+		return;
+	}
+
+	// Dispatch the entitlements to Lua as if eos.restore() was called.
+	// Note: Like eos.restore(), failed queries only show up as errors in the "startup" event.
+	if (Data->ResultCode == EOS_EResult::EOS_Success)
+	{
+		EOS_Ecom_QueryEntitlementsCallbackInfo EntitlementsData = *Data;
+		EntitlementsData.ClientData = pipelinePointer->fContextPointer;
+		pipelinePointer->fContextPointer->OnQueryEntitlementsResponse(&EntitlementsData);
+	}
+	pipelinePointer->OnStageEnded(Stage::kRestore, Data->ResultCode);
+}
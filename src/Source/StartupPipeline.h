@@ -0,0 +1,158 @@
+// ----------------------------------------------------------------------------
+//
+// StartupPipeline.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <chrono>
+#include <vector>
+#include "eos_sdk.h"
+#include "eos_ecom_types.h"
+
+// Forward declarations.
+class RuntimeContext;
+
+
+/**
+  Runs the startup stages enabled by the "startup" table in the "config.lua" file natively, starting
+  each stage as soon as the stages it depends on have completed instead of waiting for Lua to react
+  to the last stage's event on a later frame.
+
+  The platform stage is always tracked, as is the login stage unless running as a dedicated server,
+  which has no user to log in. Once the user has logged in, the enabled catalog
+  and entitlement queries are started together and their results are dispatched to Lua as the usual
+  "loadProducts" and "storeTransaction" events.
+
+  Once every started stage has completed, a "startup" event is dispatched to Lua providing the start
+  and end time of each stage in milliseconds since the plugin was loaded.
+ */
+class StartupPipeline
+{
+	public:
+		/** A startup stage, listed in the order that they are reported in. */
+		enum class Stage
+		{
+			/** Creation of the EOS platform via EOS_Platform_Create(). */
+			kPlatform,
+
+			/** The first successful EOS_Auth_Login(), no matter which credentials or API started it. */
+			kLogin,
+
+			/** EOS_Connect_Login() with the Auth ID token, started once logged in. Enabled via "connectLogin". */
+			kConnectLogin,
+
+			/** EOS_Ecom_QueryOffers(), started once logged in. Same as calling eos.loadProducts(). */
+			kLoadProducts,
+
+			/** EOS_Ecom_QueryEntitlements(), started once logged in. Same as calling eos.restore(). */
+			kRestore,
+
+			/** Number of stages. Not a stage. */
+			kCount
+		};
+
+		/** Timing and result of 1 stage, as reported by the "startup" event. */
+		struct StageTiming
+		{
+			/** The stage's name in the "startup" event, such as "login". */
+			const char* Name;
+			bool IsEnabled;
+			bool HasStarted;
+			bool HasEnded;
+			EOS_EResult ResultCode;
+
+			/** Time the stage was started, relative to when the pipeline was created. */
+			std::chrono::milliseconds StartTime;
+
+			/** Time the stage completed, relative to when the pipeline was created. */
+			std::chrono::milliseconds EndTime;
+		};
+
+		/**
+		  Creates a new pipeline with only the platform and login stages enabled.
+		  Stage times are measured from the moment this constructor is called.
+		  @param contextPointer The runtime context used to query EOS and dispatch events. Cannot be null.
+		 */
+		StartupPipeline(RuntimeContext* contextPointer);
+
+		/** Stops handling in-flight queries. */
+		virtual ~StartupPipeline();
+
+		/**
+		  Enables or disables the given stage. Expected to be called before the user logs in.
+		  @param stage The stage to enable or disable. The platform stage is always enabled.
+		               The login stage is only expected to be disabled by a dedicated server.
+		  @param value Set true to run the stage once its dependencies have completed.
+		 */
+		void SetStageEnabled(Stage stage, bool value);
+
+		/**
+		  Records the start time of the given stage. Ignored if the stage was already started.
+		  @param stage The stage that has been started.
+		 */
+		void OnStageStarted(Stage stage);
+
+		/**
+		  Records the end time and result of the given stage. Ignored if the stage already ended.
+		  @param stage The stage that has completed.
+		  @param resultCode The result the stage completed with.
+		 */
+		void OnStageEnded(Stage stage, EOS_EResult resultCode);
+
+		/**
+		  To be called when an EOS_Auth_Login() has completed.
+		  The first successful login ends the login stage and starts the stages depending on it.
+		  Failed logins are ignored since Lua can retry, such as via eos.loginWithAccountPortal().
+		  @param resultCode The login's result.
+		  @param localUserId The Epic account that logged in.
+		 */
+		void OnLoginEnded(EOS_EResult resultCode, EOS_EpicAccountId localUserId);
+
+		/**
+		  Determines if every enabled stage has completed and the "startup" event has been queued.
+		  @return Returns true if the pipeline has finished. Returns false if at least 1 stage is pending.
+		 */
+		bool IsComplete() const;
+
+	private:
+		/** Copy constructor deleted to prevent it from being called. */
+		StartupPipeline(const StartupPipeline&) = delete;
+
+		/** Method deleted to prevent the copy operator from being used. */
+		void operator=(const StartupPipeline&) = delete;
+
+		/** Queues the "startup" event if every enabled stage has completed. */
+		void CompleteIfReady();
+
+		/** Sends the "loadProducts" stage's offer query via the context's request scheduler. */
+		void SendQueryOffers();
+
+		/** Sends the "restore" stage's entitlement query via the context's request scheduler. */
+		void SendQueryEntitlements();
+
+		static void EOS_CALL OnQueryOffersResponse(const EOS_Ecom_QueryOffersCallbackInfo* Data);
+		static void EOS_CALL OnQueryEntitlementsResponse(const EOS_Ecom_QueryEntitlementsCallbackInfo* Data);
+
+		RuntimeContext* fContextPointer;
+
+		/** Time the pipeline was created, which all stage times are relative to. */
+		std::chrono::steady_clock::time_point fCreationTime;
+
+		/** Timing of each stage, indexed by the Stage enum. */
+		std::vector<StageTiming> fStages;
+
+		/** Set true once the "startup" event has been queued. */
+		bool fIsComplete;
+
+		/** The Epic account whose login started the stages depending on it. */
+		EOS_EpicAccountId fLocalUserId;
+
+		/** Number of times the "loadProducts" and "restore" stages' queries have been sent, counting retries. */
+		int fLoadProductsAttemptCount;
+		int fRestoreAttemptCount;
+};
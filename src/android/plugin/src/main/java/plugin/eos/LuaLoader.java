@@ -26,6 +26,7 @@ import android.util.Log;
 
 import androidx.annotation.NonNull;
 
+import com.ansca.corona.CoronaActivity;
 import com.ansca.corona.CoronaEnvironment;
 import com.ansca.corona.CoronaLua;
 import com.ansca.corona.CoronaRuntime;
@@ -33,7 +34,6 @@ import com.ansca.corona.CoronaRuntimeListener;
 import com.ansca.corona.CoronaRuntimeTask;
 import com.naef.jnlua.JavaFunction;
 import com.naef.jnlua.LuaState;
-import com.naef.jnlua.NamedJavaFunction;
 
 import com.epicgames.mobile.eossdk.EOSSDK;
 
@@ -173,6 +173,24 @@ public class LuaLoader implements JavaFunction, CoronaRuntimeListener {
         telephonyManager.listen(phoneStateListener, PhoneStateListener.LISTEN_DATA_CONNECTION_STATE);
     }
 
+    /**
+     * Register to network and data connectivity changes, unless already registered
+     */
+    void registerConnectivityCallbacks() {
+        if (connectivityManager == null) {
+            connectivityManager = (ConnectivityManager) getApplicationContext().getSystemService(Context.CONNECTIVITY_SERVICE);
+        }
+        if (telephonyManager == null) {
+            telephonyManager = (TelephonyManager) getApplicationContext().getSystemService(Context.TELEPHONY_SERVICE);
+        }
+        if ((connectivityManager != null) && (networkCallback == null)) {
+            registerNetworkCallback();
+        }
+        if ((telephonyManager != null) && (phoneStateListener == null)) {
+            registerDataCallback();
+        }
+    }
+
     /**
      * Unregister to network connectivity changes
      */
@@ -225,26 +243,31 @@ public class LuaLoader implements JavaFunction, CoronaRuntimeListener {
      */
     @Override
     public int invoke(LuaState L) {
-        // Register this plugin into Lua with the following functions.
-        NamedJavaFunction[] luaFunctions = new NamedJavaFunction[]{
-                new InitWrapper(),
-                new IsLoggedOnWrapper(),
-                new LoginWithAccountPortalWrapper(),
-                new AddEventListenerWrapper(),
-                new RemoveEventListenerWrapper(),
-                new GetAuthIdTokenWrapper(),
-
-                new RestoreWrapper(),
-                new PurchaseWrapper(),
-                new LoadProductsWrapper(),
-                new FinishTransactionWrapper(),
-        };
+        // Make sure the native library is loaded, since onLoaded() is not called for the first Corona activity.
+        System.loadLibrary("EOSSDK");
+        System.loadLibrary("native-lib");
+
+        /** Pass instance of main activity class to JNI for calling UI functions */
+        PassLuaLoaderInstance();
+
+        /** Pass Application context to EOS SDK Java side */
+        EOSSDK.init(CoronaEnvironment.getCoronaActivity());
 
-        String libName = L.toString(1);
-        L.register(libName, luaFunctions);
+        // Report network changes to the native side, which holds offline operations until the network returns.
+        // Note: Registered on the main thread, since the PhoneStateListener needs a thread with a Looper.
+        CoronaActivity activity = CoronaEnvironment.getCoronaActivity();
+        if (activity != null) {
+            activity.runOnUiThread(new Runnable() {
+                @Override
+                public void run() {
+                    registerConnectivityCallbacks();
+                }
+            });
+        }
 
-        // Returning 1 indicates that the Lua require() function will return the above Lua library.
-        return 1;
+        // Initialize the SDK and push this plugin's Lua library, whose functions are implemented in C.
+        // Lua calls them directly, so only the lifecycle hooks below go through Java.
+        return nativeOpenLibrary(L, getApplicationContext().getFilesDir().getAbsolutePath() + "/");
     }
 
     /**
@@ -369,202 +392,6 @@ public class LuaLoader implements JavaFunction, CoronaRuntimeListener {
         });
     }
 
-    /**
-     * The following Lua function has been called:  eos.init( listener )
-     * <p>
-     * Warning! This method is not called on the main thread.
-     *
-     * @param L Reference to the Lua state that the Lua function was called from.
-     * @return Returns the number of values to be returned by the eos.init() function.
-     */
-    @SuppressWarnings({"WeakerAccess", "SameReturnValue"})
-    public int init(LuaState L) {
-        int listenerIndex = 1;
-
-        if (CoronaLua.isListener(L, listenerIndex, EVENT_NAME)) {
-            fListener = CoronaLua.newRef(L, listenerIndex);
-        }
-
-        /** Pass instance of main activity class to JNI for calling UI functions */
-        PassLuaLoaderInstance();
-
-        /** Pass Application context to EOS SDK Java side */
-        EOSSDK.init(CoronaEnvironment.getCoronaActivity());
-
-        /** Initialize SDK and start tick */
-        boolean result = nativeInitializeSDK(L, getApplicationContext().getFilesDir().getAbsolutePath() + "/");
-        if (!result) {
-            Log.e(Tag, "Failed to initialize SDK");
-            return 0;
-        }
-
-        return 0;
-    }
-
-    /**
-     * Implements the eos.init() Lua function.
-     */
-    @SuppressWarnings("unused")
-    private class InitWrapper implements NamedJavaFunction {
-        @Override
-        public String getName() {
-            return "init";
-        }
-
-        @Override
-        public int invoke(LuaState L) {
-            return init(L);
-        }
-    }
-
-    /**
-     * Implements the eos.addEventListener() Lua function.
-     */
-    @SuppressWarnings("unused")
-    private class AddEventListenerWrapper implements NamedJavaFunction {
-        @Override
-        public String getName() {
-            return "addEventListener";
-        }
-
-        @Override
-        public int invoke(LuaState L) {
-            nativeAddEventListener(L);
-            return 0;
-        }
-    }
-
-    /**
-     * Implements the eos.removeEventListener() Lua function.
-     */
-    @SuppressWarnings("unused")
-    private class RemoveEventListenerWrapper implements NamedJavaFunction {
-        @Override
-        public String getName() {
-            return "removeEventListener";
-        }
-
-        @Override
-        public int invoke(LuaState L) {
-            nativeRemoveEventListener(L);
-            return 0;
-        }
-    }
-
-    /**
-     * Implements the eos.loginWithAccountPortal() Lua function.
-     */
-    @SuppressWarnings("unused")
-    private class LoginWithAccountPortalWrapper implements NamedJavaFunction {
-        @Override
-        public String getName() {
-            return "loginWithAccountPortal";
-        }
-
-        @Override
-        public int invoke(LuaState L) {
-            nativeLoginWithAccountPortal(L);
-            return 0;
-        }
-    }
-
-    /**
-     * Implements the eos.isLoggedOn() Lua function.
-     */
-    @SuppressWarnings("unused")
-    private class IsLoggedOnWrapper implements NamedJavaFunction {
-        @Override
-        public String getName() {
-            return "isLoggedOn";
-        }
-
-        @Override
-        public int invoke(LuaState L) {
-            nativeIsLoggedOn(L);
-            return 1;
-        }
-    }
-
-    /**
-     * Implements the eos.getAuthIdToken() Lua function.
-     */
-    @SuppressWarnings("unused")
-    private class GetAuthIdTokenWrapper implements NamedJavaFunction {
-        @Override
-        public String getName() {
-            return "getAuthIdToken";
-        }
-
-        @Override
-        public int invoke(LuaState L) {
-            return nativeGetAuthIdToken(L);
-        }
-    }
-    
-    /**
-     * Implements the eos.purchase() Lua function.
-     */
-    @SuppressWarnings("unused")
-    private class FinishTransactionWrapper implements NamedJavaFunction {
-        @Override
-        public String getName() {
-            return "finishTransaction";
-        }
-
-        @Override
-        public int invoke(LuaState L) {
-            return nativeFinishTransaction(L);
-        }
-    }
-
-    /**
-     * Implements the eos.purchase() Lua function.
-     */
-    @SuppressWarnings("unused")
-    private class PurchaseWrapper implements NamedJavaFunction {
-        @Override
-        public String getName() {
-            return "purchase";
-        }
-
-        @Override
-        public int invoke(LuaState L) {
-            return nativePurchase(L);
-        }
-    }
-    
-    /**
-     * Implements the eos.restore() Lua function.
-     */
-    @SuppressWarnings("unused")
-    private class LoadProductsWrapper implements NamedJavaFunction {
-        @Override
-        public String getName() {
-            return "loadProducts";
-        }
-
-        @Override
-        public int invoke(LuaState L) {
-            return nativeLoadProducts(L);
-        }
-    }
-
-    /**
-     * Implements the eos.restore() Lua function.
-     */
-    @SuppressWarnings("unused")
-    private class RestoreWrapper implements NamedJavaFunction {
-        @Override
-        public String getName() {
-            return "restore";
-        }
-
-        @Override
-        public int invoke(LuaState L) {
-            return nativeRestorePurchases(L);
-        }
-    }
-
     /**
      * Helper function to hide/show Login/Logout button
      */
@@ -601,25 +428,7 @@ public class LuaLoader implements JavaFunction, CoronaRuntimeListener {
 
     public native void LoginWithAccountPortal();
 
-    public native int nativeLoadProducts(LuaState luaStatePointer);
-
-    public native int nativePurchase(LuaState luaStatePointer);
-
-    public native int nativeRestorePurchases(LuaState luaStatePointer);
-
-    public native int nativeFinishTransaction(LuaState luaStatePointer);
-
-    public native boolean nativeIsLoggedOn(LuaState luaStatePointer);
-
-    public native boolean nativeAddEventListener(LuaState luaStatePointer);
-
-    public native boolean nativeRemoveEventListener(LuaState luaStatePointer);
-
-    public native boolean nativeInitializeSDK(LuaState luaStatePointer, String Path);
-
-    public native boolean nativeLoginWithAccountPortal(LuaState luaStatePointer);
-
-    public native int nativeGetAuthIdToken(LuaState luaStatePointer);
+    public native int nativeOpenLibrary(LuaState luaStatePointer, String Path);
 
     public native String GetUsername();
 
@@ -0,0 +1,147 @@
+// ----------------------------------------------------------------------------
+//
+// OfferImageIndexTest.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#include "OfferImageIndex.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+
+/** Name of the index file written to the working directory. */
+static const char kIndexFileName[] = "OfferImageIndexTest.index";
+
+/** Number of failed checks. */
+static int sFailureCount = 0;
+
+
+/** Logs a failure if the given condition is false. */
+static void Check(bool condition, const char* description)
+{
+	if (!condition)
+	{
+		printf("FAILED: %s\n", description);
+		sFailureCount++;
+	}
+}
+
+/** Fetches the indexed file names from most to least recently used. */
+static std::vector<std::string> GetFileNamesFrom(const OfferImageIndex& index)
+{
+	std::vector<std::string> fileNames;
+	for (auto&& file : index.GetFiles())
+	{
+		fileNames.push_back(file.FileName);
+	}
+	return fileNames;
+}
+
+
+/** Checks that the least recently used files are evicted first once over the cap. */
+static void TestEviction()
+{
+	OfferImageIndex index(100);
+	index.Add(0x11, 0xA1, 40, "a.png");
+	index.Add(0x12, 0xA2, 40, "b.png");
+	index.Add(0x13, 0xA3, 40, "c.png");
+	Check(index.GetTotalBytes() == 120, "Eviction: total size counts every file.");
+
+	// Touching "a" makes "b" the least recently used file.
+	Check(index.FindByUrlHash(0x11) != nullptr, "Eviction: finds an indexed URL.");
+	auto evictedFileNames = index.EvictLeastRecentlyUsed();
+	Check((evictedFileNames.size() == 1) && (evictedFileNames[0] == "b.png"), "Eviction: evicts the LRU file.");
+	Check(index.GetTotalBytes() == 80, "Eviction: total size drops by the evicted file.");
+	Check(!index.ContainsUrlHash(0x12), "Eviction: drops the evicted file's URLs.");
+	Check(index.FindByUrlHash(0x12) == nullptr, "Eviction: evicted URL is not found.");
+	Check(GetFileNamesFrom(index) == std::vector<std::string>({ "a.png", "c.png" }), "Eviction: keeps LRU order.");
+}
+
+/** Checks that the most recently used file is kept even if it exceeds the cap by itself. */
+static void TestEvictionKeepsNewestFile()
+{
+	OfferImageIndex index(100);
+	index.Add(0x11, 0xA1, 40, "a.png");
+	index.Add(0x12, 0xA2, 150, "b.png");
+	auto evictedFileNames = index.EvictLeastRecentlyUsed();
+	Check((evictedFileNames.size() == 1) && (evictedFileNames[0] == "a.png"), "Oversized: evicts older files.");
+	Check(GetFileNamesFrom(index) == std::vector<std::string>({ "b.png" }), "Oversized: keeps the newest file.");
+	Check(index.EvictLeastRecentlyUsed().empty(), "Oversized: never evicts the last file.");
+}
+
+/** Checks that URLs serving the same image share 1 file, counted once. */
+static void TestSharedContent()
+{
+	OfferImageIndex index(100);
+	index.Add(0x11, 0xA1, 40, "a.png");
+	index.Add(0x12, 0xA1, 40, "a-copy.png");
+	Check(index.GetFiles().size() == 1, "Shared: 1 file per content hash.");
+	Check(index.GetTotalBytes() == 40, "Shared: size is counted once.");
+	auto filePointer = index.FindByUrlHash(0x12);
+	Check(filePointer && (filePointer->FileName == "a.png"), "Shared: second URL maps to the first file.");
+
+	// Removing the file drops both of its URLs.
+	index.Remove(0xA1);
+	Check(!index.ContainsUrlHash(0x11) && !index.ContainsUrlHash(0x12), "Shared: remove drops every URL.");
+	Check(index.GetTotalBytes() == 0, "Shared: remove drops the size.");
+}
+
+/** Checks that a saved index reloads with the same files, URLs and LRU order. */
+static void TestSaveAndReload()
+{
+	remove(kIndexFileName);
+	{
+		OfferImageIndex index(1000);
+		index.Add(0x11, 0xA1, 10, "a.png");
+		index.Add(0x12, 0xA2, 20, "b.jpg");
+		index.Add(0x13, 0xA3, 30, "c.png");
+		index.Add(0x14, 0xA2, 20, "b.jpg");
+		index.FindByUrlHash(0x11);
+		Check(index.IsDirty(), "Reload: changes flag the index as dirty.");
+		Check(index.SaveTo(kIndexFileName), "Reload: saves the index.");
+		Check(!index.IsDirty(), "Reload: saving clears the dirty flag.");
+	}
+
+	OfferImageIndex index(1000);
+	Check(index.LoadFrom(kIndexFileName), "Reload: loads the index.");
+	Check(!index.IsDirty(), "Reload: a loaded index is not dirty.");
+	Check(index.GetTotalBytes() == 60, "Reload: restores the total size.");
+	Check(
+			GetFileNamesFrom(index) == std::vector<std::string>({ "a.png", "b.jpg", "c.png" }),
+			"Reload: restores LRU order.");
+	auto filePointer = index.FindByUrlHash(0x14);
+	Check(filePointer && (filePointer->FileName == "b.jpg"), "Reload: restores shared URLs.");
+	Check(index.ContainsUrlHash(0x13), "Reload: restores every URL.");
+
+	// A smaller cap applied to the reloaded index evicts from the LRU end.
+	OfferImageIndex smallIndex(25);
+	Check(smallIndex.LoadFrom(kIndexFileName), "Reload: loads the index again.");
+	auto evictedFileNames = smallIndex.EvictLeastRecentlyUsed();
+	Check(
+			evictedFileNames == std::vector<std::string>({ "c.png", "b.jpg" }),
+			"Reload: evicts the least recently used files first.");
+	remove(kIndexFileName);
+
+	OfferImageIndex missingIndex(1000);
+	Check(!missingIndex.LoadFrom(kIndexFileName), "Reload: a missing index file is not loaded.");
+}
+
+
+int main()
+{
+	TestEviction();
+	TestEvictionKeepsNewestFile();
+	TestSharedContent();
+	TestSaveAndReload();
+	if (sFailureCount > 0)
+	{
+		printf("%d check(s) failed.\n", sFailureCount);
+		return 1;
+	}
+	printf("All checks passed.\n");
+	return 0;
+}